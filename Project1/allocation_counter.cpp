@@ -0,0 +1,142 @@
+#include "allocation_counter.h"
+
+#include <array>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+using allocation_counter::kMemoryTagCount;
+using allocation_counter::MemoryStats;
+using allocation_counter::MemoryTag;
+
+// In front of every block; 16 bytes keeps the block as aligned as malloc's.
+struct alignas(16) BlockHeader {
+    std::size_t size;
+    MemoryTag tag;
+};
+static_assert(sizeof(BlockHeader) == 16, "operator new's header must keep blocks 16-byte aligned");
+
+struct TagCounters {
+    std::atomic<int64_t> live{0};
+    std::atomic<int64_t> high_water{0};
+    std::atomic<int64_t> external{0};
+};
+
+thread_local uint64_t t_allocations = 0;
+thread_local MemoryTag t_tag = MemoryTag::Other;
+std::atomic<uint64_t> g_allocations{0};
+std::array<TagCounters, kMemoryTagCount> g_tags;
+TagCounters g_total;
+
+constexpr std::array<const char*, kMemoryTagCount> kTagNames = {"other", "ingest", "world", "render", "assets", "hud"};
+
+void RaiseHighWater(std::atomic<int64_t>& high_water, int64_t live) {
+    int64_t seen = high_water.load(std::memory_order_relaxed);
+    while (live > seen && !high_water.compare_exchange_weak(seen, live, std::memory_order_relaxed)) {
+    }
+}
+
+void Account(MemoryTag tag, int64_t bytes) {
+    TagCounters& counters = g_tags[static_cast<size_t>(tag)];
+    const int64_t live = counters.live.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    const int64_t total = g_total.live.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    if (bytes > 0) {
+        RaiseHighWater(counters.high_water, live);
+        RaiseHighWater(g_total.high_water, total);
+    }
+}
+
+MemoryStats Load(const TagCounters& counters) {
+    MemoryStats stats;
+    stats.live_bytes = counters.live.load(std::memory_order_relaxed);
+    stats.high_water_bytes = counters.high_water.load(std::memory_order_relaxed);
+    stats.external_bytes = counters.external.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void* CountedAllocate(std::size_t size) {
+    ++t_allocations;
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    void* raw = std::malloc(sizeof(BlockHeader) + size);
+    if (raw == nullptr) {
+        return nullptr;
+    }
+    BlockHeader* header = static_cast<BlockHeader*>(raw);
+    header->size = size;
+    header->tag = t_tag;
+    Account(header->tag, static_cast<int64_t>(size));
+    return header + 1;
+}
+
+void CountedFree(void* block) {
+    if (block == nullptr) {
+        return;
+    }
+    BlockHeader* header = static_cast<BlockHeader*>(block) - 1;
+    Account(header->tag, -static_cast<int64_t>(header->size));
+    std::free(header);
+}
+
+}  // namespace
+
+namespace allocation_counter {
+
+uint64_t ThreadAllocations() {
+    return t_allocations;
+}
+
+uint64_t TotalAllocations() {
+    return g_allocations.load(std::memory_order_relaxed);
+}
+
+const char* MemoryTagName(MemoryTag tag) {
+    const size_t index = static_cast<size_t>(tag);
+    return index < kMemoryTagCount ? kTagNames[index] : "?";
+}
+
+MemoryStats TagStats(MemoryTag tag) {
+    return Load(g_tags[static_cast<size_t>(tag)]);
+}
+
+MemoryStats TotalStats() {
+    return Load(g_total);
+}
+
+void AddExternalBytes(MemoryTag tag, int64_t bytes) {
+    g_tags[static_cast<size_t>(tag)].external.fetch_add(bytes, std::memory_order_relaxed);
+    g_total.external.fetch_add(bytes, std::memory_order_relaxed);
+    Account(tag, bytes);
+}
+
+MemoryTagScope::MemoryTagScope(MemoryTag tag) : previous_(t_tag) {
+    t_tag = tag;
+}
+
+MemoryTagScope::~MemoryTagScope() {
+    t_tag = previous_;
+}
+
+MemoryTag MemoryTagScope::Current() {
+    return t_tag;
+}
+
+}  // namespace allocation_counter
+
+// The array and nothrow forms forward to these by default. Over-aligned
+// allocations are not replaced and go uncounted.
+void* operator new(std::size_t size) {
+    if (void* block = CountedAllocate(size)) {
+        return block;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* block) noexcept {
+    CountedFree(block);
+}
+
+void operator delete(void* block, std::size_t) noexcept {
+    CountedFree(block);
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Counts allocations made through the global operator new, which
+// allocation_counter.cpp replaces for any target it is linked into. Counting
+// costs one thread-local increment and a few relaxed atomic adds per
+// allocation and free.
+//
+// Live bytes are also kept per subsystem: every block records the tag its
+// thread was under when it was allocated, and is given back to that tag when
+// freed, from whichever thread. Bytes stay with the tag that allocated them
+// even if a container is later moved to another subsystem. Each block carries
+// a 16-byte header for this.
+namespace allocation_counter {
+
+enum class MemoryTag : uint8_t { Other = 0, Ingest, World, Render, Assets, Hud };
+constexpr size_t kMemoryTagCount = 6;
+
+struct MemoryStats {
+    int64_t live_bytes = 0;       // heap plus external bytes held now
+    int64_t high_water_bytes = 0; // the most live_bytes has been
+    int64_t external_bytes = 0;   // of live_bytes, reported through AddExternalBytes
+};
+
+// Allocations made by the calling thread since it started.
+uint64_t ThreadAllocations();
+// Allocations made by every thread since the process started.
+uint64_t TotalAllocations();
+
+const char* MemoryTagName(MemoryTag tag);
+MemoryStats TagStats(MemoryTag tag);
+// Every tag together; its high-water mark is its own, not the sum of theirs.
+MemoryStats TotalStats();
+// Memory the heap counters cannot see, such as textures and raylib's malloc'd
+// images. Negative to release it.
+void AddExternalBytes(MemoryTag tag, int64_t bytes);
+
+// Attributes the calling thread's allocations to tag until it goes out of
+// scope. Nests; the innermost scope wins.
+class MemoryTagScope {
+public:
+    explicit MemoryTagScope(MemoryTag tag);
+    ~MemoryTagScope();
+    MemoryTagScope(const MemoryTagScope&) = delete;
+    MemoryTagScope& operator=(const MemoryTagScope&) = delete;
+
+    // The calling thread's current tag.
+    static MemoryTag Current();
+
+private:
+    MemoryTag previous_;
+};
+
+}  // namespace allocation_counter
@@ -0,0 +1,143 @@
+"""Headless seeded runs of the simulation for balance testing.
+
+Each run builds a ``RogueGame`` with ``rng_seed`` set to the seed and the
+in-memory channel (``ipc.transport: memory``), so nothing is written to the
+shared directory, then steps it as fast as it goes, with no pacing, under a
+scripted bot until the room is cleared, the player dies or ``--max-ticks``
+pass. It prints one JSON line of metrics per seed.
+
+    python batch_runner.py --seeds 0:100            # seeds 0..99 in this process
+    python batch_runner.py --worker < seeds.txt     # one seed per input line
+
+``--worker`` is how the ``BatchRunner`` driver runs it: one worker process per
+core, fed seeds over stdin and answering on stdout, so a process pays the
+start-up and import cost once for all the seeds it gets.
+"""
+
+from __future__ import annotations
+
+import argparse
+import json
+import logging
+import math
+import sys
+import time
+from typing import Dict, Iterable
+
+from game_logic import RogueGame
+
+
+def _sign(value: float, dead_zone: float) -> int:
+    if value > dead_zone:
+        return 1
+    if value < -dead_zone:
+        return -1
+    return 0
+
+
+def bot_input(game: RogueGame) -> Dict:
+    """Keyboard-like play: aim at the nearest enemy in one of eight
+    directions, keep three to six tiles away from it and strafe in between.
+    Deterministic, so a seed always plays out the same way."""
+    if not game.enemies:
+        return {}
+    player = game.player
+    target = min(game.enemies, key=lambda enemy: (enemy.x - player.x) ** 2 + (enemy.y - player.y) ** 2)
+    dx = target.x - player.x
+    dy = target.y - player.y
+    distance = math.hypot(dx, dy)
+    dead_zone = distance * 0.38  # about 22.5 degrees either side of an axis
+    aim_x = _sign(dx, dead_zone)
+    aim_y = _sign(dy, dead_zone)
+    if distance < 3.0:
+        move_x, move_y = -aim_x, -aim_y
+    elif distance > 6.0:
+        move_x, move_y = aim_x, aim_y
+    else:
+        # Circle the target; flip direction every two seconds so walls do not pin the bot.
+        flip = 1 if (game.tick // 120) % 2 == 0 else -1
+        move_x, move_y = -aim_y * flip, aim_x * flip
+    return {"move": {"x": move_x, "y": move_y}, "attack": {"x": aim_x, "y": aim_y}}
+
+
+def run_seed(seed: int, config_path: str, max_ticks: int) -> Dict:
+    started = time.perf_counter()
+    game = RogueGame(
+        config_path=config_path,
+        config_overrides={"game": {"rng_seed": seed}, "ipc": {"transport": "memory"}},
+    )
+    spawned = len(game.enemies)
+    outcome = "timeout"
+    while game.tick < max_ticks:
+        game.step(bot_input(game))
+        if game.player.hp <= 0:
+            outcome = "dead"
+            break
+        if not game.enemies:
+            outcome = "cleared"
+            break
+    game.channel.close()
+    return {
+        "seed": seed,
+        "outcome": outcome,
+        "ticks": game.tick,
+        "sim_seconds": round(game.tick * game.delta_time, 3),
+        "player_hp": max(0, game.player.hp),
+        "damage_taken": game.player.max_hp - max(0, game.player.hp),
+        "enemies": spawned,
+        "kills": spawned - len(game.enemies),
+        "coins": game.inventory["coins"],
+        "keys": game.inventory["keys"],
+        "bombs": game.inventory["bombs"],
+        "wall_ms": round((time.perf_counter() - started) * 1000.0, 2),
+    }
+
+
+def run_seeds(seeds: Iterable[int], config_path: str, max_ticks: int) -> int:
+    runs = 0
+    started = time.perf_counter()
+    out = sys.stdout
+    for seed in seeds:
+        try:
+            metrics = run_seed(seed, config_path, max_ticks)
+        except Exception as error:  # one broken seed must not end the batch
+            logging.exception("seed %d failed", seed)
+            metrics = {"seed": seed, "outcome": "error", "error": str(error)}
+        out.write(json.dumps(metrics, separators=(",", ":")) + "\n")
+        out.flush()
+        runs += 1
+    elapsed = time.perf_counter() - started
+    if runs and elapsed > 0:
+        logging.info("%d runs in %.2f s (%.1f runs/s)", runs, elapsed, runs / elapsed)
+    return 0
+
+
+def _worker_seeds() -> Iterable[int]:
+    for line in sys.stdin:
+        line = line.strip()
+        if line:
+            yield int(line)
+
+
+def _parse_range(text: str) -> range:
+    first, _, last = text.partition(":")
+    return range(int(first), int(last)) if last else range(int(first), int(first) + 1)
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--config", default="game_config.yaml")
+    parser.add_argument("--max-ticks", type=int, default=3600)
+    source = parser.add_mutually_exclusive_group(required=True)
+    source.add_argument("--seeds", type=_parse_range, help="FIRST:END (END exclusive) or a single seed")
+    source.add_argument("--worker", action="store_true", help="read seeds from stdin, one per line")
+    args = parser.parse_args()
+    # stdout carries the results; everything else goes to stderr.
+    logging.basicConfig(level=logging.INFO if args.seeds else logging.WARNING,
+                        format="%(asctime)s %(name)s: %(message)s", stream=sys.stderr)
+    seeds = _worker_seeds() if args.worker else args.seeds
+    return run_seeds(seeds, args.config, max(1, args.max_ticks))
+
+
+if __name__ == "__main__":
+    raise SystemExit(main())
@@ -0,0 +1,232 @@
+// Headless batch evaluation. Starts one batch_runner.py worker per core,
+// hands each the next seed as soon as it reports the last one, and
+// aggregates the per-seed metrics into outcome counts and mean/min/max per
+// field, plus throughput in runs per second. Each worker steps the
+// simulation with ipc.transport "memory", so runs never touch shared/ and
+// never wait on a renderer.
+//
+//   BatchRunner [--seeds FIRST:END | --runs N] [--workers W] [--max-ticks T]
+//               [--python EXE] [--script FILE] [--config FILE] [--output FILE]
+//
+// Seeds run from FIRST up to END, exclusive (--runs N is 0:N). --workers
+// defaults to the number of hardware threads. --output writes every seed's
+// metrics, one JSON object per line in seed order. Run it from the directory
+// holding the script and config, as for the game. Exits with 1 if a seed
+// failed or a worker died.
+
+#include "child_process.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <thread>
+#include <vector>
+
+using json = nlohmann::json;
+
+namespace {
+
+struct BatchOptions {
+    int64_t first_seed = 0;
+    int64_t end_seed = 100;
+    int workers = 0;
+    int max_ticks = 3600;
+#ifdef _WIN32
+    std::string python = "python";
+#else
+    std::string python = "python3";
+#endif
+    std::string script = "batch_runner.py";
+    std::string config = "game_config.yaml";
+    std::string output_path;
+};
+
+struct FieldStats {
+    size_t count = 0;
+    double total = 0.0;
+    double min = 0.0;
+    double max = 0.0;
+
+    void Add(double value) {
+        min = count == 0 ? value : std::min(min, value);
+        max = count == 0 ? value : std::max(max, value);
+        total += value;
+        ++count;
+    }
+
+    double Mean() const { return count > 0 ? total / static_cast<double>(count) : 0.0; }
+};
+
+void PrintUsage() {
+    std::fprintf(stderr,
+                 "usage: BatchRunner [--seeds FIRST:END | --runs N] [--workers W] [--max-ticks T]\n"
+                 "                   [--python EXE] [--script FILE] [--config FILE] [--output FILE]\n");
+}
+
+bool ParseOptions(int argc, char** argv, BatchOptions& options) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (arg == "--help" || arg == "-h") {
+            return false;
+        }
+        if (value == nullptr) {
+            std::fprintf(stderr, "missing value for %s\n", arg.c_str());
+            return false;
+        }
+        ++i;
+        if (arg == "--seeds") {
+            long long first = 0;
+            long long end = 0;
+            if (std::sscanf(value, "%lld:%lld", &first, &end) != 2 || end <= first) {
+                std::fprintf(stderr, "--seeds expects FIRST:END with END > FIRST\n");
+                return false;
+            }
+            options.first_seed = first;
+            options.end_seed = end;
+        } else if (arg == "--runs") {
+            options.first_seed = 0;
+            options.end_seed = std::max(1, std::atoi(value));
+        } else if (arg == "--workers") {
+            options.workers = std::max(0, std::atoi(value));
+        } else if (arg == "--max-ticks") {
+            options.max_ticks = std::max(1, std::atoi(value));
+        } else if (arg == "--python") {
+            options.python = value;
+        } else if (arg == "--script") {
+            options.script = value;
+        } else if (arg == "--config") {
+            options.config = value;
+        } else if (arg == "--output") {
+            options.output_path = value;
+        } else {
+            std::fprintf(stderr, "unknown option %s\n", arg.c_str());
+            return false;
+        }
+    }
+    return true;
+}
+
+// Feeds one worker process seeds until the batch runs out or the worker
+// stops answering. A seed it took but never answered is recorded as an
+// error rather than retried, so a seed that crashes Python cannot take down
+// every worker in turn.
+void RunWorker(ChildProcess& worker, const BatchOptions& options, std::atomic<int64_t>& next_seed,
+               std::vector<json>& results) {
+    std::string line;
+    for (;;) {
+        const int64_t seed = next_seed.fetch_add(1);
+        if (seed >= options.end_seed) {
+            break;
+        }
+        json& result = results[static_cast<size_t>(seed - options.first_seed)];
+        if (!worker.WriteLine(std::to_string(seed)) || !worker.ReadLine(line)) {
+            result = json{{"seed", seed}, {"outcome", "error"}, {"error", "worker exited"}};
+            break;
+        }
+        result = json::parse(line, nullptr, false);
+        if (!result.is_object()) {
+            result = json{{"seed", seed}, {"outcome", "error"}, {"error", "unreadable result"}};
+        }
+    }
+    worker.CloseInput();
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    BatchOptions options;
+    if (!ParseOptions(argc, argv, options)) {
+        PrintUsage();
+        return 2;
+    }
+    const int64_t runs = options.end_seed - options.first_seed;
+    int workers = options.workers > 0 ? options.workers : static_cast<int>(std::thread::hardware_concurrency());
+    workers = static_cast<int>(std::clamp<int64_t>(workers, 1, runs));
+
+    const std::vector<std::string> command = {
+        options.python, options.script, "--worker", "--config", options.config,
+        "--max-ticks", std::to_string(options.max_ticks),
+    };
+    const auto started = std::chrono::steady_clock::now();
+    // Started here, before any worker thread exists; see ChildProcess.
+    std::vector<ChildProcess> processes(static_cast<size_t>(workers));
+    for (ChildProcess& process : processes) {
+        if (!process.Start(command)) {
+            std::fprintf(stderr, "unable to start %s %s\n", options.python.c_str(), options.script.c_str());
+            return 1;
+        }
+    }
+
+    std::vector<json> results(static_cast<size_t>(runs));
+    std::atomic<int64_t> next_seed{options.first_seed};
+    std::vector<std::thread> threads;
+    threads.reserve(processes.size());
+    for (ChildProcess& process : processes) {
+        threads.emplace_back(RunWorker, std::ref(process), std::cref(options), std::ref(next_seed),
+                             std::ref(results));
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    int failed_workers = 0;
+    for (ChildProcess& process : processes) {
+        failed_workers += process.Wait() != 0 ? 1 : 0;
+    }
+    const double wall_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+
+    std::map<std::string, int64_t> outcomes;
+    std::map<std::string, FieldStats> fields;
+    int64_t completed = 0;
+    for (const json& result : results) {
+        // A worker that died early leaves the seeds nobody took empty.
+        const std::string outcome = result.is_object() ? result.value("outcome", "error") : "skipped";
+        ++outcomes[outcome];
+        if (!result.is_object() || outcome == "error") {
+            continue;
+        }
+        ++completed;
+        for (const auto& [key, value] : result.items()) {
+            if (key != "seed" && value.is_number()) {
+                fields[key].Add(value.get<double>());
+            }
+        }
+    }
+
+    std::printf("runs          %lld seeds %lld..%lld on %d worker(s), max %d ticks\n", static_cast<long long>(runs),
+                static_cast<long long>(options.first_seed), static_cast<long long>(options.end_seed - 1), workers,
+                options.max_ticks);
+    std::printf("outcomes     ");
+    for (const auto& [outcome, count] : outcomes) {
+        std::printf(" %s %lld (%.1f%%)", outcome.c_str(), static_cast<long long>(count),
+                    100.0 * static_cast<double>(count) / static_cast<double>(runs));
+    }
+    std::printf("\n");
+    for (const auto& [key, stats] : fields) {
+        std::printf("%-13s mean %10.2f  min %10.2f  max %10.2f\n", key.c_str(), stats.Mean(), stats.min, stats.max);
+    }
+    std::printf("throughput    %.1f runs/s, %.2f s wall\n", static_cast<double>(completed) / wall_seconds,
+                wall_seconds);
+
+    if (!options.output_path.empty()) {
+        std::ofstream out(options.output_path, std::ios::binary);
+        for (const json& result : results) {
+            if (result.is_object()) {
+                out << result.dump() << '\n';
+            }
+        }
+        if (!out) {
+            std::fprintf(stderr, "unable to write %s\n", options.output_path.c_str());
+            return 1;
+        }
+    }
+    return completed < runs || failed_workers > 0 ? 1 : 0;
+}
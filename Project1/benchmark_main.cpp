@@ -0,0 +1,737 @@
+// Offscreen renderer benchmark. Feeds synthetic or recorded game_state
+// snapshots through the same decoder, world model, interpolator and
+// SceneRenderer passes as the game, and reports per-frame parse and draw
+// cost, heap allocations and throughput.
+//
+//   Benchmark [--enemies N] [--projectiles M] [--width W] [--height H]
+//             [--frames F] [--warmup K] [--replay FILE] [--seeks N] [--sprites DIR]
+//             [--threads T] [--bursts B] [--quality L] [--csv FILE] [--compare-json FILE]
+//             [--expect-zero-allocations]
+//
+// A replay file is either a recording the renderer made (.rgrp, see
+// renderer.record_dir) or a sequence of u32 little-endian sizes, each
+// followed by one payload exactly as a transport delivers it (JSON or
+// binary, keyframe or delta); record_snapshots.py writes those. Without
+// --replay, full JSON keyframes of a room with the requested entity counts
+// are generated. --sprites draws from an atlas loaded like renderer.sprites_dir
+// (the warmup frames cover the upload). --seeks times N random seeks into an .rgrp recording: find
+// the keyframe, then decode and apply every record up to the target tick.
+// --threads records the entity layers on T threads, like
+// renderer.render_threads (0 = auto); "record" is that part of the draw.
+// --bursts adds B particle spawn events per synthetic snapshot, cycling
+// through impact, blood and explosion; "draw" then includes simulating them.
+// --quality draws at one adaptive quality level (0 = full, see
+// SceneRenderer::SetQualityLevel), to see what each level saves.
+// JSON payloads are also decoded --frames times each way outside the frame
+// loop, streamed (what the game does) and through the DOM, to compare the
+// two and check they agree; a large --width/--height/--projectiles room
+// shows the gap best.
+// "memory" is the high-water mark of each allocation_counter tag over the
+// run, heap and texture bytes together, as the overlay shows it in game.
+// --compare-json takes the JSON twin of a binary --replay
+// (record_snapshots.py --json-twin) and checks that every pair decodes to the
+// same tile, pickup and actor codes, and that a binary payload with a wrong
+// code_table_hash is refused; the run exits 1 if either check fails.
+
+#include "raylib.h"
+#include "allocation_counter.h"
+#include "frame_profiler.h"
+#include "job_system.h"
+#include "replay_file.h"
+#include "scene_renderer.h"
+#include "snapshot_decoder.h"
+#include "world_interpolator.h"
+#include "world_model.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <nlohmann/json.hpp>
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+
+using json = nlohmann::json;
+
+namespace {
+
+struct BenchmarkOptions {
+    int enemies = 40;
+    int projectiles = 400;
+    int width = 20;
+    int height = 12;
+    int frames = 2000;
+    int warmup = 120;
+    int screen_width = 1280;
+    int screen_height = 720;
+    std::string replay_path;
+    std::string csv_path;
+    std::string sprites_dir;
+    std::string compare_json_path;
+    int seeks = 0;
+    int threads = 0;
+    int bursts = 0;
+    int quality = 0;
+    bool expect_zero_allocations = false;
+};
+
+struct Samples {
+    std::vector<int64_t> values;
+
+    double Mean() const {
+        if (values.empty()) {
+            return 0.0;
+        }
+        double total = 0.0;
+        for (const int64_t value : values) {
+            total += static_cast<double>(value);
+        }
+        return total / static_cast<double>(values.size());
+    }
+
+    int64_t Percentile(double fraction) const {
+        if (values.empty()) {
+            return 0;
+        }
+        std::vector<int64_t> sorted = values;
+        const size_t rank = std::min(sorted.size() - 1, static_cast<size_t>(fraction * sorted.size()));
+        std::nth_element(sorted.begin(), sorted.begin() + rank, sorted.end());
+        return sorted[rank];
+    }
+};
+
+void PrintUsage() {
+    std::printf("usage: Benchmark [--enemies N] [--projectiles M] [--width W] [--height H]\n"
+                "                 [--frames F] [--warmup K] [--screen WxH] [--replay FILE] [--seeks N]\n"
+                "                 [--sprites DIR] [--threads T] [--bursts B] [--quality L] [--csv FILE]\n"
+                "                 [--compare-json FILE] [--expect-zero-allocations]\n");
+}
+
+bool ParseOptions(int argc, char** argv, BenchmarkOptions& options) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (arg == "--help" || arg == "-h") {
+            return false;
+        }
+        if (arg == "--expect-zero-allocations") {
+            options.expect_zero_allocations = true;
+            continue;
+        }
+        if (value == nullptr) {
+            std::fprintf(stderr, "missing value for %s\n", arg.c_str());
+            return false;
+        }
+        ++i;
+        if (arg == "--enemies") {
+            options.enemies = std::max(0, std::atoi(value));
+        } else if (arg == "--projectiles") {
+            options.projectiles = std::max(0, std::atoi(value));
+        } else if (arg == "--width") {
+            options.width = std::max(3, std::atoi(value));
+        } else if (arg == "--height") {
+            options.height = std::max(3, std::atoi(value));
+        } else if (arg == "--frames") {
+            options.frames = std::max(1, std::atoi(value));
+        } else if (arg == "--warmup") {
+            options.warmup = std::max(0, std::atoi(value));
+        } else if (arg == "--screen") {
+            if (std::sscanf(value, "%dx%d", &options.screen_width, &options.screen_height) != 2) {
+                std::fprintf(stderr, "--screen expects WxH\n");
+                return false;
+            }
+        } else if (arg == "--replay") {
+            options.replay_path = value;
+        } else if (arg == "--sprites") {
+            options.sprites_dir = value;
+        } else if (arg == "--seeks") {
+            options.seeks = std::max(0, std::atoi(value));
+        } else if (arg == "--bursts") {
+            options.bursts = std::max(0, std::atoi(value));
+        } else if (arg == "--quality") {
+            options.quality = std::clamp(std::atoi(value), 0, SceneRenderer::kQualityLevels - 1);
+        } else if (arg == "--threads") {
+            options.threads = std::max(0, std::atoi(value));
+        } else if (arg == "--csv") {
+            options.csv_path = value;
+        } else if (arg == "--compare-json") {
+            options.compare_json_path = value;
+        } else {
+            std::fprintf(stderr, "unknown option %s\n", arg.c_str());
+            return false;
+        }
+    }
+    return true;
+}
+
+bool LoadRecording(const std::string& path, std::vector<std::string>& payloads) {
+    ReplayReader reader;
+    if (!reader.Open(path)) {
+        return false;
+    }
+    std::vector<char> bytes;
+    size_t unreadable = 0;
+    while (reader.Peek()) {
+        if (reader.Read(bytes)) {
+            payloads.emplace_back(bytes.data(), bytes.size());
+        } else {
+            ++unreadable;
+        }
+    }
+    if (unreadable > 0) {
+        std::fprintf(stderr, "skipped %zu unreadable records in %s; deltas after them will not apply\n", unreadable,
+                     path.c_str());
+    }
+    return !payloads.empty();
+}
+
+bool LoadReplay(const std::string& path, std::vector<std::string>& payloads) {
+    if (replay::IsReplayFile(path)) {
+        return LoadRecording(path, payloads);
+    }
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    uint8_t prefix[4];
+    while (file.read(reinterpret_cast<char*>(prefix), sizeof(prefix))) {
+        const uint32_t size = prefix[0] | (prefix[1] << 8) | (prefix[2] << 16) | (static_cast<uint32_t>(prefix[3]) << 24);
+        std::string payload(size, '\0');
+        if (!file.read(payload.data(), size)) {
+            return false;
+        }
+        payloads.push_back(std::move(payload));
+    }
+    return !payloads.empty();
+}
+
+// Index of the first payload that decodes as a keyframe, or 0 if none does.
+size_t FirstKeyframe(const std::vector<std::string>& payloads) {
+    SnapshotUpdate update;
+    for (size_t i = 0; i < payloads.size(); ++i) {
+        try {
+            DecodeSnapshot(payloads[i].data(), payloads[i].size(), update);
+        } catch (const std::exception&) {
+            continue;
+        }
+        if (update.keyframe) {
+            return i;
+        }
+    }
+    return 0;
+}
+
+// A bordered room with rocks, a ring of wandering enemies and projectiles
+// crossing it. Projectiles wrap instead of dying so counts stay constant.
+std::vector<std::string> MakeSyntheticStream(const BenchmarkOptions& options, int count) {
+    const float delta_time = 1.0f / 60.0f;
+    json tiles = json::array();
+    for (int y = 0; y < options.height; ++y) {
+        json row = json::array();
+        for (int x = 0; x < options.width; ++x) {
+            const bool border = x == 0 || y == 0 || x == options.width - 1 || y == options.height - 1;
+            const bool rock = !border && (x * 7 + y * 13) % 17 == 0;
+            row.push_back(border ? "wall" : rock ? "rock" : "floor");
+        }
+        tiles.push_back(std::move(row));
+    }
+
+    const float inner_w = static_cast<float>(options.width - 2);
+    const float inner_h = static_cast<float>(options.height - 2);
+    std::vector<std::string> payloads;
+    payloads.reserve(count);
+    for (int frame = 0; frame < count; ++frame) {
+        const float t = frame * delta_time;
+        json actors = json::array();
+        actors.push_back({{"id", "player"}, {"type", "player"}, {"variant", "isaac"},
+                          {"x", options.width * 0.5f}, {"y", options.height * 0.5f},
+                          {"hp", 6}, {"max_hp", 6}, {"speed", 4.0f}});
+        for (int i = 0; i < options.enemies; ++i) {
+            const float phase = t * 0.5f + i * 0.37f;
+            actors.push_back({{"id", "enemy_" + std::to_string(i)}, {"type", "enemy"},
+                              {"variant", i % 3 == 0 ? "spitter" : "charger"},
+                              {"x", 1.0f + inner_w * (0.5f + 0.45f * std::sin(phase + i))},
+                              {"y", 1.0f + inner_h * (0.5f + 0.45f * std::cos(phase * 1.3f + i))},
+                              {"hp", 3 + i % 5}, {"max_hp", 8}, {"state", "chasing"}});
+        }
+        json projectiles = json::array();
+        for (int i = 0; i < options.projectiles; ++i) {
+            const float vx = 6.0f * std::cos(i * 0.7f);
+            const float vy = 6.0f * std::sin(i * 0.7f);
+            const float x = std::fmod(i * 1.618f + vx * t, inner_w);
+            const float y = std::fmod(i * 2.414f + vy * t, inner_h);
+            projectiles.push_back({{"id", "proj_" + std::to_string(i)},
+                                   {"owner", i % 4 == 0 ? "player" : "enemy"},
+                                   {"kind", i % 4 == 0 ? "player_projectile" : "enemy_projectile"},
+                                   {"x", 1.0f + (x < 0.0f ? x + inner_w : x)},
+                                   {"y", 1.0f + (y < 0.0f ? y + inner_h : y)},
+                                   {"vx", vx}, {"vy", vy}, {"damage", 1}, {"ttl", 1.0f}, {"radius", 0.2f}});
+        }
+        json particles = json::array();
+        for (int i = 0; i < options.bursts; ++i) {
+            const int n = frame * options.bursts + i;
+            static constexpr const char* kKinds[] = {"impact", "blood_splatter", "explosion"};
+            particles.push_back({{"kind", kKinds[n % 3]},
+                                 {"x", 1.0f + inner_w * (0.5f + 0.45f * std::sin(n * 0.61f))},
+                                 {"y", 1.0f + inner_h * (0.5f + 0.45f * std::cos(n * 0.83f))},
+                                 {"seed", static_cast<uint32_t>(n) * 2654435761u}});
+        }
+        json state = {
+            {"meta", {{"tick", frame + 1}, {"delta_time", delta_time}, {"room_id", 0},
+                      {"player_hp", 6}, {"player_max_hp", 6}, {"coins", frame % 100},
+                      {"keys", 1}, {"bombs", 2}, {"room_cleared", options.enemies == 0},
+                      {"player_dead", false}}},
+            {"tilemap", {{"tile_size", 32}, {"width", options.width}, {"height", options.height}, {"tiles", tiles}}},
+            {"actors", std::move(actors)},
+            {"projectiles", std::move(projectiles)},
+            {"pickups", json::array({{{"id", "coin_0"}, {"kind", "coin"}, {"x", 2.0f}, {"y", 2.0f}},
+                                     {{"id", "heart_0"}, {"kind", "heart"}, {"x", 3.0f}, {"y", 2.0f}}})},
+            {"effects", json::array()},
+            {"particles", std::move(particles)},
+            {"ui", {{"messages", json::array({"Benchmark room"})}, {"boss_health", nullptr}}},
+        };
+        payloads.push_back(state.dump());
+    }
+    return payloads;
+}
+
+struct DecoderRun {
+    Samples micros;
+    uint64_t allocations = 0;
+    size_t bytes = 0;
+};
+
+bool SameSpawns(const std::vector<ParticleSpawn>& a, const std::vector<ParticleSpawn>& b) {
+    return std::equal(a.begin(), a.end(), b.begin(), b.end(), [](const ParticleSpawn& x, const ParticleSpawn& y) {
+        return x.tick == y.tick && x.kind == y.kind && x.x == y.x && x.y == y.y && x.seed == y.seed;
+    });
+}
+
+bool SameChanges(const std::vector<TileChange>& a, const std::vector<TileChange>& b) {
+    return std::equal(a.begin(), a.end(), b.begin(), b.end(), [](const TileChange& x, const TileChange& y) {
+        return x.x == y.x && x.y == y.y && x.code == y.code;
+    });
+}
+
+bool SameUpdate(const SnapshotUpdate& a, const SnapshotUpdate& b) {
+    const WorldSnapshot& x = a.frame;
+    const WorldSnapshot& y = b.frame;
+    const auto meta = [](const SnapshotMeta& m) {
+        return std::tie(m.tick, m.delta_time, m.room_id, m.player_hp, m.player_max_hp, m.coins, m.keys, m.bombs,
+                        m.room_cleared, m.player_dead, m.input_ack, m.timestamp_us);
+    };
+    const auto boss = [](const BossHealth& h) { return std::tie(h.active, h.hp, h.max_hp, h.name); };
+    return a.keyframe == b.keyframe && a.base_tick == b.base_tick && meta(x.meta) == meta(y.meta) &&
+        x.tile_size == y.tile_size && x.room_width == y.room_width && x.room_height == y.room_height &&
+        x.tiles == y.tiles && ActorArrays::ColumnsOf(x.actors) == ActorArrays::ColumnsOf(y.actors) &&
+        ProjectileArrays::ColumnsOf(x.projectiles) == ProjectileArrays::ColumnsOf(y.projectiles) &&
+        PickupArrays::ColumnsOf(x.pickups) == PickupArrays::ColumnsOf(y.pickups) &&
+        EffectArrays::ColumnsOf(x.effects) == EffectArrays::ColumnsOf(y.effects) && x.messages == y.messages &&
+        boss(x.boss) == boss(y.boss) && a.removed_actors == b.removed_actors &&
+        a.removed_projectiles == b.removed_projectiles && a.removed_pickups == b.removed_pickups &&
+        a.removed_effects == b.removed_effects && SameChanges(a.tile_changes, b.tile_changes) &&
+        SameSpawns(a.particle_spawns, b.particle_spawns);
+}
+
+// Decodes the JSON payloads count times with each decoder, after one pass
+// that warms both arenas and checks the two agree. Returns how many payloads
+// decoded differently (or threw in only one of them).
+size_t CompareJsonDecoders(const std::vector<std::string>& payloads, int count, DecoderRun& stream, DecoderRun& dom) {
+    std::vector<const std::string*> json_payloads;
+    for (const std::string& payload : payloads) {
+        if (!snapshot::IsBinarySnapshot(payload.data(), payload.size())) {
+            json_payloads.push_back(&payload);
+        }
+    }
+    if (json_payloads.empty()) {
+        return 0;
+    }
+    SnapshotUpdate streamed;
+    SnapshotUpdate parsed;
+    size_t mismatches = 0;
+    for (const std::string* payload : json_payloads) {
+        bool stream_ok = true;
+        bool dom_ok = true;
+        try {
+            StreamJsonSnapshot(payload->data(), payload->size(), streamed);
+        } catch (const std::exception&) {
+            stream_ok = false;
+        }
+        try {
+            ParseJsonSnapshot(payload->data(), payload->size(), parsed);
+        } catch (const std::exception&) {
+            dom_ok = false;
+        }
+        mismatches += stream_ok != dom_ok || (stream_ok && !SameUpdate(streamed, parsed)) ? 1 : 0;
+    }
+
+    const auto run = [&](DecoderRun& result, auto decode, SnapshotUpdate& update) {
+        result.micros.values.reserve(count);
+        for (int i = 0; i < count; ++i) {
+            const std::string& payload = *json_payloads[i % json_payloads.size()];
+            const uint64_t allocations_before = allocation_counter::ThreadAllocations();
+            const int64_t start = FrameProfiler::NowMicros();
+            try {
+                decode(payload.data(), payload.size(), update);
+            } catch (const std::exception&) {
+            }
+            result.micros.values.push_back(FrameProfiler::NowMicros() - start);
+            result.allocations += allocation_counter::ThreadAllocations() - allocations_before;
+            result.bytes += payload.size();
+        }
+    };
+    run(stream, StreamJsonSnapshot, streamed);
+    run(dom, ParseJsonSnapshot, parsed);
+    return mismatches;
+}
+
+bool SameCodes(const SnapshotUpdate& a, const SnapshotUpdate& b) {
+    return a.keyframe == b.keyframe && a.frame.tiles == b.frame.tiles && SameChanges(a.tile_changes, b.tile_changes) &&
+        a.frame.actors.type == b.frame.actors.type && a.frame.actors.variant == b.frame.actors.variant &&
+        a.frame.pickups.kind == b.frame.pickups.kind;
+}
+
+// Decodes binary[i] and text[i] and compares their codes; then flips one byte
+// of the first binary payload's code_table_hash, which must be refused.
+// Returns how many checks failed.
+size_t CompareCodes(const std::vector<std::string>& binary, const std::vector<std::string>& text, size_t& pairs) {
+    pairs = std::min(binary.size(), text.size());
+    size_t failures = binary.size() != text.size() ? 1 : 0;
+    SnapshotUpdate from_binary;
+    SnapshotUpdate from_text;
+    for (size_t i = 0; i < pairs; ++i) {
+        if (!snapshot::IsBinarySnapshot(binary[i].data(), binary[i].size())) {
+            ++failures;
+            continue;
+        }
+        try {
+            DecodeSnapshot(binary[i].data(), binary[i].size(), from_binary);
+            DecodeSnapshot(text[i].data(), text[i].size(), from_text);
+        } catch (const std::exception&) {
+            ++failures;
+            continue;
+        }
+        failures += SameCodes(from_binary, from_text) ? 0 : 1;
+    }
+    if (!binary.empty() && binary.front().size() >= sizeof(snapshot::Header)) {
+        std::string tampered = binary.front();
+        tampered[offsetof(snapshot::Header, code_table_hash)] ^= 0x01;
+        try {
+            DecodeSnapshot(tampered.data(), tampered.size(), from_binary);
+            ++failures;
+        } catch (const std::exception&) {
+        }
+    }
+    return failures;
+}
+
+void PrintDecoderRun(const char* label, const DecoderRun& run) {
+    const double seconds = run.micros.Mean() * run.micros.values.size() / 1e6;
+    std::printf("%-13s mean %8.1f us  p50 %6lld us  p99 %6lld us  %.1f MiB/s  %.1f allocs/payload\n", label,
+                run.micros.Mean(), static_cast<long long>(run.micros.Percentile(0.50)),
+                static_cast<long long>(run.micros.Percentile(0.99)),
+                seconds > 0.0 ? run.bytes / 1048576.0 / seconds : 0.0,
+                static_cast<double>(run.allocations) / static_cast<double>(run.micros.values.size()));
+}
+
+void PrintMemoryPeaks() {
+    std::printf("memory        peak MiB");
+    for (size_t i = 0; i < allocation_counter::kMemoryTagCount; ++i) {
+        const allocation_counter::MemoryTag tag = static_cast<allocation_counter::MemoryTag>(i);
+        std::printf("  %s %.1f", allocation_counter::MemoryTagName(tag),
+                    allocation_counter::TagStats(tag).high_water_bytes / 1048576.0);
+    }
+    std::printf("  total %.1f\n", allocation_counter::TotalStats().high_water_bytes / 1048576.0);
+}
+
+// Each sample is what a replay seek costs the ingest thread: the keyframe
+// lookup plus decoding and applying every record up to the target.
+bool MeasureSeeks(const std::string& path, int count, Samples& seeks, Samples& records) {
+    ReplayReader reader;
+    if (!reader.Open(path)) {
+        return false;
+    }
+    std::mt19937_64 random(0x5eed);
+    std::uniform_int_distribution<uint64_t> ticks(reader.FirstTick(), reader.LastTick());
+    WorldModel model;
+    SnapshotUpdate update;
+    std::vector<char> bytes;
+    for (int i = 0; i < count; ++i) {
+        const uint64_t target = ticks(random);
+        const int64_t start = FrameProfiler::NowMicros();
+        reader.Seek(target);
+        int64_t applied = 0;
+        while (const replay::RecordHeader* record = reader.Peek()) {
+            if (record->tick > target) {
+                break;
+            }
+            if (!reader.Read(bytes)) {
+                continue;
+            }
+            try {
+                DecodeSnapshot(bytes.data(), bytes.size(), update);
+                model.Apply(update);
+            } catch (const std::exception&) {
+            }
+            ++applied;
+        }
+        seeks.values.push_back(FrameProfiler::NowMicros() - start);
+        records.values.push_back(applied);
+    }
+    return true;
+}
+
+void WriteCsv(const std::string& path, const BenchmarkOptions& options, const Samples& parse, const Samples& draw,
+              double parse_allocs, double draw_allocs, double frames_per_second) {
+    std::ifstream existing(path);
+    const bool write_header = !existing.good() || existing.peek() == std::ifstream::traits_type::eof();
+    existing.close();
+
+    std::ofstream file(path, std::ios::app);
+    if (!file.is_open()) {
+        std::fprintf(stderr, "unable to write %s\n", path.c_str());
+        return;
+    }
+    if (write_header) {
+        file << "source,enemies,projectiles,width,height,frames,parse_mean_us,parse_p99_us,"
+                "draw_mean_us,draw_p99_us,parse_allocs,draw_allocs,frames_per_second\n";
+    }
+    file << (options.replay_path.empty() ? "synthetic" : options.replay_path) << ','
+         << options.enemies << ',' << options.projectiles << ',' << options.width << ',' << options.height << ','
+         << options.frames << ',' << parse.Mean() << ',' << parse.Percentile(0.99) << ','
+         << draw.Mean() << ',' << draw.Percentile(0.99) << ',' << parse_allocs << ',' << draw_allocs << ','
+         << frames_per_second << '\n';
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    BenchmarkOptions options;
+    if (!ParseOptions(argc, argv, options)) {
+        PrintUsage();
+        return 2;
+    }
+
+    const int total_frames = options.warmup + options.frames;
+    std::vector<std::string> payloads;
+    if (!options.replay_path.empty()) {
+        if (!LoadReplay(options.replay_path, payloads)) {
+            std::fprintf(stderr, "unable to read replay %s\n", options.replay_path.c_str());
+            return 1;
+        }
+    } else {
+        payloads = MakeSyntheticStream(options, std::min(total_frames, 600));
+    }
+    size_t payload_bytes = 0;
+    for (const std::string& payload : payloads) {
+        payload_bytes += payload.size();
+    }
+    // Playback loops over the payloads. Each pass after the first restarts at
+    // the first keyframe, so wrapping never feeds the model a delta whose base
+    // it does not have.
+    const size_t loop_start = FirstKeyframe(payloads);
+
+    SetTraceLogLevel(LOG_WARNING);
+    SetConfigFlags(FLAG_WINDOW_HIDDEN);
+    InitWindow(options.screen_width, options.screen_height, "Renderer Benchmark");
+    SetTargetFPS(0);
+    // Decoding and the world model tag their own allocations.
+    allocation_counter::MemoryTagScope memory(allocation_counter::MemoryTag::Render);
+    SceneRenderer scene;
+    scene.ConfigureSprites(options.sprites_dir, 4);
+    scene.Load();
+    scene.SetQualityLevel(options.quality);
+    JobSystem jobs;
+    jobs.Start(JobSystem::ResolveWorkers(options.threads));
+    RenderTexture2D target = LoadRenderTexture(options.screen_width, options.screen_height);
+
+    WorldModel model;
+    SnapshotUpdate update;
+    WorldInterpolator interpolator;
+    interpolator.Configure(true, 0.1f);
+    uint64_t serial = 0;
+
+    Samples parse;
+    Samples draw;
+    Samples record;
+    uint64_t parse_allocations = 0;
+    uint64_t draw_allocations = 0;
+    uint64_t parse_failures = 0;
+    uint64_t deltas_dropped = 0;
+    size_t bytes_parsed = 0;
+    int64_t measure_start_us = FrameProfiler::NowMicros();
+    parse.values.reserve(options.frames);
+    draw.values.reserve(options.frames);
+    record.values.reserve(options.frames);
+
+    for (int frame = 0; frame < total_frames; ++frame) {
+        const bool measured = frame >= options.warmup;
+        if (frame == options.warmup) {
+            measure_start_us = FrameProfiler::NowMicros();
+        }
+        const size_t index = static_cast<size_t>(frame) < payloads.size()
+                                 ? static_cast<size_t>(frame)
+                                 : loop_start + (frame - payloads.size()) % (payloads.size() - loop_start);
+        const std::string& payload = payloads[index];
+
+        const uint64_t allocations_before_parse = allocation_counter::ThreadAllocations();
+        const int64_t parse_start = FrameProfiler::NowMicros();
+        try {
+            DecodeSnapshot(payload.data(), payload.size(), update);
+            if (!model.Apply(update)) {
+                ++deltas_dropped;
+            }
+        } catch (const std::exception&) {
+            ++parse_failures;
+        }
+        const int64_t parse_end = FrameProfiler::NowMicros();
+        const uint64_t allocations_after_parse = allocation_counter::ThreadAllocations();
+
+        const WorldSnapshot& world = model.Snapshot();
+        interpolator.Update(world, true, frame / 60.0);
+        scene.UpdateSprites();
+        scene.UpdateCamera(world, interpolator.Actors());
+        scene.UpdateTileCache(world, model.TileLayoutRevision(), ++serial, model.DirtyTiles());
+        model.ClearDirtyTiles();
+        scene.UpdateHud(world);
+        scene.UpdateParticles(world, model.ParticleSpawns(), 1.0f / 60.0f);
+        model.ClearParticleSpawns();
+        const int64_t record_start = FrameProfiler::NowMicros();
+        scene.BuildEntityLayers(world, interpolator.Actors(), interpolator.Projectiles(), jobs);
+        const int64_t record_end = FrameProfiler::NowMicros();
+        BeginTextureMode(target);
+        ClearBackground(Color{16, 16, 24, 255});
+        scene.DrawTilemap(world);
+        scene.DrawEntityLayers();
+        scene.DrawHud();
+        EndTextureMode();
+        const int64_t draw_end = FrameProfiler::NowMicros();
+        const uint64_t allocations_after_draw = allocation_counter::ThreadAllocations();
+
+        if (measured) {
+            parse.values.push_back(parse_end - parse_start);
+            draw.values.push_back(draw_end - parse_end);
+            record.values.push_back(record_end - record_start);
+            parse_allocations += allocations_after_parse - allocations_before_parse;
+            draw_allocations += allocations_after_draw - allocations_after_parse;
+            bytes_parsed += payload.size();
+        }
+
+        // Swap without vsync so the driver does not queue frames unboundedly.
+        BeginDrawing();
+        EndDrawing();
+    }
+    const int64_t measure_us = FrameProfiler::NowMicros() - measure_start_us;
+
+    const SceneRenderer::CullStats cull = scene.Stats();
+    const uint64_t hud_rebuilds = scene.HudRebuilds();
+    const int sprites = scene.Sprites().Loaded();
+    const int threads = jobs.Workers() + 1;
+    const size_t particles = scene.Particles().Live();
+    const uint64_t particles_dropped = scene.Particles().Dropped();
+    jobs.Stop();
+    UnloadRenderTexture(target);
+    scene.Unload();
+    CloseWindow();
+
+    const double frames = static_cast<double>(options.frames);
+    const double parse_allocs = parse_allocations / frames;
+    const double draw_allocs = draw_allocations / frames;
+    // Presented frames over the wall time they took, swaps and all.
+    const double frames_per_second = options.frames > 0 && measure_us > 0 ? frames * 1e6 / measure_us : 0.0;
+    const WorldSnapshot& world = model.Snapshot();
+
+    std::printf("source        %s (%zu payloads, %.1f KiB avg)\n",
+                options.replay_path.empty() ? "synthetic json" : options.replay_path.c_str(), payloads.size(),
+                payload_bytes / 1024.0 / payloads.size());
+    std::printf("world         %dx%d tiles, %zu actors, %zu projectiles\n", world.room_width, world.room_height,
+                world.actors.Size(), world.projectiles.Size());
+    std::printf("shapes        %s, quality level %d\n", scene.InstancedShapes() ? "instanced" : "raylib batch",
+                scene.QualityLevel());
+    std::printf("visible       %d/%d tiles in %d chunks (%d textures), %u/%u entities\n", cull.visible_tiles,
+                cull.room_tiles, cull.visible_chunks, cull.chunk_textures, cull.drawn_entities,
+                cull.drawn_entities + cull.culled_entities);
+    std::printf("hud           %llu rebuilds over %d frames\n", static_cast<unsigned long long>(hud_rebuilds),
+                total_frames);
+    if (!options.sprites_dir.empty()) {
+        std::printf("sprites       %d in the atlas from %s\n", sprites, options.sprites_dir.c_str());
+    }
+    if (particles > 0 || particles_dropped > 0) {
+        std::printf("particles     %zu alive at the end, %llu dropped by the full pool\n", particles,
+                    static_cast<unsigned long long>(particles_dropped));
+    }
+    std::printf("frames        %d measured after %d warmup\n", options.frames, options.warmup);
+    std::printf("parse         mean %8.1f us  p50 %6lld us  p99 %6lld us  %.1f allocs/frame\n", parse.Mean(),
+                static_cast<long long>(parse.Percentile(0.50)), static_cast<long long>(parse.Percentile(0.99)),
+                parse_allocs);
+    std::printf("draw          mean %8.1f us  p50 %6lld us  p99 %6lld us  %.1f allocs/frame\n", draw.Mean(),
+                static_cast<long long>(draw.Percentile(0.50)), static_cast<long long>(draw.Percentile(0.99)),
+                draw_allocs);
+    std::printf("record        mean %8.1f us  p50 %6lld us  p99 %6lld us  on %d thread(s)\n", record.Mean(),
+                static_cast<long long>(record.Percentile(0.50)), static_cast<long long>(record.Percentile(0.99)),
+                threads);
+    std::printf("throughput    %.0f frames/s presented, %.1f MiB/s parsed\n", frames_per_second,
+                parse.Mean() > 0.0 ? bytes_parsed / 1048576.0 / (parse.Mean() * frames / 1e6) : 0.0);
+    PrintMemoryPeaks();
+    if (options.seeks > 0) {
+        Samples seeks;
+        Samples records;
+        if (MeasureSeeks(options.replay_path, options.seeks, seeks, records)) {
+            std::printf("seek          mean %8.1f us  p50 %6lld us  p99 %6lld us  %.1f records applied/seek\n",
+                        seeks.Mean(), static_cast<long long>(seeks.Percentile(0.50)),
+                        static_cast<long long>(seeks.Percentile(0.99)), records.Mean());
+        } else {
+            std::printf("seek          --seeks needs an .rgrp recording\n");
+        }
+    }
+    DecoderRun stream_run;
+    DecoderRun dom_run;
+    const size_t decoder_mismatches = CompareJsonDecoders(payloads, options.frames, stream_run, dom_run);
+    if (!stream_run.micros.values.empty()) {
+        PrintDecoderRun("json stream", stream_run);
+        PrintDecoderRun("json dom", dom_run);
+        if (decoder_mismatches > 0) {
+            std::printf("FAILED        %zu JSON payloads decode differently streamed and through the DOM\n",
+                        decoder_mismatches);
+        }
+    }
+    if (parse_failures > 0) {
+        std::printf("failures      %llu payloads failed to decode\n", static_cast<unsigned long long>(parse_failures));
+    }
+    size_t code_failures = 0;
+    if (!options.compare_json_path.empty()) {
+        std::vector<std::string> twin;
+        size_t pairs = 0;
+        if (!LoadReplay(options.compare_json_path, twin)) {
+            std::printf("FAILED        unable to read %s\n", options.compare_json_path.c_str());
+            code_failures = 1;
+        } else if ((code_failures = CompareCodes(payloads, twin, pairs)) == 0) {
+            std::printf("codes         %zu binary/json pairs agree, a wrong code_table_hash is refused\n", pairs);
+        } else {
+            std::printf("FAILED        %zu code checks over %zu binary/json pairs\n", code_failures, pairs);
+        }
+    }
+    if (deltas_dropped > 0) {
+        std::printf("dropped       %llu deltas did not follow the world (a gap in the recording); draws after them "
+                    "show stale state until the next keyframe\n",
+                    static_cast<unsigned long long>(deltas_dropped));
+    }
+
+    if (!options.csv_path.empty()) {
+        WriteCsv(options.csv_path, options, parse, draw, parse_allocs, draw_allocs, frames_per_second);
+    }
+    // nlohmann's parser keeps a few scratch buffers per parse outside the
+    // arena, so only binary streams reach zero on the parse side.
+    if (options.expect_zero_allocations && parse_allocations + draw_allocations > 0) {
+        std::printf("FAILED        %llu allocations in %d measured frames\n",
+                    static_cast<unsigned long long>(parse_allocations + draw_allocations), options.frames);
+        return 1;
+    }
+    return parse_failures > 0 || decoder_mismatches > 0 || code_failures > 0 ? 1 : 0;
+}
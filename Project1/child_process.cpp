@@ -0,0 +1,297 @@
+#include "child_process.h"
+
+#include <cerrno>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <csignal>
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+#endif
+
+namespace {
+
+constexpr size_t kReadChunk = 4096;
+
+#ifdef _WIN32
+// Quotes one argument the way the MSVC runtime splits a command line:
+// backslashes are literal unless they precede a quote.
+void AppendQuoted(std::string& command_line, const std::string& arg) {
+    if (!command_line.empty()) {
+        command_line += ' ';
+    }
+    if (!arg.empty() && arg.find_first_of(" \t\"") == std::string::npos) {
+        command_line += arg;
+        return;
+    }
+    command_line += '"';
+    size_t backslashes = 0;
+    for (const char c : arg) {
+        if (c == '\\') {
+            ++backslashes;
+            continue;
+        }
+        command_line.append(c == '"' ? backslashes * 2 + 1 : backslashes, '\\');
+        backslashes = 0;
+        command_line += c;
+    }
+    command_line.append(backslashes * 2, '\\');
+    command_line += '"';
+}
+
+void CloseHandleOnce(void*& handle) {
+    if (handle != nullptr) {
+        CloseHandle(handle);
+        handle = nullptr;
+    }
+}
+#else
+void CloseOnce(int& fd) {
+    if (fd >= 0) {
+        close(fd);
+        fd = -1;
+    }
+}
+#endif
+
+}  // namespace
+
+ChildProcess::~ChildProcess() {
+    Wait();
+}
+
+#ifdef _WIN32
+
+bool ChildProcess::Start(const std::vector<std::string>& args) {
+    if (args.empty() || Running()) {
+        return false;
+    }
+    SECURITY_ATTRIBUTES inherit{sizeof(SECURITY_ATTRIBUTES), nullptr, TRUE};
+    HANDLE child_input = nullptr;
+    HANDLE child_output = nullptr;
+    if (!CreatePipe(&child_input, &input_, &inherit, 0)) {
+        return false;
+    }
+    if (!CreatePipe(&output_, &child_output, &inherit, 0)) {
+        CloseHandle(child_input);
+        CloseHandleOnce(input_);
+        return false;
+    }
+    SetHandleInformation(input_, HANDLE_FLAG_INHERIT, 0);
+    SetHandleInformation(output_, HANDLE_FLAG_INHERIT, 0);
+
+    std::string command_line;
+    for (const std::string& arg : args) {
+        AppendQuoted(command_line, arg);
+    }
+    STARTUPINFOA startup{};
+    startup.cb = sizeof(startup);
+    startup.dwFlags = STARTF_USESTDHANDLES;
+    startup.hStdInput = child_input;
+    startup.hStdOutput = child_output;
+    startup.hStdError = GetStdHandle(STD_ERROR_HANDLE);
+    PROCESS_INFORMATION info{};
+    const BOOL started = CreateProcessA(nullptr, command_line.data(), nullptr, nullptr, TRUE, 0, nullptr, nullptr,
+                                        &startup, &info);
+    CloseHandle(child_input);
+    CloseHandle(child_output);
+    if (!started) {
+        CloseHandleOnce(input_);
+        CloseHandleOnce(output_);
+        return false;
+    }
+    CloseHandle(info.hThread);
+    process_ = info.hProcess;
+    buffer_.clear();
+    buffer_start_ = 0;
+    return true;
+}
+
+bool ChildProcess::WriteLine(const std::string& line) {
+    if (input_ == nullptr) {
+        return false;
+    }
+    const std::string data = line + '\n';
+    size_t written = 0;
+    while (written < data.size()) {
+        DWORD count = 0;
+        if (!WriteFile(input_, data.data() + written, static_cast<DWORD>(data.size() - written), &count, nullptr)) {
+            return false;
+        }
+        written += count;
+    }
+    return true;
+}
+
+bool ChildProcess::Fill() {
+    if (output_ == nullptr) {
+        return false;
+    }
+    char chunk[kReadChunk];
+    DWORD count = 0;
+    if (!ReadFile(output_, chunk, sizeof(chunk), &count, nullptr) || count == 0) {
+        return false;  // ERROR_BROKEN_PIPE once the child has exited
+    }
+    buffer_.append(chunk, count);
+    return true;
+}
+
+void ChildProcess::CloseInput() {
+    CloseHandleOnce(input_);
+}
+
+int ChildProcess::Wait() {
+    CloseHandleOnce(input_);
+    CloseHandleOnce(output_);
+    if (process_ == nullptr) {
+        return -1;
+    }
+    WaitForSingleObject(process_, INFINITE);
+    DWORD code = 0;
+    const bool exited = GetExitCodeProcess(process_, &code) != 0;
+    CloseHandleOnce(process_);
+    return exited ? static_cast<int>(code) : -1;
+}
+
+bool ChildProcess::Running() const {
+    return process_ != nullptr;
+}
+
+#else
+
+bool ChildProcess::Start(const std::vector<std::string>& args) {
+    if (args.empty() || Running()) {
+        return false;
+    }
+    // A child that dies mid-batch must fail WriteLine, not kill the driver.
+    std::signal(SIGPIPE, SIG_IGN);
+
+    int child_input[2];
+    int child_output[2];
+    if (pipe(child_input) != 0) {
+        return false;
+    }
+    if (pipe(child_output) != 0) {
+        close(child_input[0]);
+        close(child_input[1]);
+        return false;
+    }
+    // dup2 in the child clears the flag on its stdin and stdout only.
+    for (const int fd : {child_input[0], child_input[1], child_output[0], child_output[1]}) {
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+    }
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, child_input[0], STDIN_FILENO);
+    posix_spawn_file_actions_adddup2(&actions, child_output[1], STDOUT_FILENO);
+    std::vector<char*> argv;
+    argv.reserve(args.size() + 1);
+    for (const std::string& arg : args) {
+        argv.push_back(const_cast<char*>(arg.c_str()));
+    }
+    argv.push_back(nullptr);
+    pid_t pid = -1;
+    const int error = posix_spawnp(&pid, argv[0], &actions, nullptr, argv.data(), environ);
+    posix_spawn_file_actions_destroy(&actions);
+    close(child_input[0]);
+    close(child_output[1]);
+    if (error != 0) {
+        close(child_input[1]);
+        close(child_output[0]);
+        return false;
+    }
+    pid_ = pid;
+    input_ = child_input[1];
+    output_ = child_output[0];
+    buffer_.clear();
+    buffer_start_ = 0;
+    return true;
+}
+
+bool ChildProcess::WriteLine(const std::string& line) {
+    if (input_ < 0) {
+        return false;
+    }
+    const std::string data = line + '\n';
+    size_t written = 0;
+    while (written < data.size()) {
+        const ssize_t count = write(input_, data.data() + written, data.size() - written);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0) {
+            return false;
+        }
+        written += static_cast<size_t>(count);
+    }
+    return true;
+}
+
+bool ChildProcess::Fill() {
+    if (output_ < 0) {
+        return false;
+    }
+    char chunk[kReadChunk];
+    ssize_t count;
+    do {
+        count = read(output_, chunk, sizeof(chunk));
+    } while (count < 0 && errno == EINTR);
+    if (count <= 0) {
+        return false;
+    }
+    buffer_.append(chunk, static_cast<size_t>(count));
+    return true;
+}
+
+void ChildProcess::CloseInput() {
+    CloseOnce(input_);
+}
+
+int ChildProcess::Wait() {
+    CloseOnce(input_);
+    CloseOnce(output_);
+    if (pid_ < 0) {
+        return -1;
+    }
+    int status = 0;
+    pid_t result;
+    do {
+        result = waitpid(pid_, &status, 0);
+    } while (result < 0 && errno == EINTR);
+    pid_ = -1;
+    return result >= 0 && WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+bool ChildProcess::Running() const {
+    return pid_ >= 0;
+}
+
+#endif
+
+bool ChildProcess::ReadLine(std::string& line) {
+    size_t end;
+    while ((end = buffer_.find('\n', buffer_start_)) == std::string::npos) {
+        if (!Fill()) {
+            return false;  // a trailing line without '\n' is a truncated result; drop it
+        }
+    }
+    size_t length = end - buffer_start_;
+    if (length > 0 && buffer_[end - 1] == '\r') {
+        --length;  // text-mode stdout on Windows
+    }
+    line.assign(buffer_, buffer_start_, length);
+    buffer_start_ = end + 1;
+    if (buffer_start_ == buffer_.size()) {
+        buffer_.clear();
+        buffer_start_ = 0;
+    }
+    return true;
+}
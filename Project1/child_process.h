@@ -0,0 +1,51 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// A child process that talks to this one over a line protocol: its stdin and
+// stdout are pipes owned by the ChildProcess, its stderr is ours. One thread
+// at a time may use a ChildProcess. Start children from one thread: the
+// pipes are made uninheritable right after they are created, and a child
+// started by another thread in between would inherit them and keep a
+// sibling's stdin open past CloseInput.
+class ChildProcess {
+public:
+    ChildProcess() = default;
+    ~ChildProcess();
+    ChildProcess(const ChildProcess&) = delete;
+    ChildProcess& operator=(const ChildProcess&) = delete;
+
+    // args[0] is looked up on PATH. False if the pipes or the process could
+    // not be created.
+    bool Start(const std::vector<std::string>& args);
+
+    // Appends '\n'. False once the child has stopped reading.
+    bool WriteLine(const std::string& line);
+    // Blocks for the next line, without its line ending. False at end of
+    // output (the child exited or closed stdout).
+    bool ReadLine(std::string& line);
+
+    // Sends end of input; a child reading until EOF then finishes.
+    void CloseInput();
+    // Closes both pipes and waits for the child. Its exit code, or -1 if it
+    // was never started or did not exit normally.
+    int Wait();
+
+    bool Running() const;
+
+private:
+    bool Fill();
+
+#ifdef _WIN32
+    void* process_ = nullptr;
+    void* input_ = nullptr;   // our end of the child's stdin
+    void* output_ = nullptr;  // our end of the child's stdout
+#else
+    int pid_ = -1;
+    int input_ = -1;
+    int output_ = -1;
+#endif
+    std::string buffer_;  // read but not yet returned
+    size_t buffer_start_ = 0;
+};
@@ -0,0 +1,201 @@
+"""Batched collision queries for the simulation.
+
+``open_collision_world`` returns the native ``rogue_native.CollisionWorld``
+(a uniform-grid spatial hash, the room's solid mask and a flow field towards
+the player, see ``rogue_native_module.cpp``) when the extension is built, and the pure-Python
+``PyCollisionWorld`` otherwise. Both answer whole batches per call and give
+identical results, so game rules never depend on which one is loaded. The
+native projectile kernel uses AVX when built with ``ROGUE_NATIVE_AVX=1``,
+otherwise SSE2 (``rogue_native.KERNEL_ISA`` says which).
+
+    python setup.py build_ext --inplace
+"""
+
+from __future__ import annotations
+
+import heapq
+import logging
+import math
+from typing import Dict, List, Sequence, Tuple, Union
+
+logger = logging.getLogger(__name__)
+
+Radii = Union[float, Sequence[float]]
+
+# Flow-field neighbours as (dx, dy, cost), in FlowField::kStepX/kStepY order:
+# ties between equally short steps go to the earlier one.
+FLOW_STEPS = ((1, 0, 10), (-1, 0, 10), (0, 1, 10), (0, -1, 10), (1, 1, 14), (-1, 1, 14), (1, -1, 14), (-1, -1, 14))
+
+
+def _expand(radii: Radii, count: int) -> Sequence[float]:
+    if isinstance(radii, (int, float)):
+        return [float(radii)] * count
+    if len(radii) != count:
+        raise ValueError(f"radii has {len(radii)} entries, expected {count}")
+    return radii
+
+
+class PyCollisionWorld:
+    """Same API in pure Python, with a dict of unit cells as the spatial hash."""
+
+    def __init__(self, width: int, height: int, solid: bytes) -> None:
+        self.set_tiles(width, height, solid)
+        self.build_circles([], [], 0.0)
+        self._flow_width = 0
+        self._flow_height = 0
+        self._flow_steps: List[int] = []
+
+    def set_tiles(self, width: int, height: int, solid: bytes) -> None:
+        if len(solid) != width * height:
+            raise ValueError(f"solid has {len(solid)} bytes, expected {width * height} (width * height)")
+        self.width = width
+        self.height = height
+        self.solid = bytes(solid)
+
+    def _solid(self, x: float, y: float) -> bool:
+        xi = max(0, min(self.width - 1, int(x)))
+        yi = max(0, min(self.height - 1, int(y)))
+        return self.solid[yi * self.width + xi] != 0
+
+    def solid_at(self, xs: Sequence[float], ys: Sequence[float]) -> List[bool]:
+        return [self._solid(x, y) for x, y in zip(xs, ys)]
+
+    def walkable(self, xs: Sequence[float], ys: Sequence[float], radii: Radii) -> List[bool]:
+        solid, width = self.solid, self.width
+        last_x, last_y = self.width - 1, self.height - 1
+        result: List[bool] = []
+        for x, y, r in zip(xs, ys, _expand(radii, len(xs))):
+            left = max(0, min(last_x, int(x - r)))
+            right = max(0, min(last_x, int(x + r)))
+            top = max(0, min(last_y, int(y - r))) * width
+            bottom = max(0, min(last_y, int(y + r))) * width
+            result.append(not (solid[top + left] or solid[top + right] or solid[bottom + left] or solid[bottom + right]))
+        return result
+
+    def build_circles(self, xs: Sequence[float], ys: Sequence[float], radii: Radii) -> None:
+        self._circles = list(zip(xs, ys, _expand(radii, len(xs))))
+        self._max_radius = max((r for _, _, r in self._circles), default=0.0)
+        self._cells: Dict[Tuple[int, int], List[int]] = {}
+        for index, (x, y, _) in enumerate(self._circles):
+            self._cells.setdefault((math.floor(x), math.floor(y)), []).append(index)
+
+    def first_overlaps(self, xs: Sequence[float], ys: Sequence[float], radii: Radii) -> List[int]:
+        hits: List[int] = []
+        for x, y, r in zip(xs, ys, _expand(radii, len(xs))):
+            reach = r + self._max_radius
+            best = len(self._circles)
+            for cy in range(math.floor(y - reach), math.floor(y + reach) + 1):
+                for cx in range(math.floor(x - reach), math.floor(x + reach) + 1):
+                    for index in self._cells.get((cx, cy), ()):
+                        if index >= best:
+                            break
+                        ox, oy, orad = self._circles[index]
+                        if math.hypot(ox - x, oy - y) < r + orad:
+                            best = index
+                            break
+            hits.append(best if best < len(self._circles) else -1)
+        return hits
+
+    def build_flow_field(self, goal_x: int, goal_y: int) -> None:
+        width, height, solid = self.width, self.height, self.solid
+
+        def is_open(x: int, y: int) -> bool:
+            return 0 <= x < width and 0 <= y < height and not solid[y * width + x]
+
+        def can_step(x: int, y: int, dx: int, dy: int) -> bool:
+            # Diagonals may not cut the corner of a solid tile.
+            return is_open(x + dx, y + dy) and (dx == 0 or dy == 0 or (is_open(x + dx, y) and is_open(x, y + dy)))
+
+        self._flow_width, self._flow_height = width, height
+        distance: List[Union[int, None]] = [None] * (width * height)
+        steps = [-1] * (width * height)
+        self._flow_steps = steps
+        if not is_open(goal_x, goal_y):
+            return
+        goal = goal_y * width + goal_x
+        distance[goal] = 0
+        frontier = [(0, goal)]
+        while frontier:
+            dist, index = heapq.heappop(frontier)
+            if dist != distance[index]:
+                continue
+            x, y = index % width, index // width
+            for dx, dy, cost in FLOW_STEPS:
+                if not can_step(x, y, dx, dy):
+                    continue
+                neighbour = (y + dy) * width + x + dx
+                best = distance[neighbour]
+                if best is None or dist + cost < best:
+                    distance[neighbour] = dist + cost
+                    heapq.heappush(frontier, (dist + cost, neighbour))
+
+        for index, own in enumerate(distance):
+            if not own:
+                continue
+            x, y = index % width, index // width
+            best = None
+            for step, (dx, dy, cost) in enumerate(FLOW_STEPS):
+                if not can_step(x, y, dx, dy):
+                    continue
+                through = distance[(y + dy) * width + x + dx]
+                if through is not None and (best is None or through + cost < best):
+                    best = through + cost
+                    steps[index] = step
+
+    def flow_directions(self, xs: Sequence[float], ys: Sequence[float]) -> List[Tuple[float, float]]:
+        width, height, steps = self._flow_width, self._flow_height, self._flow_steps
+        result: List[Tuple[float, float]] = []
+        for x, y in zip(xs, ys):
+            if not steps:
+                result.append((0.0, 0.0))
+                continue
+            tile_x = max(0, min(width - 1, int(x)))
+            tile_y = max(0, min(height - 1, int(y)))
+            step = steps[tile_y * width + tile_x]
+            if step < 0:
+                result.append((0.0, 0.0))
+                continue
+            dx, dy, _ = FLOW_STEPS[step]
+            to_x = (tile_x + dx) + 0.5 - x
+            to_y = (tile_y + dy) + 0.5 - y
+            length = math.sqrt(to_x * to_x + to_y * to_y)
+            result.append((to_x / length, to_y / length) if length > 0.0 else (0.0, 0.0))
+        return result
+
+    def step_projectiles(self, x, y, vx, vy, ttl, radius, dt: float) -> Tuple[List[int], List[Tuple[int, float, float]]]:
+        removed: List[int] = []
+        impacts: List[Tuple[int, float, float]] = []
+        kept = 0
+        for row in range(len(x)):
+            nx = x[row] + vx[row] * dt
+            ny = y[row] + vy[row] * dt
+            left = ttl[row] - dt
+            if not left > 0:
+                removed.append(row)
+                continue
+            if self._solid(nx, ny):
+                removed.append(row)
+                impacts.append((row, nx, ny))
+                continue
+            x[kept], y[kept], vx[kept], vy[kept] = nx, ny, vx[row], vy[row]
+            ttl[kept], radius[kept] = left, radius[row]
+            kept += 1
+        return removed, impacts
+
+
+def solid_mask(room: Dict, solid_tiles: Sequence[str]) -> bytes:
+    """Row-major byte per tile, 1 where ``room["tiles"]`` holds a solid tile."""
+    return bytes(1 if tile in solid_tiles else 0 for row in room["tiles"] for tile in row)
+
+
+def open_collision_world(room: Dict, solid_tiles: Sequence[str], native: bool = True):
+    mask = solid_mask(room, solid_tiles)
+    if native:
+        try:
+            import rogue_native
+        except ImportError:
+            logger.info("rogue_native is not built; using Python collision queries")
+        else:
+            logger.info("native collision queries (%s projectile kernel)", rogue_native.KERNEL_ISA)
+            return rogue_native.CollisionWorld(room["width"], room["height"], mask)
+    return PyCollisionWorld(room["width"], room["height"], mask)
@@ -0,0 +1,200 @@
+#include "config_loader.h"
+
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+using json = nlohmann::json;
+
+namespace {
+
+struct ConfigLine {
+    int indent = 0;
+    int number = 0;
+    std::string text;
+};
+
+std::string Trim(const std::string& value) {
+    size_t begin = 0;
+    size_t end = value.size();
+    while (begin < end && std::isspace(static_cast<unsigned char>(value[begin]))) ++begin;
+    while (end > begin && std::isspace(static_cast<unsigned char>(value[end - 1]))) --end;
+    return value.substr(begin, end - begin);
+}
+
+std::string StripComment(const std::string& line) {
+    char quote = 0;
+    for (size_t i = 0; i < line.size(); ++i) {
+        const char c = line[i];
+        if (quote) {
+            if (c == quote) quote = 0;
+        } else if (c == '"' || c == '\'') {
+            quote = c;
+        } else if (c == '#' && (i == 0 || std::isspace(static_cast<unsigned char>(line[i - 1])))) {
+            return line.substr(0, i);
+        }
+    }
+    return line;
+}
+
+[[noreturn]] void Fail(const ConfigLine& line, const std::string& what) {
+    throw std::runtime_error("config line " + std::to_string(line.number) + ": " + what);
+}
+
+json ParseScalar(const std::string& raw) {
+    const std::string value = Trim(raw);
+    if (value.empty() || value == "~" || value == "null" || value == "Null" || value == "NULL") {
+        return nullptr;
+    }
+    if (value.size() >= 2 && (value.front() == '"' || value.front() == '\'') && value.back() == value.front()) {
+        return value.substr(1, value.size() - 2);
+    }
+    if (value == "true" || value == "True" || value == "TRUE") return true;
+    if (value == "false" || value == "False" || value == "FALSE") return false;
+    if (value.front() == '[' && value.back() == ']') {
+        json list = json::array();
+        const std::string inner = Trim(value.substr(1, value.size() - 2));
+        if (inner.empty()) {
+            return list;
+        }
+        std::stringstream items(inner);
+        std::string item;
+        while (std::getline(items, item, ',')) {
+            list.push_back(ParseScalar(item));
+        }
+        return list;
+    }
+
+    char* end = nullptr;
+    const long long integer = std::strtoll(value.c_str(), &end, 10);
+    if (end && *end == '\0') {
+        return integer;
+    }
+    const double real = std::strtod(value.c_str(), &end);
+    if (end && *end == '\0') {
+        return real;
+    }
+    return value;
+}
+
+bool IsSequenceItem(const std::string& text) {
+    return text == "-" || (text.size() > 1 && text[0] == '-' && text[1] == ' ');
+}
+
+size_t FindKeySeparator(const std::string& text) {
+    char quote = 0;
+    for (size_t i = 0; i < text.size(); ++i) {
+        const char c = text[i];
+        if (quote) {
+            if (c == quote) quote = 0;
+        } else if (c == '"' || c == '\'') {
+            quote = c;
+        } else if (c == ':' && (i + 1 == text.size() || text[i + 1] == ' ')) {
+            return i;
+        }
+    }
+    return std::string::npos;
+}
+
+json ParseBlock(const std::vector<ConfigLine>& lines, size_t& index, int indent);
+
+json ParseNested(const std::vector<ConfigLine>& lines, size_t& index, int parent_indent) {
+    if (index >= lines.size()) {
+        return nullptr;
+    }
+    const ConfigLine& next = lines[index];
+    if (next.indent > parent_indent || (next.indent == parent_indent && IsSequenceItem(next.text))) {
+        return ParseBlock(lines, index, next.indent);
+    }
+    return nullptr;
+}
+
+json ParseBlock(const std::vector<ConfigLine>& lines, size_t& index, int indent) {
+    if (IsSequenceItem(lines[index].text)) {
+        json list = json::array();
+        while (index < lines.size() && lines[index].indent == indent && IsSequenceItem(lines[index].text)) {
+            const ConfigLine& line = lines[index++];
+            const std::string item = Trim(line.text.substr(1));
+            if (item.empty()) {
+                list.push_back(ParseNested(lines, index, indent));
+            } else if (FindKeySeparator(item) != std::string::npos) {
+                Fail(line, "mappings inside sequences are not supported");
+            } else {
+                list.push_back(ParseScalar(item));
+            }
+        }
+        return list;
+    }
+
+    json mapping = json::object();
+    while (index < lines.size() && lines[index].indent == indent && !IsSequenceItem(lines[index].text)) {
+        const ConfigLine& line = lines[index++];
+        const size_t separator = FindKeySeparator(line.text);
+        if (separator == std::string::npos) {
+            Fail(line, "expected 'key: value'");
+        }
+        std::string key = Trim(line.text.substr(0, separator));
+        if (key.size() >= 2 && (key.front() == '"' || key.front() == '\'') && key.back() == key.front()) {
+            key = key.substr(1, key.size() - 2);
+        }
+        const std::string rest = Trim(line.text.substr(separator + 1));
+        mapping[key] = rest.empty() ? ParseNested(lines, index, indent) : ParseScalar(rest);
+    }
+    if (index < lines.size() && lines[index].indent > indent) {
+        Fail(lines[index], "unexpected indentation");
+    }
+    return mapping;
+}
+
+}  // namespace
+
+json ParseConfigText(const std::string& text) {
+    std::vector<ConfigLine> lines;
+    std::stringstream stream(text);
+    std::string raw;
+    int number = 0;
+    while (std::getline(stream, raw)) {
+        ++number;
+        if (!raw.empty() && raw.back() == '\r') {
+            raw.pop_back();
+        }
+        const std::string content = StripComment(raw);
+        const std::string trimmed = Trim(content);
+        if (trimmed.empty() || trimmed == "---") {
+            continue;
+        }
+        ConfigLine line;
+        line.number = number;
+        line.text = trimmed;
+        while (line.indent < static_cast<int>(content.size()) && content[line.indent] == ' ') {
+            ++line.indent;
+        }
+        if (content[line.indent] == '\t') {
+            Fail(line, "tabs are not allowed for indentation");
+        }
+        lines.push_back(std::move(line));
+    }
+
+    if (lines.empty()) {
+        return json::object();
+    }
+    size_t index = 0;
+    json root = ParseBlock(lines, index, lines.front().indent);
+    if (index < lines.size()) {
+        Fail(lines[index], "unexpected content");
+    }
+    return root;
+}
+
+json LoadConfigFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("unable to open " + path);
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    return ParseConfigText(buffer.str());
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <nlohmann/json.hpp>
+#include <string>
+
+// Loads the subset of YAML used by game_config.yaml (nested block mappings,
+// block/flow sequences of scalars, comments) into a json object so the renderer
+// reads the same file as the Python simulation. Throws std::runtime_error on
+// malformed input.
+nlohmann::json LoadConfigFile(const std::string& path);
+nlohmann::json ParseConfigText(const std::string& text);
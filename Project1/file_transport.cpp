@@ -0,0 +1,56 @@
+#include "file_transport.h"
+
+#include <fstream>
+#include <iterator>
+
+namespace fs = std::filesystem;
+
+FileTransport::FileTransport(fs::path shared_dir)
+    : state_path_(shared_dir / "game_state.json"),
+      input_path_(shared_dir / "input.json") {}
+
+bool FileTransport::Open() {
+    return true;
+}
+
+void FileTransport::Close() {}
+
+bool FileTransport::ReadLatest(SnapshotPayload& payload) {
+    std::ifstream file(state_path_, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    payload.bytes.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    if (payload.bytes.empty()) {
+        return false;
+    }
+    payload.sequence = ++sequence_;
+    return true;
+}
+
+bool FileTransport::ReadNext(SnapshotPayload& payload) {
+    std::error_code error;
+    const fs::file_time_type write_time = fs::last_write_time(state_path_, error);
+    if (error) {
+        return false;
+    }
+    const std::uintmax_t size = fs::file_size(state_path_, error);
+    if (error || (write_time == last_write_time_ && size == last_size_)) {
+        return false;
+    }
+    if (!ReadLatest(payload)) {
+        return false;
+    }
+    last_write_time_ = write_time;
+    last_size_ = size;
+    return true;
+}
+
+bool FileTransport::WriteInput(const std::string& payload) {
+    std::ofstream file(input_path_, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        return false;
+    }
+    file << payload;
+    return true;
+}
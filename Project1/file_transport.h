@@ -0,0 +1,27 @@
+#pragma once
+
+#include "state_transport.h"
+
+#include <filesystem>
+
+// Debug fallback: polls shared/game_state.json and rewrites shared/input.json.
+class FileTransport : public StateTransport {
+public:
+    explicit FileTransport(std::filesystem::path shared_dir);
+
+    bool Open() override;
+    void Close() override;
+    bool ReadLatest(SnapshotPayload& payload) override;
+    // Only the newest snapshot is on disk. It is returned once per change,
+    // detected from the file's write time and size without opening it.
+    bool ReadNext(SnapshotPayload& payload) override;
+    bool WriteInput(const std::string& payload) override;
+    const char* Name() const override { return "file"; }
+
+private:
+    std::filesystem::path state_path_;
+    std::filesystem::path input_path_;
+    std::filesystem::file_time_type last_write_time_{};
+    std::uintmax_t last_size_ = 0;
+    uint64_t sequence_ = 0;
+};
@@ -0,0 +1,155 @@
+"""Tells the simulation when ``game_config.yaml`` changed, from OS notifications."""
+
+from __future__ import annotations
+
+import ctypes
+import ctypes.util
+import logging
+import os
+import struct
+import sys
+import time
+from pathlib import Path
+from typing import Optional
+
+logger = logging.getLogger(__name__)
+
+SETTLE_SECONDS = 0.2  # quiet time before a change is reported, as FileWatcher::kSettleMicros
+
+# inotify(7)
+_IN_MODIFY = 0x00000002
+_IN_CLOSE_WRITE = 0x00000008
+_IN_MOVED_FROM = 0x00000040
+_IN_MOVED_TO = 0x00000080
+_IN_CREATE = 0x00000100
+_IN_DELETE = 0x00000200
+_IN_Q_OVERFLOW = 0x00004000
+_IN_NONBLOCK = os.O_NONBLOCK if hasattr(os, "O_NONBLOCK") else 0o4000
+_IN_CLOEXEC = 0o2000000
+_INOTIFY_EVENT = struct.Struct("iIII")  # wd, mask, cookie, len; the name follows
+
+# FindFirstChangeNotificationW
+_FILE_NOTIFY_CHANGE_FILE_NAME = 0x00000001
+_FILE_NOTIFY_CHANGE_SIZE = 0x00000008
+_FILE_NOTIFY_CHANGE_LAST_WRITE = 0x00000010
+_WAIT_OBJECT_0 = 0
+
+
+class FileWatcher:
+    """Reports changes to one file without polling the filesystem.
+
+    The file's directory is watched (inotify on Linux, a change notification
+    handle on Windows), so an editor that saves by renaming a new file over the
+    old one is still seen. ``changed`` is non-blocking: it drains what the OS
+    queued and answers True once a change has been quiet for
+    ``SETTLE_SECONDS``, so a save made of several writes is one change. On
+    other platforms nothing is watched and ``changed`` is always False.
+    """
+
+    def __init__(self, path: Path) -> None:
+        self.path = Path(path).resolve()
+        self._pending_since: Optional[float] = None
+        self._inotify: Optional[int] = None
+        self._handle: Optional[int] = None
+        self._signature = self._stat()
+        if sys.platform.startswith("linux"):
+            self._open_inotify()
+        elif sys.platform == "win32":
+            self._open_windows()
+        else:
+            logger.info("change notifications are not available here; %s is not watched", self.path)
+
+    @property
+    def active(self) -> bool:
+        return self._inotify is not None or self._handle is not None
+
+    def changed(self) -> bool:
+        now = time.perf_counter()
+        if self._drain():
+            self._pending_since = now
+        if self._pending_since is None or now - self._pending_since < SETTLE_SECONDS:
+            return False
+        self._pending_since = None
+        # A directory notification on Windows may be another file's.
+        signature = self._stat()
+        if self._handle is not None and signature == self._signature:
+            return False
+        self._signature = signature
+        return True
+
+    def close(self) -> None:
+        if self._inotify is not None:
+            os.close(self._inotify)
+            self._inotify = None
+        if self._handle is not None:
+            self._kernel32.FindCloseChangeNotification(self._handle)
+            self._handle = None
+
+    def _stat(self):
+        try:
+            stat = self.path.stat()
+        except OSError:
+            return None
+        return (stat.st_mtime_ns, stat.st_size)
+
+    def _open_inotify(self) -> None:
+        libc = ctypes.CDLL(ctypes.util.find_library("c") or None, use_errno=True)
+        fd = libc.inotify_init1(_IN_NONBLOCK | _IN_CLOEXEC)
+        if fd < 0:
+            logger.warning("unable to watch %s: inotify_init1 failed (errno %d)", self.path, ctypes.get_errno())
+            return
+        # IN_MODIFY too, as FileWatcher does: a writer that never closes the file.
+        mask = _IN_MODIFY | _IN_CLOSE_WRITE | _IN_CREATE | _IN_DELETE | _IN_MOVED_FROM | _IN_MOVED_TO
+        if libc.inotify_add_watch(fd, os.fsencode(self.path.parent), mask) < 0:
+            logger.warning("unable to watch %s (errno %d)", self.path, ctypes.get_errno())
+            os.close(fd)
+            return
+        self._inotify = fd
+
+    def _open_windows(self) -> None:
+        kernel32 = ctypes.WinDLL("kernel32", use_last_error=True)
+        kernel32.FindFirstChangeNotificationW.restype = ctypes.c_void_p
+        kernel32.FindFirstChangeNotificationW.argtypes = [ctypes.c_wchar_p, ctypes.c_int, ctypes.c_uint32]
+        kernel32.FindNextChangeNotification.argtypes = [ctypes.c_void_p]
+        kernel32.FindCloseChangeNotification.argtypes = [ctypes.c_void_p]
+        kernel32.WaitForSingleObject.argtypes = [ctypes.c_void_p, ctypes.c_uint32]
+        kernel32.WaitForSingleObject.restype = ctypes.c_uint32
+        flags = _FILE_NOTIFY_CHANGE_FILE_NAME | _FILE_NOTIFY_CHANGE_SIZE | _FILE_NOTIFY_CHANGE_LAST_WRITE
+        handle = kernel32.FindFirstChangeNotificationW(str(self.path.parent), False, flags)
+        if handle is None or handle == ctypes.c_void_p(-1).value:
+            logger.warning("unable to watch %s (error %d)", self.path, ctypes.get_last_error())
+            return
+        self._kernel32 = kernel32
+        self._handle = handle
+
+    def _drain(self) -> bool:
+        """True if the OS reported a change to the file since the last call."""
+        if self._inotify is not None:
+            return self._drain_inotify()
+        if self._handle is not None:
+            seen = False
+            while self._kernel32.WaitForSingleObject(self._handle, 0) == _WAIT_OBJECT_0:
+                seen = True
+                if not self._kernel32.FindNextChangeNotification(self._handle):
+                    break
+            return seen
+        return False
+
+    def _drain_inotify(self) -> bool:
+        seen = False
+        name = os.fsencode(self.path.name)
+        while True:
+            try:
+                data = os.read(self._inotify, 4096)
+            except BlockingIOError:
+                return seen
+            if not data:
+                return seen
+            offset = 0
+            while offset < len(data):
+                _wd, mask, _cookie, length = _INOTIFY_EVENT.unpack_from(data, offset)
+                offset += _INOTIFY_EVENT.size
+                event_name = data[offset:offset + length].rstrip(b"\0")
+                offset += length
+                if mask & _IN_Q_OVERFLOW or event_name == name:
+                    seen = True
@@ -0,0 +1,278 @@
+#include "file_watcher.h"
+
+#include "frame_profiler.h"
+#include "raylib.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <system_error>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#elif defined(__linux__)
+#include <cerrno>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+#ifdef _WIN32
+
+struct FileWatcher::Native {
+    HANDLE directory = INVALID_HANDLE_VALUE;
+    HANDLE event = nullptr;
+    OVERLAPPED overlapped{};
+    bool pending = false;  // a read is outstanding on overlapped
+    bool recursive = false;
+    std::wstring name;
+    alignas(DWORD) unsigned char buffer[16 * 1024];
+
+    bool Issue() {
+        overlapped = OVERLAPPED{};
+        overlapped.hEvent = event;
+        pending = ReadDirectoryChangesW(directory, buffer, sizeof(buffer), recursive,
+                                        FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_DIR_NAME |
+                                            FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_SIZE,
+                                        nullptr, &overlapped, nullptr) != 0;
+        return pending;
+    }
+
+    // True if the notifications in buffer touch the watched file (or
+    // anything, for a directory). bytes 0 means the buffer overflowed.
+    bool Matches(DWORD bytes) const {
+        if (name.empty() || bytes == 0) {
+            return true;
+        }
+        const unsigned char* cursor = buffer;
+        for (;;) {
+            const auto* info = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(cursor);
+            const int length = static_cast<int>(info->FileNameLength / sizeof(WCHAR));
+            if (CompareStringOrdinal(info->FileName, length, name.c_str(), static_cast<int>(name.size()), TRUE) ==
+                CSTR_EQUAL) {
+                return true;
+            }
+            if (info->NextEntryOffset == 0) {
+                return false;
+            }
+            cursor += info->NextEntryOffset;
+        }
+    }
+
+    ~Native() {
+        if (pending) {
+            CancelIoEx(directory, &overlapped);
+            DWORD bytes = 0;
+            GetOverlappedResult(directory, &overlapped, &bytes, TRUE);
+        }
+        if (directory != INVALID_HANDLE_VALUE) {
+            CloseHandle(directory);
+        }
+        if (event != nullptr) {
+            CloseHandle(event);
+        }
+    }
+};
+
+#else
+
+struct FileWatcher::Native {};
+
+#endif
+
+namespace {
+
+#ifdef __linux__
+// IN_MODIFY as well as IN_CLOSE_WRITE: a writer that keeps the file open, or
+// writes through a mapping, never closes it. The settle period folds a burst
+// of modifications into one change.
+constexpr uint32_t kInotifyMask =
+    IN_MODIFY | IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO;
+#endif
+
+}  // namespace
+
+FileWatcher::FileWatcher() = default;
+
+FileWatcher::~FileWatcher() {
+    Clear();
+#ifdef __linux__
+    if (inotify_ >= 0) {
+        close(inotify_);
+    }
+#endif
+}
+
+int FileWatcher::Add(const std::string& path) {
+    std::error_code error;
+    const fs::path target = fs::absolute(path, error);
+    if (error || watches_.size() >= static_cast<size_t>(kMaxWatches)) {
+        return -1;
+    }
+    const bool directory = fs::is_directory(target, error);
+    const fs::path parent = directory ? target : target.parent_path();
+    if (!fs::is_directory(parent, error)) {
+        return -1;
+    }
+    Watch watch;
+    if (!directory) {
+        watch.name = target.filename().string();
+    }
+    const int index = static_cast<int>(watches_.size());
+
+#ifdef _WIN32
+    auto native = std::make_unique<Native>();
+    native->recursive = directory;
+    native->name = directory ? std::wstring() : target.filename().wstring();
+    native->directory = CreateFileW(parent.wstring().c_str(), FILE_LIST_DIRECTORY,
+                                    FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+                                    FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+    native->event = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    if (native->directory == INVALID_HANDLE_VALUE || native->event == nullptr || !native->Issue()) {
+        TraceLog(LOG_WARNING, "Unable to watch %s for changes (error %lu)", path.c_str(), GetLastError());
+        return -1;
+    }
+    watch.native = std::move(native);
+#elif defined(__linux__)
+    if (inotify_ < 0) {
+        inotify_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (inotify_ < 0) {
+            TraceLog(LOG_WARNING, "Unable to watch files for changes: inotify_init1 failed (errno %d)", errno);
+            return -1;
+        }
+    }
+    // inotify is not recursive: a directory tree gets a descriptor per
+    // directory, and Drain adds the ones created or moved in later.
+    if (directory) {
+        WatchTree(parent.string(), index);
+    } else {
+        const int wd = inotify_add_watch(inotify_, parent.c_str(), kInotifyMask);
+        if (wd < 0) {
+            TraceLog(LOG_WARNING, "Unable to watch %s for changes (errno %d)", parent.c_str(), errno);
+        } else {
+            descriptors_.push_back({wd, index, std::string()});
+        }
+    }
+#else
+    TraceLog(LOG_INFO, "Change notifications are not available here; %s is not watched", path.c_str());
+    return -1;
+#endif
+
+    watches_.push_back(std::move(watch));
+    return index;
+}
+
+#ifdef __linux__
+void FileWatcher::WatchTree(const std::string& root, int watch) {
+    std::error_code error;
+    std::vector<fs::path> directories{root};
+    for (fs::recursive_directory_iterator it(root, error), end; !error && it != end; it.increment(error)) {
+        if (it->is_directory(error)) {
+            directories.push_back(it->path());
+        }
+    }
+    for (const fs::path& watched : directories) {
+        const int wd = inotify_add_watch(inotify_, watched.c_str(), kInotifyMask);
+        if (wd < 0) {
+            TraceLog(LOG_WARNING, "Unable to watch %s for changes (errno %d)", watched.c_str(), errno);
+            continue;
+        }
+        // A directory moved within the tree keeps its descriptor; only its
+        // path changes.
+        auto known = std::find_if(descriptors_.begin(), descriptors_.end(), [&](const Descriptor& descriptor) {
+            return descriptor.wd == wd && descriptor.watch == watch;
+        });
+        if (known != descriptors_.end()) {
+            known->path = watched.string();
+        } else {
+            descriptors_.push_back({wd, watch, watched.string()});
+        }
+    }
+}
+#endif
+
+void FileWatcher::Clear() {
+#ifdef __linux__
+    for (const Descriptor& descriptor : descriptors_) {
+        inotify_rm_watch(inotify_, descriptor.wd);
+    }
+#endif
+    descriptors_.clear();
+    watches_.clear();
+}
+
+uint32_t FileWatcher::Poll() {
+    if (watches_.empty()) {
+        return 0;
+    }
+    const int64_t now_us = FrameProfiler::NowMicros();
+    Drain(now_us);
+    uint32_t changed = 0;
+    for (size_t i = 0; i < watches_.size(); ++i) {
+        Watch& watch = watches_[i];
+        if (watch.changed_us != 0 && now_us - watch.changed_us >= kSettleMicros) {
+            watch.changed_us = 0;
+            changed |= 1u << i;
+        }
+    }
+    return changed;
+}
+
+void FileWatcher::Drain(int64_t now_us) {
+#ifdef _WIN32
+    for (Watch& watch : watches_) {
+        Native& native = *watch.native;
+        DWORD bytes = 0;
+        while (native.pending) {
+            if (!GetOverlappedResult(native.directory, &native.overlapped, &bytes, FALSE)) {
+                if (GetLastError() != ERROR_IO_INCOMPLETE) {
+                    // The directory went away; report it once, then stay quiet.
+                    native.pending = false;
+                    watch.changed_us = now_us;
+                }
+                break;
+            }
+            if (native.Matches(bytes)) {
+                watch.changed_us = now_us;
+            }
+            native.Issue();
+        }
+    }
+#elif defined(__linux__)
+    alignas(inotify_event) char buffer[4096];
+    for (;;) {
+        const ssize_t length = read(inotify_, buffer, sizeof(buffer));
+        if (length <= 0) {
+            return;  // EAGAIN: nothing more queued
+        }
+        for (ssize_t offset = 0; offset < length;) {
+            const auto* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+            offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+            if (event->mask & IN_Q_OVERFLOW) {
+                for (Watch& watch : watches_) {
+                    watch.changed_us = now_us;
+                }
+                continue;
+            }
+            const std::string name = event->len > 0 ? std::string(event->name) : std::string();
+            for (size_t i = 0; i < descriptors_.size(); ++i) {
+                if (descriptors_[i].wd != event->wd) {
+                    continue;
+                }
+                Watch& watch = watches_[descriptors_[i].watch];
+                if (!watch.name.empty() && watch.name != name) {
+                    continue;
+                }
+                watch.changed_us = now_us;
+                if ((event->mask & (IN_CREATE | IN_MOVED_TO)) && (event->mask & IN_ISDIR) && watch.name.empty()) {
+                    WatchTree(descriptors_[i].path + "/" + name, descriptors_[i].watch);
+                }
+            }
+        }
+    }
+#else
+    (void)now_us;
+#endif
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// File and directory change notifications from the OS: ReadDirectoryChangesW
+// on Windows, inotify on Linux. Nothing polls the filesystem; Poll only
+// drains the notifications that have queued up. A watched file is watched
+// through its directory, so an editor that saves by writing a new file and
+// renaming it over the old one is still seen. A watch is reported once its
+// changes have been quiet for kSettleMicros, so a save made of several
+// writes, or a folder of sprites being copied in, is one change. Elsewhere
+// Add fails and nothing is ever reported.
+class FileWatcher {
+public:
+    static constexpr int64_t kSettleMicros = 200000;
+    static constexpr int kMaxWatches = 32;
+
+    FileWatcher();
+    ~FileWatcher();
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+
+    // Watches a file, or a directory and everything below it. Returns the
+    // watch's bit in Poll's mask, or -1 if it cannot be watched (missing, or
+    // no notifications on this platform).
+    int Add(const std::string& path);
+    void Clear();
+    // Non-blocking, once per frame: bit i is set for watch i if it changed
+    // and has settled since the last call.
+    uint32_t Poll();
+
+private:
+    struct Native;  // the platform's handles and buffers
+    struct Watch {
+        std::string name;          // file in the directory; empty = anything below it
+        int64_t changed_us = 0;    // last change not yet reported, 0 = none
+        std::unique_ptr<Native> native;
+    };
+
+    void Drain(int64_t now_us);
+    // Linux: adds a descriptor for root and every directory below it.
+    void WatchTree(const std::string& root, int watch);
+
+    std::vector<Watch> watches_;
+    // Linux: one inotify instance, with a descriptor per watched directory.
+    struct Descriptor {
+        int wd;
+        int watch;
+        std::string path;
+    };
+    int inotify_ = -1;
+    std::vector<Descriptor> descriptors_;
+};
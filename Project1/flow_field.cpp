@@ -0,0 +1,105 @@
+#include "flow_field.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+void FlowField::Build(int width, int height, const uint8_t* solid, int goal_x, int goal_y) {
+    width_ = std::max(0, width);
+    height_ = std::max(0, height);
+    goal_x_ = goal_x;
+    goal_y_ = goal_y;
+    max_distance_ = 0;
+    const size_t count = static_cast<size_t>(width_) * height_;
+    distance_.assign(count, kUnreachable);
+    step_.assign(count, kNoStep);
+    auto open = [&](int x, int y) {
+        return x >= 0 && y >= 0 && x < width_ && y < height_ && solid[Index(x, y)] == 0;
+    };
+    if (!open(goal_x, goal_y)) {
+        return;
+    }
+
+    // Steps are picked after the search, in the fixed tie order, so they do
+    // not depend on how the heap orders equal distances.
+    using Entry = std::pair<uint32_t, uint32_t>;
+    const std::greater<Entry> later;
+    frontier_.clear();
+    distance_[Index(goal_x, goal_y)] = 0;
+    frontier_.push_back({0, static_cast<uint32_t>(Index(goal_x, goal_y))});
+    while (!frontier_.empty()) {
+        std::pop_heap(frontier_.begin(), frontier_.end(), later);
+        const Entry entry = frontier_.back();
+        frontier_.pop_back();
+        if (entry.first != distance_[entry.second]) {
+            continue;  // superseded by a shorter path
+        }
+        max_distance_ = entry.first;
+        const int x = static_cast<int>(entry.second % static_cast<uint32_t>(width_));
+        const int y = static_cast<int>(entry.second / static_cast<uint32_t>(width_));
+        for (int step = 0; step < 8; ++step) {
+            const int nx = x + kStepX[step];
+            const int ny = y + kStepY[step];
+            if (!open(nx, ny)) {
+                continue;
+            }
+            const bool diagonal = step >= 4;
+            if (diagonal && (!open(nx, y) || !open(x, ny))) {
+                continue;
+            }
+            const uint32_t distance = entry.first + (diagonal ? kDiagonalCost : kStraightCost);
+            uint32_t& best = distance_[Index(nx, ny)];
+            if (distance < best) {
+                best = distance;
+                frontier_.push_back({distance, static_cast<uint32_t>(Index(nx, ny))});
+                std::push_heap(frontier_.begin(), frontier_.end(), later);
+            }
+        }
+    }
+
+    for (int y = 0; y < height_; ++y) {
+        for (int x = 0; x < width_; ++x) {
+            const uint32_t own = distance_[Index(x, y)];
+            if (own == kUnreachable || own == 0) {
+                continue;
+            }
+            uint32_t best = kUnreachable;
+            for (int step = 0; step < 8; ++step) {
+                const int nx = x + kStepX[step];
+                const int ny = y + kStepY[step];
+                const bool diagonal = step >= 4;
+                if (!open(nx, ny) || (diagonal && (!open(nx, y) || !open(x, ny)))) {
+                    continue;
+                }
+                const uint32_t through = distance_[Index(nx, ny)] + (diagonal ? kDiagonalCost : kStraightCost);
+                if (distance_[Index(nx, ny)] != kUnreachable && through < best) {
+                    best = through;
+                    step_[Index(x, y)] = static_cast<uint8_t>(step);
+                }
+            }
+        }
+    }
+}
+
+bool FlowField::Direction(double x, double y, double& dx, double& dy) const {
+    dx = 0.0;
+    dy = 0.0;
+    if (width_ <= 0 || height_ <= 0) {
+        return false;
+    }
+    const int tile_x = std::clamp(static_cast<int>(x), 0, width_ - 1);
+    const int tile_y = std::clamp(static_cast<int>(y), 0, height_ - 1);
+    const uint8_t step = step_[Index(tile_x, tile_y)];
+    if (step == kNoStep) {
+        return false;
+    }
+    const double to_x = (tile_x + kStepX[step]) + 0.5 - x;
+    const double to_y = (tile_y + kStepY[step]) + 0.5 - y;
+    const double length = std::sqrt(to_x * to_x + to_y * to_y);
+    if (!(length > 0.0)) {
+        return false;
+    }
+    dx = to_x / length;
+    dy = to_y / length;
+    return true;
+}
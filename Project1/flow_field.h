@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Distance field over a room's open tiles towards one goal tile, plus the
+// neighbour each tile steps to along it. Every enemy chasing the same goal
+// shares one field, so a movement query is a tile lookup instead of a path
+// search. Built by the simulation (rogue_native.CollisionWorld) once per
+// player tile, and by the renderer for its debug overlay; collision.py has
+// the same search in Python, with identical results.
+class FlowField {
+public:
+    static constexpr uint32_t kUnreachable = UINT32_MAX;
+    static constexpr uint8_t kNoStep = 0xFF;  // goal, solid or unreachable tile
+    // Step costs; integers keep native and Python distances identical.
+    static constexpr uint32_t kStraightCost = 10;
+    static constexpr uint32_t kDiagonalCost = 14;
+    // Neighbour offsets, straight ones first; a step is an index into these.
+    // Ties between equally short steps go to the lower index.
+    static constexpr int kStepX[8] = {1, -1, 0, 0, 1, -1, 1, -1};
+    static constexpr int kStepY[8] = {0, 0, 1, -1, 1, 1, -1, -1};
+
+    // Dijkstra from the goal over 8-connected open tiles. solid is row-major,
+    // one byte per tile, non-zero = blocks; a diagonal step may not cut the
+    // corner of a solid tile. A goal outside the room or on a solid tile
+    // leaves every tile unreachable.
+    void Build(int width, int height, const uint8_t* solid, int goal_x, int goal_y);
+
+    int Width() const { return width_; }
+    int Height() const { return height_; }
+    int GoalX() const { return goal_x_; }
+    int GoalY() const { return goal_y_; }
+    // Largest finite distance, 0 for an empty field.
+    uint32_t MaxDistance() const { return max_distance_; }
+
+    uint32_t Distance(int x, int y) const { return distance_[Index(x, y)]; }
+    uint8_t Step(int x, int y) const { return step_[Index(x, y)]; }
+
+    // Unit vector from (x, y) towards the centre of the next tile on the
+    // path, sampled like TileGrid (truncated, clamped to the room). Aiming at
+    // the centre rather than along the step keeps box-shaped movers off
+    // corners. False, with (0, 0), on the goal tile and where there is no path.
+    bool Direction(double x, double y, double& dx, double& dy) const;
+
+private:
+    size_t Index(int x, int y) const { return static_cast<size_t>(y) * width_ + x; }
+
+    int width_ = 0;
+    int height_ = 0;
+    int goal_x_ = -1;
+    int goal_y_ = -1;
+    uint32_t max_distance_ = 0;
+    std::vector<uint32_t> distance_;
+    std::vector<uint8_t> step_;
+    std::vector<std::pair<uint32_t, uint32_t>> frontier_;  // (distance, tile) min-heap, kept between builds
+};
@@ -0,0 +1,77 @@
+#include "frame_arena.h"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace {
+
+thread_local FrameArena* t_current_arena = nullptr;
+
+}  // namespace
+
+FrameArena::FrameArena(size_t initial_capacity) {
+    AddBlock(initial_capacity);
+}
+
+void* FrameArena::Allocate(size_t size, size_t alignment) {
+    Block* block = &blocks_.back();
+    size_t offset = (used_ + alignment - 1) & ~(alignment - 1);
+    if (offset + size > block->size) {
+        retired_ += used_;
+        AddBlock(std::max(size + alignment, block->size * 2));
+        block = &blocks_.back();
+        offset = 0;
+    }
+    used_ = offset + size;
+    high_water_ = std::max(high_water_, retired_ + used_);
+    return block->data.get() + offset;
+}
+
+bool FrameArena::Owns(const void* pointer) const {
+    const auto* address = static_cast<const unsigned char*>(pointer);
+    for (const Block& block : blocks_) {
+        if (address >= block.data.get() && address < block.data.get() + block.size) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void FrameArena::Reset() {
+    if (blocks_.size() > 1) {
+        const size_t peak = Capacity();
+        blocks_.clear();
+        AddBlock(peak);
+    }
+    used_ = 0;
+    retired_ = 0;
+}
+
+size_t FrameArena::Capacity() const {
+    size_t capacity = 0;
+    for (const Block& block : blocks_) {
+        capacity += block.size;
+    }
+    return capacity;
+}
+
+void FrameArena::AddBlock(size_t minimum) {
+    Block block;
+    block.size = std::max<size_t>(minimum, 4096);
+    block.data.reset(new unsigned char[block.size]);
+    blocks_.push_back(std::move(block));
+    used_ = 0;
+}
+
+FrameArena* CurrentArena() {
+    return t_current_arena;
+}
+
+ArenaScope::ArenaScope(FrameArena& arena) : arena_(arena), previous_(t_current_arena) {
+    t_current_arena = &arena;
+}
+
+ArenaScope::~ArenaScope() {
+    t_current_arena = previous_;
+    arena_.Reset();
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <vector>
+
+// Bump allocator for data that only lives while one snapshot is decoded.
+// Reset() rewinds without freeing. If a decode outgrew the arena, the next
+// Reset() swaps its blocks for a single block sized for that peak, so after
+// warm-up a decode costs no heap allocations at all.
+class FrameArena {
+public:
+    explicit FrameArena(size_t initial_capacity = 256 * 1024);
+
+    void* Allocate(size_t size, size_t alignment);
+    bool Owns(const void* pointer) const;
+    void Reset();
+
+    size_t Capacity() const;
+    size_t HighWater() const { return high_water_; }
+
+private:
+    struct Block {
+        std::unique_ptr<unsigned char[]> data;
+        size_t size = 0;
+    };
+
+    void AddBlock(size_t minimum);
+
+    std::vector<Block> blocks_;
+    size_t used_ = 0;      // bytes taken from the last block
+    size_t retired_ = 0;   // bytes taken from earlier blocks
+    size_t high_water_ = 0;
+};
+
+// The arena ArenaAllocator draws from on this thread, or nullptr.
+FrameArena* CurrentArena();
+
+// Routes ArenaAllocator on this thread to arena until destroyed, then resets
+// the arena. Everything allocated from it must be destroyed first.
+class ArenaScope {
+public:
+    explicit ArenaScope(FrameArena& arena);
+    ~ArenaScope();
+
+    ArenaScope(const ArenaScope&) = delete;
+    ArenaScope& operator=(const ArenaScope&) = delete;
+
+private:
+    FrameArena& arena_;
+    FrameArena* previous_;
+};
+
+// Stateless allocator over CurrentArena(), falling back to the heap when no
+// scope is active. Freeing arena memory is a no-op; Reset reclaims it.
+template <typename T>
+struct ArenaAllocator {
+    using value_type = T;
+
+    ArenaAllocator() noexcept = default;
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>&) noexcept {}
+
+    T* allocate(size_t count) {
+        if (FrameArena* arena = CurrentArena()) {
+            return static_cast<T*>(arena->Allocate(count * sizeof(T), alignof(T)));
+        }
+        return static_cast<T*>(::operator new(count * sizeof(T)));
+    }
+
+    void deallocate(T* pointer, size_t) noexcept {
+        const FrameArena* arena = CurrentArena();
+        if (arena == nullptr || !arena->Owns(pointer)) {
+            ::operator delete(pointer);
+        }
+    }
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U>&) const noexcept { return true; }
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U>&) const noexcept { return false; }
+};
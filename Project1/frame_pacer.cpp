@@ -0,0 +1,132 @@
+#include "frame_pacer.h"
+
+#include "raylib.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Holds and smoothing are in wall time, not frames, so they behave the same
+// at 60 Hz, 144 Hz or uncapped.
+constexpr double kSmoothingMicros = 158000.0;  // Load() time constant; a weight of 0.1 per frame at 60 fps
+constexpr double kDegradeLoad = 0.9;           // smoothed load that sheds a level
+constexpr double kRestoreLoad = 0.6;           // load that must hold before one comes back
+constexpr int64_t kDegradeHoldMicros = 500000;  // lets one drop show in Load() before the next
+constexpr int64_t kRestoreHoldMicros = 3000000;
+constexpr int64_t kMaxRestoreHoldMicros = 24000000;
+constexpr int64_t kBounceMicros = 5000000;  // a drop this soon after a restore means it did not fit
+constexpr uint64_t kWarmupFrames = 120;  // window creation, first keyframe, sprite uploads
+// Longer frames are hitches (a dragged window, a breakpoint), not load.
+constexpr int64_t kStallMicros = 250000;
+// A capped frame this far over its slot missed it: the swap blocked, so the
+// GPU is behind and the whole frame counts.
+constexpr double kMissedSlot = 1.25;
+constexpr int kVrrMarginFps = 3;
+constexpr int kDefaultBudgetFps = 60;
+
+}  // namespace
+
+void FramePacer::Configure(const std::string& mode, int target_fps, bool adaptive, int quality_target_fps,
+                           int levels) {
+    target_fps_ = std::max(0, target_fps);
+    if (mode == "uncapped") {
+        mode_ = Mode::Uncapped;
+    } else if (mode == "vrr") {
+        mode_ = Mode::Vrr;
+    } else {
+        if (mode != "fixed") {
+            TraceLog(LOG_WARNING, "Unknown renderer pacing '%s', using fixed", mode.c_str());
+        }
+        mode_ = target_fps_ > 0 ? Mode::Fixed : Mode::Uncapped;
+    }
+    adaptive_ = adaptive;
+    quality_target_fps_ = std::max(0, quality_target_fps);
+    levels_ = std::max(1, levels);
+    level_ = 0;
+    restore_hold_us_ = kRestoreHoldMicros;
+}
+
+void FramePacer::ApplyWindowHints() const {
+    if (mode_ == Mode::Vrr) {
+        SetConfigFlags(FLAG_VSYNC_HINT);
+    }
+}
+
+void FramePacer::Start() {
+    cap_fps_ = 0;
+    if (mode_ == Mode::Fixed) {
+        cap_fps_ = target_fps_;
+    } else if (mode_ == Mode::Vrr) {
+        const int refresh = GetMonitorRefreshRate(GetCurrentMonitor());
+        cap_fps_ = refresh > kVrrMarginFps ? refresh - kVrrMarginFps : target_fps_;
+        if (target_fps_ > 0) {
+            cap_fps_ = cap_fps_ > 0 ? std::min(cap_fps_, target_fps_) : target_fps_;
+        }
+    }
+    SetTargetFPS(cap_fps_);
+    const int budget_fps = quality_target_fps_ > 0 ? quality_target_fps_ : cap_fps_ > 0 ? cap_fps_ : kDefaultBudgetFps;
+    budget_us_ = 1000000 / budget_fps;
+    TraceLog(LOG_INFO, "Frame pacing %s, %s, adaptive quality %s (%.1f ms budget)", ModeName(mode_),
+             cap_fps_ > 0 ? TextFormat("capped at %d fps", cap_fps_) : "uncapped", Adaptive() ? "on" : "off",
+             budget_us_ / 1000.0);
+}
+
+bool FramePacer::EndFrame(int64_t work_us, int64_t frame_us) {
+    if (!Adaptive() || ++frames_ <= kWarmupFrames || frame_us > kStallMicros) {
+        return false;
+    }
+    // Capped frames wait out the rest of their slot in EndDrawing, so the
+    // frame's cost is its work, unless the slot was missed anyway. The slot is
+    // the cap's, not the quality budget's, which may be longer.
+    int64_t cost = work_us;
+    if (cap_fps_ == 0 || frame_us > static_cast<int64_t>(1000000.0 / cap_fps_ * kMissedSlot)) {
+        cost = std::max(cost, frame_us);
+    }
+    const double weight = 1.0 - std::exp(-static_cast<double>(frame_us) / kSmoothingMicros);
+    load_ += (static_cast<double>(cost) / static_cast<double>(budget_us_) - load_) * weight;
+    since_change_us_ += frame_us;
+
+    if (load_ > kDegradeLoad) {
+        calm_us_ = 0;
+        if (level_ + 1 >= levels_ || since_change_us_ < kDegradeHoldMicros) {
+            return false;
+        }
+        if (restored_ && since_change_us_ < kBounceMicros) {
+            restore_hold_us_ = std::min(restore_hold_us_ * 2, kMaxRestoreHoldMicros);
+        }
+        ++level_;
+        since_change_us_ = 0;
+        restored_ = false;
+        TraceLog(LOG_INFO, "Frame load %.2f of the budget, quality level %d", load_, level_);
+        return true;
+    }
+
+    calm_us_ = load_ < kRestoreLoad ? calm_us_ + frame_us : 0;
+    if (level_ > 0 && calm_us_ >= restore_hold_us_) {
+        --level_;
+        since_change_us_ = 0;
+        calm_us_ = 0;
+        restored_ = true;
+        TraceLog(LOG_INFO, "Frame load %.2f of the budget, quality level %d", load_, level_);
+        return true;
+    }
+    if (restored_ && since_change_us_ >= kBounceMicros) {
+        // The restore held; let the hold relax towards its default.
+        restored_ = false;
+        restore_hold_us_ = std::max(kRestoreHoldMicros, restore_hold_us_ / 2);
+    }
+    return false;
+}
+
+const char* FramePacer::ModeName(Mode mode) {
+    switch (mode) {
+    case Mode::Fixed:
+        return "fixed";
+    case Mode::Uncapped:
+        return "uncapped";
+    case Mode::Vrr:
+        return "vrr";
+    }
+    return "fixed";
+}
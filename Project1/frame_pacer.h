@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// Frame pacing and adaptive quality. The pacing mode decides how frames meet
+// the display:
+//   fixed     SetTargetFPS(target_fps); target_fps 0 runs uncapped
+//   uncapped  no cap and no vsync, as fast as frames go
+//   vrr       vsync on, capped a few fps under the monitor's refresh rate (or
+//             target_fps if that is lower), so a variable refresh display
+//             follows every frame instead of vsync queueing them
+// Every frame then reports its cost against the budget (quality_target_fps,
+// or the cap). While the smoothed cost stays over 90% of the budget the
+// quality level goes up one step at a time (0 is full quality); it comes
+// back down a step only after the cost has stayed under 60% for 3 seconds.
+// Holds are measured in wall time from frame_us, whatever the frame rate.
+// The gap between the two loads and the hold times are the hysteresis, and
+// a restore that is undone straight away doubles the next hold, so quality
+// does not flap at the edge of the budget.
+class FramePacer {
+public:
+    enum class Mode : uint8_t { Fixed = 0, Uncapped, Vrr };
+
+    // Before InitWindow. levels is how many quality levels there are; 1
+    // turns adaptivity off, as does adaptive = false.
+    void Configure(const std::string& mode, int target_fps, bool adaptive, int quality_target_fps, int levels);
+    // Window flags the mode needs; call before InitWindow.
+    void ApplyWindowHints() const;
+    // After InitWindow: sets the frame cap and the quality budget.
+    void Start();
+
+    // Once per presented frame. work_us is the frame's own cost, up to
+    // EndDrawing; frame_us includes EndDrawing and its wait for the cap.
+    // True if Level() changed.
+    bool EndFrame(int64_t work_us, int64_t frame_us);
+
+    int Level() const { return level_; }
+    Mode GetMode() const { return mode_; }
+    // 0 when uncapped.
+    int CapFps() const { return cap_fps_; }
+    int64_t BudgetMicros() const { return budget_us_; }
+    // Smoothed frame cost over the budget.
+    double Load() const { return load_; }
+    bool Adaptive() const { return adaptive_ && levels_ > 1; }
+
+    static const char* ModeName(Mode mode);
+
+private:
+    Mode mode_ = Mode::Fixed;
+    int target_fps_ = 60;
+    int quality_target_fps_ = 0;
+    bool adaptive_ = true;
+    int levels_ = 1;
+    int cap_fps_ = 60;
+    int64_t budget_us_ = 16667;
+
+    int level_ = 0;
+    double load_ = 0.0;
+    uint64_t frames_ = 0;
+    int64_t since_change_us_ = 0;  // wall time since the level last changed
+    int64_t calm_us_ = 0;          // unbroken time under kRestoreLoad
+    int64_t restore_hold_us_ = 0;  // calm time a restore needs; grows when restores bounce
+    bool restored_ = false;        // the last change was a restore
+};
@@ -0,0 +1,144 @@
+#include "frame_profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+
+namespace {
+
+constexpr std::array<const char*, FrameProfiler::kStageCount> kStageNames = {
+    "frame", "update", "input", "tile_cache", "particles", "build_lists", "tilemap",
+    "pickups", "actors", "projectiles", "effects", "shapes", "hud", "present",
+    "ingest", "snapshot_age", "input_latency",
+};
+
+bool IsValueStage(size_t stage) {
+    return stage == static_cast<size_t>(ProfileStage::Ingest) ||
+           stage == static_cast<size_t>(ProfileStage::SnapshotAge) ||
+           stage == static_cast<size_t>(ProfileStage::InputLatency);
+}
+
+// Entity layers are recorded in parallel, so each gets its own trace row
+// rather than overlapping on the render thread's.
+int TraceThread(size_t stage) {
+    const size_t first = static_cast<size_t>(ProfileStage::Pickups);
+    const size_t last = static_cast<size_t>(ProfileStage::Effects);
+    return stage >= first && stage <= last ? static_cast<int>(stage - first) + 2 : 1;
+}
+
+}  // namespace
+
+const char* FrameProfiler::StageName(ProfileStage stage) {
+    const size_t index = static_cast<size_t>(stage);
+    return index < kStageNames.size() ? kStageNames[index] : "unknown";
+}
+
+int64_t FrameProfiler::NowMicros() {
+    using namespace std::chrono;
+    static const steady_clock::time_point origin = steady_clock::now();
+    return duration_cast<microseconds>(steady_clock::now() - origin).count();
+}
+
+void FrameProfiler::BeginFrame() {
+    FrameSample& frame = Current();
+    frame.start_us = NowMicros();
+    frame.stage_start.fill(0);
+    frame.duration.fill(-1);
+}
+
+void FrameProfiler::EndFrame() {
+    FrameSample& frame = Current();
+    Record(ProfileStage::Frame, frame.start_us, NowMicros() - frame.start_us);
+    cursor_ = (cursor_ + 1) % kHistory;
+    count_ = std::min(count_ + 1, kHistory);
+}
+
+// Stages recorded more than once in a frame accumulate.
+void FrameProfiler::Record(ProfileStage stage, int64_t start_us, int64_t duration_us) {
+    FrameSample& frame = Current();
+    const size_t index = static_cast<size_t>(stage);
+    if (frame.duration[index] < 0) {
+        frame.stage_start[index] = start_us;
+        frame.duration[index] = duration_us;
+    } else {
+        frame.duration[index] += duration_us;
+    }
+}
+
+void FrameProfiler::RecordValue(ProfileStage stage, int64_t value_us) {
+    FrameSample& frame = Current();
+    const size_t index = static_cast<size_t>(stage);
+    frame.stage_start[index] = frame.start_us;
+    frame.duration[index] = value_us;
+}
+
+int64_t FrameProfiler::Percentile(ProfileStage stage, double fraction) const {
+    const size_t index = static_cast<size_t>(stage);
+    scratch_.clear();
+    for (size_t i = 0; i < count_; ++i) {
+        // Skip the frame in progress.
+        const size_t slot = (cursor_ + kHistory - 1 - i) % kHistory;
+        if (frames_[slot].duration[index] >= 0) {
+            scratch_.push_back(frames_[slot].duration[index]);
+        }
+    }
+    if (scratch_.empty()) {
+        return 0;
+    }
+    const size_t rank = std::min(scratch_.size() - 1, static_cast<size_t>(std::ceil(fraction * scratch_.size())) - 1);
+    std::nth_element(scratch_.begin(), scratch_.begin() + rank, scratch_.end());
+    return scratch_[rank];
+}
+
+bool FrameProfiler::ExportCsv(const std::string& path) const {
+    std::ofstream file(path, std::ios::trunc);
+    if (!file.is_open()) {
+        return false;
+    }
+    file << "frame_start_us";
+    for (const char* name : kStageNames) {
+        file << ',' << name << "_us";
+    }
+    file << '\n';
+    for (size_t i = 0; i < count_; ++i) {
+        const FrameSample& frame = frames_[(cursor_ + kHistory - count_ + i) % kHistory];
+        file << frame.start_us;
+        for (const int64_t duration : frame.duration) {
+            file << ',';
+            if (duration >= 0) {
+                file << duration;
+            }
+        }
+        file << '\n';
+    }
+    return static_cast<bool>(file);
+}
+
+// Chrome trace event format (chrome://tracing, Perfetto): timed stages are
+// complete events, ingest time, snapshot age and input latency are counters.
+bool FrameProfiler::ExportChromeTrace(const std::string& path) const {
+    std::ofstream file(path, std::ios::trunc);
+    if (!file.is_open()) {
+        return false;
+    }
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    for (size_t i = 0; i < count_; ++i) {
+        const FrameSample& frame = frames_[(cursor_ + kHistory - count_ + i) % kHistory];
+        for (size_t stage = 0; stage < kStageCount; ++stage) {
+            if (frame.duration[stage] < 0) {
+                continue;
+            }
+            file << (first ? "" : ",") << "\n{\"name\":\"" << kStageNames[stage] << "\",\"pid\":1,\"tid\":" << TraceThread(stage) << ",";
+            if (IsValueStage(stage)) {
+                file << "\"ph\":\"C\",\"ts\":" << frame.start_us << ",\"args\":{\"us\":" << frame.duration[stage] << "}}";
+            } else {
+                file << "\"ph\":\"X\",\"ts\":" << frame.stage_start[stage] << ",\"dur\":" << frame.duration[stage] << "}";
+            }
+            first = false;
+        }
+    }
+    file << "\n]}\n";
+    return static_cast<bool>(file);
+}
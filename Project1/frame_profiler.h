@@ -0,0 +1,80 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+enum class ProfileStage : uint8_t {
+    Frame = 0,
+    Update,
+    Input,
+    TileCache,
+    Particles,    // spawning and moving particles, before they are recorded with the effects
+    BuildLists,   // recording every entity layer, across the job workers
+    Tilemap,
+    Pickups,      // Pickups..Effects: each layer's recording, on whichever thread ran it
+    Actors,
+    Projectiles,
+    Effects,
+    Shapes,       // submitting the recorded layers
+    Hud,
+    Present,
+    Ingest,       // read + decode + apply on the ingest thread, per published frame
+    SnapshotAge,  // render time minus meta.timestamp_us
+    InputLatency, // input event queued -> first presented frame that reflects it
+    Count
+};
+
+// Keeps per-stage timings for the last kHistory frames. Render thread only:
+// values measured elsewhere (ingest, snapshot age) are handed over with
+// RecordValue. Percentiles come from the rolling window; exports dump it.
+class FrameProfiler {
+public:
+    static constexpr size_t kHistory = 600;
+    static constexpr size_t kStageCount = static_cast<size_t>(ProfileStage::Count);
+
+    void BeginFrame();
+    void EndFrame();
+
+    void Record(ProfileStage stage, int64_t start_us, int64_t duration_us);
+    void RecordValue(ProfileStage stage, int64_t value_us);
+
+    // Microseconds; 0 when the stage has no samples in the window.
+    int64_t Percentile(ProfileStage stage, double fraction) const;
+
+    bool ExportCsv(const std::string& path) const;
+    bool ExportChromeTrace(const std::string& path) const;
+
+    static const char* StageName(ProfileStage stage);
+    static int64_t NowMicros();
+
+private:
+    struct FrameSample {
+        int64_t start_us = 0;
+        std::array<int64_t, kStageCount> stage_start{};
+        std::array<int64_t, kStageCount> duration{};  // -1 when not recorded
+    };
+
+    FrameSample& Current() { return frames_[cursor_]; }
+
+    std::array<FrameSample, kHistory> frames_{};
+    size_t cursor_ = 0;
+    size_t count_ = 0;
+    mutable std::vector<int64_t> scratch_;
+};
+
+class ScopedTimer {
+public:
+    ScopedTimer(FrameProfiler& profiler, ProfileStage stage)
+        : profiler_(profiler), stage_(stage), start_us_(FrameProfiler::NowMicros()) {}
+    ~ScopedTimer() { profiler_.Record(stage_, start_us_, FrameProfiler::NowMicros() - start_us_); }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    FrameProfiler& profiler_;
+    ProfileStage stage_;
+    int64_t start_us_;
+};
@@ -2,16 +2,29 @@
 
 from __future__ import annotations
 
-import json
+import logging
 import math
 import random
 import time
 from dataclasses import dataclass, asdict
 from pathlib import Path
-from typing import Dict, List, Tuple
+from typing import Dict, List, Optional, Sequence, Tuple
 
 import yaml
 
+from collision import open_collision_world
+from file_watch import FileWatcher
+from projectiles import Projectile, ProjectilePool
+from tick_sync import TickPacer
+from transport import FileChannel, open_channel
+
+logger = logging.getLogger(__name__)
+
+# Settings read only when the room or the channel is built; a hot reload
+# reports a change to them but it waits for a restart.
+RESTART_SETTINGS = {"game.room_width", "game.room_height", "game.rng_seed", "game.native_collision", "game.hot_reload"}
+RESTART_SECTIONS = {"ipc"}
+
 
 @dataclass
 class Actor:
@@ -30,20 +43,6 @@ class Actor:
     invulnerability: float = 0.0
 
 
-@dataclass
-class Projectile:
-    id: str
-    owner: str
-    kind: str
-    x: float
-    y: float
-    vx: float
-    vy: float
-    damage: int
-    ttl: float
-    radius: float = 0.2
-
-
 @dataclass
 class Pickup:
     id: str
@@ -67,12 +66,22 @@ class RogueGame:
     SOLID_TILES = {"wall", "rock", "pit"}
     HAZARD_TILES = {"spikes"}
 
-    def __init__(self, config_path: str = "game_config.yaml", shared_dir: str = "shared") -> None:
+    def __init__(
+        self,
+        config_path: str = "game_config.yaml",
+        shared_dir: str = "shared",
+        config_overrides: Optional[Dict] = None,
+    ) -> None:
         self.config_path = Path(config_path)
         self.shared_dir = Path(shared_dir)
-        self.shared_dir.mkdir(parents=True, exist_ok=True)
 
-        self.config = self._load_config()
+        # Overrides are merged over the file, e.g. a batch run's seed, and
+        # again over every reload of it.
+        self.config_overrides = config_overrides or {}
+        self.config = self._deep_merge(self._load_config(), self.config_overrides)
+        if self.config["ipc"].get("transport") != "memory":
+            self.shared_dir.mkdir(parents=True, exist_ok=True)
+        self.channel: FileChannel = open_channel(self.config["ipc"], self.shared_dir)
         self.tick_rate = float(self.config["game"].get("tick_rate", 60))
         self.delta_time = 1.0 / self.tick_rate
 
@@ -97,6 +106,8 @@ class RogueGame:
                 "tile_size": 32,
                 "tick_rate": 60,
                 "rng_seed": None,
+                "native_collision": True,
+                "hot_reload": True,
             },
             "player": {
                 "hp": 6,
@@ -113,6 +124,10 @@ class RogueGame:
                 "speed_max": 2.4,
                 "hp_min": 2,
                 "hp_max": 5,
+                "flow_field": True,
+            },
+            "effects": {
+                "particles": True,
             },
             "pickups": {
                 "chance_heart": 0.25,
@@ -120,11 +135,25 @@ class RogueGame:
                 "chance_key": 0.2,
                 "chance_bomb": 0.15,
             },
+            "ipc": {
+                "transport": "shared_memory",
+                "shm_file": "game_state.shm",
+                "shm_slots": 16,
+                "shm_slot_size": 262144,
+                "format": "binary",
+                "deltas": True,
+                "keyframe_interval": 300,
+                "sync": "free",
+                "max_ticks_ahead": 2,
+                "sync_timeout": 1.0,
+            },
         }
 
         if self.config_path.exists():
             with self.config_path.open("r", encoding="utf-8") as fh:
                 user_config = yaml.safe_load(fh) or {}
+            if not isinstance(user_config, dict):
+                raise ValueError(f"{self.config_path} does not hold a mapping")
             base_config = self._deep_merge(base_config, user_config)
 
         return base_config
@@ -138,12 +167,86 @@ class RogueGame:
                 result[key] = value
         return result
 
+    def reload_config(self) -> List[str]:
+        """Re-reads the config file and applies what can change mid-run.
+
+        Call between ticks. The file is merged over the defaults and this run's
+        overrides again, exactly as at startup. Settings read on every use
+        (fire delay, pickup chances, enemy spawn ranges) need nothing more; the
+        ones cached on the game are refreshed here. A file that does not parse,
+        or holds a value that cannot be applied, leaves the running config as it
+        was. Returns the settings that changed, as ``section.key``.
+        """
+        try:
+            fresh = self._deep_merge(self._load_config(), self.config_overrides)
+        except (OSError, ValueError, yaml.YAMLError) as exc:
+            logger.warning("ignoring the change to %s, keeping the running config: %s", self.config_path, exc)
+            return []
+        changed = self._changed_settings(self.config, fresh)
+        if not changed:
+            return []
+        previous = self.config
+        self.config = fresh
+        try:
+            self._apply_settings(changed)
+        except (KeyError, TypeError, ValueError) as exc:
+            logger.warning("ignoring the change to %s, keeping the running config: %s", self.config_path, exc)
+            self.config = previous
+            self._apply_settings(changed)
+            return []
+
+        logger.info("reloaded %s: %s", self.config_path, ", ".join(changed))
+        restart = [name for name in changed if name in RESTART_SETTINGS or name.split(".")[0] in RESTART_SECTIONS]
+        if restart:
+            logger.warning("restart to apply %s", ", ".join(restart))
+        return changed
+
+    @staticmethod
+    def _changed_settings(old: Dict, new: Dict) -> List[str]:
+        changed = []
+        for section in sorted(set(old) | set(new)):
+            before, after = old.get(section), new.get(section)
+            if isinstance(before, dict) and isinstance(after, dict):
+                changed.extend(
+                    f"{section}.{key}" for key in sorted(set(before) | set(after)) if before.get(key) != after.get(key)
+                )
+            elif before != after:
+                changed.append(section)
+        return changed
+
+    def _apply_settings(self, changed: Sequence[str]) -> None:
+        if "game.tick_rate" in changed:
+            tick_rate = float(self.config["game"]["tick_rate"])
+            if tick_rate <= 0:
+                raise ValueError("game.tick_rate must be positive")
+            self.tick_rate = tick_rate
+            self.delta_time = 1.0 / tick_rate
+        if "game.tile_size" in changed:
+            # Goes out in the next snapshot's tilemap; the renderer rebuilds its tile cache.
+            self.room["tile_size"] = int(self.config["game"]["tile_size"])
+        if "player.speed" in changed:
+            self.player.speed = float(self.config["player"]["speed"])
+        if "player.hp" in changed:
+            self.player.max_hp = int(self.config["player"]["hp"])
+            self.player.hp = min(self.player.hp, self.player.max_hp)
+        if "enemies.flow_field" in changed:
+            self.flow_field = bool(self.config["enemies"].get("flow_field", True))
+            self._flow_goal = None
+        if "effects.particles" in changed:
+            self.particles = bool(self.config["effects"].get("particles", True))
+        self._refresh_meta()
+
     def _reset_run(self) -> None:
         self.tick = 0
         self.inventory = {"coins": 0, "keys": 0, "bombs": 1}
         self.messages: List[str] = []
 
         self.room = self._generate_room()
+        self.collision = open_collision_world(
+            self.room, self.SOLID_TILES, native=bool(self.config["game"].get("native_collision", True))
+        )
+        self.flow_field = bool(self.config["enemies"].get("flow_field", True))
+        self._flow_goal: Optional[Tuple[int, int]] = None
         spawn_x = self.room["width"] / 2.0
         spawn_y = self.room["height"] / 2.0
         player_hp = int(self.config["player"]["hp"])
@@ -159,9 +262,12 @@ class RogueGame:
         )
 
         self.enemies: List[Actor] = self._spawn_enemies()
-        self.projectiles: List[Projectile] = []
+        self.player_shots = ProjectilePool("player")
+        self.enemy_shots = ProjectilePool("enemy")
         self.pickups: List[Pickup] = self._spawn_pickups()
         self.effects: List[Effect] = []
+        self.particles = bool(self.config["effects"].get("particles", True))
+        self.particle_events: List[Dict] = []
 
         self.running = True
         self._refresh_meta()
@@ -269,6 +375,7 @@ class RogueGame:
 
         dt = self.delta_time
         self.tick += 1
+        self.particle_events = []
 
         self._update_player(input_data, dt)
         self._update_enemies(dt)
@@ -308,24 +415,33 @@ class RogueGame:
         self.player.invulnerability = max(0.0, self.player.invulnerability - dt)
 
     def _move_actor(self, actor: Actor, radius: float, dt: float) -> None:
-        desired_x = actor.x + actor.vx * dt
-        desired_y = actor.y + actor.vy * dt
+        self._move_actors([actor], radius, dt)
 
-        if self._is_position_walkable(desired_x, actor.y, radius):
-            actor.x = desired_x
-        else:
-            actor.vx = 0.0
+    def _move_actors(self, actors: Sequence[Actor], radius: float, dt: float) -> None:
+        # One batched walkability query per axis: x first, then y from the new x.
+        if not actors:
+            return
+        desired_x = [actor.x + actor.vx * dt for actor in actors]
+        free_x = self.collision.walkable(desired_x, [actor.y for actor in actors], radius)
+        for actor, x, free in zip(actors, desired_x, free_x):
+            if free:
+                actor.x = x
+            else:
+                actor.vx = 0.0
 
-        if self._is_position_walkable(actor.x, desired_y, radius):
-            actor.y = desired_y
-        else:
-            actor.vy = 0.0
+        desired_y = [actor.y + actor.vy * dt for actor in actors]
+        free_y = self.collision.walkable([actor.x for actor in actors], desired_y, radius)
+        for actor, y, free in zip(actors, desired_y, free_y):
+            if free:
+                actor.y = y
+            else:
+                actor.vy = 0.0
 
     def _spawn_player_projectile(self, direction: Tuple[float, float]) -> None:
         proj_speed = float(self.config["player"]["projectile_speed"])
         damage = int(self.config["player"]["projectile_damage"])
         projectile = Projectile(
-            id=f"tear_{self.tick}_{len(self.projectiles)}",
+            id=f"tear_{self.tick}_{len(self.player_shots) + len(self.enemy_shots)}",
             owner="player",
             kind="player_projectile",
             x=self.player.x,
@@ -335,22 +451,45 @@ class RogueGame:
             damage=damage,
             ttl=2.0,
         )
-        self.projectiles.append(projectile)
+        self.player_shots.add(projectile)
+
+    def _update_flow_field(self) -> None:
+        # Paths only change when the player crosses into another tile.
+        goal = (int(self.player.x), int(self.player.y))
+        if goal != self._flow_goal:
+            self.collision.build_flow_field(*goal)
+            self._flow_goal = goal
 
     def _update_enemies(self, dt: float) -> None:
-        for enemy in list(self.enemies):
+        # Enemies only chase the player, so all of them move in one batch
+        # before any attacks resolve. With the flow field they follow the
+        # shortest path round obstacles; on the player's tile, or with no
+        # path, they head straight for the player.
+        enemies = list(self.enemies)
+        if self.flow_field and enemies:
+            self._update_flow_field()
+            paths = self.collision.flow_directions([enemy.x for enemy in enemies], [enemy.y for enemy in enemies])
+        else:
+            paths = [(0.0, 0.0)] * len(enemies)
+        distances: List[float] = []
+        for enemy, (path_x, path_y) in zip(enemies, paths):
             dx = self.player.x - enemy.x
             dy = self.player.y - enemy.y
             dist = math.hypot(dx, dy)
+            distances.append(dist)
 
-            if dist > 0.01:
+            if path_x or path_y:
+                enemy.vx = path_x * enemy.speed
+                enemy.vy = path_y * enemy.speed
+            elif dist > 0.01:
                 enemy.vx = (dx / dist) * enemy.speed
                 enemy.vy = (dy / dist) * enemy.speed
             else:
                 enemy.vx = enemy.vy = 0.0
 
-            self._move_actor(enemy, self.enemy_radius, dt)
+        self._move_actors(enemies, self.enemy_radius, dt)
 
+        for enemy, dist in zip(enemies, distances):
             enemy.attack_cooldown = max(0.0, enemy.attack_cooldown - dt)
             if dist < 1.0 and enemy.attack_cooldown <= 0.0:
                 self._damage_player(1, source=enemy.variant)
@@ -361,65 +500,36 @@ class RogueGame:
                 self._on_enemy_death(enemy)
 
     def _update_projectiles(self, dt: float) -> None:
-        next_projectiles: List[Projectile] = []
-        for projectile in self.projectiles:
-            projectile.x += projectile.vx * dt
-            projectile.y += projectile.vy * dt
-            projectile.ttl -= dt
-
-            if projectile.ttl <= 0:
-                continue
-
-            tile = self._tile_at(projectile.x, projectile.y)
-            if tile in self.SOLID_TILES:
-                self.effects.append(
-                    Effect(
-                        id=f"impact_{projectile.id}",
-                        kind="impact",
-                        x=projectile.x,
-                        y=projectile.y,
-                        ttl=0.2,
-                    )
-                )
-                continue
-
-            if projectile.owner == "player":
-                hit_enemy = self._check_enemy_hit(projectile)
-                if hit_enemy:
-                    continue
-            else:
-                if self._check_player_hit(projectile):
-                    continue
-
-            next_projectiles.append(projectile)
-
-        self.projectiles = next_projectiles
-
-    def _check_enemy_hit(self, projectile: Projectile) -> bool:
-        for enemy in self.enemies:
-            if self._distance(enemy.x, enemy.y, projectile.x, projectile.y) < (self.enemy_radius + projectile.radius):
-                enemy.hp -= projectile.damage
-                self.effects.append(
-                    Effect(
-                        id=f"blood_{enemy.id}_{self.tick}",
-                        kind="blood_splatter",
-                        x=projectile.x,
-                        y=projectile.y,
-                        ttl=0.4,
-                    )
-                )
-                if enemy.hp <= 0:
-                    self.messages.append(f"{enemy.variant.title()} defeated!")
-                return True
-        return False
-
-    def _check_player_hit(self, projectile: Projectile) -> bool:
-        if self.player.invulnerability > 0.0:
-            return False
-        if self._distance(self.player.x, self.player.y, projectile.x, projectile.y) < (self.player_radius + projectile.radius):
-            self._damage_player(1, source="projectile")
-            return True
-        return False
+        # Each pool moves, expires and tile-tests its whole batch in one call.
+        for pool in (self.player_shots, self.enemy_shots):
+            for projectile_id, x, y in pool.step(self.collision, dt):
+                self._spawn_effect("impact", f"impact_{projectile_id}", x, y, ttl=0.2)
+
+        shots = self.player_shots
+        if shots:
+            self.collision.build_circles(
+                [enemy.x for enemy in self.enemies], [enemy.y for enemy in self.enemies], self.enemy_radius
+            )
+            hits = self.collision.first_overlaps(shots.x, shots.y, shots.radius)
+            spent = [row for row, enemy_index in enumerate(hits) if enemy_index >= 0]
+            for row in spent:
+                self._apply_enemy_hit(self.enemies[hits[row]], shots.x[row], shots.y[row], shots.damage[row])
+            shots.remove(spent)
+
+        # Only the first overlapping shot lands: the hit makes the player invulnerable.
+        shots = self.enemy_shots
+        if shots and self.player.invulnerability <= 0.0:
+            self.collision.build_circles(shots.x, shots.y, shots.radius)
+            row = self.collision.first_overlaps([self.player.x], [self.player.y], self.player_radius)[0]
+            if row >= 0:
+                self._damage_player(1, source="projectile")
+                shots.remove([row])
+
+    def _apply_enemy_hit(self, enemy: Actor, x: float, y: float, damage: int) -> None:
+        enemy.hp -= damage
+        self._spawn_effect("blood_splatter", f"blood_{enemy.id}_{self.tick}", x, y, ttl=0.4)
+        if enemy.hp <= 0:
+            self.messages.append(f"{enemy.variant.title()} defeated!")
 
     def _handle_pickups(self) -> None:
         remaining: List[Pickup] = []
@@ -451,7 +561,20 @@ class RogueGame:
                 remaining.append(effect)
         self.effects = remaining
 
+    def _spawn_effect(self, kind: str, effect_id: str, x: float, y: float, ttl: float) -> None:
+        """With ``effects.particles`` the renderer animates the effect itself
+        from a one-off spawn event; otherwise it is an entity that lives for
+        ``ttl`` seconds and travels in every snapshot until then."""
+        if not self.particles:
+            self.effects.append(Effect(id=effect_id, kind=kind, x=x, y=y, ttl=ttl))
+            return
+        # Derived from the tick rather than drawn from self.rng, so turning
+        # particles on or off does not change the game.
+        seed = (self.tick * 0x9E3779B1 + len(self.particle_events) * 0x85EBCA6B) & 0xFFFFFFFF
+        self.particle_events.append({"kind": kind, "x": x, "y": y, "seed": seed})
+
     def _on_enemy_death(self, enemy: Actor) -> None:
+        self._spawn_effect("explosion", f"explosion_{enemy.id}", enemy.x, enemy.y, ttl=0.3)
         if self.rng.random() < 0.3:
             kind = self._roll_pickup_kind()
             self.pickups.append(Pickup(id=f"pickup_{kind}_{self.tick}", kind=kind, x=enemy.x, y=enemy.y))
@@ -473,6 +596,7 @@ class RogueGame:
             "room_cleared": not self.enemies,
             "messages": self.messages[-4:],
             "player_dead": self.player.hp <= 0,
+            "input_ack": self.channel.input_ack,
         }
 
     def _tile_at(self, x: float, y: float) -> str:
@@ -481,17 +605,7 @@ class RogueGame:
         return self.room["tiles"][yi][xi]
 
     def _is_position_walkable(self, x: float, y: float, radius: float) -> bool:
-        samples = [
-            (x - radius, y - radius),
-            (x + radius, y - radius),
-            (x - radius, y + radius),
-            (x + radius, y + radius),
-        ]
-        for sx, sy in samples:
-            tile = self._tile_at(sx, sy)
-            if tile in self.SOLID_TILES:
-                return False
-        return True
+        return self.collision.walkable([x], [y], radius)[0]
 
     def _damage_player(self, amount: int, source: str) -> None:
         if self.player.invulnerability > 0.0:
@@ -552,9 +666,10 @@ class RogueGame:
                 }
                 for enemy in self.enemies
             ],
-            "projectiles": [asdict(p) for p in self.projectiles],
+            "projectiles": self.player_shots.serialise() + self.enemy_shots.serialise(),
             "pickups": [asdict(p) for p in self.pickups],
             "effects": [asdict(e) for e in self.effects],
+            "particles": self.particle_events,
             "ui": {
                 "messages": self.meta.get("messages", []),
                 "boss_health": None,
@@ -562,41 +677,40 @@ class RogueGame:
         }
 
     def write_state(self) -> None:
-        state_path = self.shared_dir / "game_state.json"
-        with state_path.open("w", encoding="utf-8") as fh:
-            json.dump(self.serialise_state(), fh, indent=2)
+        # Wall-clock publish time, so the renderer can report snapshot age.
+        self.meta["timestamp_us"] = time.time_ns() // 1000
+        self.channel.publish(self.serialise_state())
 
     def read_input(self) -> Dict:
-        input_path = self.shared_dir / "input.json"
-        if not input_path.exists():
-            return {}
-        try:
-            with input_path.open("r", encoding="utf-8") as fh:
-                data = json.load(fh)
-                if isinstance(data, dict):
-                    return data
-        except json.JSONDecodeError:
-            pass
-        return {}
+        return self.channel.read_input()
 
     # ------------------------------------------------------------------
     # Main loop
     # ------------------------------------------------------------------
     def run(self) -> None:
+        pacer = TickPacer(self.channel, self.tick_rate, self.config["ipc"])
+        watcher = FileWatcher(self.config_path) if self.config["game"].get("hot_reload", True) else None
         try:
             while self.running:
-                start = time.perf_counter()
+                # Edits land between ticks, so every tick runs under one config.
+                if watcher is not None and watcher.changed():
+                    if "game.tick_rate" in self.reload_config():
+                        pacer.set_tick_rate(self.tick_rate)
+                # Wait first, so the tick runs on the freshest input.
+                pacer.wait(self.tick)
                 inputs = self.read_input()
                 self.step(inputs)
                 self.write_state()
-                elapsed = time.perf_counter() - start
-                sleep_time = max(0.0, self.delta_time - elapsed)
-                time.sleep(sleep_time)
         except KeyboardInterrupt:
             self.running = False
+        finally:
+            if watcher is not None:
+                watcher.close()
+            self.channel.close()
 
 
 def main() -> None:
+    logging.basicConfig(level=logging.INFO, format="%(asctime)s %(name)s: %(message)s")
     game = RogueGame()
     game.write_state()  # Initial snapshot for renderer start-up
     game.run()
@@ -1,25 +1,126 @@
 #include "game_renderer.h"
 
+#include "allocation_counter.h"
+#include "config_loader.h"
+#include "file_transport.h"
+#include "network_transport.h"
+#include "replay_transport.h"
+#include "shared_memory_transport.h"
+
 #include <algorithm>
+#include <array>
+#include <cassert>
+#include <chrono>
+#include <cstdio>
 #include <filesystem>
-#include <fstream>
-#include <unordered_map>
+#include <initializer_list>
+#include <string_view>
+#include <utility>
 
 using json = nlohmann::json;
 namespace fs = std::filesystem;
 
+namespace {
+
+// Frames before allocation checks start, covering window creation, the first
+// keyframe and buffers growing to the room's entity counts.
+constexpr uint64_t kAllocationWarmupFrames = 300;
+// Tick length assumed for a skipped frame's wait until a snapshot reports one.
+constexpr int64_t kDefaultTickMicros = 16667;
+// Unacknowledged input is written again this often, in case a write failed or
+// the simulation never saw it.
+constexpr double kInputResendInterval = 0.1;
+constexpr double kMiB = 1024.0 * 1024.0;
+
+using allocation_counter::MemoryTag;
+using allocation_counter::MemoryTagScope;
+
+const json& Setting(const json& section, const char* key) {
+    static const json kMissing;
+    if (!section.is_object()) {
+        return kMissing;
+    }
+    const auto it = section.find(key);
+    return it != section.end() ? *it : kMissing;
+}
+
+bool ParseColor(const json& value, Color& color) {
+    if (!value.is_array() || (value.size() != 3 && value.size() != 4)) {
+        return false;
+    }
+    std::array<unsigned char, 4> channels = {0, 0, 0, 255};
+    for (size_t i = 0; i < value.size(); ++i) {
+        if (!value[i].is_number()) {
+            return false;
+        }
+        channels[i] = static_cast<unsigned char>(std::clamp(value[i].get<int>(), 0, 255));
+    }
+    color = Color{channels[0], channels[1], channels[2], channels[3]};
+    return true;
+}
+
+// renderer.palette: {tiles: {name: [r, g, b(, a)]}, pickups: {...}} over the
+// built-in colours; names are the snapshot's tile and pickup kinds.
+template <size_t N>
+void ParsePaletteSet(const json& overrides, const char* set, const std::array<std::string_view, N>& names,
+                     std::array<Color, N>& colors) {
+    if (overrides.is_null()) {
+        return;
+    }
+    if (!overrides.is_object()) {
+        TraceLog(LOG_WARNING, "renderer.palette.%s should map names to colours", set);
+        return;
+    }
+    for (const auto& item : overrides.items()) {
+        const auto name = std::find(names.begin(), names.end(), item.key());
+        if (name == names.end()) {
+            TraceLog(LOG_WARNING, "renderer.palette.%s: no %s called '%s'", set, set, item.key().c_str());
+        } else if (!ParseColor(item.value(), colors[static_cast<size_t>(name - names.begin())])) {
+            TraceLog(LOG_WARNING, "renderer.palette.%s.%s should be [r, g, b] or [r, g, b, a]", set,
+                     item.key().c_str());
+        }
+    }
+}
+
+SceneRenderer::Palette ParsePalette(const json& palette) {
+    SceneRenderer::Palette result = SceneRenderer::DefaultPalette();
+    ParsePaletteSet(Setting(palette, "tiles"), "tiles", snapshot::kTileNames, result.tiles);
+    ParsePaletteSet(Setting(palette, "pickups"), "pickups", snapshot::kPickupNames, result.pickups);
+    return result;
+}
+
+}  // namespace
+
 void GameRenderer::Initialize() {
+    startup_.started_us = FrameProfiler::NowMicros();
     EnsureSharedDirectory();
-    const int screen_width = 1280;
-    const int screen_height = 720;
-    InitWindow(screen_width, screen_height, "Rogue-like Prototype");
-    SetTargetFPS(60);
-
-    current_state_ = json::object();
+    LoadConfig();
+    startup_.config_us = FrameProfiler::NowMicros();
+    OpenTransport();
+    startup_.transport_us = FrameProfiler::NowMicros();
+    pacer_.ApplyWindowHints();
+    InitWindow(window_width_, window_height_, "Rogue-like Prototype");
+    pacer_.Start();
+    startup_.window_us = FrameProfiler::NowMicros();
+    {
+        MemoryTagScope memory(MemoryTag::Render);
+        scene_.Load();
+    }
+    jobs_.Start(JobSystem::ResolveWorkers(render_threads_));
+    WatchFiles();
+    TraceLog(LOG_INFO, "Recording entity layers on %d thread(s)", jobs_.Workers() + 1);
+    startup_.scene_us = FrameProfiler::NowMicros();
 }
 
 void GameRenderer::Shutdown() {
+    ingest_.Stop();
+    jobs_.Stop();
+    scene_.Unload();
     CloseWindow();
+    if (transport_) {
+        transport_->Close();
+        transport_.reset();
+    }
 }
 
 void GameRenderer::EnsureSharedDirectory() {
@@ -30,29 +131,326 @@ void GameRenderer::EnsureSharedDirectory() {
     }
 }
 
-void GameRenderer::UpdateFromPython() {
-    const fs::path state_path = fs::path(shared_dir_) / "game_state.json";
-    std::ifstream file(state_path);
-    if (!file.is_open()) {
+void GameRenderer::LoadConfig() {
+    try {
+        config_ = LoadConfigFile(config_path_);
+    } catch (const std::exception& e) {
+        TraceLog(LOG_WARNING, "Failed to load %s, using defaults: %s", config_path_.c_str(), e.what());
+        config_ = json::object();
+    }
+
+    const json renderer = config_.value("renderer", json::object());
+    ApplyRendererConfig(renderer, nullptr);
+    scene_.ConfigureParticles(std::max(0, renderer.value("particle_capacity", 4096)));
+    render_threads_ = renderer.value("render_threads", 0);
+    record_dir_ = renderer.value("record_dir", std::string());
+    record_compress_ = renderer.value("record_compress", true);
+    hot_reload_ = renderer.value("hot_reload", true);
+}
+
+// Settings that can change while running. previous is the section they
+// replace on a hot reload, nullptr at startup. Only keys whose value changed
+// are applied, so what F1 or F3 toggled survives an unrelated edit, and only
+// the caches a change affects are rebuilt.
+void GameRenderer::ApplyRendererConfig(const json& renderer, const json* previous) {
+    const auto changed = [&](std::initializer_list<const char*> keys) {
+        return previous == nullptr || std::any_of(keys.begin(), keys.end(), [&](const char* key) {
+                   return Setting(renderer, key) != Setting(*previous, key);
+               });
+    };
+    if (changed({"window_width", "window_height"})) {
+        window_width_ = std::max(320, renderer.value("window_width", window_width_));
+        window_height_ = std::max(240, renderer.value("window_height", window_height_));
+        if (previous) {
+            SetWindowSize(window_width_, window_height_);
+        }
+    }
+    if (changed({"pacing", "target_fps", "adaptive_quality", "quality_target_fps"})) {
+        const std::string pacing = renderer.value("pacing", std::string("fixed"));
+        if (previous && (pacing == "vrr") != (previous->value("pacing", std::string("fixed")) == "vrr")) {
+            TraceLog(LOG_WARNING, "renderer.pacing vrr turns vsync on or off, which takes a restart");
+        }
+        pacer_.Configure(pacing, renderer.value("target_fps", 60), renderer.value("adaptive_quality", true),
+                         renderer.value("quality_target_fps", 0), SceneRenderer::kQualityLevels);
+        if (previous) {
+            pacer_.Start();
+            scene_.SetQualityLevel(pacer_.Level());
+        }
+    }
+    if (changed({"interpolation", "max_extrapolation"})) {
+        interpolator_.Configure(renderer.value("interpolation", true), renderer.value("max_extrapolation", 0.1f));
+    }
+    if (changed({"profiler_overlay"})) {
+        show_profiler_ = renderer.value("profiler_overlay", false);
+    }
+    if (changed({"profile_dir"})) {
+        profile_dir_ = renderer.value("profile_dir", profile_dir_);
+    }
+    if (changed({"assert_zero_allocations"})) {
+        assert_zero_allocations_ = renderer.value("assert_zero_allocations", false);
+    }
+    if (changed({"memory_budgets"})) {
+        memory_budget_.Configure(renderer.value("memory_budgets", json::object()));
+    }
+    if (changed({"camera_zoom"})) {
+        scene_.ConfigureCamera(renderer.value("camera_zoom", 1.0f));
+    }
+    if (changed({"flow_field_overlay"})) {
+        scene_.SetFlowFieldOverlay(renderer.value("flow_field_overlay", false));
+    }
+    if (changed({"palette"})) {
+        scene_.SetPalette(ParsePalette(Setting(renderer, "palette")));
+    }
+    if (changed({"hud_font"})) {
+        scene_.ConfigureHud(renderer.value("hud_font", std::string()));
+        if (previous) {
+            scene_.ReloadHud();
+        }
+    }
+    if (changed({"sprites_dir", "sprite_uploads_per_frame"})) {
+        scene_.ConfigureSprites(renderer.value("sprites_dir", std::string()),
+                                renderer.value("sprite_uploads_per_frame", 4));
+        if (previous && changed({"sprites_dir"})) {
+            scene_.ReloadSprites();
+        }
+    }
+}
+
+// Hot reload watches the config file, the sprite folder and the HUD font.
+void GameRenderer::WatchFiles() {
+    watcher_.Clear();
+    config_watch_ = -1;
+    sprites_watch_ = -1;
+    font_watch_ = -1;
+    if (!hot_reload_) {
+        return;
+    }
+    config_watch_ = watcher_.Add(config_path_);
+    const json renderer = config_.value("renderer", json::object());
+    const std::string sprites_dir = renderer.value("sprites_dir", std::string());
+    if (!sprites_dir.empty()) {
+        sprites_watch_ = watcher_.Add(sprites_dir);
+    }
+    const std::string hud_font = renderer.value("hud_font", std::string());
+    if (!hud_font.empty()) {
+        font_watch_ = watcher_.Add(hud_font);
+    }
+}
+
+// Between frames, before the frame's allocations are counted.
+void GameRenderer::CheckHotReload() {
+    const uint32_t changed = watcher_.Poll();
+    if (changed == 0) {
         return;
     }
+    const auto has = [changed](int watch) { return watch >= 0 && (changed & (1u << watch)) != 0; };
+    if (has(config_watch_)) {
+        ReloadConfig();
+    }
+    if (has(sprites_watch_)) {
+        TraceLog(LOG_INFO, "Sprites changed, reloading the atlas");
+        scene_.ReloadSprites();
+    }
+    if (has(font_watch_)) {
+        TraceLog(LOG_INFO, "HUD font changed, reloading it");
+        scene_.ReloadHud();
+    }
+}
 
+void GameRenderer::ReloadConfig() {
+    json config;
     try {
-        json state;
-        file >> state;
-        current_state_ = std::move(state);
-        if (current_state_.contains("tilemap")) {
-            const json& tilemap = current_state_["tilemap"];
-            tile_size_ = tilemap.value("tile_size", 32.0f);
-            room_width_ = tilemap.value("width", 0);
-            room_height_ = tilemap.value("height", 0);
-        }
+        config = LoadConfigFile(config_path_);
     } catch (const std::exception& e) {
-        TraceLog(LOG_WARNING, "Failed to parse game_state.json: %s", e.what());
+        TraceLog(LOG_WARNING, "Ignoring the change to %s, keeping the running config: %s", config_path_.c_str(),
+                 e.what());
+        return;
+    }
+    const json before = config_.value("renderer", json::object());
+    const json after = config.value("renderer", json::object());
+    ApplyRendererConfig(after, &before);
+
+    constexpr std::array<const char*, 5> kRestartKeys = {"render_threads", "particle_capacity", "record_dir",
+                                                         "record_compress", "hot_reload"};
+    for (const char* key : kRestartKeys) {
+        if (Setting(after, key) != Setting(before, key)) {
+            TraceLog(LOG_WARNING, "renderer.%s changed; it takes effect after a restart", key);
+        }
+    }
+    for (const char* section : {"ipc", "replay"}) {
+        if (Setting(config, section) != Setting(config_, section)) {
+            TraceLog(LOG_WARNING, "%s settings changed; they take effect after a restart", section);
+        }
+    }
+    const bool rewatch = Setting(after, "sprites_dir") != Setting(before, "sprites_dir") ||
+                         Setting(after, "hud_font") != Setting(before, "hud_font");
+    config_ = std::move(config);
+    if (rewatch) {
+        WatchFiles();
+    }
+    TraceLog(LOG_INFO, "Reloaded %s", config_path_.c_str());
+}
+
+void GameRenderer::OpenTransport() {
+    const json ipc = config_.value("ipc", json::object());
+    const std::string mode = ipc.value("transport", std::string("shared_memory"));
+    stats_log_interval_ = ipc.value("stats_log_interval", 10.0);
+    const std::string sync = ipc.value("sync", std::string("free"));
+    if (sync != "free" && sync != "lockstep") {
+        TraceLog(LOG_WARNING, "Unknown ipc sync mode '%s', using free", sync.c_str());
+    }
+    lockstep_ = sync == "lockstep";
+
+    const json replay = config_.value("replay", json::object());
+    const std::string replay_file = replay.value("file", std::string());
+    if (!replay_file.empty()) {
+        // Playing a recording: no simulation to pace, nothing to record.
+        auto transport = std::make_unique<ReplayTransport>(replay_file, replay.value("speed", 1.0),
+                                                           replay.value("start_tick", uint64_t{0}),
+                                                           replay.value("loop", false));
+        replay_ = transport.get();
+        replay_seek_step_ = replay.value("seek_step", replay_seek_step_);
+        transport_ = std::move(transport);
+        lockstep_ = false;
+        if (!transport_->Open()) {
+            TraceLog(LOG_WARNING, "Replay %s is not playable", replay_file.c_str());
+        }
+        ingest_.Start(*transport_);
+        return;
+    }
+
+    if (mode == "file") {
+        transport_ = std::make_unique<FileTransport>(shared_dir_);
+    } else if (mode == "tcp" || mode == "udp") {
+        const std::string role = ipc.value("net_role", std::string("player"));
+        if (role != "player" && role != "spectator") {
+            TraceLog(LOG_WARNING, "Unknown ipc net_role '%s', using player", role.c_str());
+        }
+        const int port = std::clamp(ipc.value("net_port", 47800), 1, 65535);
+        transport_ = std::make_unique<NetworkTransport>(
+            mode == "tcp" ? NetworkTransport::Protocol::Tcp : NetworkTransport::Protocol::Udp,
+            ipc.value("net_host", std::string("127.0.0.1")), static_cast<uint16_t>(port), role == "spectator");
+    } else {
+        if (mode != "shared_memory") {
+            TraceLog(LOG_WARNING, "Unknown ipc transport '%s', using shared_memory", mode.c_str());
+        }
+        const fs::path mapping_path = fs::path(shared_dir_) / ipc.value("shm_file", std::string("game_state.shm"));
+        transport_ = std::make_unique<SharedMemoryTransport>(mapping_path, shared_dir_);
+    }
+
+    if (lockstep_ && !transport_->SupportsPresentedTicks()) {
+        TraceLog(LOG_WARNING, "ipc sync lockstep needs the shared_memory transport; running free");
+        lockstep_ = false;
+    }
+    if (!transport_->Open()) {
+        TraceLog(LOG_INFO, "Transport '%s' not ready yet, waiting for the simulation", transport_->Name());
+    }
+    if (!record_dir_.empty()) {
+        ingest_.Record(record_dir_, record_compress_);
     }
+    ingest_.Start(*transport_);
+}
+
+// Snapshots are read and decoded on the ingest thread; a frame only swaps to
+// the newest finished world and advances interpolation.
+void GameRenderer::UpdateFromPython() {
+    CheckHotReload();
+    profiler_.BeginFrame();
+    frame_start_us_ = FrameProfiler::NowMicros();
+    frame_allocations_start_ = allocation_counter::ThreadAllocations();
+    input_allocations_ = 0;
+    MemoryTagScope memory(MemoryTag::Render);
+    ScopedTimer timer(profiler_, ProfileStage::Update);
+    const bool new_frame = ingest_.AcquireLatest();
+
+    const WorldSnapshot& world = ingest_.World();
+    interpolator_.Update(world, new_frame, GetTime());
+    frame_changed_ = new_frame;
+    if (new_frame) {
+        snapshot_arrived_us_ = frame_start_us_;
+        double queued_at = 0.0;
+        if (input_queue_.Acknowledge(world.meta.input_ack, queued_at)) {
+            acknowledged_input_time_ = queued_at;
+        }
+        profiler_.RecordValue(ProfileStage::Ingest, ingest_.Current().ingest_us);
+        ingest_allocations_ = ingest_.Current().allocations;
+    }
+    LogIngestStats();
+}
+
+void GameRenderer::LogIngestStats() {
+    if (stats_log_interval_ <= 0.0) {
+        return;
+    }
+    const double now = GetTime();
+    if (now < next_stats_log_time_) {
+        return;
+    }
+    if (next_stats_log_time_ > 0.0) {
+        const IngestStats stats = ingest_.Stats();
+        TraceLog(LOG_INFO, "Snapshot ingest: %llu parsed, %llu idle polls, %llu failed, %llu deltas dropped",
+                 static_cast<unsigned long long>(stats.snapshots_parsed),
+                 static_cast<unsigned long long>(stats.idle_polls),
+                 static_cast<unsigned long long>(stats.snapshots_failed),
+                 static_cast<unsigned long long>(stats.deltas_dropped));
+        if (const uint64_t lost = transport_ ? transport_->PayloadsLost() : 0) {
+            TraceLog(LOG_INFO, "Transport %s: %llu snapshots lost in transit", transport_->Name(),
+                     static_cast<unsigned long long>(lost));
+        }
+        TraceLog(LOG_INFO, "Latency (%s): snapshot age p50 %.1f ms p99 %.1f ms, input to present p50 %.1f ms p99 %.1f ms",
+                 lockstep_ ? "lockstep" : "free",
+                 profiler_.Percentile(ProfileStage::SnapshotAge, 0.50) / 1000.0,
+                 profiler_.Percentile(ProfileStage::SnapshotAge, 0.99) / 1000.0,
+                 profiler_.Percentile(ProfileStage::InputLatency, 0.50) / 1000.0,
+                 profiler_.Percentile(ProfileStage::InputLatency, 0.99) / 1000.0);
+        if (allocating_frames_ > 0) {
+            TraceLog(LOG_WARNING, "%llu frames allocated on the render thread since the last report",
+                     static_cast<unsigned long long>(allocating_frames_));
+            allocating_frames_ = 0;
+        }
+        LogMemory();
+    }
+    next_stats_log_time_ = now + stats_log_interval_;
+}
+
+// One line, formatted on the stack: this runs on the frame path.
+void GameRenderer::LogMemory() {
+    char line[512];
+    int length = 0;
+    for (size_t i = 0; i < allocation_counter::kMemoryTagCount; ++i) {
+        const MemoryTag tag = static_cast<MemoryTag>(i);
+        const allocation_counter::MemoryStats stats = allocation_counter::TagStats(tag);
+        length += std::snprintf(line + length, sizeof(line) - length, "%s %.1f (peak %.1f), ",
+                                allocation_counter::MemoryTagName(tag), stats.live_bytes / kMiB,
+                                stats.high_water_bytes / kMiB);
+    }
+    const allocation_counter::MemoryStats total = allocation_counter::TotalStats();
+    std::snprintf(line + length, sizeof(line) - length, "total %.1f (peak %.1f)", total.live_bytes / kMiB,
+                  total.high_water_bytes / kMiB);
+    TraceLog(LOG_INFO, "Memory MiB: %s", line);
 }
 
 void GameRenderer::HandleInput() {
+    ScopedTimer timer(profiler_, ProfileStage::Input);
+    // Input goes out through file writes, which allocate; it is not part of
+    // the allocation-free frame path.
+    const uint64_t input_allocations_start = allocation_counter::ThreadAllocations();
+    if (IsKeyPressed(KEY_F1)) {
+        show_profiler_ = !show_profiler_;
+    }
+    if (IsKeyPressed(KEY_F2)) {
+        ExportProfile();
+    }
+    if (IsKeyPressed(KEY_M)) {
+        scene_.ToggleOverview();
+    }
+    if (IsKeyPressed(KEY_F3)) {
+        scene_.ToggleFlowFieldOverlay();
+    }
+    if (replay_) {
+        HandleReplayKeys();
+    }
+
     Vector2 move{0.0f, 0.0f};
     if (IsKeyDown(KEY_W)) move.y -= 1.0f;
     if (IsKeyDown(KEY_S)) move.y += 1.0f;
@@ -65,24 +463,42 @@ void GameRenderer::HandleInput() {
     if (IsKeyDown(KEY_LEFT)) attack.x -= 1.0f;
     if (IsKeyDown(KEY_RIGHT)) attack.x += 1.0f;
 
-    const bool bomb = IsKeyPressed(KEY_SPACE);
-    const bool use_item = IsKeyPressed(KEY_E);
-    const bool pause = IsKeyPressed(KEY_P);
-    const bool quit = IsKeyPressed(KEY_ESCAPE);
-
-    json input = json::object();
-    input["move"] = { {"x", move.x}, {"y", move.y} };
-    input["attack"] = { {"x", attack.x}, {"y", attack.y} };
-    input["bomb"] = bomb;
-    input["use_item"] = use_item;
-    input["pause"] = pause;
-    input["quit"] = quit;
-
-    WriteInput(input);
+    InputState input;
+    input.move_x = move.x;
+    input.move_y = move.y;
+    input.attack_x = attack.x;
+    input.attack_y = attack.y;
+    input.bomb = IsKeyPressed(KEY_SPACE);
+    input.use_item = IsKeyPressed(KEY_E);
+    input.pause = IsKeyPressed(KEY_P);
+    input.quit = IsKeyPressed(KEY_ESCAPE);
+    input.resync = !ingest_.Current().synced;
+
+    // Changes are sent at once; otherwise a frame writes nothing unless events
+    // are still waiting for their ack.
+    const double now = GetTime();
+    if (input_queue_.Update(input, ingest_.World().meta.tick, now) ||
+        (input_queue_.Pending() > 0 && now - input_written_time_ >= kInputResendInterval)) {
+        WriteInput();
+    }
+    last_input_ = input;
 
-    if (quit) {
+    if (input.quit) {
         quit_requested_ = true;
     }
+    input_allocations_ += allocation_counter::ThreadAllocations() - input_allocations_start;
+}
+
+// PageUp/PageDown jump seek_step ticks forward/back, Home restarts.
+void GameRenderer::HandleReplayKeys() {
+    const uint64_t tick = replay_->CurrentTick();
+    if (IsKeyPressed(KEY_PAGE_UP)) {
+        replay_->RequestSeek(tick + replay_seek_step_);
+    } else if (IsKeyPressed(KEY_PAGE_DOWN)) {
+        replay_->RequestSeek(tick > replay_seek_step_ ? tick - replay_seek_step_ : 0);
+    } else if (IsKeyPressed(KEY_HOME)) {
+        replay_->RequestSeek(replay_->FirstTick());
+    }
 }
 
 bool GameRenderer::ShouldClose() {
@@ -94,295 +510,250 @@ bool GameRenderer::ShouldClose() {
 }
 
 void GameRenderer::SignalQuit() {
-    json quit_payload = {
-        {"move", { {"x", 0}, {"y", 0} }},
-        {"attack", { {"x", 0}, {"y", 0} }},
-        {"bomb", false},
-        {"use_item", false},
-        {"pause", false},
-        {"quit", true}
-    };
-    WriteInput(quit_payload);
+    InputState input;
+    input.quit = true;
+    input.resync = last_input_.resync;
+    input_queue_.Update(input, ingest_.World().meta.tick, GetTime());
+    WriteInput();
 }
 
-void GameRenderer::WriteInput(const json& input) {
-    const fs::path input_path = fs::path(shared_dir_) / "input.json";
-    std::ofstream file(input_path);
-    if (!file.is_open()) {
+void GameRenderer::WriteInput() {
+    input_written_time_ = GetTime();
+    if (!transport_ || !transport_->WriteInput(input_queue_.Serialize())) {
         TraceLog(LOG_WARNING, "Unable to write input.json");
-        return;
     }
-    file << input.dump(2);
 }
 
 void GameRenderer::RenderFrame() {
-    BeginDrawing();
-    ClearBackground(Color{16, 16, 24, 255});
-
-    DrawTilemap();
-    DrawPickups();
-    DrawActors();
-    DrawProjectiles();
-    DrawEffects();
-    DrawHud();
-
-    EndDrawing();
-}
-
-void GameRenderer::DrawTilemap() {
-    if (!current_state_.contains("tilemap")) {
+    if (SkipUnchangedFrame()) {
         return;
     }
-
-    const json& tilemap = current_state_["tilemap"];
-    if (!tilemap.contains("tiles")) {
-        return;
+    MemoryTagScope memory(MemoryTag::Render);
+    {
+        ScopedTimer timer(profiler_, ProfileStage::TileCache);
+        scene_.UpdateSprites();
+        const IngestFrame& frame = ingest_.Current();
+        scene_.UpdateCamera(frame.world, interpolator_.Actors());
+        scene_.UpdateTileCache(frame.world, frame.tile_layout_revision, frame.serial, frame.dirty_tiles);
     }
-
-    const auto& tiles = tilemap["tiles"];
-    const float offset_x = (GetScreenWidth() - room_width_ * tile_size_) * 0.5f;
-    const float offset_y = (GetScreenHeight() - room_height_ * tile_size_) * 0.5f;
-
-    for (size_t y = 0; y < tiles.size(); ++y) {
-        const auto& row = tiles[y];
-        for (size_t x = 0; x < row.size(); ++x) {
-            std::string tile = row[x].get<std::string>();
-            Rectangle rect{
-                offset_x + static_cast<float>(x) * tile_size_,
-                offset_y + static_cast<float>(y) * tile_size_,
-                tile_size_,
-                tile_size_
-            };
-            DrawRectangleRec(rect, TileFillColor(tile));
-            Color outline = TileOutlineColor(tile);
-            if (outline.a > 0) {
-                DrawRectangleLinesEx(rect, 1.0f, outline);
-            }
-        }
+    {
+        ScopedTimer timer(profiler_, ProfileStage::Hud);
+        scene_.UpdateHud(ingest_.World());
     }
-}
 
-void GameRenderer::DrawPickups() {
-    if (!current_state_.contains("pickups")) {
-        return;
+    const WorldSnapshot& world = ingest_.World();
+    {
+        ScopedTimer timer(profiler_, ProfileStage::Particles);
+        scene_.UpdateParticles(world, ingest_.Current().particle_spawns, GetFrameTime());
     }
-
-    for (const json& pickup : current_state_["pickups"]) {
-        const float x = pickup.value("x", 0.0f);
-        const float y = pickup.value("y", 0.0f);
-        const std::string kind = pickup.value("kind", std::string("coin"));
-        Vector2 pos = WorldToScreen(x, y);
-        DrawCircleV(pos, tile_size_ * 0.22f, PickupColor(kind));
+    {
+        ScopedTimer timer(profiler_, ProfileStage::BuildLists);
+        scene_.BuildEntityLayers(world, interpolator_.Actors(), interpolator_.Projectiles(), jobs_);
     }
-}
+    RecordLayerTimings();
 
-void GameRenderer::DrawActors() {
-    if (!current_state_.contains("actors")) {
-        return;
+    BeginDrawing();
+    ClearBackground(Color{16, 16, 24, 255});
+    {
+        ScopedTimer timer(profiler_, ProfileStage::Tilemap);
+        scene_.DrawTilemap(world);
+        scene_.DrawFlowField(world);
     }
-
-    for (const json& actor : current_state_["actors"]) {
-        const std::string type = actor.value("type", std::string("enemy"));
-        const std::string variant = actor.value("variant", std::string("default"));
-        const float x = actor.value("x", 0.0f);
-        const float y = actor.value("y", 0.0f);
-        Vector2 pos = WorldToScreen(x, y);
-
-        if (type == "player") {
-            Color fill = Color{120, 200, 255, 255};
-            if (actor.value("invulnerable", false)) {
-                fill = Color{255, 255, 180, 255};
-            }
-            DrawCircleV(pos, tile_size_ * 0.35f, fill);
-            DrawCircleLines(pos.x, pos.y, tile_size_ * 0.35f, Color{30, 30, 60, 255});
-        } else {
-            Color fill = variant == "spitter" ? Color{220, 90, 90, 255} : Color{200, 120, 120, 255};
-            DrawCircleV(pos, tile_size_ * 0.32f, fill);
-            DrawCircleLines(pos.x, pos.y, tile_size_ * 0.32f, Color{60, 20, 20, 255});
-
-            const int hp = actor.value("hp", 0);
-            const int max_hp = std::max(1, actor.value("max_hp", 1));
-            float bar_width = tile_size_ * 0.6f;
-            Rectangle background{
-                pos.x - bar_width / 2.0f,
-                pos.y - tile_size_ * 0.5f,
-                bar_width,
-                4.0f
-            };
-            DrawRectangleRec(background, Color{30, 10, 10, 180});
-            Rectangle foreground = background;
-            foreground.width *= static_cast<float>(hp) / static_cast<float>(max_hp);
-            DrawRectangleRec(foreground, Color{220, 40, 40, 200});
-        }
+    {
+        ScopedTimer timer(profiler_, ProfileStage::Shapes);
+        scene_.DrawEntityLayers();
     }
-}
-
-void GameRenderer::DrawProjectiles() {
-    if (!current_state_.contains("projectiles")) {
-        return;
+    {
+        ScopedTimer timer(profiler_, ProfileStage::Hud);
+        scene_.DrawHud();
+    }
+    if (show_profiler_) {
+        DrawProfilerOverlay();
     }
 
-    for (const json& projectile : current_state_["projectiles"]) {
-        const float x = projectile.value("x", 0.0f);
-        const float y = projectile.value("y", 0.0f);
-        const std::string owner = projectile.value("owner", std::string("player"));
-        Vector2 pos = WorldToScreen(x, y);
-        Color color = owner == "player" ? Color{150, 220, 255, 255} : Color{255, 150, 150, 255};
-        DrawCircleV(pos, tile_size_ * 0.18f, color);
+    RecordSnapshotAge();
+    const int64_t work_end_us = FrameProfiler::NowMicros();
+    {
+        // Includes the SetTargetFPS wait, so it is the frame's idle time too.
+        ScopedTimer timer(profiler_, ProfileStage::Present);
+        EndDrawing();
+    }
+    // Takes effect from the next frame's recording.
+    if (pacer_.EndFrame(work_end_us - frame_start_us_, FrameProfiler::NowMicros() - frame_start_us_)) {
+        scene_.SetQualityLevel(pacer_.Level());
+    }
+    RecordPresented();
+    if (frames_rendered_ == 0) {
+        ReportStartup();
     }
+    profiler_.EndFrame();
+    CheckAllocations();
+    memory_budget_.Check();
 }
 
-void GameRenderer::DrawEffects() {
-    if (!current_state_.contains("effects")) {
+// Where the time to the first picture went. Sprites finish later, over the
+// first frames; SpriteAtlas reports them when the last one is uploaded.
+void GameRenderer::ReportStartup() {
+    const int64_t presented_us = FrameProfiler::NowMicros();
+    TraceLog(LOG_INFO,
+             "Startup: config %.1f ms, transport %.1f ms, window %.1f ms, scene %.1f ms, first frame presented "
+             "%.1f ms after start (%d sprites ready%s)",
+             (startup_.config_us - startup_.started_us) / 1000.0,
+             (startup_.transport_us - startup_.config_us) / 1000.0,
+             (startup_.window_us - startup_.transport_us) / 1000.0, (startup_.scene_us - startup_.window_us) / 1000.0,
+             (presented_us - startup_.started_us) / 1000.0, scene_.Sprites().Loaded(),
+             scene_.Sprites().Loading() ? ", more loading" : "");
+}
+
+// Once warmed up, a frame (snapshot swap, interpolation, every draw pass)
+// should not touch the heap. Frames that do are counted and reported with the
+// ingest stats; with renderer.assert_zero_allocations set, debug builds stop
+// at the first one.
+void GameRenderer::CheckAllocations() {
+    render_allocations_ = allocation_counter::ThreadAllocations() - frame_allocations_start_ - input_allocations_;
+    if (++frames_rendered_ <= kAllocationWarmupFrames || render_allocations_ == 0) {
         return;
     }
+    ++allocating_frames_;
+    assert(!assert_zero_allocations_ && "heap allocation on the steady-state frame path");
+}
 
-    for (const json& effect : current_state_["effects"]) {
-        const float x = effect.value("x", 0.0f);
-        const float y = effect.value("y", 0.0f);
-        const std::string kind = effect.value("kind", std::string("impact"));
-        Vector2 pos = WorldToScreen(x, y);
-        Color color = kind == "blood_splatter" ? Color{200, 40, 40, 180} : Color{220, 220, 255, 180};
-        DrawCircleLines(pos.x, pos.y, tile_size_ * 0.28f, color);
+// The draw passes timed themselves; their spans go into the profile as stages.
+void GameRenderer::RecordLayerTimings() {
+    constexpr std::array<std::pair<SceneRenderer::Layer, ProfileStage>, 4> kLayerStages = {{
+        {SceneRenderer::Layer::Pickups, ProfileStage::Pickups},
+        {SceneRenderer::Layer::Actors, ProfileStage::Actors},
+        {SceneRenderer::Layer::Projectiles, ProfileStage::Projectiles},
+        {SceneRenderer::Layer::Effects, ProfileStage::Effects},
+    }};
+    for (const auto& [layer, stage] : kLayerStages) {
+        const SceneRenderer::LayerTiming timing = scene_.Timing(layer);
+        profiler_.Record(stage, timing.start_us, timing.duration_us);
     }
 }
 
-void GameRenderer::DrawHud() {
-    DrawMessages();
-    DrawBossHealth();
-
-    if (!current_state_.contains("meta")) {
+// Age of the snapshot on screen: now minus the wall-clock time the simulation
+// published it. Needs both processes on one machine; skipped when the
+// producer does not stamp meta.timestamp_us, and for replays.
+void GameRenderer::RecordSnapshotAge() {
+    const uint64_t produced_us = ingest_.World().meta.timestamp_us;
+    if (produced_us == 0 || replay_) {
         return;
     }
+    using namespace std::chrono;
+    const int64_t now_us = duration_cast<microseconds>(system_clock::now().time_since_epoch()).count();
+    profiler_.RecordValue(ProfileStage::SnapshotAge, std::max<int64_t>(0, now_us - static_cast<int64_t>(produced_us)));
+}
 
-    const json& meta = current_state_["meta"];
-    const int hp = meta.value("player_hp", 0);
-    const int max_hp = meta.value("player_max_hp", std::max(hp, 1));
-    const int coins = meta.value("coins", 0);
-    const int keys = meta.value("keys", 0);
-    const int bombs = meta.value("bombs", 0);
-
-    const float heart_size = 20.0f;
-    const float start_x = 20.0f;
-    const float start_y = 20.0f;
-
-    for (int i = 0; i < max_hp; ++i) {
-        Rectangle heart{
-            start_x + i * (heart_size + 6.0f),
-            start_y,
-            heart_size,
-            heart_size
-        };
-        Color fill = i < hp ? Color{220, 30, 60, 255} : Color{80, 40, 40, 255};
-        DrawRectangleRec(heart, fill);
-        DrawRectangleLinesEx(heart, 1.5f, Color{30, 10, 10, 255});
+// Tells the simulation which tick is on screen (lockstep waits on it), and
+// closes the input-to-present measurement for input the snapshot applied.
+void GameRenderer::RecordPresented() {
+    if (transport_) {
+        transport_->ReportPresented(ingest_.World().meta.tick);
+    }
+    if (acknowledged_input_time_ >= 0.0) {
+        profiler_.RecordValue(ProfileStage::InputLatency,
+                              static_cast<int64_t>((GetTime() - acknowledged_input_time_) * 1000000.0));
+        acknowledged_input_time_ = -1.0;
     }
-
-    DrawText(TextFormat("Coins: %d  Keys: %d  Bombs: %d", coins, keys, bombs), 20, 50, 20, Color{235, 235, 235, 255});
 }
 
-void GameRenderer::DrawMessages() {
-    if (!current_state_.contains("ui")) {
-        return;
+// In lockstep without interpolation nothing on screen moves between ticks,
+// so frames without a new snapshot only poll input instead of redrawing the
+// same image. The frame's profile sample is dropped with it. Without
+// EndDrawing nothing paces the skipped frame, so it sleeps until the next
+// frame slot, or until the next tick's snapshot is due if that is sooner; an
+// uncapped renderer's slot is one tick.
+bool GameRenderer::SkipUnchangedFrame() {
+    if (!lockstep_ || interpolator_.Enabled() || frame_changed_ || show_profiler_ || frames_rendered_ == 0 ||
+        scene_.Particles().Live() > 0) {
+        return false;
     }
-    const json& ui = current_state_["ui"];
-    if (!ui.contains("messages")) {
-        return;
+    PollInputEvents();
+    const float delta_time = ingest_.World().meta.delta_time;
+    const int64_t tick_us = delta_time > 0.0f ? static_cast<int64_t>(delta_time * 1000000.0f) : kDefaultTickMicros;
+    const int64_t slot_us = pacer_.CapFps() > 0 ? 1000000 / pacer_.CapFps() : tick_us;
+    const int64_t now_us = FrameProfiler::NowMicros();
+    int64_t wake_us = frame_start_us_ + slot_us;
+    const int64_t snapshot_due_us = snapshot_arrived_us_ + tick_us;
+    if (snapshot_due_us > now_us) {
+        wake_us = std::min(wake_us, snapshot_due_us);
     }
-    const auto& messages = ui["messages"];
-    int y = GetScreenHeight() - 20;
-    for (auto it = messages.rbegin(); it != messages.rend(); ++it) {
-        const std::string text = it->get<std::string>();
-        y -= 22;
-        DrawText(text.c_str(), 20, y, 18, Color{230, 230, 230, 255});
+    if (wake_us > now_us) {
+        WaitTime(static_cast<double>(wake_us - now_us) / 1000000.0);
     }
+    return true;
 }
 
-void GameRenderer::DrawBossHealth() {
-    if (!current_state_.contains("ui")) {
+void GameRenderer::ExportProfile() {
+    try {
+        fs::create_directories(profile_dir_);
+    } catch (const std::exception& e) {
+        TraceLog(LOG_WARNING, "Failed to create %s: %s", profile_dir_.c_str(), e.what());
         return;
     }
-    const json& ui = current_state_["ui"];
-    if (!ui.contains("boss_health") || ui["boss_health"].is_null()) {
-        return;
+    const std::string csv_path = (fs::path(profile_dir_) / "frame_profile.csv").string();
+    const std::string trace_path = (fs::path(profile_dir_) / "frame_trace.json").string();
+    if (profiler_.ExportCsv(csv_path) && profiler_.ExportChromeTrace(trace_path)) {
+        TraceLog(LOG_INFO, "Wrote frame profile to %s and %s", csv_path.c_str(), trace_path.c_str());
+    } else {
+        TraceLog(LOG_WARNING, "Unable to write frame profile to %s", profile_dir_.c_str());
     }
-    const json& boss = ui["boss_health"];
-    const int hp = boss.value("hp", 0);
-    const int max_hp = std::max(1, boss.value("max_hp", 1));
-    const std::string name = boss.value("name", std::string("Boss"));
-
-    const float width = GetScreenWidth() * 0.4f;
-    const float height = 18.0f;
-    const float x = (GetScreenWidth() - width) * 0.5f;
-    const float y = GetScreenHeight() - 60.0f;
-
-    Rectangle bg{x, y, width, height};
-    DrawRectangleRec(bg, Color{40, 10, 10, 200});
-
-    Rectangle fg = bg;
-    fg.width *= static_cast<float>(hp) / static_cast<float>(max_hp);
-    DrawRectangleRec(fg, Color{200, 40, 40, 255});
-
-    DrawText(name.c_str(), static_cast<int>(x), static_cast<int>(y - 22), 20, Color{240, 240, 240, 255});
 }
 
-Color GameRenderer::TileFillColor(const std::string& tile) const {
-    static const std::unordered_map<std::string, Color> colors = {
-        {"floor", Color{60, 52, 65, 255}},
-        {"wall", Color{90, 92, 112, 255}},
-        {"pit", Color{20, 20, 32, 255}},
-        {"rock", Color{120, 120, 140, 255}},
-        {"spikes", Color{110, 40, 40, 255}},
-        {"door_up", Color{150, 120, 60, 255}},
-        {"door_down", Color{150, 120, 60, 255}},
-        {"door_left", Color{150, 120, 60, 255}},
-        {"door_right", Color{150, 120, 60, 255}},
-        {"special", Color{100, 50, 130, 255}},
-    };
-    const auto it = colors.find(tile);
-    if (it != colors.end()) {
-        return it->second;
+void GameRenderer::DrawProfilerOverlay() {
+    const int font_size = 14;
+    const int line_height = 16;
+    const int width = 250;
+    const int x = GetScreenWidth() - width - 10;
+    int y = 10;
+    const int lines = static_cast<int>(FrameProfiler::kStageCount + allocation_counter::kMemoryTagCount) +
+                      (replay_ ? 7 : 6);
+
+    DrawRectangle(x - 8, y - 6, width + 8, lines * line_height + 12, Color{0, 0, 0, 170});
+    DrawText("stage            p50 ms   p99 ms", x, y, font_size, Color{200, 200, 200, 255});
+    for (size_t i = 0; i < FrameProfiler::kStageCount; ++i) {
+        y += line_height;
+        const ProfileStage stage = static_cast<ProfileStage>(i);
+        const double p50 = profiler_.Percentile(stage, 0.50) / 1000.0;
+        const double p99 = profiler_.Percentile(stage, 0.99) / 1000.0;
+        DrawText(FrameProfiler::StageName(stage), x, y, font_size, Color{235, 235, 235, 255});
+        DrawText(TextFormat("%7.2f  %7.2f", p50, p99), x + 120, y, font_size, Color{235, 235, 235, 255});
     }
-    return Color{50, 48, 60, 255};
-}
-
-Color GameRenderer::TileOutlineColor(const std::string& tile) const {
-    static const std::unordered_map<std::string, Color> outlines = {
-        {"wall", Color{15, 15, 25, 180}},
-        {"rock", Color{30, 30, 40, 200}},
-        {"spikes", Color{200, 40, 60, 255}},
-        {"door_up", Color{240, 190, 90, 255}},
-        {"door_down", Color{240, 190, 90, 255}},
-        {"door_left", Color{240, 190, 90, 255}},
-        {"door_right", Color{240, 190, 90, 255}},
-        {"special", Color{200, 120, 255, 255}},
-    };
-    const auto it = outlines.find(tile);
-    if (it != outlines.end()) {
-        return it->second;
+    y += line_height;
+    DrawText(TextFormat("allocs/frame  render %llu  ingest %llu", static_cast<unsigned long long>(render_allocations_),
+                        static_cast<unsigned long long>(ingest_allocations_)),
+             x, y, font_size, Color{235, 235, 235, 255});
+    y += line_height;
+    const SceneRenderer::CullStats& cull = scene_.Stats();
+    DrawText(TextFormat("visible  tiles %d/%d  entities %u/%u", cull.visible_tiles, cull.room_tiles,
+                        cull.drawn_entities, cull.drawn_entities + cull.culled_entities),
+             x, y, font_size, Color{235, 235, 235, 255});
+    y += line_height;
+    DrawText(TextFormat("pacing  %s %d fps  quality %d/%d  load %.2f", FramePacer::ModeName(pacer_.GetMode()),
+                        pacer_.CapFps(), pacer_.Level(), SceneRenderer::kQualityLevels - 1, pacer_.Load()),
+             x, y, font_size, Color{235, 235, 235, 255});
+    if (replay_) {
+        y += line_height;
+        DrawText(TextFormat("replay  tick %llu / %llu", static_cast<unsigned long long>(replay_->CurrentTick()),
+                            static_cast<unsigned long long>(replay_->LastTick())),
+                 x, y, font_size, Color{235, 235, 235, 255});
     }
-    return Color{0, 0, 0, 0};
-}
 
-Color GameRenderer::PickupColor(const std::string& pickup) const {
-    static const std::unordered_map<std::string, Color> colors = {
-        {"heart", Color{220, 60, 80, 255}},
-        {"coin", Color{230, 200, 80, 255}},
-        {"key", Color{180, 180, 200, 255}},
-        {"bomb", Color{90, 90, 90, 255}},
+    // Red once a budget has been exceeded.
+    auto draw_memory = [&](const char* name, const allocation_counter::MemoryStats& stats, bool over) {
+        const Color color = over ? Color{255, 120, 120, 255} : Color{235, 235, 235, 255};
+        y += line_height;
+        DrawText(name, x, y, font_size, color);
+        DrawText(TextFormat("%7.1f  %7.1f", stats.live_bytes / kMiB, stats.high_water_bytes / kMiB), x + 120, y,
+                 font_size, color);
     };
-    const auto it = colors.find(pickup);
-    if (it != colors.end()) {
-        return it->second;
+    y += line_height;
+    DrawText("memory          MiB     peak", x, y, font_size, Color{200, 200, 200, 255});
+    for (size_t i = 0; i < allocation_counter::kMemoryTagCount; ++i) {
+        const MemoryTag tag = static_cast<MemoryTag>(i);
+        draw_memory(allocation_counter::MemoryTagName(tag), allocation_counter::TagStats(tag),
+                    memory_budget_.Over(tag));
     }
-    return Color{220, 220, 220, 255};
+    draw_memory("total", allocation_counter::TotalStats(), memory_budget_.TotalOver());
 }
-
-Vector2 GameRenderer::WorldToScreen(float x, float y) const {
-    const float offset_x = (GetScreenWidth() - room_width_ * tile_size_) * 0.5f;
-    const float offset_y = (GetScreenHeight() - room_height_ * tile_size_) * 0.5f;
-    return {
-        offset_x + (x + 0.5f) * tile_size_,
-        offset_y + (y + 0.5f) * tile_size_
-    };
-}
\ No newline at end of file
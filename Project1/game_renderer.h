@@ -1,6 +1,19 @@
 #pragma once
 #include "raylib.h"
+#include "frame_pacer.h"
+#include "file_watcher.h"
+#include "frame_profiler.h"
+#include "input_queue.h"
+#include "job_system.h"
+#include "memory_budget.h"
+#include "replay_transport.h"
+#include "scene_renderer.h"
+#include "snapshot_ingest.h"
+#include "state_transport.h"
+#include "world_interpolator.h"
+#include "world_snapshot.h"
 
+#include <memory>
 #include <nlohmann/json.hpp>
 #include <string>
 
@@ -13,27 +26,81 @@ public:
     void RenderFrame();
     bool ShouldClose();
     void SignalQuit();
+    IngestStats GetIngestStats() const { return ingest_.Stats(); }
 
 private:
-    nlohmann::json current_state_;
+    // FrameProfiler::NowMicros at the end of each Initialize step.
+    struct StartupTimes {
+        int64_t started_us = 0;
+        int64_t config_us = 0;
+        int64_t transport_us = 0;
+        int64_t window_us = 0;
+        int64_t scene_us = 0;
+    };
+
+    nlohmann::json config_;
+    std::unique_ptr<StateTransport> transport_;
+    SnapshotIngest ingest_;
+    WorldInterpolator interpolator_;
+    InputQueue input_queue_;
+    InputState last_input_;
+    FramePacer pacer_;
+    int window_width_ = 1280;
+    int window_height_ = 720;
+    int64_t frame_start_us_ = 0;  // FrameProfiler::NowMicros at BeginFrame
+    int64_t snapshot_arrived_us_ = 0;  // frame_start_us_ of the frame that took the newest snapshot
+    double stats_log_interval_ = 10.0;
+    double next_stats_log_time_ = 0.0;
+    SceneRenderer scene_;
+    JobSystem jobs_;
+    int render_threads_ = 0;  // renderer.render_threads; 0 = auto
+    FrameProfiler profiler_;
+    bool show_profiler_ = false;
+    std::string profile_dir_ = "profile";
+    bool assert_zero_allocations_ = false;
+    uint64_t frames_rendered_ = 0;
+    uint64_t frame_allocations_start_ = 0;
+    uint64_t input_allocations_ = 0;
+    uint64_t render_allocations_ = 0;   // last frame, render thread
+    uint64_t ingest_allocations_ = 0;   // last acquired frame, ingest thread
+    uint64_t allocating_frames_ = 0;    // since the last stats log, after warm-up
+    MemoryBudget memory_budget_;         // renderer.memory_budgets
+    std::string config_path_ = "game_config.yaml";
     std::string shared_dir_ = "shared";
-    float tile_size_ = 32.0f;
-    int room_width_ = 0;
-    int room_height_ = 0;
     bool quit_requested_ = false;
+    bool lockstep_ = false;              // ipc.sync: lockstep
+    bool frame_changed_ = true;          // a new snapshot arrived this frame
+    double input_written_time_ = 0.0;
+    double acknowledged_input_time_ = -1.0;  // oldest input the new snapshot applied, until presented
+    std::string record_dir_;             // renderer.record_dir, empty = not recording
+    bool record_compress_ = true;
+    ReplayTransport* replay_ = nullptr;  // transport_ when replay.file is set
+    uint64_t replay_seek_step_ = 600;
+    StartupTimes startup_;
+    bool hot_reload_ = true;  // renderer.hot_reload
+    FileWatcher watcher_;
+    int config_watch_ = -1;   // watcher_ bits, -1 = not watched
+    int sprites_watch_ = -1;
+    int font_watch_ = -1;
 
     void EnsureSharedDirectory();
-    void WriteInput(const nlohmann::json& input);
-    void DrawTilemap();
-    void DrawPickups();
-    void DrawActors();
-    void DrawProjectiles();
-    void DrawEffects();
-    void DrawHud();
-    void DrawMessages();
-    void DrawBossHealth();
-    Color TileFillColor(const std::string& tile) const;
-    Color TileOutlineColor(const std::string& tile) const;
-    Color PickupColor(const std::string& pickup) const;
-    Vector2 WorldToScreen(float x, float y) const;
+    void LoadConfig();
+    void ApplyRendererConfig(const nlohmann::json& renderer, const nlohmann::json* previous);
+    void WatchFiles();
+    void CheckHotReload();
+    void ReloadConfig();
+    void OpenTransport();
+    void WriteInput();
+    void LogIngestStats();
+    void HandleReplayKeys();
+    void DrawProfilerOverlay();
+    void LogMemory();
+    // The entity layers' recording times, from whichever threads ran them.
+    void RecordLayerTimings();
+    void RecordSnapshotAge();
+    void RecordPresented();
+    bool SkipUnchangedFrame();
+    void CheckAllocations();
+    void ReportStartup();
+    void ExportProfile();
 };
\ No newline at end of file
@@ -0,0 +1,220 @@
+#include "hud_layer.h"
+
+#include "memory_budget.h"
+#include "rlgl.h"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace {
+
+// Size the font file is baked at; the HUD draws at 18 and 20.
+constexpr int kBakedFontSize = 20;
+
+}  // namespace
+
+bool HudLayer::Values::operator==(const Values& other) const {
+    return screen_width == other.screen_width && screen_height == other.screen_height && hp == other.hp &&
+           max_hp == other.max_hp && coins == other.coins && keys == other.keys && bombs == other.bombs &&
+           boss_active == other.boss_active && boss_hp == other.boss_hp && boss_max_hp == other.boss_max_hp;
+}
+
+void HudLayer::Load() {
+    allocation_counter::MemoryTagScope memory(allocation_counter::MemoryTag::Hud);
+    font_ = GetFontDefault();
+    owns_font_ = false;
+    if (!font_path_.empty()) {
+        if (FileExists(font_path_.c_str())) {
+            Font baked = LoadFontEx(font_path_.c_str(), kBakedFontSize, nullptr, 0);
+            if (baked.texture.id != 0) {
+                SetTextureFilter(baked.texture, TEXTURE_FILTER_BILINEAR);
+                font_ = baked;
+                owns_font_ = true;
+                allocation_counter::AddExternalBytes(allocation_counter::MemoryTag::Hud, TextureBytes(font_.texture));
+            }
+        }
+        if (!owns_font_) {
+            TraceLog(LOG_WARNING, "Unable to load HUD font %s, using the default font", font_path_.c_str());
+        }
+    }
+    valid_ = false;
+}
+
+void HudLayer::Unload() {
+    if (target_.id != 0) {
+        allocation_counter::AddExternalBytes(allocation_counter::MemoryTag::Hud, -TextureBytes(target_));
+        UnloadRenderTexture(target_);
+        target_ = RenderTexture2D{};
+    }
+    if (owns_font_) {
+        allocation_counter::AddExternalBytes(allocation_counter::MemoryTag::Hud, -TextureBytes(font_.texture));
+        UnloadFont(font_);
+        owns_font_ = false;
+    }
+    font_ = Font{};
+    valid_ = false;
+}
+
+void HudLayer::Update(const WorldSnapshot& world) {
+    allocation_counter::MemoryTagScope memory(allocation_counter::MemoryTag::Hud);
+    const SnapshotMeta& meta = world.meta;
+    Values values;
+    values.screen_width = GetScreenWidth();
+    values.screen_height = GetScreenHeight();
+    values.hp = meta.player_hp;
+    values.max_hp = meta.player_max_hp;
+    values.coins = meta.coins;
+    values.keys = meta.keys;
+    values.bombs = meta.bombs;
+    values.boss_active = world.boss.active;
+    values.boss_hp = world.boss.active ? world.boss.hp : 0;
+    values.boss_max_hp = world.boss.active ? std::max(1, world.boss.max_hp) : 1;
+    ++frames_since_rebuild_;
+    if (valid_ && !Changed(values, world)) {
+        return;
+    }
+    const bool resized = values.screen_width != values_.screen_width || values.screen_height != values_.screen_height;
+    if (valid_ && !resized && frames_since_rebuild_ < rebuild_interval_) {
+        return;  // still changed next frame, so it is drawn once the interval is up
+    }
+    if (values.screen_width <= 0 || values.screen_height <= 0) {
+        return;
+    }
+
+    if (target_.id == 0 || target_.texture.width != values.screen_width ||
+        target_.texture.height != values.screen_height) {
+        if (target_.id != 0) {
+            allocation_counter::AddExternalBytes(allocation_counter::MemoryTag::Hud, -TextureBytes(target_));
+            UnloadRenderTexture(target_);
+        }
+        target_ = LoadRenderTexture(values.screen_width, values.screen_height);
+        if (target_.id == 0) {
+            return;
+        }
+        allocation_counter::AddExternalBytes(allocation_counter::MemoryTag::Hud, TextureBytes(target_));
+    }
+    Rasterize(world);
+    Remember(values, world);
+    valid_ = true;
+    ++rebuilds_;
+    frames_since_rebuild_ = 0;
+}
+
+void HudLayer::Draw() const {
+    if (!valid_) {
+        return;
+    }
+    // Render textures are stored bottom-up; a negative source height flips
+    // them. The texture holds premultiplied colour (see Rasterize).
+    const Texture2D& texture = target_.texture;
+    const Rectangle source{0.0f, 0.0f, static_cast<float>(texture.width), -static_cast<float>(texture.height)};
+    BeginBlendMode(BLEND_ALPHA_PREMULTIPLY);
+    DrawTextureRec(texture, source, Vector2{0.0f, 0.0f}, WHITE);
+    EndBlendMode();
+}
+
+bool HudLayer::Changed(const Values& values, const WorldSnapshot& world) const {
+    if (!(values == values_) || world.messages.size() != message_count_) {
+        return true;
+    }
+    if (values.boss_active && world.boss.name != boss_name_) {
+        return true;
+    }
+    for (size_t i = 0; i < message_count_; ++i) {
+        if (world.messages[i] != messages_[i]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void HudLayer::Remember(const Values& values, const WorldSnapshot& world) {
+    values_ = values;
+    message_count_ = world.messages.size();
+    if (messages_.size() < message_count_) {
+        messages_.resize(message_count_);
+    }
+    for (size_t i = 0; i < message_count_; ++i) {
+        messages_[i].assign(world.messages[i]);
+    }
+    boss_name_.assign(world.boss.name);
+}
+
+// Plain alpha blending into a cleared target would square the alpha of
+// translucent pixels. Colour is blended as usual but alpha accumulates as
+// src + dst * (1 - src), which leaves premultiplied colour in the texture
+// for Draw to composite.
+void HudLayer::Rasterize(const WorldSnapshot& world) {
+    BeginTextureMode(target_);
+    ClearBackground(BLANK);
+    rlSetBlendFactorsSeparate(RL_SRC_ALPHA, RL_ONE_MINUS_SRC_ALPHA, RL_ONE, RL_ONE_MINUS_SRC_ALPHA, RL_FUNC_ADD,
+                              RL_FUNC_ADD);
+    BeginBlendMode(BLEND_CUSTOM_SEPARATE);
+    DrawMessages(world);
+    DrawBossHealth(world);
+    DrawCounters(world);
+    EndBlendMode();
+    EndTextureMode();
+}
+
+void HudLayer::DrawCounters(const WorldSnapshot& world) {
+    const SnapshotMeta& meta = world.meta;
+    const float heart_size = 20.0f;
+    const float start_x = 20.0f;
+    const float start_y = 20.0f;
+
+    for (int i = 0; i < meta.player_max_hp; ++i) {
+        Rectangle heart{
+            start_x + i * (heart_size + 6.0f),
+            start_y,
+            heart_size,
+            heart_size
+        };
+        Color fill = i < meta.player_hp ? Color{220, 30, 60, 255} : Color{80, 40, 40, 255};
+        DrawRectangleRec(heart, fill);
+        DrawRectangleLinesEx(heart, 1.5f, Color{30, 10, 10, 255});
+    }
+
+    char line[96];
+    std::snprintf(line, sizeof(line), "Coins: %d  Keys: %d  Bombs: %d", meta.coins, meta.keys, meta.bombs);
+    DrawLabel(line, 20.0f, 50.0f, 20.0f, Color{235, 235, 235, 255});
+}
+
+void HudLayer::DrawMessages(const WorldSnapshot& world) {
+    const auto& messages = world.messages;
+    float y = GetScreenHeight() - 20.0f;
+    for (auto it = messages.rbegin(); it != messages.rend(); ++it) {
+        y -= 22.0f;
+        DrawLabel(it->c_str(), 20.0f, y, 18.0f, Color{230, 230, 230, 255});
+    }
+}
+
+void HudLayer::DrawBossHealth(const WorldSnapshot& world) {
+    const BossHealth& boss = world.boss;
+    if (!boss.active) {
+        return;
+    }
+    const int max_hp = std::max(1, boss.max_hp);
+
+    const float width = GetScreenWidth() * 0.4f;
+    const float height = 18.0f;
+    const float x = (GetScreenWidth() - width) * 0.5f;
+    const float y = GetScreenHeight() - 60.0f;
+
+    Rectangle bg{x, y, width, height};
+    DrawRectangleRec(bg, Color{40, 10, 10, 200});
+
+    Rectangle fg = bg;
+    fg.width *= static_cast<float>(boss.hp) / static_cast<float>(max_hp);
+    DrawRectangleRec(fg, Color{200, 40, 40, 255});
+
+    DrawLabel(boss.name.c_str(), x, y - 22.0f, 20.0f, Color{240, 240, 240, 255});
+}
+
+// Matches DrawText's spacing for the default font (size / base size), and
+// keeps glyph positions on whole pixels.
+void HudLayer::DrawLabel(const char* text, float x, float y, float size, Color color) const {
+    const float spacing = size / static_cast<float>(std::max(1, font_.baseSize));
+    DrawTextEx(font_, text, Vector2{static_cast<float>(static_cast<int>(x)), static_cast<float>(static_cast<int>(y))},
+               size, spacing, color);
+}
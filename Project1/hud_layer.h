@@ -0,0 +1,71 @@
+#pragma once
+#include "raylib.h"
+#include "world_snapshot.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// The HUD (hearts, counters, messages, boss bar) rasterized into a
+// screen-sized render texture that is redrawn only when a value it shows
+// changes, then composited with a single textured quad. Text comes from one
+// glyph atlas: a font file baked at load time, or raylib's built-in font.
+class HudLayer {
+public:
+    // font_path may be empty; call before Load.
+    void Configure(const std::string& font_path) { font_path_ = font_path; }
+    // Redraw at most once every frames frames, so a stream of changes (a
+    // boss losing health every tick) costs fewer rasterizations; the HUD
+    // shows the newest values when it does. 1 redraws on every change. A
+    // resize always redraws at once.
+    void SetRebuildInterval(int frames) { rebuild_interval_ = frames > 1 ? frames : 1; }
+
+    // Requires a GL context, so call after InitWindow.
+    void Load();
+    void Unload();
+
+    // Call once per frame before BeginDrawing.
+    void Update(const WorldSnapshot& world);
+    void Draw() const;
+
+    uint64_t Rebuilds() const { return rebuilds_; }
+
+private:
+    // Everything the HUD shows apart from the message and boss name strings.
+    struct Values {
+        int screen_width = 0;
+        int screen_height = 0;
+        int hp = 0;
+        int max_hp = 0;
+        int coins = 0;
+        int keys = 0;
+        int bombs = 0;
+        bool boss_active = false;
+        int boss_hp = 0;
+        int boss_max_hp = 1;
+
+        bool operator==(const Values& other) const;
+    };
+
+    bool Changed(const Values& values, const WorldSnapshot& world) const;
+    void Remember(const Values& values, const WorldSnapshot& world);
+    void Rasterize(const WorldSnapshot& world);
+    void DrawCounters(const WorldSnapshot& world);
+    void DrawMessages(const WorldSnapshot& world);
+    void DrawBossHealth(const WorldSnapshot& world);
+    void DrawLabel(const char* text, float x, float y, float size, Color color) const;
+
+    std::string font_path_;
+    Font font_{};
+    bool owns_font_ = false;
+    RenderTexture2D target_{};
+    bool valid_ = false;
+    Values values_;
+    // Grow-only, so a steady stream of messages reuses string capacity.
+    std::vector<std::string> messages_;
+    size_t message_count_ = 0;
+    std::string boss_name_;
+    uint64_t rebuilds_ = 0;
+    int rebuild_interval_ = 1;
+    int frames_since_rebuild_ = 0;
+};
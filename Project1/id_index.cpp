@@ -0,0 +1,110 @@
+#include "id_index.h"
+
+#include <utility>
+
+namespace {
+
+constexpr size_t kMinCapacity = 16;
+
+}  // namespace
+
+void IdIndex::Clear() {
+    for (Slot& slot : slots_) {
+        slot.row = kMissing;
+    }
+    size_ = 0;
+}
+
+// Keeps the load factor at or below one half.
+void IdIndex::Reserve(size_t count) {
+    size_t capacity = slots_.empty() ? kMinCapacity : slots_.size();
+    while (capacity < count * 2) {
+        capacity *= 2;
+    }
+    if (capacity != slots_.size()) {
+        Rehash(capacity);
+    }
+}
+
+size_t IdIndex::Home(uint32_t id) const {
+    // Murmur3 finalizer: binary ids are small sequential integers.
+    id ^= id >> 16;
+    id *= 0x85ebca6bu;
+    id ^= id >> 13;
+    id *= 0xc2b2ae35u;
+    id ^= id >> 16;
+    return id & (slots_.size() - 1);
+}
+
+// Slot holding id, or the empty slot where it would go.
+size_t IdIndex::Locate(uint32_t id) const {
+    const size_t mask = slots_.size() - 1;
+    size_t index = Home(id);
+    while (slots_[index].row != kMissing && slots_[index].id != id) {
+        index = (index + 1) & mask;
+    }
+    return index;
+}
+
+uint32_t IdIndex::Find(uint32_t id) const {
+    if (size_ == 0) {
+        return kMissing;
+    }
+    return slots_[Locate(id)].row;
+}
+
+uint32_t IdIndex::Insert(uint32_t id, uint32_t row, bool& inserted) {
+    Reserve(size_ + 1);
+    Slot& slot = slots_[Locate(id)];
+    inserted = slot.row == kMissing;
+    if (inserted) {
+        slot.id = id;
+        slot.row = row;
+        ++size_;
+    }
+    return slot.row;
+}
+
+void IdIndex::Assign(uint32_t id, uint32_t row) {
+    bool inserted = false;
+    Insert(id, row, inserted);
+    if (!inserted) {
+        slots_[Locate(id)].row = row;
+    }
+}
+
+bool IdIndex::Erase(uint32_t id) {
+    if (size_ == 0) {
+        return false;
+    }
+    const size_t mask = slots_.size() - 1;
+    size_t hole = Locate(id);
+    if (slots_[hole].row == kMissing) {
+        return false;
+    }
+    // Pull later entries of the probe run back into the hole when the hole
+    // lies between their home slot and where they sit.
+    for (size_t next = (hole + 1) & mask; slots_[next].row != kMissing; next = (next + 1) & mask) {
+        const size_t home = Home(slots_[next].id);
+        if (((next - home) & mask) >= ((next - hole) & mask)) {
+            slots_[hole] = slots_[next];
+            hole = next;
+        }
+    }
+    slots_[hole].row = kMissing;
+    --size_;
+    return true;
+}
+
+void IdIndex::Rehash(size_t capacity) {
+    std::vector<Slot> previous(capacity);
+    previous.swap(slots_);
+    size_ = 0;
+    for (const Slot& slot : previous) {
+        if (slot.row != kMissing) {
+            Slot& target = slots_[Locate(slot.id)];
+            target = slot;
+            ++size_;
+        }
+    }
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Entity id -> row index map with open addressing (linear probing, backward
+// shift deletion). Clearing and erasing keep the table, so once it has grown
+// to the largest entity count seen, lookups, inserts and removals on the
+// per-snapshot path never touch the heap.
+class IdIndex {
+public:
+    static constexpr uint32_t kMissing = 0xFFFFFFFFu;
+
+    void Clear();
+    void Reserve(size_t count);
+
+    // Row stored for id, or kMissing.
+    uint32_t Find(uint32_t id) const;
+    // Stores row for id unless id is present; returns the row now stored and
+    // whether it was inserted.
+    uint32_t Insert(uint32_t id, uint32_t row, bool& inserted);
+    // Stores row for id, replacing any previous row.
+    void Assign(uint32_t id, uint32_t row);
+    bool Erase(uint32_t id);
+
+    size_t Size() const { return size_; }
+
+private:
+    struct Slot {
+        uint32_t id = 0;
+        uint32_t row = kMissing;  // kMissing marks an empty slot
+    };
+
+    size_t Home(uint32_t id) const;
+    size_t Locate(uint32_t id) const;
+    void Rehash(size_t capacity);
+
+    std::vector<Slot> slots_;
+    size_t size_ = 0;
+};
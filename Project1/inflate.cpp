@@ -0,0 +1,307 @@
+#include "inflate.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+
+namespace {
+
+constexpr int kMaxBits = 15;
+constexpr int kMaxLengthCodes = 286;
+constexpr int kMaxDistanceCodes = 30;
+constexpr int kFixedLengthCodes = 288;
+constexpr int kCodeLengthCodes = 19;
+constexpr int kEndOfBlock = 256;
+
+constexpr uint16_t kLengthBase[29] = {3,  4,  5,  6,  7,  8,  9,  10, 11,  13,  15,  17,  19,  23, 27,
+                                      31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+constexpr uint8_t kLengthExtra[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2,
+                                      2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+constexpr uint16_t kDistanceBase[30] = {1,   2,   3,   4,   5,   7,    9,    13,   17,   25,
+                                        33,  49,  65,  97,  129, 193,  257,  385,  513,  769,
+                                        1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+constexpr uint8_t kDistanceExtra[30] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6,
+                                        6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+// Order the code length code lengths are sent in.
+constexpr uint8_t kCodeLengthOrder[kCodeLengthCodes] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5,
+                                                        11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+// Canonical Huffman code: how many codes have each length, and the symbols
+// ordered by code.
+struct Huffman {
+    uint16_t count[kMaxBits + 1];
+    uint16_t symbol[kFixedLengthCodes];
+};
+
+// Returns 0 for a complete code, > 0 for an incomplete one and < 0 for an
+// over-subscribed one.
+int BuildHuffman(Huffman& code, const uint8_t* lengths, int symbols) {
+    std::fill(std::begin(code.count), std::end(code.count), uint16_t{0});
+    for (int i = 0; i < symbols; ++i) {
+        ++code.count[lengths[i]];
+    }
+    if (code.count[0] == symbols) {
+        return 0;
+    }
+    int left = 1;
+    for (int length = 1; length <= kMaxBits; ++length) {
+        left = (left << 1) - code.count[length];
+        if (left < 0) {
+            return left;
+        }
+    }
+    uint16_t offsets[kMaxBits + 1];
+    offsets[1] = 0;
+    for (int length = 1; length < kMaxBits; ++length) {
+        offsets[length + 1] = static_cast<uint16_t>(offsets[length] + code.count[length]);
+    }
+    for (int i = 0; i < symbols; ++i) {
+        if (lengths[i] != 0) {
+            code.symbol[offsets[lengths[i]]++] = static_cast<uint16_t>(i);
+        }
+    }
+    return left;
+}
+
+class Inflater {
+public:
+    Inflater(const unsigned char* data, size_t size, unsigned char* out, size_t out_size)
+        : in_(data), in_size_(size), out_(out), out_size_(out_size) {}
+
+    bool Run() {
+        uint32_t last = 0;
+        do {
+            uint32_t type = 0;
+            if (!Bits(1, last) || !Bits(2, type)) {
+                return false;
+            }
+            const bool decoded = type == 0 ? Stored() : type == 1 ? Fixed() : type == 2 ? Dynamic() : false;
+            if (!decoded) {
+                return false;
+            }
+        } while (!last);
+        return out_pos_ == out_size_;
+    }
+
+private:
+    void Refill() {
+        while (bit_count_ <= 24 && in_pos_ < in_size_) {
+            bit_buffer_ |= static_cast<uint32_t>(in_[in_pos_++]) << bit_count_;
+            bit_count_ += 8;
+        }
+    }
+
+    bool Bits(int need, uint32_t& value) {
+        if (bit_count_ < need) {
+            Refill();
+            if (bit_count_ < need) {
+                return false;
+            }
+        }
+        value = bit_buffer_ & ((1u << need) - 1u);
+        bit_buffer_ >>= need;
+        bit_count_ -= need;
+        return true;
+    }
+
+    // Codes are stored most significant bit first, so they are walked a bit
+    // at a time against the canonical code's first code of each length.
+    int Decode(const Huffman& code) {
+        Refill();
+        int value = 0;
+        int first = 0;
+        int index = 0;
+        for (int length = 1; length <= kMaxBits && length <= bit_count_; ++length) {
+            value |= static_cast<int>((bit_buffer_ >> (length - 1)) & 1u);
+            const int count = code.count[length];
+            if (value - count < first) {
+                bit_buffer_ >>= length;
+                bit_count_ -= length;
+                return code.symbol[index + (value - first)];
+            }
+            index += count;
+            first = (first + count) << 1;
+            value <<= 1;
+        }
+        return -1;
+    }
+
+    bool Stored() {
+        // Give back the whole bytes Refill read ahead; the block starts at the
+        // next byte boundary.
+        in_pos_ -= static_cast<size_t>(bit_count_ / 8);
+        bit_buffer_ = 0;
+        bit_count_ = 0;
+        if (in_size_ - in_pos_ < 4) {
+            return false;
+        }
+        const size_t length = in_[in_pos_] | (in_[in_pos_ + 1] << 8);
+        const size_t inverse = in_[in_pos_ + 2] | (in_[in_pos_ + 3] << 8);
+        in_pos_ += 4;
+        if (length != (~inverse & 0xFFFFu) || length > in_size_ - in_pos_ || length > out_size_ - out_pos_) {
+            return false;
+        }
+        std::memcpy(out_ + out_pos_, in_ + in_pos_, length);
+        in_pos_ += length;
+        out_pos_ += length;
+        return true;
+    }
+
+    bool Fixed() {
+        struct FixedCodes {
+            Huffman lengths;
+            Huffman distances;
+            FixedCodes() {
+                uint8_t code_lengths[kFixedLengthCodes];
+                std::fill(code_lengths, code_lengths + 144, uint8_t{8});
+                std::fill(code_lengths + 144, code_lengths + 256, uint8_t{9});
+                std::fill(code_lengths + 256, code_lengths + 280, uint8_t{7});
+                std::fill(code_lengths + 280, code_lengths + kFixedLengthCodes, uint8_t{8});
+                BuildHuffman(lengths, code_lengths, kFixedLengthCodes);
+                std::fill(code_lengths, code_lengths + kMaxDistanceCodes, uint8_t{5});
+                BuildHuffman(distances, code_lengths, kMaxDistanceCodes);
+            }
+        };
+        static const FixedCodes fixed;
+        return Codes(fixed.lengths, fixed.distances);
+    }
+
+    bool Dynamic() {
+        uint32_t length_count = 0;
+        uint32_t distance_count = 0;
+        uint32_t code_count = 0;
+        if (!Bits(5, length_count) || !Bits(5, distance_count) || !Bits(4, code_count)) {
+            return false;
+        }
+        length_count += 257;
+        distance_count += 1;
+        code_count += 4;
+        if (length_count > kMaxLengthCodes || distance_count > kMaxDistanceCodes) {
+            return false;
+        }
+
+        uint8_t lengths[kMaxLengthCodes + kMaxDistanceCodes] = {};
+        for (uint32_t i = 0; i < code_count; ++i) {
+            uint32_t length = 0;
+            if (!Bits(3, length)) {
+                return false;
+            }
+            lengths[kCodeLengthOrder[i]] = static_cast<uint8_t>(length);
+        }
+        Huffman code_lengths;
+        if (BuildHuffman(code_lengths, lengths, kCodeLengthCodes) != 0) {
+            return false;
+        }
+
+        const uint32_t total = length_count + distance_count;
+        for (uint32_t index = 0; index < total;) {
+            const int symbol = Decode(code_lengths);
+            if (symbol < 0) {
+                return false;
+            }
+            if (symbol < 16) {
+                lengths[index++] = static_cast<uint8_t>(symbol);
+                continue;
+            }
+            uint8_t repeated = 0;
+            uint32_t repeat = 0;
+            if (symbol == 16) {
+                if (index == 0 || !Bits(2, repeat)) {
+                    return false;
+                }
+                repeated = lengths[index - 1];
+                repeat += 3;
+            } else if (symbol == 17) {
+                if (!Bits(3, repeat)) {
+                    return false;
+                }
+                repeat += 3;
+            } else {
+                if (!Bits(7, repeat)) {
+                    return false;
+                }
+                repeat += 11;
+            }
+            if (index + repeat > total) {
+                return false;
+            }
+            std::fill(lengths + index, lengths + index + repeat, repeated);
+            index += repeat;
+        }
+        if (lengths[kEndOfBlock] == 0) {
+            return false;
+        }
+
+        // An incomplete code is only allowed when it is a single code.
+        Huffman literal_codes;
+        Huffman distance_codes;
+        const int literal_left = BuildHuffman(literal_codes, lengths, static_cast<int>(length_count));
+        if (literal_left < 0 || (literal_left > 0 && length_count - literal_codes.count[0] != 1)) {
+            return false;
+        }
+        const int distance_left =
+            BuildHuffman(distance_codes, lengths + length_count, static_cast<int>(distance_count));
+        if (distance_left < 0 || (distance_left > 0 && distance_count - distance_codes.count[0] != 1)) {
+            return false;
+        }
+        return Codes(literal_codes, distance_codes);
+    }
+
+    bool Codes(const Huffman& literals, const Huffman& distances) {
+        for (;;) {
+            int symbol = Decode(literals);
+            if (symbol < 0) {
+                return false;
+            }
+            if (symbol < kEndOfBlock) {
+                if (out_pos_ == out_size_) {
+                    return false;
+                }
+                out_[out_pos_++] = static_cast<unsigned char>(symbol);
+                continue;
+            }
+            if (symbol == kEndOfBlock) {
+                return true;
+            }
+
+            symbol -= kEndOfBlock + 1;
+            uint32_t extra = 0;
+            if (symbol >= 29 || !Bits(kLengthExtra[symbol], extra)) {
+                return false;
+            }
+            const size_t length = kLengthBase[symbol] + extra;
+            const int distance_symbol = Decode(distances);
+            if (distance_symbol < 0 || distance_symbol >= kMaxDistanceCodes ||
+                !Bits(kDistanceExtra[distance_symbol], extra)) {
+                return false;
+            }
+            const size_t distance = kDistanceBase[distance_symbol] + extra;
+            if (distance > out_pos_ || length > out_size_ - out_pos_) {
+                return false;
+            }
+            // Byte by byte: a match may overlap the bytes it produces.
+            const unsigned char* from = out_ + out_pos_ - distance;
+            unsigned char* to = out_ + out_pos_;
+            for (size_t i = 0; i < length; ++i) {
+                to[i] = from[i];
+            }
+            out_pos_ += length;
+        }
+    }
+
+    const unsigned char* in_;
+    size_t in_size_;
+    size_t in_pos_ = 0;
+    uint32_t bit_buffer_ = 0;
+    int bit_count_ = 0;
+    unsigned char* out_;
+    size_t out_size_;
+    size_t out_pos_ = 0;
+};
+
+}  // namespace
+
+bool InflateRaw(const unsigned char* data, size_t size, unsigned char* out, size_t out_size) {
+    return Inflater(data, size, out, out_size).Run();
+}
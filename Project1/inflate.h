@@ -0,0 +1,11 @@
+#pragma once
+
+#include <cstddef>
+
+// Raw DEFLATE (RFC 1951) decoding straight into a caller-owned buffer, for
+// the compressed payloads of the network transport and replay files. raylib's
+// DecompressData callocs its 64 MiB maximum output and logs a line on every
+// call; this allocates nothing, so a reused buffer sized to the payload's
+// known raw size makes decompression free of heap traffic. Returns true only
+// if data holds a complete stream that inflates to exactly out_size bytes.
+bool InflateRaw(const unsigned char* data, size_t size, unsigned char* out, size_t out_size);
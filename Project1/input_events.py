@@ -0,0 +1,66 @@
+"""Folds the renderer's input event queue into per-tick input state."""
+
+from __future__ import annotations
+
+from typing import Dict, List, Optional
+
+PRESS_EVENTS = ("bomb", "use_item", "pause", "quit")
+
+
+class InputEventReader:
+    """Applies each renderer input event exactly once, in sequence order.
+
+    The renderer rewrites ``input.json`` with every event the simulation has not
+    acknowledged; ``last_sequence`` goes back out as ``meta.input_ack`` so it
+    can drop them. Held inputs (move, attack, resync) persist between ticks.
+    Presses (bomb, use_item, pause, quit) are reported for one tick each; a
+    second press of the same kind waits for the next tick instead of merging.
+    """
+
+    def __init__(self) -> None:
+        self.session: Optional[int] = None
+        self.last_sequence = 0
+        self.move = {"x": 0.0, "y": 0.0}
+        self.attack = {"x": 0.0, "y": 0.0}
+        self.resync = False
+        self._presses: List[str] = []
+
+    def skip(self, payload: Dict) -> None:
+        """Marks ``payload``'s events as handled, e.g. leftovers from a previous run."""
+        self.session = payload.get("session")
+        self.last_sequence = max((int(event.get("seq", 0)) for event in payload.get("events", [])), default=0)
+
+    def apply(self, payload: Dict) -> None:
+        session = payload.get("session")
+        if session != self.session:
+            # A new session id is a restarted renderer; its first sequence is
+            # random, so none of the previous run's numbering carries over.
+            self.session = session
+            self.last_sequence = 0
+
+        for event in sorted(payload.get("events", []), key=lambda entry: int(entry.get("seq", 0))):
+            sequence = int(event.get("seq", 0))
+            if sequence <= self.last_sequence:
+                continue
+            self.last_sequence = sequence
+            kind = event.get("type")
+            if kind == "move":
+                self.move = {"x": float(event.get("x", 0.0)), "y": float(event.get("y", 0.0))}
+            elif kind == "attack":
+                self.attack = {"x": float(event.get("x", 0.0)), "y": float(event.get("y", 0.0))}
+            elif kind == "resync":
+                self.resync = bool(event.get("active", False))
+            elif kind in PRESS_EVENTS:
+                self._presses.append(kind)
+
+    def state(self) -> Dict:
+        """Input for one tick in the shape ``RogueGame.step`` expects."""
+        presses = {kind: False for kind in PRESS_EVENTS}
+        remaining: List[str] = []
+        for kind in self._presses:
+            if presses[kind]:
+                remaining.append(kind)
+            else:
+                presses[kind] = True
+        self._presses = remaining
+        return {"move": dict(self.move), "attack": dict(self.attack), **presses, "resync": self.resync}
@@ -0,0 +1,105 @@
+#include "input_queue.h"
+
+#include <chrono>
+#include <nlohmann/json.hpp>
+#include <random>
+
+using json = nlohmann::json;
+
+namespace {
+
+// Without a simulation acknowledging, drop the oldest events past this.
+constexpr size_t kMaxPendingEvents = 256;
+
+const char* EventTypeName(InputEventType type) {
+    switch (type) {
+        case InputEventType::Move: return "move";
+        case InputEventType::Attack: return "attack";
+        case InputEventType::Bomb: return "bomb";
+        case InputEventType::UseItem: return "use_item";
+        case InputEventType::Pause: return "pause";
+        case InputEventType::Quit: return "quit";
+        case InputEventType::Resync: return "resync";
+    }
+    return "move";
+}
+
+}  // namespace
+
+// The session id tells this renderer's events from a previous run's. The
+// first sequence is random, so an ack left over from that run almost never
+// falls in this run's range; it is below 2^31, leaving room for the run's
+// events before it wraps.
+InputQueue::InputQueue()
+    : session_(static_cast<uint32_t>(std::chrono::system_clock::now().time_since_epoch().count())) {
+    std::mt19937 random(std::random_device{}() ^ session_);
+    first_sequence_ = std::uniform_int_distribution<uint32_t>(1, 0x7FFFFFFFu)(random);
+    next_sequence_ = first_sequence_;
+}
+
+bool InputQueue::Update(const InputState& state, uint64_t tick, double time) {
+    const size_t queued = pending_.size();
+    if (state.move_x != previous_.move_x || state.move_y != previous_.move_y) {
+        Push(InputEventType::Move, state.move_x, state.move_y, false, tick, time);
+    }
+    if (state.attack_x != previous_.attack_x || state.attack_y != previous_.attack_y) {
+        Push(InputEventType::Attack, state.attack_x, state.attack_y, false, tick, time);
+    }
+    if (state.bomb) Push(InputEventType::Bomb, 0.0f, 0.0f, true, tick, time);
+    if (state.use_item) Push(InputEventType::UseItem, 0.0f, 0.0f, true, tick, time);
+    if (state.pause) Push(InputEventType::Pause, 0.0f, 0.0f, true, tick, time);
+    if (state.quit) Push(InputEventType::Quit, 0.0f, 0.0f, true, tick, time);
+    if (state.resync != previous_.resync) {
+        Push(InputEventType::Resync, 0.0f, 0.0f, state.resync, tick, time);
+    }
+    previous_ = state;
+    return pending_.size() != queued;
+}
+
+bool InputQueue::Acknowledge(uint32_t sequence, double& oldest_time) {
+    // An ack outside this run's sequences is left over from a previous renderer.
+    if (sequence < first_sequence_ || sequence >= next_sequence_ || pending_.empty() ||
+        pending_.front().sequence > sequence) {
+        return false;
+    }
+    oldest_time = pending_.front().time;
+    while (!pending_.empty() && pending_.front().sequence <= sequence) {
+        pending_.pop_front();
+    }
+    return true;
+}
+
+void InputQueue::Push(InputEventType type, float x, float y, bool active, uint64_t tick, double time) {
+    if (pending_.size() >= kMaxPendingEvents) {
+        pending_.pop_front();
+    }
+    InputEvent event;
+    event.sequence = next_sequence_++;
+    event.type = type;
+    event.x = x;
+    event.y = y;
+    event.active = active;
+    event.tick = tick;
+    event.time = time;
+    pending_.push_back(event);
+}
+
+std::string InputQueue::Serialize() const {
+    json events = json::array();
+    for (const InputEvent& event : pending_) {
+        json entry = {
+            {"seq", event.sequence},
+            {"type", EventTypeName(event.type)},
+            {"tick", event.tick},
+            {"time", event.time},
+        };
+        if (event.type == InputEventType::Move || event.type == InputEventType::Attack) {
+            entry["x"] = event.x;
+            entry["y"] = event.y;
+        } else if (event.type == InputEventType::Resync) {
+            entry["active"] = event.active;
+        }
+        events.push_back(std::move(entry));
+    }
+    return json{{"session", session_}, {"events", std::move(events)}}.dump();
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <string>
+
+struct InputState {
+    float move_x = 0.0f;
+    float move_y = 0.0f;
+    float attack_x = 0.0f;
+    float attack_y = 0.0f;
+    bool bomb = false;      // edge-triggered: true only on the frame of the press
+    bool use_item = false;  // edge-triggered
+    bool pause = false;     // edge-triggered
+    bool quit = false;      // edge-triggered
+    bool resync = false;    // held while the renderer needs a keyframe
+};
+
+enum class InputEventType : uint8_t { Move, Attack, Bomb, UseItem, Pause, Quit, Resync };
+
+struct InputEvent {
+    uint32_t sequence = 0;
+    InputEventType type = InputEventType::Move;
+    float x = 0.0f;
+    float y = 0.0f;
+    bool active = false;
+    uint64_t tick = 0;  // simulation tick on screen when the input happened
+    double time = 0.0;  // renderer clock, seconds
+};
+
+// Turns per-frame input state into an ordered queue of change events. Events
+// stay queued until the simulation reports their sequence in meta.input_ack,
+// and every write carries the whole unacknowledged queue, so a press is never
+// lost to a missed or overwritten write. Sequences start at a random value per
+// session, so an ack the simulation still reports for a previous renderer run
+// falls outside this run's range and is ignored. Payload format is documented
+// in docs/data_contract.md.
+class InputQueue {
+public:
+    InputQueue();
+
+    // Queues one event per change since the previous call. Returns true if
+    // anything was queued, i.e. the payload needs to be written.
+    bool Update(const InputState& state, uint64_t tick, double time);
+    // Drops events up to sequence. Returns true if any were pending, with
+    // oldest_time set to when the oldest of them was queued.
+    bool Acknowledge(uint32_t sequence, double& oldest_time);
+
+    std::string Serialize() const;
+    size_t Pending() const { return pending_.size(); }
+
+private:
+    void Push(InputEventType type, float x, float y, bool active, uint64_t tick, double time);
+
+    std::deque<InputEvent> pending_;
+    InputState previous_;
+    uint32_t session_ = 0;
+    uint32_t first_sequence_ = 1;
+    uint32_t next_sequence_ = 1;
+};
@@ -0,0 +1,106 @@
+#include "job_system.h"
+
+#include <algorithm>
+
+JobSystem::~JobSystem() {
+    Stop();
+}
+
+void JobSystem::Start(int workers) {
+    Stop();
+    stopping_ = false;
+    for (int i = 0; i < workers; ++i) {
+        threads_.emplace_back([this] { WorkerLoop(); });
+    }
+}
+
+void JobSystem::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    for (std::thread& thread : threads_) {
+        thread.join();
+    }
+    threads_.clear();
+}
+
+int JobSystem::ResolveWorkers(int configured) {
+    if (configured > 0) {
+        return configured - 1;  // the calling thread is one of them
+    }
+    const int hardware = static_cast<int>(std::thread::hardware_concurrency());
+    return std::clamp(hardware - 1, 0, kMaxAutoWorkers);
+}
+
+void JobSystem::Run(size_t count, Task task, void* context) {
+    if (count == 0) {
+        return;
+    }
+    if (threads_.empty() || count == 1) {
+        for (size_t i = 0; i < count; ++i) {
+            task(context, i);
+        }
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        task_ = task;
+        context_ = context;
+        tag_ = allocation_counter::MemoryTagScope::Current();
+        count_ = count;
+        finished_ = 0;
+        next_.store(0, std::memory_order_relaxed);
+        ++generation_;
+    }
+    wake_.notify_all();
+
+    const size_t ran = Drain(task, context, count);
+    std::unique_lock<std::mutex> lock(mutex_);
+    finished_ += ran;
+    // A worker that joined late may still hold this batch's task; the next
+    // batch must not start under it.
+    done_.wait(lock, [&] { return finished_ == count_ && active_ == 0; });
+    task_ = nullptr;
+    context_ = nullptr;
+}
+
+size_t JobSystem::Drain(Task task, void* context, size_t count) {
+    size_t ran = 0;
+    for (size_t index = next_.fetch_add(1, std::memory_order_relaxed); index < count;
+         index = next_.fetch_add(1, std::memory_order_relaxed)) {
+        task(context, index);
+        ++ran;
+    }
+    return ran;
+}
+
+void JobSystem::WorkerLoop() {
+    uint64_t seen = 0;
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        wake_.wait(lock, [&] { return stopping_ || (generation_ != seen && task_ != nullptr); });
+        if (stopping_) {
+            return;
+        }
+        seen = generation_;
+        const Task task = task_;
+        void* const context = context_;
+        const size_t count = count_;
+        const allocation_counter::MemoryTag tag = tag_;
+        ++active_;
+        lock.unlock();
+        size_t ran = 0;
+        {
+            allocation_counter::MemoryTagScope memory(tag);
+            ran = Drain(task, context, count);
+        }
+        lock.lock();
+        finished_ += ran;
+        --active_;
+        if (finished_ == count_ && active_ == 0) {
+            done_.notify_one();
+        }
+    }
+}
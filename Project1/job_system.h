@@ -0,0 +1,61 @@
+#pragma once
+#include "allocation_counter.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A few worker threads for fork-join work inside a frame. ParallelFor hands
+// out indices to the workers and the calling thread and returns when all are
+// done; nothing is allocated per call, so it can run on the zero-allocation
+// frame path. One caller at a time. Workers allocate under the caller's
+// memory tag.
+class JobSystem {
+public:
+    ~JobSystem();
+
+    // 0 runs every job on the calling thread.
+    void Start(int workers);
+    void Stop();
+    int Workers() const { return static_cast<int>(threads_.size()); }
+
+    // Calls body(index) for every index in [0, count), spread over the
+    // workers and the caller. body must outlive the call, which it does.
+    template <typename Body>
+    void ParallelFor(size_t count, Body& body) {
+        Run(count, [](void* context, size_t index) { (*static_cast<Body*>(context))(index); }, &body);
+    }
+
+    // Workers for renderer.render_threads: negative or 0 picks one less than
+    // the hardware threads, capped at kMaxAutoWorkers.
+    static int ResolveWorkers(int configured);
+    static constexpr int kMaxAutoWorkers = 3;
+
+private:
+    using Task = void (*)(void*, size_t);
+
+    void Run(size_t count, Task task, void* context);
+    void WorkerLoop();
+    // Runs claimed indices until none are left; returns how many it ran.
+    size_t Drain(Task task, void* context, size_t count);
+
+    std::vector<std::thread> threads_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable done_;
+    // Guarded by mutex_.
+    Task task_ = nullptr;
+    void* context_ = nullptr;
+    allocation_counter::MemoryTag tag_ = allocation_counter::MemoryTag::Other;
+    size_t count_ = 0;
+    size_t finished_ = 0;
+    int active_ = 0;  // workers inside the current batch
+    uint64_t generation_ = 0;
+    bool stopping_ = false;
+
+    std::atomic<size_t> next_{0};
+};
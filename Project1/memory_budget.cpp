@@ -0,0 +1,47 @@
+#include "memory_budget.h"
+
+namespace {
+
+constexpr double kMiB = 1024.0 * 1024.0;
+
+int64_t BudgetBytes(const nlohmann::json& budgets, const char* key) {
+    const double mib = budgets.is_object() ? budgets.value(key, 0.0) : 0.0;
+    return mib > 0.0 ? static_cast<int64_t>(mib * kMiB) : 0;
+}
+
+void WarnOver(const char* name, const allocation_counter::MemoryStats& stats, int64_t budget) {
+    TraceLog(LOG_WARNING, "Memory: %s peaked at %.1f MiB, over its %.1f MiB budget (%.1f MiB now)", name,
+             stats.high_water_bytes / kMiB, budget / kMiB, stats.live_bytes / kMiB);
+}
+
+}  // namespace
+
+void MemoryBudget::Configure(const nlohmann::json& budgets) {
+    for (size_t i = 0; i < allocation_counter::kMemoryTagCount; ++i) {
+        budgets_[i] = BudgetBytes(budgets, allocation_counter::MemoryTagName(static_cast<MemoryTag>(i)));
+        over_[i] = false;
+    }
+    total_budget_ = BudgetBytes(budgets, "total");
+    total_over_ = false;
+}
+
+void MemoryBudget::Check() {
+    for (size_t i = 0; i < allocation_counter::kMemoryTagCount; ++i) {
+        if (budgets_[i] == 0 || over_[i]) {
+            continue;
+        }
+        const MemoryTag tag = static_cast<MemoryTag>(i);
+        const allocation_counter::MemoryStats stats = allocation_counter::TagStats(tag);
+        if (stats.high_water_bytes > budgets_[i]) {
+            over_[i] = true;
+            WarnOver(allocation_counter::MemoryTagName(tag), stats, budgets_[i]);
+        }
+    }
+    if (total_budget_ != 0 && !total_over_) {
+        const allocation_counter::MemoryStats stats = allocation_counter::TotalStats();
+        if (stats.high_water_bytes > total_budget_) {
+            total_over_ = true;
+            WarnOver("total", stats, total_budget_);
+        }
+    }
+}
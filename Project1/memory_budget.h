@@ -0,0 +1,41 @@
+#pragma once
+#include "raylib.h"
+#include "allocation_counter.h"
+
+#include <array>
+#include <cstdint>
+#include <nlohmann/json.hpp>
+
+// Budgets for allocation_counter's per-subsystem memory (renderer.memory_budgets,
+// in MiB per tag name plus "total"). Check compares high-water marks, so a
+// spike between two checks is still caught; each budget warns once, the first
+// time its peak goes over.
+class MemoryBudget {
+public:
+    using MemoryTag = allocation_counter::MemoryTag;
+
+    // Missing or 0 means no budget.
+    void Configure(const nlohmann::json& budgets);
+    void Check();
+    // Both 0 when there is no budget.
+    int64_t Budget(MemoryTag tag) const { return budgets_[static_cast<size_t>(tag)]; }
+    int64_t TotalBudget() const { return total_budget_; }
+    bool Over(MemoryTag tag) const { return over_[static_cast<size_t>(tag)]; }
+    bool TotalOver() const { return total_over_; }
+
+private:
+    std::array<int64_t, allocation_counter::kMemoryTagCount> budgets_{};
+    std::array<bool, allocation_counter::kMemoryTagCount> over_{};
+    int64_t total_budget_ = 0;
+    bool total_over_ = false;
+};
+
+// Texture memory for AddExternalBytes, counted as RGBA8; render targets add a
+// 32-bit depth buffer.
+inline int64_t TextureBytes(const Texture2D& texture) {
+    return static_cast<int64_t>(texture.width) * texture.height * 4;
+}
+
+inline int64_t TextureBytes(const RenderTexture2D& target) {
+    return TextureBytes(target.texture) * 2;
+}
@@ -0,0 +1,513 @@
+#include "network_transport.h"
+
+#include "frame_profiler.h"
+#include "inflate.h"
+#include "raylib.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#ifdef _MSC_VER
+#pragma comment(lib, "ws2_32.lib")
+#endif
+#else
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+constexpr uint32_t kFrameMagic = 0x544E4752;  // "RGNT"
+constexpr uint8_t kFrameVersion = 1;
+
+// Frame kinds. Snapshots go to the renderer, the rest to the simulation.
+constexpr uint8_t kKindSnapshot = 1;
+constexpr uint8_t kKindInput = 2;
+constexpr uint8_t kKindHello = 3;
+constexpr uint8_t kKindKeyframe = 4;  // request: the next snapshot is a keyframe
+constexpr uint8_t kFlagDeflate = 1;
+
+constexpr uint32_t kMaxPayloadSize = 16u << 20;
+constexpr size_t kReceiveChunk = 64 * 1024;
+constexpr size_t kMaxDatagram = 65536;
+constexpr int kUdpReceiveBuffer = 4 << 20;  // room for a large keyframe's fragments
+constexpr int kMaxReadsPerLatest = 64;
+constexpr int64_t kRetryMicros = 1000000;
+constexpr int64_t kConnectTimeoutMicros = 3000000;
+// A UDP simulation forgets renderers it has not heard from for 5 s; a hello
+// every second keeps this one well inside that.
+constexpr int64_t kHelloMicros = 1000000;
+
+struct FrameHeader {
+    uint32_t magic;
+    uint8_t version;
+    uint8_t kind;
+    uint8_t flags;
+    uint8_t reserved0;
+    uint32_t stream;       // random per simulation run
+    uint32_t size;         // bytes after this header
+    uint64_t sequence;     // per stream, from 1; 0 in frames to the simulation
+    uint32_t offset;       // of these bytes within the stored payload (UDP fragments)
+    uint32_t stored_size;  // whole payload as sent
+    uint32_t raw_size;     // whole payload once decompressed
+    uint32_t reserved1;
+};
+
+static_assert(sizeof(FrameHeader) == 40, "frame header layout is shared with transport.py");
+static_assert(offsetof(FrameHeader, sequence) == 16, "frame header layout is shared with transport.py");
+
+#ifdef _WIN32
+using NativeSocket = SOCKET;
+#else
+using NativeSocket = int;
+#endif
+
+#ifdef MSG_NOSIGNAL
+constexpr int kSendFlags = MSG_NOSIGNAL;  // a closed peer fails send, not the process
+#else
+constexpr int kSendFlags = 0;
+#endif
+
+NativeSocket Native(intptr_t socket) {
+    return static_cast<NativeSocket>(socket);
+}
+
+bool WouldBlock() {
+#ifdef _WIN32
+    const int error = WSAGetLastError();
+    return error == WSAEWOULDBLOCK || error == WSAEINPROGRESS;
+#else
+    return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINPROGRESS || errno == EINTR;
+#endif
+}
+
+bool SetNonBlocking(intptr_t socket) {
+#ifdef _WIN32
+    u_long enabled = 1;
+    return ioctlsocket(Native(socket), FIONBIO, &enabled) == 0;
+#else
+    const int flags = fcntl(Native(socket), F_GETFL, 0);
+    return flags >= 0 && fcntl(Native(socket), F_SETFL, flags | O_NONBLOCK) == 0;
+#endif
+}
+
+void CloseSocket(intptr_t& socket) {
+    if (socket == -1) {
+        return;
+    }
+#ifdef _WIN32
+    closesocket(Native(socket));
+#else
+    close(Native(socket));
+#endif
+    socket = -1;
+}
+
+void AppendFrame(std::vector<unsigned char>& out, uint8_t kind, const std::string& body) {
+    FrameHeader header{};
+    header.magic = kFrameMagic;
+    header.version = kFrameVersion;
+    header.kind = kind;
+    header.size = static_cast<uint32_t>(body.size());
+    header.stored_size = header.size;
+    header.raw_size = header.size;
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&header);
+    out.insert(out.end(), bytes, bytes + sizeof(header));
+    out.insert(out.end(), body.begin(), body.end());
+}
+
+}  // namespace
+
+NetworkTransport::NetworkTransport(Protocol protocol, std::string host, uint16_t port, bool spectator)
+    : protocol_(protocol), host_(std::move(host)), port_(port), spectator_(spectator) {}
+
+NetworkTransport::~NetworkTransport() {
+    Close();
+}
+
+bool NetworkTransport::Open() {
+    if (!sockets_started_) {
+#ifdef _WIN32
+        WSADATA data;
+        if (WSAStartup(MAKEWORD(2, 2), &data) != 0) {
+            return false;
+        }
+#endif
+        sockets_started_ = true;
+    }
+    retry_at_us_ = 0;
+    return Connect();
+}
+
+void NetworkTransport::Close() {
+    CloseSocket(socket_);
+    state_ = State::Closed;
+    if (sockets_started_) {
+#ifdef _WIN32
+        WSACleanup();
+#endif
+        sockets_started_ = false;
+    }
+}
+
+// Starts a connection; a TCP one finishes in EnsureConnected. UDP has no
+// handshake, so a UDP transport counts as connected as soon as it has a
+// socket and finds out whether anyone is serving from what arrives.
+bool NetworkTransport::Connect() {
+    Disconnect();
+    const int64_t now = FrameProfiler::NowMicros();
+    retry_at_us_ = now + kRetryMicros;
+    const bool tcp = protocol_ == Protocol::Tcp;
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = tcp ? SOCK_STREAM : SOCK_DGRAM;
+    hints.ai_protocol = tcp ? IPPROTO_TCP : IPPROTO_UDP;
+    addrinfo* found = nullptr;
+    if (getaddrinfo(host_.c_str(), std::to_string(port_).c_str(), &hints, &found) != 0 || found == nullptr) {
+        return false;
+    }
+    const NativeSocket native = socket(found->ai_family, found->ai_socktype, found->ai_protocol);
+#ifdef _WIN32
+    socket_ = native == INVALID_SOCKET ? -1 : static_cast<intptr_t>(native);
+#else
+    socket_ = native;
+#endif
+    if (socket_ == -1 || !SetNonBlocking(socket_)) {
+        freeaddrinfo(found);
+        CloseSocket(socket_);
+        return false;
+    }
+    if (tcp) {
+        const int enabled = 1;
+        setsockopt(native, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&enabled), sizeof(enabled));
+    } else {
+        setsockopt(native, SOL_SOCKET, SO_RCVBUF, reinterpret_cast<const char*>(&kUdpReceiveBuffer),
+                   sizeof(kUdpReceiveBuffer));
+    }
+    const int result = connect(native, found->ai_addr, static_cast<socklen_t>(found->ai_addrlen));
+    freeaddrinfo(found);
+    if (result == 0 || !tcp) {
+        OnConnected();
+        return true;
+    }
+    if (!WouldBlock()) {
+        CloseSocket(socket_);
+        return false;
+    }
+    state_ = State::Connecting;
+    connect_deadline_us_ = now + kConnectTimeoutMicros;
+    return true;
+}
+
+void NetworkTransport::OnConnected() {
+    state_ = State::Connected;
+    receive_.resize(protocol_ == Protocol::Tcp ? kReceiveChunk : kMaxDatagram);
+    receive_start_ = 0;
+    receive_end_ = 0;
+    send_.clear();
+    send_start_ = 0;
+    // A new connection starts wherever the stream is; no gap to report.
+    last_sequence_ = 0;
+    assembly_sequence_ = 0;
+    hello_at_us_ = 0;
+    if (protocol_ == Protocol::Tcp) {
+        TraceLog(LOG_INFO, "Connected to %s:%u over tcp", host_.c_str(), static_cast<unsigned>(port_));
+        SendHello();
+    }
+}
+
+void NetworkTransport::Disconnect() {
+    if (state_ == State::Connected && protocol_ == Protocol::Tcp) {
+        TraceLog(LOG_INFO, "Lost the connection to %s:%u, reconnecting", host_.c_str(), static_cast<unsigned>(port_));
+    }
+    CloseSocket(socket_);
+    state_ = State::Closed;
+    send_.clear();
+    send_start_ = 0;
+}
+
+bool NetworkTransport::EnsureConnected() {
+    if (state_ == State::Connected) {
+        return true;
+    }
+    const int64_t now = FrameProfiler::NowMicros();
+    if (state_ == State::Closed) {
+        if (now < retry_at_us_ || !Connect() || state_ != State::Connecting) {
+            return state_ == State::Connected;
+        }
+    }
+    fd_set writable;
+    fd_set failed;  // where Windows reports a refused connect
+    FD_ZERO(&writable);
+    FD_ZERO(&failed);
+    FD_SET(Native(socket_), &writable);
+    FD_SET(Native(socket_), &failed);
+    timeval poll{0, 0};
+    const int ready = select(static_cast<int>(socket_ + 1), nullptr, &writable, &failed, &poll);
+    if (ready == 0) {
+        if (now >= connect_deadline_us_) {
+            Disconnect();
+        }
+        return false;
+    }
+    int error = 0;
+    socklen_t length = sizeof(error);
+    getsockopt(Native(socket_), SOL_SOCKET, SO_ERROR, reinterpret_cast<char*>(&error), &length);
+    if (ready < 0 || error != 0 || FD_ISSET(Native(socket_), &failed)) {
+        Disconnect();
+        return false;
+    }
+    OnConnected();
+    return true;
+}
+
+void NetworkTransport::SendHello() {
+    SendControl(kKindHello, spectator_ ? R"({"role":"spectator"})" : R"({"role":"player"})");
+}
+
+// TCP frames queue behind any unsent tail; a UDP frame is one datagram and
+// is simply lost if the socket cannot take it.
+void NetworkTransport::SendControl(uint8_t kind, const std::string& body) {
+    if (state_ != State::Connected) {
+        return;
+    }
+    if (protocol_ == Protocol::Tcp) {
+        AppendFrame(send_, kind, body);
+        Flush();
+        return;
+    }
+    send_.clear();
+    AppendFrame(send_, kind, body);
+    send(Native(socket_), reinterpret_cast<const char*>(send_.data()), static_cast<int>(send_.size()), kSendFlags);
+    send_.clear();
+}
+
+// Only the newest input is kept: every input payload carries the whole
+// unacknowledged event queue, so an older one has nothing the newer lacks.
+void NetworkTransport::SendPendingInput() {
+    std::string input;
+    {
+        std::lock_guard<std::mutex> lock(input_mutex_);
+        if (!has_input_ || (protocol_ == Protocol::Tcp && send_start_ < send_.size())) {
+            return;
+        }
+        input.swap(pending_input_);
+        has_input_ = false;
+    }
+    SendControl(kKindInput, input);
+}
+
+bool NetworkTransport::Flush() {
+    while (send_start_ < send_.size()) {
+        const auto count = send(Native(socket_), reinterpret_cast<const char*>(send_.data() + send_start_),
+                                static_cast<int>(send_.size() - send_start_), kSendFlags);
+        if (count > 0) {
+            send_start_ += static_cast<size_t>(count);
+            continue;
+        }
+        if (count < 0 && WouldBlock()) {
+            return true;
+        }
+        Disconnect();
+        return false;
+    }
+    send_.clear();
+    send_start_ = 0;
+    return true;
+}
+
+bool NetworkTransport::ReadLatest(SnapshotPayload& payload) {
+    bool read = false;
+    for (int i = 0; i < kMaxReadsPerLatest && ReadNext(payload); ++i) {
+        read = true;
+    }
+    return read;
+}
+
+bool NetworkTransport::ReadNext(SnapshotPayload& payload) {
+    if (!EnsureConnected()) {
+        return false;
+    }
+    if (protocol_ == Protocol::Udp) {
+        const int64_t now = FrameProfiler::NowMicros();
+        if (now >= hello_at_us_) {
+            hello_at_us_ = now + kHelloMicros;
+            SendHello();
+        }
+    }
+    SendPendingInput();
+    if (protocol_ == Protocol::Tcp) {
+        return Flush() && ReadTcp(payload);
+    }
+    return ReadUdp(payload);
+}
+
+bool NetworkTransport::ReadTcp(SnapshotPayload& payload) {
+    for (;;) {
+        const size_t available = receive_end_ - receive_start_;
+        if (available >= sizeof(FrameHeader)) {
+            FrameHeader header;
+            std::memcpy(&header, receive_.data() + receive_start_, sizeof(header));
+            if (header.magic != kFrameMagic || header.version != kFrameVersion || header.size > kMaxPayloadSize) {
+                TraceLog(LOG_WARNING, "Malformed frame from %s:%u", host_.c_str(), static_cast<unsigned>(port_));
+                Disconnect();
+                return false;
+            }
+            const size_t frame_size = sizeof(FrameHeader) + header.size;
+            if (available >= frame_size) {
+                const unsigned char* frame = receive_.data() + receive_start_;
+                receive_start_ += frame_size;
+                if (Accept(frame, frame_size, payload)) {
+                    return true;
+                }
+                continue;
+            }
+            if (receive_.size() < frame_size) {
+                receive_.resize(frame_size + kReceiveChunk);
+            }
+        }
+        // Keep the partial frame at the front so it can grow in place.
+        if (receive_start_ > 0) {
+            std::memmove(receive_.data(), receive_.data() + receive_start_, available);
+            receive_start_ = 0;
+            receive_end_ = available;
+        }
+        if (receive_.size() - receive_end_ < kReceiveChunk) {
+            receive_.resize(receive_end_ + kReceiveChunk);
+        }
+        const auto count = recv(Native(socket_), reinterpret_cast<char*>(receive_.data() + receive_end_),
+                                static_cast<int>(receive_.size() - receive_end_), 0);
+        if (count > 0) {
+            receive_end_ += static_cast<size_t>(count);
+            continue;
+        }
+        if (count < 0 && WouldBlock()) {
+            return false;
+        }
+        Disconnect();  // 0: the simulation closed the connection
+        return false;
+    }
+}
+
+bool NetworkTransport::ReadUdp(SnapshotPayload& payload) {
+    for (;;) {
+        const auto count = recv(Native(socket_), reinterpret_cast<char*>(receive_.data()),
+                                static_cast<int>(receive_.size()), 0);
+        if (count < 0) {
+            // Would block, or nothing is serving on the port yet (an ICMP
+            // unreachable surfaces here); either way, try again next poll.
+            return false;
+        }
+        if (Accept(receive_.data(), static_cast<size_t>(count), payload)) {
+            return true;
+        }
+    }
+}
+
+bool NetworkTransport::Accept(const unsigned char* frame, size_t size, SnapshotPayload& payload) {
+    if (size < sizeof(FrameHeader)) {
+        return false;
+    }
+    FrameHeader header;
+    std::memcpy(&header, frame, sizeof(header));
+    const unsigned char* body = frame + sizeof(header);
+    if (header.magic != kFrameMagic || header.version != kFrameVersion || header.kind != kKindSnapshot ||
+        header.size != size - sizeof(header) || header.stored_size > kMaxPayloadSize ||
+        header.offset > header.stored_size || header.size > header.stored_size - header.offset) {
+        return false;
+    }
+    if (header.stream != stream_) {
+        // The simulation restarted; its numbers start over.
+        stream_ = header.stream;
+        last_sequence_ = 0;
+        assembly_sequence_ = 0;
+    }
+    if (header.sequence <= last_sequence_) {
+        return false;  // duplicate or late
+    }
+    if (header.offset == 0 && header.size == header.stored_size) {
+        return Deliver(header.flags, header.sequence, header.raw_size, body, header.size, payload);
+    }
+
+    if (header.sequence < assembly_sequence_) {
+        return false;  // a fragment of a payload already given up on
+    }
+    if (header.sequence != assembly_sequence_) {
+        assembly_sequence_ = header.sequence;
+        assembly_.resize(header.stored_size);
+        fragments_.clear();
+        assembly_received_ = 0;
+        assembly_flags_ = header.flags;
+        assembly_raw_size_ = header.raw_size;
+    }
+    // A fragment that overlaps one already here is a duplicate, or from a
+    // peer that splits payloads some other way; counting it would let the
+    // payload complete with holes.
+    const uint32_t end = header.offset + header.size;
+    const auto overlaps = [&](const std::pair<uint32_t, uint32_t>& fragment) {
+        return header.offset < fragment.second && fragment.first < end;
+    };
+    if (header.stored_size != assembly_.size() || header.size == 0 ||
+        std::any_of(fragments_.begin(), fragments_.end(), overlaps)) {
+        return false;
+    }
+    std::memcpy(assembly_.data() + header.offset, body, header.size);
+    fragments_.emplace_back(header.offset, end);
+    assembly_received_ += header.size;
+    if (assembly_received_ < assembly_.size()) {
+        return false;
+    }
+    return Deliver(assembly_flags_, assembly_sequence_, assembly_raw_size_, assembly_.data(), assembly_.size(),
+                   payload);
+}
+
+bool NetworkTransport::Deliver(uint8_t flags, uint64_t sequence, uint32_t raw_size, const unsigned char* data,
+                               size_t size, SnapshotPayload& payload) {
+    if (last_sequence_ != 0 && sequence > last_sequence_ + 1) {
+        const uint64_t missed = sequence - last_sequence_ - 1;
+        lost_.fetch_add(missed, std::memory_order_relaxed);
+        TraceLog(LOG_INFO, "Missed %llu snapshot(s) before #%llu, requesting a keyframe",
+                 static_cast<unsigned long long>(missed), static_cast<unsigned long long>(sequence));
+        SendControl(kKindKeyframe, std::string());
+    }
+    last_sequence_ = sequence;
+    payload.sequence = sequence;
+    if ((flags & kFlagDeflate) == 0) {
+        payload.bytes.assign(data, data + size);
+        return true;
+    }
+    // Straight into the payload's buffer, which keeps its capacity between
+    // snapshots.
+    bool inflated = raw_size <= kMaxPayloadSize;
+    if (inflated) {
+        payload.bytes.resize(raw_size);
+        inflated = InflateRaw(data, size, reinterpret_cast<unsigned char*>(payload.bytes.data()), raw_size);
+    }
+    if (!inflated) {
+        lost_.fetch_add(1, std::memory_order_relaxed);
+        TraceLog(LOG_WARNING, "Snapshot #%llu did not decompress, requesting a keyframe",
+                 static_cast<unsigned long long>(sequence));
+        SendControl(kKindKeyframe, std::string());
+        return false;
+    }
+    return true;
+}
+
+bool NetworkTransport::WriteInput(const std::string& payload) {
+    std::lock_guard<std::mutex> lock(input_mutex_);
+    pending_input_ = payload;
+    has_input_ = true;
+    return true;
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "state_transport.h"
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Reads snapshots from a simulation serving them over TCP or UDP
+// (ipc.transport "tcp" / "udp"), so the simulation can run on another machine
+// and feed several renderers at once. Payloads are the same bytes the
+// shared-memory ring carries, optionally DEFLATE-compressed, in frames that
+// number them per simulation run. A gap in the numbers asks the simulation
+// for a keyframe straight away rather than waiting for the next delta to fail
+// to apply. Over UDP a payload arrives in fragments and is put back together
+// here; one still missing a fragment when a newer payload completes is lost.
+// Framing is documented in docs/data_contract.md.
+//
+// The socket belongs to the ingest thread: it connects (and reconnects) from
+// ReadNext, and WriteInput only leaves the newest input for it to send.
+class NetworkTransport : public StateTransport {
+public:
+    enum class Protocol : uint8_t { Tcp = 0, Udp };
+
+    // A spectator's input moves nothing; it is only read for resync.
+    NetworkTransport(Protocol protocol, std::string host, uint16_t port, bool spectator);
+    ~NetworkTransport() override;
+
+    bool Open() override;
+    void Close() override;
+    bool ReadLatest(SnapshotPayload& payload) override;
+    bool ReadNext(SnapshotPayload& payload) override;
+    bool WriteInput(const std::string& payload) override;
+    uint64_t PayloadsLost() const override { return lost_.load(std::memory_order_relaxed); }
+    const char* Name() const override { return protocol_ == Protocol::Tcp ? "tcp" : "udp"; }
+
+private:
+    enum class State : uint8_t { Closed = 0, Connecting, Connected };
+
+    bool EnsureConnected();
+    bool Connect();
+    void OnConnected();
+    void Disconnect();
+    void SendHello();
+    void SendControl(uint8_t kind, const std::string& body);
+    void SendPendingInput();
+    bool Flush();
+    bool ReadTcp(SnapshotPayload& payload);
+    bool ReadUdp(SnapshotPayload& payload);
+    // One frame or fragment; true once payload holds a whole new snapshot.
+    bool Accept(const unsigned char* frame, size_t size, SnapshotPayload& payload);
+    bool Deliver(uint8_t flags, uint64_t sequence, uint32_t raw_size, const unsigned char* data, size_t size,
+                 SnapshotPayload& payload);
+
+    Protocol protocol_;
+    std::string host_;
+    uint16_t port_;
+    bool spectator_;
+
+    // Ingest thread.
+    intptr_t socket_ = -1;
+    State state_ = State::Closed;
+    int64_t retry_at_us_ = 0;
+    int64_t connect_deadline_us_ = 0;
+    int64_t hello_at_us_ = 0;
+    bool sockets_started_ = false;
+    std::vector<unsigned char> receive_;  // TCP bytes read, or the last datagram
+    size_t receive_start_ = 0;
+    size_t receive_end_ = 0;
+    std::vector<unsigned char> send_;     // unsent tail of a TCP frame
+    size_t send_start_ = 0;
+    std::vector<unsigned char> assembly_;  // UDP payload being reassembled
+    // [begin, end) of the fragments already in assembly_; they never overlap,
+    // so assembly_received_ reaching its size means every byte arrived.
+    std::vector<std::pair<uint32_t, uint32_t>> fragments_;
+    uint64_t assembly_sequence_ = 0;
+    uint32_t assembly_received_ = 0;
+    uint8_t assembly_flags_ = 0;
+    uint32_t assembly_raw_size_ = 0;
+    uint32_t stream_ = 0;
+    uint64_t last_sequence_ = 0;
+
+    // Render thread to ingest thread.
+    std::mutex input_mutex_;
+    std::string pending_input_;
+    bool has_input_ = false;
+
+    std::atomic<uint64_t> lost_{0};
+};
@@ -0,0 +1,179 @@
+#include "particle_system.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+namespace {
+
+using snapshot::EffectKind;
+
+// How each kind of burst looks. Speeds in tiles per second, sizes are radii
+// in tiles; drag slows particles exponentially (per second).
+struct BurstStyle {
+    int count;
+    float speed_min;
+    float speed_max;
+    float life_min;
+    float life_max;
+    float size_min;
+    float size_max;
+    float drag;
+    Color start;  // colour at birth, faded towards end over the life
+    Color end;
+};
+
+constexpr std::array<BurstStyle, snapshot::CodeCount<EffectKind>()> kStyles = {{
+    {4, 0.5f, 1.5f, 0.15f, 0.25f, 0.04f, 0.06f, 6.0f, Color{200, 200, 200, 200}, Color{200, 200, 200, 0}},
+    {6, 1.5f, 3.5f, 0.12f, 0.25f, 0.04f, 0.08f, 8.0f, Color{220, 220, 255, 220}, Color{150, 170, 255, 0}},
+    {10, 1.0f, 4.0f, 0.30f, 0.60f, 0.05f, 0.10f, 5.0f, Color{210, 30, 30, 230}, Color{120, 10, 10, 0}},
+    {28, 2.0f, 6.5f, 0.30f, 0.70f, 0.08f, 0.16f, 3.5f, Color{255, 200, 90, 255}, Color{110, 40, 20, 0}},
+}};
+
+const BurstStyle& StyleOf(EffectKind kind) {
+    const size_t index = snapshot::CodeIndex(kind);
+    return kStyles[index < kStyles.size() ? index : 0];
+}
+
+// xorshift32: small, and the same sequence on every platform.
+class BurstRandom {
+public:
+    explicit BurstRandom(uint32_t seed) : state_((seed ^ 0x9E3779B9u) | 1u) {}
+
+    float Range(float low, float high) {
+        state_ ^= state_ << 13;
+        state_ ^= state_ >> 17;
+        state_ ^= state_ << 5;
+        return low + (high - low) * static_cast<float>(state_ >> 8) * (1.0f / 16777216.0f);
+    }
+
+private:
+    uint32_t state_;
+};
+
+// Exact for exponential drag, so the result does not depend on frame rate.
+struct DragStep {
+    float decay;   // velocity factor over the step
+    float travel;  // distance covered per unit of starting velocity
+};
+
+DragStep MakeDragStep(float drag, float dt) {
+    const float decay = std::exp(-drag * dt);
+    return DragStep{decay, (1.0f - decay) / drag};
+}
+
+unsigned char Lerp(unsigned char from, unsigned char to, float t) {
+    return static_cast<unsigned char>(from + (static_cast<float>(to) - from) * t);
+}
+
+}  // namespace
+
+void ParticleSystem::Configure(size_t capacity) {
+    x_.assign(capacity, 0.0f);
+    y_.assign(capacity, 0.0f);
+    vx_.assign(capacity, 0.0f);
+    vy_.assign(capacity, 0.0f);
+    age_.assign(capacity, 0.0f);
+    life_.assign(capacity, 0.0f);
+    size_.assign(capacity, 0.0f);
+    kind_.assign(capacity, EffectKind::Unknown);
+    count_ = 0;
+    limit_ = capacity;
+    dropped_ = 0;
+}
+
+void ParticleSystem::Clear() {
+    count_ = 0;
+}
+
+void ParticleSystem::Spawn(const ParticleSpawn& spawn, float age) {
+    const BurstStyle& style = StyleOf(spawn.kind);
+    age = std::max(0.0f, age);
+    if (age >= style.life_max) {
+        return;
+    }
+    const DragStep step = MakeDragStep(style.drag, age);
+    BurstRandom random(spawn.seed);
+    for (int i = 0; i < style.count; ++i) {
+        // Draw every value even for particles that are skipped, so the rest
+        // of the burst does not depend on the age it arrived at.
+        const float angle = random.Range(0.0f, 6.2831853f);
+        const float speed = random.Range(style.speed_min, style.speed_max);
+        const float life = random.Range(style.life_min, style.life_max);
+        const float size = random.Range(style.size_min, style.size_max);
+        if (life <= age) {
+            continue;
+        }
+        if (count_ >= limit_) {
+            ++dropped_;
+            continue;
+        }
+        const float vx = std::cos(angle) * speed;
+        const float vy = std::sin(angle) * speed;
+        const size_t index = count_++;
+        x_[index] = spawn.x + vx * step.travel;
+        y_[index] = spawn.y + vy * step.travel;
+        vx_[index] = vx * step.decay;
+        vy_[index] = vy * step.decay;
+        age_[index] = age;
+        life_[index] = life;
+        size_[index] = size;
+        kind_[index] = spawn.kind;
+    }
+}
+
+void ParticleSystem::Update(float dt) {
+    if (count_ == 0 || dt <= 0.0f) {
+        return;
+    }
+    std::array<DragStep, kStyles.size()> steps;
+    for (size_t kind = 0; kind < kStyles.size(); ++kind) {
+        steps[kind] = MakeDragStep(kStyles[kind].drag, dt);
+    }
+    for (size_t i = 0; i < count_; ++i) {
+        const DragStep& step = steps[std::min(snapshot::CodeIndex(kind_[i]), steps.size() - 1)];
+        x_[i] += vx_[i] * step.travel;
+        y_[i] += vy_[i] * step.travel;
+        vx_[i] *= step.decay;
+        vy_[i] *= step.decay;
+        age_[i] += dt;
+    }
+    for (size_t i = 0; i < count_;) {
+        if (age_[i] >= life_[i]) {
+            Remove(i);
+        } else {
+            ++i;
+        }
+    }
+}
+
+void ParticleSystem::Record(const WorldCamera& camera, ShapeList& list) const {
+    const float scale = camera.Scale();
+    for (size_t i = 0; i < count_; ++i) {
+        if (!camera.Visible(x_[i], y_[i], size_[i])) {
+            continue;
+        }
+        const BurstStyle& style = StyleOf(kind_[i]);
+        const float t = age_[i] / life_[i];
+        const Color color{
+            Lerp(style.start.r, style.end.r, t),
+            Lerp(style.start.g, style.end.g, t),
+            Lerp(style.start.b, style.end.b, t),
+            Lerp(style.start.a, style.end.a, t),
+        };
+        list.Circle(camera.WorldToScreen(x_[i], y_[i]), scale * size_[i] * (1.0f - 0.5f * t), color);
+    }
+}
+
+// Swap-remove: the last particle fills the hole.
+void ParticleSystem::Remove(size_t index) {
+    const size_t last = --count_;
+    x_[index] = x_[last];
+    y_[index] = y_[last];
+    vx_[index] = vx_[last];
+    vy_[index] = vy_[last];
+    age_[index] = age_[last];
+    life_[index] = life_[last];
+    size_[index] = size_[last];
+    kind_[index] = kind_[last];
+}
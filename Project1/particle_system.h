@@ -0,0 +1,57 @@
+#pragma once
+
+#include "shape_batch.h"
+#include "world_camera.h"
+#include "world_snapshot.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Short-lived particles for impacts, blood and explosions. The simulation
+// sends one ParticleSpawn per burst and the renderer does the rest, so only
+// a few bytes per event cross the channel however many particles it makes.
+// Particles live in a struct of arrays sized once by Configure: a burst that
+// finds the pool full loses the particles that do not fit, and dead ones are
+// swap-removed, so nothing is allocated per particle or per frame. A burst
+// is seeded by its event, so a replay shows the same particles.
+class ParticleSystem {
+public:
+    // Allocates the pool and drops any live particles.
+    void Configure(size_t capacity);
+    void Clear();
+    // Caps live particles below the capacity; bursts past it lose particles
+    // like a full pool. Ones already alive live out their life.
+    void SetLimit(size_t limit) { limit_ = limit < x_.size() ? limit : x_.size(); }
+
+    // Starts a burst as if it had been running for age seconds, so bursts
+    // that arrive late (a slow frame, a replay seek) are where they would
+    // have been; ones already over are skipped.
+    void Spawn(const ParticleSpawn& spawn, float age);
+    void Update(float dt);
+
+    // Appends every particle the camera can see to list as a circle. Reads
+    // only, so it can run on a job worker.
+    void Record(const WorldCamera& camera, ShapeList& list) const;
+
+    size_t Live() const { return count_; }
+    size_t Capacity() const { return x_.size(); }
+    size_t Limit() const { return limit_; }
+    // Particles lost to a full pool or the limit since Configure.
+    uint64_t Dropped() const { return dropped_; }
+
+private:
+    void Remove(size_t index);
+
+    size_t count_ = 0;
+    size_t limit_ = 0;
+    uint64_t dropped_ = 0;
+    std::vector<float> x_;
+    std::vector<float> y_;
+    std::vector<float> vx_;
+    std::vector<float> vy_;
+    std::vector<float> age_;
+    std::vector<float> life_;
+    std::vector<float> size_;
+    std::vector<snapshot::EffectKind> kind_;
+};
@@ -0,0 +1,163 @@
+#include "projectile_kernel.h"
+
+#include <algorithm>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define ROGUE_PROJECTILES_AVX 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define ROGUE_PROJECTILES_SSE2 1
+#endif
+
+namespace {
+
+enum RowStatus : uint8_t { kAlive = 0, kExpired = 1, kImpact = 2 };
+
+// Stand-in for an empty room: one open tile.
+constexpr uint8_t kOpenTile = 0;
+
+struct TileView {
+    const uint8_t* solid = &kOpenTile;
+    int32_t width = 1;
+    double last_x = 0.0;
+    double last_y = 0.0;
+
+    explicit TileView(const TileGrid& tiles) {
+        if (tiles.Width() > 0 && tiles.Height() > 0) {
+            solid = tiles.Solid();
+            width = tiles.Width();
+            last_x = tiles.Width() - 1;
+            last_y = tiles.Height() - 1;
+        }
+    }
+
+    // Clamp then truncate, which equals _tile_at's int() then clamp. max()
+    // comes first so NaN lands on 0 exactly as it does in the vector lanes.
+    bool SolidAt(double x, double y) const {
+        const int32_t xi = static_cast<int32_t>(std::min(std::max(0.0, x), last_x));
+        const int32_t yi = static_cast<int32_t>(std::min(std::max(0.0, y), last_y));
+        return solid[static_cast<size_t>(yi) * width + xi] != 0;
+    }
+};
+
+uint8_t StepRow(ProjectileColumns& columns, size_t row, double dt, const TileView& tiles) {
+    const double x = columns.x[row] + columns.vx[row] * dt;
+    const double y = columns.y[row] + columns.vy[row] * dt;
+    const double ttl = columns.ttl[row] - dt;
+    columns.x[row] = x;
+    columns.y[row] = y;
+    columns.ttl[row] = ttl;
+    if (!(ttl > 0.0)) {
+        return kExpired;
+    }
+    return tiles.SolidAt(x, y) ? kImpact : kAlive;
+}
+
+// Integrates and classifies rows [0, end) a vector at a time; returns the
+// first row left for the scalar tail.
+size_t StepVectorized(ProjectileColumns& columns, double dt, const TileView& tiles, uint8_t* status) {
+    size_t row = 0;
+#if defined(ROGUE_PROJECTILES_AVX)
+    const __m256d step = _mm256_set1_pd(dt);
+    const __m256d zero = _mm256_setzero_pd();
+    const __m256d last_x = _mm256_set1_pd(tiles.last_x);
+    const __m256d last_y = _mm256_set1_pd(tiles.last_y);
+    const __m128i width = _mm_set1_epi32(tiles.width);
+    alignas(16) int32_t index[4];
+    for (; row + 4 <= columns.count; row += 4) {
+        const __m256d x = _mm256_add_pd(_mm256_loadu_pd(columns.x + row), _mm256_mul_pd(_mm256_loadu_pd(columns.vx + row), step));
+        const __m256d y = _mm256_add_pd(_mm256_loadu_pd(columns.y + row), _mm256_mul_pd(_mm256_loadu_pd(columns.vy + row), step));
+        const __m256d ttl = _mm256_sub_pd(_mm256_loadu_pd(columns.ttl + row), step);
+        _mm256_storeu_pd(columns.x + row, x);
+        _mm256_storeu_pd(columns.y + row, y);
+        _mm256_storeu_pd(columns.ttl + row, ttl);
+
+        const int alive = _mm256_movemask_pd(_mm256_cmp_pd(ttl, zero, _CMP_GT_OQ));
+        const __m128i xi = _mm256_cvttpd_epi32(_mm256_min_pd(_mm256_max_pd(x, zero), last_x));
+        const __m128i yi = _mm256_cvttpd_epi32(_mm256_min_pd(_mm256_max_pd(y, zero), last_y));
+        _mm_store_si128(reinterpret_cast<__m128i*>(index), _mm_add_epi32(_mm_mullo_epi32(yi, width), xi));
+        for (int lane = 0; lane < 4; ++lane) {
+            status[row + lane] = !(alive & (1 << lane)) ? kExpired : tiles.solid[index[lane]] ? kImpact : kAlive;
+        }
+    }
+#elif defined(ROGUE_PROJECTILES_SSE2)
+    const __m128d step = _mm_set1_pd(dt);
+    const __m128d zero = _mm_setzero_pd();
+    const __m128d last_x = _mm_set1_pd(tiles.last_x);
+    const __m128d last_y = _mm_set1_pd(tiles.last_y);
+    alignas(16) int32_t xi[4];
+    alignas(16) int32_t yi[4];
+    for (; row + 2 <= columns.count; row += 2) {
+        const __m128d x = _mm_add_pd(_mm_loadu_pd(columns.x + row), _mm_mul_pd(_mm_loadu_pd(columns.vx + row), step));
+        const __m128d y = _mm_add_pd(_mm_loadu_pd(columns.y + row), _mm_mul_pd(_mm_loadu_pd(columns.vy + row), step));
+        const __m128d ttl = _mm_sub_pd(_mm_loadu_pd(columns.ttl + row), step);
+        _mm_storeu_pd(columns.x + row, x);
+        _mm_storeu_pd(columns.y + row, y);
+        _mm_storeu_pd(columns.ttl + row, ttl);
+
+        const int alive = _mm_movemask_pd(_mm_cmpgt_pd(ttl, zero));
+        _mm_store_si128(reinterpret_cast<__m128i*>(xi), _mm_cvttpd_epi32(_mm_min_pd(_mm_max_pd(x, zero), last_x)));
+        _mm_store_si128(reinterpret_cast<__m128i*>(yi), _mm_cvttpd_epi32(_mm_min_pd(_mm_max_pd(y, zero), last_y)));
+        for (int lane = 0; lane < 2; ++lane) {
+            const size_t tile = static_cast<size_t>(yi[lane]) * tiles.width + xi[lane];
+            status[row + lane] = !(alive & (1 << lane)) ? kExpired : tiles.solid[tile] ? kImpact : kAlive;
+        }
+    }
+#else
+    (void)columns;
+    (void)dt;
+    (void)tiles;
+    (void)status;
+#endif
+    return row;
+}
+
+}  // namespace
+
+const char* ProjectileKernelIsa() {
+#if defined(ROGUE_PROJECTILES_AVX)
+    return "avx";
+#elif defined(ROGUE_PROJECTILES_SSE2)
+    return "sse2";
+#else
+    return "scalar";
+#endif
+}
+
+size_t StepProjectiles(ProjectileColumns& columns,
+                       double dt,
+                       const TileGrid& tiles,
+                       std::vector<uint8_t>& status,
+                       std::vector<uint32_t>& removed,
+                       std::vector<ProjectileImpact>& impacts) {
+    removed.clear();
+    impacts.clear();
+    status.resize(columns.count);
+    const TileView view(tiles);
+
+    for (size_t row = StepVectorized(columns, dt, view, status.data()); row < columns.count; ++row) {
+        status[row] = StepRow(columns, row, dt, view);
+    }
+
+    size_t kept = 0;
+    for (size_t row = 0; row < columns.count; ++row) {
+        if (status[row] == kAlive) {
+            if (kept != row) {
+                columns.x[kept] = columns.x[row];
+                columns.y[kept] = columns.y[row];
+                columns.vx[kept] = columns.vx[row];
+                columns.vy[kept] = columns.vy[row];
+                columns.ttl[kept] = columns.ttl[row];
+                columns.radius[kept] = columns.radius[row];
+            }
+            ++kept;
+            continue;
+        }
+        removed.push_back(static_cast<uint32_t>(row));
+        if (status[row] == kImpact) {
+            impacts.push_back({static_cast<uint32_t>(row), columns.x[row], columns.y[row]});
+        }
+    }
+    return kept;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "spatial_hash.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Projectiles as parallel double columns (structure of arrays), owned by the
+// caller; ProjectilePool in projectiles.py keeps them in array('d') buffers.
+struct ProjectileColumns {
+    double* x = nullptr;
+    double* y = nullptr;
+    double* vx = nullptr;
+    double* vy = nullptr;
+    double* ttl = nullptr;
+    double* radius = nullptr;
+    size_t count = 0;
+};
+
+struct ProjectileImpact {
+    uint32_t row;  // row before compaction
+    double x;
+    double y;
+};
+
+// Which instruction set StepProjectiles was compiled for: "avx", "sse2"
+// or "scalar".
+const char* ProjectileKernelIsa();
+
+// One simulation tick for the whole batch: x += vx * dt, y += vy * dt,
+// ttl -= dt. Rows whose ttl ran out are dropped; rows that now sit on a solid
+// tile are dropped and reported as impacts. Survivors are compacted, in
+// order, to the front of every column and their count is returned. removed
+// lists every dropped row (pre-compaction, ascending). Arithmetic is plain
+// IEEE double multiply then add, so results match the Python simulation bit
+// for bit.
+size_t StepProjectiles(ProjectileColumns& columns,
+                       double dt,
+                       const TileGrid& tiles,
+                       std::vector<uint8_t>& status,
+                       std::vector<uint32_t>& removed,
+                       std::vector<ProjectileImpact>& impacts);
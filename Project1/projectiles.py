@@ -0,0 +1,102 @@
+"""Projectiles stored column-wise so a whole batch steps in one native call.
+
+Positions, velocities, ttl and radius live in ``array('d')`` columns that
+``CollisionWorld.step_projectiles`` (``projectile_kernel.cpp``, or the
+Python fallback in ``collision.py``) integrates and compacts in place; ids,
+kinds and damage stay in parallel Python lists.
+"""
+
+from __future__ import annotations
+
+from array import array
+from dataclasses import dataclass
+from typing import Dict, Iterable, List, Tuple
+
+FLOAT_COLUMNS = ("x", "y", "vx", "vy", "ttl", "radius")
+
+
+@dataclass
+class Projectile:
+    id: str
+    owner: str
+    kind: str
+    x: float
+    y: float
+    vx: float
+    vy: float
+    damage: int
+    ttl: float
+    radius: float = 0.2
+
+
+class ProjectilePool:
+    """Every projectile of one owner, as parallel columns in spawn order."""
+
+    def __init__(self, owner: str) -> None:
+        self.owner = owner
+        self.ids: List[str] = []
+        self.kinds: List[str] = []
+        self.damage: List[int] = []
+        self.x = array("d")
+        self.y = array("d")
+        self.vx = array("d")
+        self.vy = array("d")
+        self.ttl = array("d")
+        self.radius = array("d")
+
+    def __len__(self) -> int:
+        return len(self.ids)
+
+    def add(self, projectile: Projectile) -> None:
+        self.ids.append(projectile.id)
+        self.kinds.append(projectile.kind)
+        self.damage.append(projectile.damage)
+        for name in FLOAT_COLUMNS:
+            getattr(self, name).append(getattr(projectile, name))
+
+    def step(self, world, dt: float) -> List[Tuple[str, float, float]]:
+        """Moves every projectile, drops expired ones and returns ``(id, x, y)``
+        for each one that hit a solid tile (and was dropped too)."""
+        if not self.ids:
+            return []
+        removed, impacts = world.step_projectiles(self.x, self.y, self.vx, self.vy, self.ttl, self.radius, dt)
+        hits = [(self.ids[row], x, y) for row, x, y in impacts]
+        if removed:
+            # The numeric columns are already compacted; trim their tails.
+            survivors = len(self.ids) - len(removed)
+            for name in FLOAT_COLUMNS:
+                del getattr(self, name)[survivors:]
+            self._remove_rows(removed, (self.ids, self.kinds, self.damage))
+        return hits
+
+    def remove(self, rows: Iterable[int]) -> None:
+        """Drops ``rows`` (ascending) from every column."""
+        rows = list(rows)
+        if rows:
+            self._remove_rows(rows, (self.ids, self.kinds, self.damage) + tuple(getattr(self, n) for n in FLOAT_COLUMNS))
+
+    def _remove_rows(self, rows: List[int], columns: Tuple) -> None:
+        # Splice the runs between removed rows: O(removed) Python steps, the
+        # copying itself happens inside list/array slicing.
+        for column in columns:
+            kept = column[: rows[0]]
+            for start, end in zip(rows, rows[1:] + [len(column)]):
+                kept += column[start + 1 : end]
+            column[:] = kept
+
+    def serialise(self) -> List[Dict]:
+        return [
+            {
+                "id": self.ids[row],
+                "owner": self.owner,
+                "kind": self.kinds[row],
+                "x": self.x[row],
+                "y": self.y[row],
+                "vx": self.vx[row],
+                "vy": self.vy[row],
+                "damage": self.damage[row],
+                "ttl": self.ttl[row],
+                "radius": self.radius[row],
+            }
+            for row in range(len(self.ids))
+        ]
@@ -0,0 +1,79 @@
+"""Records a game_state stream for the renderer benchmark.
+
+Runs the simulation headless (no pacing, scripted random input) and writes
+every payload exactly as the shared-memory channel would publish it, each
+prefixed with its ``u32`` little-endian size. Feed the file to
+``Benchmark --replay``.
+
+    python record_snapshots.py --ticks 3000 --format binary --output recording.bin
+
+``--json-twin FILE`` also writes every message as JSON, payload for payload,
+for ``Benchmark --replay recording.bin --compare-json FILE``, which checks that
+both encodings decode to the same tile, pickup and actor codes.
+"""
+
+from __future__ import annotations
+
+import argparse
+import json
+import random
+import struct
+import tempfile
+from contextlib import ExitStack
+from pathlib import Path
+from typing import Dict
+
+from game_logic import RogueGame
+from snapshot_codec import BinarySnapshotEncoder, SnapshotDiffer
+
+
+def scripted_input(rng: random.Random) -> Dict:
+    return {
+        "move": {"x": rng.choice([-1, 0, 1]), "y": rng.choice([-1, 0, 1])},
+        "attack": {"x": rng.choice([-1, 0, 0, 1]), "y": rng.choice([-1, 0, 0, 1])},
+        "bomb": rng.random() < 0.02,
+    }
+
+
+def record(args: argparse.Namespace) -> int:
+    rng = random.Random(args.seed)
+    differ = SnapshotDiffer(args.keyframe_interval) if args.deltas else None
+    encoder = BinarySnapshotEncoder() if args.format == "binary" else None
+    written = 0
+    with ExitStack() as stack:
+        shared_dir = stack.enter_context(tempfile.TemporaryDirectory())
+        output = stack.enter_context(open(args.output, "wb"))
+        twin = stack.enter_context(open(args.json_twin, "wb")) if args.json_twin else None
+        game = RogueGame(config_path=args.config, shared_dir=shared_dir)
+        game.channel.close()
+        for _ in range(args.ticks):
+            game.step(scripted_input(rng))
+            state = game.serialise_state()
+            message = differ.diff(state) if differ is not None else state
+            text = json.dumps(message, separators=(",", ":")).encode("utf-8") if twin is not None or encoder is None else b""
+            payload = encoder.encode(message) if encoder is not None else text
+            output.write(struct.pack("<I", len(payload)))
+            output.write(payload)
+            written += len(payload)
+            if twin is not None:
+                twin.write(struct.pack("<I", len(text)))
+                twin.write(text)
+    print(f"wrote {args.ticks} snapshots ({written / args.ticks:.0f} bytes avg) to {args.output}")
+    return 0
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--config", default="game_config.yaml")
+    parser.add_argument("--ticks", type=int, default=3000)
+    parser.add_argument("--format", choices=("binary", "json"), default="binary")
+    parser.add_argument("--deltas", action=argparse.BooleanOptionalAction, default=True)
+    parser.add_argument("--keyframe-interval", type=int, default=300)
+    parser.add_argument("--seed", type=int, default=1)
+    parser.add_argument("--output", type=Path, default=Path("recording.bin"))
+    parser.add_argument("--json-twin", type=Path, default=None, help="also write each message as JSON here")
+    return record(parser.parse_args())
+
+
+if __name__ == "__main__":
+    raise SystemExit(main())
@@ -0,0 +1,416 @@
+#include "replay_file.h"
+
+#include "inflate.h"
+#include "raylib.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// Smaller payloads are stored as they are; DEFLATE framing would not pay off.
+constexpr size_t kMinCompressSize = 128;
+// Records between flushes, on top of a flush after every keyframe, bounding
+// what a crash can lose.
+constexpr uint64_t kFlushInterval = 60;
+// A corrupt raw_size is refused rather than allocated.
+constexpr uint32_t kMaxRecordSize = 64u << 20;
+
+int64_t SteadyMicros() {
+    using namespace std::chrono;
+    return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+uint64_t UnixMicros() {
+    using namespace std::chrono;
+    return static_cast<uint64_t>(duration_cast<microseconds>(system_clock::now().time_since_epoch()).count());
+}
+
+}  // namespace
+
+namespace replay {
+
+bool IsReplayFile(const fs::path& path) {
+    std::FILE* file = std::fopen(path.string().c_str(), "rb");
+    if (!file) {
+        return false;
+    }
+    uint32_t magic = 0;
+    const bool read = std::fread(&magic, sizeof(magic), 1, file) == 1;
+    std::fclose(file);
+    return read && magic == kFileMagic;
+}
+
+}  // namespace replay
+
+ReplayWriter::~ReplayWriter() {
+    Close();
+}
+
+bool ReplayWriter::Open(const fs::path& path, bool compress) {
+    Close();
+    std::error_code error;
+    if (path.has_parent_path()) {
+        fs::create_directories(path.parent_path(), error);
+    }
+    file_ = std::fopen(path.string().c_str(), "wb");
+    if (!file_) {
+        TraceLog(LOG_WARNING, "Unable to create replay %s", path.string().c_str());
+        return false;
+    }
+    path_ = path;
+    compress_ = compress;
+    started_us_ = SteadyMicros();
+    offset_ = 0;
+    last_tick_ = 0;
+    records_ = 0;
+    raw_bytes_ = 0;
+    stored_bytes_ = 0;
+    index_.clear();
+
+    replay::FileHeader header{};
+    header.magic = replay::kFileMagic;
+    header.version = replay::kFileVersion;
+    header.header_size = sizeof(header);
+    header.created_us = UnixMicros();
+    return Write(&header, sizeof(header));
+}
+
+void ReplayWriter::Close() {
+    if (!file_) {
+        return;
+    }
+    replay::IndexTrailer trailer{};
+    trailer.index_offset = offset_;
+    trailer.record_count = records_;
+    trailer.last_tick = last_tick_;
+    trailer.entry_count = static_cast<uint32_t>(index_.size());
+    trailer.magic = replay::kIndexMagic;
+    const bool indexed = (index_.empty() || Write(index_.data(), index_.size() * sizeof(replay::IndexEntry))) &&
+                         file_ && Write(&trailer, sizeof(trailer));
+    if (file_) {
+        std::fclose(file_);
+        file_ = nullptr;
+    }
+    if (indexed) {
+        TraceLog(LOG_INFO, "Replay %s: %llu records, %.1f MiB (%.1f MiB raw)", path_.string().c_str(),
+                 static_cast<unsigned long long>(records_), stored_bytes_ / (1024.0 * 1024.0),
+                 raw_bytes_ / (1024.0 * 1024.0));
+    }
+}
+
+bool ReplayWriter::Append(const char* data, size_t size, uint64_t tick, bool keyframe) {
+    if (!file_ || (records_ == 0 && !keyframe) || size > UINT32_MAX) {
+        return file_ != nullptr;
+    }
+
+    const unsigned char* stored = reinterpret_cast<const unsigned char*>(data);
+    int stored_size = static_cast<int>(size);
+    unsigned char* compressed = nullptr;
+    bool use_compressed = false;
+    if (compress_ && size >= kMinCompressSize) {
+        int compressed_size = 0;
+        compressed = CompressData(stored, static_cast<int>(size), &compressed_size);
+        if (compressed && compressed_size > 0 && static_cast<size_t>(compressed_size) < size) {
+            stored = compressed;
+            stored_size = compressed_size;
+            use_compressed = true;
+        }
+    }
+
+    replay::RecordHeader record{};
+    record.tick = tick;
+    record.time_us = static_cast<uint64_t>(std::max<int64_t>(0, SteadyMicros() - started_us_));
+    record.stored_size = static_cast<uint32_t>(stored_size);
+    record.raw_size = static_cast<uint32_t>(size);
+    record.flags = (keyframe ? replay::kRecordKeyframe : 0) | (use_compressed ? replay::kRecordCompressed : 0);
+
+    const uint64_t record_offset = offset_;
+    const bool written = Write(&record, sizeof(record)) && Write(stored, static_cast<size_t>(stored_size));
+    if (compressed) {
+        MemFree(compressed);
+    }
+    if (!written) {
+        return false;
+    }
+
+    if (keyframe) {
+        index_.push_back({tick, record_offset});
+    }
+    last_tick_ = tick;
+    ++records_;
+    raw_bytes_ += size;
+    stored_bytes_ += static_cast<uint64_t>(stored_size);
+    if (keyframe || records_ % kFlushInterval == 0) {
+        std::fflush(file_);
+    }
+    return true;
+}
+
+bool ReplayWriter::Write(const void* data, size_t size) {
+    if (std::fwrite(data, 1, size, file_) != size) {
+        TraceLog(LOG_WARNING, "Unable to write replay %s, recording stopped", path_.string().c_str());
+        std::fclose(file_);
+        file_ = nullptr;
+        return false;
+    }
+    offset_ += size;
+    return true;
+}
+
+ReplayReader::~ReplayReader() {
+    Close();
+}
+
+bool ReplayReader::Open(const fs::path& path) {
+    Close();
+    if (!Map(path)) {
+        return false;
+    }
+    replay::FileHeader header{};
+    if (view_size_ < sizeof(header)) {
+        Close();
+        return false;
+    }
+    std::memcpy(&header, view_, sizeof(header));
+    if (header.magic != replay::kFileMagic || header.version != replay::kFileVersion ||
+        header.header_size < sizeof(header) || header.header_size > view_size_) {
+        TraceLog(LOG_WARNING, "%s is not a version %u replay", path.string().c_str(), replay::kFileVersion);
+        Close();
+        return false;
+    }
+    if (!LoadIndex()) {
+        TraceLog(LOG_INFO, "Replay %s has no index (recording did not finish), scanning it", path.string().c_str());
+        ScanRecords();
+    }
+    if (keyframes_.empty()) {
+        TraceLog(LOG_WARNING, "Replay %s holds no keyframe", path.string().c_str());
+        Close();
+        return false;
+    }
+    first_tick_ = keyframes_.front().tick;
+    last_tick_ = std::max(last_tick_, first_tick_);
+    BuildSeekTable();
+    Rewind();
+    return true;
+}
+
+void ReplayReader::Close() {
+    Unmap();
+    data_end_ = 0;
+    cursor_ = 0;
+    first_tick_ = 0;
+    last_tick_ = 0;
+    records_ = 0;
+    keyframes_.clear();
+    seek_table_.clear();
+}
+
+bool ReplayReader::LoadIndex() {
+    replay::FileHeader header{};
+    std::memcpy(&header, view_, sizeof(header));
+    if (view_size_ < header.header_size + sizeof(replay::IndexTrailer)) {
+        return false;
+    }
+    replay::IndexTrailer trailer{};
+    std::memcpy(&trailer, view_ + view_size_ - sizeof(trailer), sizeof(trailer));
+    // Bound index_offset before any arithmetic with it: a corrupt trailer must
+    // not wrap the sum and put data_end_ past the mapping.
+    const uint64_t index_end = view_size_ - sizeof(trailer);
+    const uint64_t index_bytes = static_cast<uint64_t>(trailer.entry_count) * sizeof(replay::IndexEntry);
+    if (trailer.magic != replay::kIndexMagic || trailer.index_offset < header.header_size ||
+        trailer.index_offset > index_end || index_end - trailer.index_offset != index_bytes) {
+        return false;
+    }
+    keyframes_.resize(trailer.entry_count);
+    if (index_bytes != 0) {
+        std::memcpy(keyframes_.data(), view_ + trailer.index_offset, index_bytes);
+    }
+    for (const replay::IndexEntry& entry : keyframes_) {
+        if (!RecordFits(entry.offset) || entry.offset >= trailer.index_offset) {
+            keyframes_.clear();
+            return false;
+        }
+    }
+    data_end_ = trailer.index_offset;
+    records_ = static_cast<size_t>(trailer.record_count);
+    last_tick_ = trailer.last_tick;
+    return true;
+}
+
+// Walks the record headers of a file with no index. Stops at a record that
+// runs past the end of the file, which is where a crash cut it off, or at a
+// tick that goes backwards.
+void ReplayReader::ScanRecords() {
+    replay::FileHeader header{};
+    std::memcpy(&header, view_, sizeof(header));
+    keyframes_.clear();
+    records_ = 0;
+    uint64_t offset = header.header_size;
+    while (RecordFits(offset)) {
+        replay::RecordHeader record{};
+        std::memcpy(&record, view_ + offset, sizeof(record));
+        if (records_ != 0 && record.tick < last_tick_) {
+            TraceLog(LOG_WARNING, "Replay ticks go backwards at offset %llu; ignoring the rest",
+                     static_cast<unsigned long long>(offset));
+            break;
+        }
+        if (record.flags & replay::kRecordKeyframe) {
+            keyframes_.push_back({record.tick, offset});
+        }
+        last_tick_ = record.tick;
+        ++records_;
+        offset += sizeof(record) + record.stored_size;
+    }
+    data_end_ = offset;
+}
+
+void ReplayReader::BuildSeekTable() {
+    const uint64_t span = last_tick_ - first_tick_;
+    seek_table_.assign(static_cast<size_t>(span / kSeekStride) + 1, 0);
+    size_t keyframe = 0;
+    for (size_t slot = 0; slot < seek_table_.size(); ++slot) {
+        const uint64_t tick = first_tick_ + slot * kSeekStride;
+        while (keyframe + 1 < keyframes_.size() && keyframes_[keyframe + 1].tick <= tick) {
+            ++keyframe;
+        }
+        seek_table_[slot] = keyframe;
+    }
+}
+
+bool ReplayReader::RecordFits(uint64_t offset) const {
+    if (offset + sizeof(replay::RecordHeader) > view_size_) {
+        return false;
+    }
+    replay::RecordHeader record{};
+    std::memcpy(&record, view_ + offset, sizeof(record));
+    return offset + sizeof(record) + record.stored_size <= view_size_;
+}
+
+void ReplayReader::Seek(uint64_t tick) {
+    if (seek_table_.empty()) {
+        return;
+    }
+    const uint64_t clamped = std::clamp(tick, first_tick_, last_tick_);
+    // The slot's keyframe is at or before the slot start; one closer to tick
+    // may sit inside the slot.
+    size_t keyframe = seek_table_[static_cast<size_t>((clamped - first_tick_) / kSeekStride)];
+    while (keyframe + 1 < keyframes_.size() && keyframes_[keyframe + 1].tick <= clamped) {
+        ++keyframe;
+    }
+    cursor_ = keyframes_[keyframe].offset;
+}
+
+void ReplayReader::Rewind() {
+    cursor_ = keyframes_.empty() ? data_end_ : keyframes_.front().offset;
+}
+
+const replay::RecordHeader* ReplayReader::Peek() const {
+    if (!view_ || cursor_ + sizeof(replay::RecordHeader) > data_end_) {
+        return nullptr;
+    }
+    // Records are packed at arbitrary offsets; RecordHeader is a packed
+    // struct, so reading it in place is fine on every target we build for.
+    const auto* record = reinterpret_cast<const replay::RecordHeader*>(view_ + cursor_);
+    return cursor_ + sizeof(replay::RecordHeader) + record->stored_size <= data_end_ ? record : nullptr;
+}
+
+bool ReplayReader::Read(std::vector<char>& bytes) {
+    const replay::RecordHeader* record = Peek();
+    if (!record) {
+        return false;
+    }
+    const unsigned char* stored = view_ + cursor_ + sizeof(replay::RecordHeader);
+    cursor_ += sizeof(replay::RecordHeader) + record->stored_size;
+
+    if (!(record->flags & replay::kRecordCompressed)) {
+        bytes.assign(stored, stored + record->stored_size);
+        return true;
+    }
+    // Into the caller's buffer, which keeps its capacity between records; a
+    // seek inflates many of them back to back.
+    if (record->raw_size > kMaxRecordSize) {
+        return false;
+    }
+    bytes.resize(record->raw_size);
+    return InflateRaw(stored, record->stored_size, reinterpret_cast<unsigned char*>(bytes.data()), bytes.size());
+}
+
+bool ReplayReader::Map(const fs::path& path) {
+#ifdef _WIN32
+    HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                              nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER file_size{};
+    if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0) {
+        CloseHandle(file);
+        return false;
+    }
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping) {
+        CloseHandle(file);
+        return false;
+    }
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!view) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+    file_handle_ = file;
+    mapping_handle_ = mapping;
+    view_ = static_cast<const unsigned char*>(view);
+    view_size_ = static_cast<size_t>(file_size.QuadPart);
+#else
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info {};
+    if (fstat(fd, &info) != 0 || info.st_size == 0) {
+        close(fd);
+        return false;
+    }
+    void* view = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    if (view == MAP_FAILED) {
+        close(fd);
+        return false;
+    }
+    fd_ = fd;
+    view_ = static_cast<const unsigned char*>(view);
+    view_size_ = static_cast<size_t>(info.st_size);
+#endif
+    return true;
+}
+
+void ReplayReader::Unmap() {
+#ifdef _WIN32
+    if (view_) UnmapViewOfFile(view_);
+    if (mapping_handle_) CloseHandle(static_cast<HANDLE>(mapping_handle_));
+    if (file_handle_) CloseHandle(static_cast<HANDLE>(file_handle_));
+    mapping_handle_ = nullptr;
+    file_handle_ = nullptr;
+#else
+    if (view_) munmap(const_cast<unsigned char*>(view_), view_size_);
+    if (fd_ >= 0) close(fd_);
+    fd_ = -1;
+#endif
+    view_ = nullptr;
+    view_size_ = 0;
+}
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <vector>
+
+// Recorded game_state streams (.rgrp): every payload the renderer applied,
+// keyframes and deltas exactly as the transport delivered them, optionally
+// DEFLATE-compressed, followed by an index of the keyframes. Layout is
+// documented in docs/data_contract.md.
+namespace replay {
+
+constexpr uint32_t kFileMagic = 0x50524752;   // "RGRP"
+constexpr uint32_t kIndexMagic = 0x49524752;  // "RGRI"
+constexpr uint16_t kFileVersion = 1;
+
+enum RecordFlags : uint8_t {
+    kRecordKeyframe = 1u << 0,
+    kRecordCompressed = 1u << 1,
+};
+
+#pragma pack(push, 1)
+struct FileHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t header_size;
+    uint64_t created_us;  // Unix time recording started
+    uint8_t reserved[16];
+};
+
+struct RecordHeader {
+    uint64_t tick;
+    uint64_t time_us;  // since the recording started
+    uint32_t stored_size;
+    uint32_t raw_size;
+    uint8_t flags;
+    uint8_t reserved[7];
+};
+
+struct IndexEntry {
+    uint64_t tick;
+    uint64_t offset;  // of the keyframe's RecordHeader
+};
+
+struct IndexTrailer {
+    uint64_t index_offset;
+    uint64_t record_count;
+    uint64_t last_tick;
+    uint32_t entry_count;
+    uint32_t magic;
+};
+#pragma pack(pop)
+
+static_assert(sizeof(FileHeader) == 32, "replay layout is documented in docs/data_contract.md");
+static_assert(sizeof(RecordHeader) == 32, "replay layout is documented in docs/data_contract.md");
+static_assert(sizeof(IndexEntry) == 16, "replay layout is documented in docs/data_contract.md");
+static_assert(sizeof(IndexTrailer) == 32, "replay layout is documented in docs/data_contract.md");
+
+bool IsReplayFile(const std::filesystem::path& path);
+
+}  // namespace replay
+
+// Appends records; Close writes the keyframe index. A file that was never
+// closed (the renderer crashed) is still readable: ReplayReader rebuilds the
+// index by walking the records, and drops a torn last record.
+class ReplayWriter {
+public:
+    ~ReplayWriter();
+
+    bool Open(const std::filesystem::path& path, bool compress);
+    void Close();
+    bool IsOpen() const { return file_ != nullptr; }
+    const std::filesystem::path& Path() const { return path_; }
+
+    // The first record of a file must be a keyframe; earlier deltas are
+    // skipped. Returns false (and closes the file) on a write error.
+    bool Append(const char* data, size_t size, uint64_t tick, bool keyframe);
+
+    uint64_t LastTick() const { return last_tick_; }
+    uint64_t Records() const { return records_; }
+    uint64_t RawBytes() const { return raw_bytes_; }
+    uint64_t StoredBytes() const { return stored_bytes_; }
+
+private:
+    bool Write(const void* data, size_t size);
+
+    std::filesystem::path path_;
+    std::FILE* file_ = nullptr;
+    bool compress_ = true;
+    int64_t started_us_ = 0;
+    uint64_t offset_ = 0;
+    uint64_t last_tick_ = 0;
+    uint64_t records_ = 0;
+    uint64_t raw_bytes_ = 0;
+    uint64_t stored_bytes_ = 0;
+    std::vector<replay::IndexEntry> index_;
+};
+
+// Memory-maps a replay and walks it with a cursor. Seek finds the keyframe
+// to start from with one table lookup: the table has one entry per
+// kSeekStride ticks holding the last keyframe at or before it, so reaching
+// any tick costs that lookup plus the deltas since the keyframe.
+class ReplayReader {
+public:
+    static constexpr uint64_t kSeekStride = 32;
+
+    ~ReplayReader();
+
+    bool Open(const std::filesystem::path& path);
+    void Close();
+    bool IsOpen() const { return view_ != nullptr; }
+
+    uint64_t FirstTick() const { return first_tick_; }
+    uint64_t LastTick() const { return last_tick_; }
+    size_t Records() const { return records_; }
+    size_t Keyframes() const { return keyframes_.size(); }
+
+    // Moves the cursor to the keyframe a replay of tick must start from;
+    // ticks outside the recording clamp to its ends.
+    void Seek(uint64_t tick);
+    void Rewind();
+
+    // Header of the record under the cursor, or nullptr at the end.
+    const replay::RecordHeader* Peek() const;
+    // Copies (decompressing if needed) the record under the cursor into bytes
+    // and advances. Returns false at the end or on a corrupt record.
+    bool Read(std::vector<char>& bytes);
+
+private:
+    bool Map(const std::filesystem::path& path);
+    void Unmap();
+    bool LoadIndex();
+    void ScanRecords();
+    void BuildSeekTable();
+    bool RecordFits(uint64_t offset) const;
+
+    const unsigned char* view_ = nullptr;
+    size_t view_size_ = 0;
+    uint64_t data_end_ = 0;  // first byte past the last whole record
+    uint64_t cursor_ = 0;
+    uint64_t first_tick_ = 0;
+    uint64_t last_tick_ = 0;
+    size_t records_ = 0;
+    std::vector<replay::IndexEntry> keyframes_;
+    std::vector<size_t> seek_table_;  // per kSeekStride ticks: index into keyframes_
+#ifdef _WIN32
+    void* file_handle_ = nullptr;
+    void* mapping_handle_ = nullptr;
+#else
+    int fd_ = -1;
+#endif
+};
@@ -0,0 +1,101 @@
+#include "replay_transport.h"
+
+#include "frame_profiler.h"
+#include "raylib.h"
+
+#include <utility>
+
+namespace fs = std::filesystem;
+
+ReplayTransport::ReplayTransport(fs::path path, double speed, uint64_t start_tick, bool loop)
+    : path_(std::move(path)),
+      speed_(speed > 0.0 ? speed : 0.0),
+      start_tick_(start_tick),
+      loop_(loop) {}
+
+bool ReplayTransport::Open() {
+    if (!reader_.IsOpen() && !reader_.Open(path_)) {
+        TraceLog(LOG_WARNING, "Unable to open replay %s", path_.string().c_str());
+        return false;
+    }
+    first_tick_ = reader_.FirstTick();
+    last_tick_ = reader_.LastTick();
+    TraceLog(LOG_INFO, "Replaying %s: ticks %llu-%llu, %zu records, %zu keyframes, speed %s",
+             path_.string().c_str(), static_cast<unsigned long long>(first_tick_),
+             static_cast<unsigned long long>(last_tick_), reader_.Records(), reader_.Keyframes(),
+             speed_ > 0.0 ? TextFormat("%.2fx", speed_) : "unpaced");
+    if (start_tick_ > first_tick_) {
+        SeekTo(start_tick_);
+    }
+    return true;
+}
+
+void ReplayTransport::Close() {
+    reader_.Close();
+}
+
+bool ReplayTransport::ReadLatest(SnapshotPayload& payload) {
+    return ReadNext(payload);
+}
+
+bool ReplayTransport::ReadNext(SnapshotPayload& payload) {
+    if (!reader_.IsOpen()) {
+        return false;
+    }
+    const uint64_t seek = seek_request_.exchange(kNoSeek, std::memory_order_relaxed);
+    if (seek != kNoSeek) {
+        SeekTo(seek);
+    }
+
+    const replay::RecordHeader* record = reader_.Peek();
+    if (!record && loop_) {
+        reader_.Rewind();
+        clock_started_ = false;
+        record = reader_.Peek();
+    }
+    if (!record) {
+        if (!reported_end_) {
+            TraceLog(LOG_INFO, "Replay finished at tick %llu", static_cast<unsigned long long>(CurrentTick()));
+            reported_end_ = true;
+        }
+        return false;
+    }
+
+    const uint64_t tick = record->tick;
+    if (tick >= catch_up_tick_ && speed_ > 0.0) {
+        const int64_t now_us = FrameProfiler::NowMicros();
+        if (!clock_started_) {
+            clock_started_ = true;
+            clock_origin_us_ = now_us;
+            record_origin_us_ = record->time_us;
+        }
+        const double elapsed_us = static_cast<double>(static_cast<int64_t>(record->time_us - record_origin_us_));
+        if (static_cast<double>(now_us - clock_origin_us_) < elapsed_us / speed_) {
+            return false;
+        }
+    }
+
+    if (!reader_.Read(payload.bytes)) {
+        TraceLog(LOG_WARNING, "Skipping corrupt replay record at tick %llu", static_cast<unsigned long long>(tick));
+        return false;
+    }
+    payload.sequence = ++sequence_;
+    current_tick_.store(tick, std::memory_order_relaxed);
+    return true;
+}
+
+bool ReplayTransport::WriteInput(const std::string& payload) {
+    (void)payload;
+    return true;
+}
+
+void ReplayTransport::RequestSeek(uint64_t tick) {
+    seek_request_.store(tick, std::memory_order_relaxed);
+}
+
+void ReplayTransport::SeekTo(uint64_t tick) {
+    reader_.Seek(tick);
+    catch_up_tick_ = tick;
+    clock_started_ = false;
+    reported_end_ = false;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "replay_file.h"
+#include "state_transport.h"
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+
+// Plays a recorded .rgrp stream instead of a live simulation. Records are
+// released on the recording's own clock scaled by speed (0 = as fast as the
+// ingest thread decodes). Input goes nowhere.
+class ReplayTransport : public StateTransport {
+public:
+    ReplayTransport(std::filesystem::path path, double speed, uint64_t start_tick, bool loop);
+
+    bool Open() override;
+    void Close() override;
+    bool ReadLatest(SnapshotPayload& payload) override;
+    bool ReadNext(SnapshotPayload& payload) override;
+    bool WriteInput(const std::string& payload) override;
+    const char* Name() const override { return "replay"; }
+
+    // Render thread. Jumps to tick: the ingest thread is handed the keyframe
+    // before it and every delta up to tick at once, then playback resumes.
+    void RequestSeek(uint64_t tick);
+    // Render thread. The tick of the newest record handed out.
+    uint64_t CurrentTick() const { return current_tick_.load(std::memory_order_relaxed); }
+    uint64_t FirstTick() const { return first_tick_; }
+    uint64_t LastTick() const { return last_tick_; }
+
+private:
+    static constexpr uint64_t kNoSeek = UINT64_MAX;
+
+    void SeekTo(uint64_t tick);
+
+    std::filesystem::path path_;
+    double speed_ = 1.0;
+    uint64_t start_tick_ = 0;
+    bool loop_ = false;
+
+    // Ingest thread.
+    ReplayReader reader_;
+    uint64_t catch_up_tick_ = 0;   // records before this tick are released immediately
+    bool clock_started_ = false;
+    int64_t clock_origin_us_ = 0;  // steady time playback (re)started
+    uint64_t record_origin_us_ = 0;  // record time at that moment
+    uint64_t sequence_ = 0;
+    bool reported_end_ = false;
+
+    // Written once in Open, before the ingest thread starts.
+    uint64_t first_tick_ = 0;
+    uint64_t last_tick_ = 0;
+    std::atomic<uint64_t> seek_request_{kNoSeek};
+    std::atomic<uint64_t> current_tick_{0};
+};
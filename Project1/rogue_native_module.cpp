@@ -0,0 +1,474 @@
+// rogue_native: collision queries for game_logic.py, built with
+// `python setup.py build_ext --inplace` (see docs/data_contract.md). The
+// simulation keeps its rules in Python; this module only answers batched
+// "which tiles block", "which circle does this hit" and "which way to the
+// player" questions.
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include "flow_field.h"
+#include "projectile_kernel.h"
+#include "spatial_hash.h"
+
+#include <cstring>
+#include <new>
+#include <vector>
+
+namespace {
+
+struct CollisionState {
+    TileGrid tiles;
+    SpatialHash circles;
+    FlowField flow;
+    std::vector<double> xs;
+    std::vector<double> ys;
+    std::vector<double> radii;
+    std::vector<uint8_t> projectile_status;
+    std::vector<uint32_t> removed;
+    std::vector<ProjectileImpact> impacts;
+};
+
+struct CollisionWorldObject {
+    PyObject_HEAD
+    CollisionState* state;
+};
+
+bool IsDoubleBuffer(const Py_buffer& view) {
+    return view.itemsize == sizeof(double) && view.format != nullptr && std::strcmp(view.format, "d") == 0;
+}
+
+// Reads a sequence of floats into out. array('d') and other double buffers
+// are copied without boxing; a plain number stands for `count` copies of
+// itself, so callers can pass one radius for every entry.
+bool ReadDoubles(PyObject* object, std::vector<double>& out, Py_ssize_t count, const char* name) {
+    if (PyObject_CheckBuffer(object)) {
+        Py_buffer view;
+        if (PyObject_GetBuffer(object, &view, PyBUF_FORMAT | PyBUF_C_CONTIGUOUS) == 0) {
+            if (IsDoubleBuffer(view)) {
+                const Py_ssize_t size = view.len / view.itemsize;
+                if (count >= 0 && size != count) {
+                    PyErr_Format(PyExc_ValueError, "%s has %zd entries, expected %zd", name, size, count);
+                    PyBuffer_Release(&view);
+                    return false;
+                }
+                const double* data = static_cast<const double*>(view.buf);
+                out.assign(data, data + size);
+                PyBuffer_Release(&view);
+                return true;
+            }
+            PyBuffer_Release(&view);
+        } else {
+            PyErr_Clear();
+        }
+    }
+    if (PyNumber_Check(object) && !PySequence_Check(object)) {
+        const double value = PyFloat_AsDouble(object);
+        if (value == -1.0 && PyErr_Occurred()) {
+            return false;
+        }
+        out.assign(static_cast<size_t>(count < 0 ? 0 : count), value);
+        return true;
+    }
+    PyObject* fast = PySequence_Fast(object, name);
+    if (fast == nullptr) {
+        return false;
+    }
+    const Py_ssize_t size = PySequence_Fast_GET_SIZE(fast);
+    if (count >= 0 && size != count) {
+        PyErr_Format(PyExc_ValueError, "%s has %zd entries, expected %zd", name, size, count);
+        Py_DECREF(fast);
+        return false;
+    }
+    PyObject** items = PySequence_Fast_ITEMS(fast);
+    out.resize(static_cast<size_t>(size));
+    for (Py_ssize_t i = 0; i < size; ++i) {
+        const double value = PyFloat_AsDouble(items[i]);
+        if (value == -1.0 && PyErr_Occurred()) {
+            Py_DECREF(fast);
+            return false;
+        }
+        out[static_cast<size_t>(i)] = value;
+    }
+    Py_DECREF(fast);
+    return true;
+}
+
+// Reads parallel x/y sequences; returns the entry count or -1.
+Py_ssize_t ReadPoints(PyObject* xs, PyObject* ys, CollisionState& state) {
+    if (!ReadDoubles(xs, state.xs, -1, "xs")) {
+        return -1;
+    }
+    const Py_ssize_t count = static_cast<Py_ssize_t>(state.xs.size());
+    if (!ReadDoubles(ys, state.ys, count, "ys")) {
+        return -1;
+    }
+    return count;
+}
+
+bool AssignTiles(CollisionState& state, int width, int height, PyObject* solid) {
+    if (width < 0 || height < 0) {
+        PyErr_SetString(PyExc_ValueError, "room dimensions must be non-negative");
+        return false;
+    }
+    Py_buffer view;
+    if (PyObject_GetBuffer(solid, &view, PyBUF_SIMPLE) != 0) {
+        return false;
+    }
+    const Py_ssize_t expected = static_cast<Py_ssize_t>(width) * height;
+    if (view.len != expected) {
+        PyErr_Format(PyExc_ValueError, "solid has %zd bytes, expected %zd (width * height)", view.len, expected);
+        PyBuffer_Release(&view);
+        return false;
+    }
+    state.tiles.Assign(width, height, static_cast<const uint8_t*>(view.buf));
+    PyBuffer_Release(&view);
+    return true;
+}
+
+template <typename Query>
+PyObject* BoolList(Py_ssize_t count, Query&& query) {
+    PyObject* result = PyList_New(count);
+    if (result == nullptr) {
+        return nullptr;
+    }
+    for (Py_ssize_t i = 0; i < count; ++i) {
+        PyObject* value = query(static_cast<size_t>(i)) ? Py_True : Py_False;
+        Py_INCREF(value);
+        PyList_SET_ITEM(result, i, value);
+    }
+    return result;
+}
+
+PyObject* CollisionWorldNew(PyTypeObject* type, PyObject*, PyObject*) {
+    auto* self = reinterpret_cast<CollisionWorldObject*>(type->tp_alloc(type, 0));
+    if (self == nullptr) {
+        return nullptr;
+    }
+    self->state = new (std::nothrow) CollisionState();
+    if (self->state == nullptr) {
+        Py_DECREF(self);
+        return PyErr_NoMemory();
+    }
+    return reinterpret_cast<PyObject*>(self);
+}
+
+void CollisionWorldDealloc(PyObject* object) {
+    auto* self = reinterpret_cast<CollisionWorldObject*>(object);
+    delete self->state;
+    PyTypeObject* type = Py_TYPE(object);
+    type->tp_free(object);
+    Py_DECREF(type);  // instances of a heap type own a reference to it
+}
+
+int CollisionWorldInit(PyObject* object, PyObject* args, PyObject* kwargs) {
+    static const char* keywords[] = {"width", "height", "solid", nullptr};
+    int width = 0;
+    int height = 0;
+    PyObject* solid = nullptr;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "iiO", const_cast<char**>(keywords), &width, &height, &solid)) {
+        return -1;
+    }
+    auto* self = reinterpret_cast<CollisionWorldObject*>(object);
+    return AssignTiles(*self->state, width, height, solid) ? 0 : -1;
+}
+
+PyObject* CollisionWorldSetTiles(PyObject* object, PyObject* args) {
+    int width = 0;
+    int height = 0;
+    PyObject* solid = nullptr;
+    if (!PyArg_ParseTuple(args, "iiO", &width, &height, &solid)) {
+        return nullptr;
+    }
+    auto* self = reinterpret_cast<CollisionWorldObject*>(object);
+    if (!AssignTiles(*self->state, width, height, solid)) {
+        return nullptr;
+    }
+    Py_RETURN_NONE;
+}
+
+PyObject* CollisionWorldSolidAt(PyObject* object, PyObject* args) {
+    PyObject* xs = nullptr;
+    PyObject* ys = nullptr;
+    if (!PyArg_ParseTuple(args, "OO", &xs, &ys)) {
+        return nullptr;
+    }
+    CollisionState& state = *reinterpret_cast<CollisionWorldObject*>(object)->state;
+    const Py_ssize_t count = ReadPoints(xs, ys, state);
+    if (count < 0) {
+        return nullptr;
+    }
+    return BoolList(count, [&](size_t i) { return state.tiles.SolidAt(state.xs[i], state.ys[i]); });
+}
+
+PyObject* CollisionWorldWalkable(PyObject* object, PyObject* args) {
+    PyObject* xs = nullptr;
+    PyObject* ys = nullptr;
+    PyObject* radii = nullptr;
+    if (!PyArg_ParseTuple(args, "OOO", &xs, &ys, &radii)) {
+        return nullptr;
+    }
+    CollisionState& state = *reinterpret_cast<CollisionWorldObject*>(object)->state;
+    const Py_ssize_t count = ReadPoints(xs, ys, state);
+    if (count < 0 || !ReadDoubles(radii, state.radii, count, "radii")) {
+        return nullptr;
+    }
+    return BoolList(count, [&](size_t i) { return state.tiles.Walkable(state.xs[i], state.ys[i], state.radii[i]); });
+}
+
+PyObject* CollisionWorldBuildCircles(PyObject* object, PyObject* args) {
+    PyObject* xs = nullptr;
+    PyObject* ys = nullptr;
+    PyObject* radii = nullptr;
+    if (!PyArg_ParseTuple(args, "OOO", &xs, &ys, &radii)) {
+        return nullptr;
+    }
+    CollisionState& state = *reinterpret_cast<CollisionWorldObject*>(object)->state;
+    const Py_ssize_t count = ReadPoints(xs, ys, state);
+    if (count < 0 || !ReadDoubles(radii, state.radii, count, "radii")) {
+        return nullptr;
+    }
+    try {
+        state.circles.Build(state.xs.data(), state.ys.data(), state.radii.data(), state.xs.size());
+    } catch (const std::bad_alloc&) {
+        return PyErr_NoMemory();
+    }
+    Py_RETURN_NONE;
+}
+
+PyObject* CollisionWorldFirstOverlaps(PyObject* object, PyObject* args) {
+    PyObject* xs = nullptr;
+    PyObject* ys = nullptr;
+    PyObject* radii = nullptr;
+    if (!PyArg_ParseTuple(args, "OOO", &xs, &ys, &radii)) {
+        return nullptr;
+    }
+    CollisionState& state = *reinterpret_cast<CollisionWorldObject*>(object)->state;
+    const Py_ssize_t count = ReadPoints(xs, ys, state);
+    if (count < 0 || !ReadDoubles(radii, state.radii, count, "radii")) {
+        return nullptr;
+    }
+    PyObject* result = PyList_New(count);
+    if (result == nullptr) {
+        return nullptr;
+    }
+    for (Py_ssize_t i = 0; i < count; ++i) {
+        const size_t row = static_cast<size_t>(i);
+        PyObject* hit = PyLong_FromLong(state.circles.FirstOverlap(state.xs[row], state.ys[row], state.radii[row]));
+        if (hit == nullptr) {
+            Py_DECREF(result);
+            return nullptr;
+        }
+        PyList_SET_ITEM(result, i, hit);
+    }
+    return result;
+}
+
+PyObject* CollisionWorldBuildFlowField(PyObject* object, PyObject* args) {
+    int goal_x = 0;
+    int goal_y = 0;
+    if (!PyArg_ParseTuple(args, "ii", &goal_x, &goal_y)) {
+        return nullptr;
+    }
+    CollisionState& state = *reinterpret_cast<CollisionWorldObject*>(object)->state;
+    try {
+        state.flow.Build(state.tiles.Width(), state.tiles.Height(), state.tiles.Solid(), goal_x, goal_y);
+    } catch (const std::bad_alloc&) {
+        return PyErr_NoMemory();
+    }
+    Py_RETURN_NONE;
+}
+
+PyObject* CollisionWorldFlowDirections(PyObject* object, PyObject* args) {
+    PyObject* xs = nullptr;
+    PyObject* ys = nullptr;
+    if (!PyArg_ParseTuple(args, "OO", &xs, &ys)) {
+        return nullptr;
+    }
+    CollisionState& state = *reinterpret_cast<CollisionWorldObject*>(object)->state;
+    const Py_ssize_t count = ReadPoints(xs, ys, state);
+    if (count < 0) {
+        return nullptr;
+    }
+    PyObject* result = PyList_New(count);
+    if (result == nullptr) {
+        return nullptr;
+    }
+    for (Py_ssize_t i = 0; i < count; ++i) {
+        const size_t row = static_cast<size_t>(i);
+        double dx = 0.0;
+        double dy = 0.0;
+        state.flow.Direction(state.xs[row], state.ys[row], dx, dy);
+        PyObject* direction = Py_BuildValue("(dd)", dx, dy);
+        if (direction == nullptr) {
+            Py_DECREF(result);
+            return nullptr;
+        }
+        PyList_SET_ITEM(result, i, direction);
+    }
+    return result;
+}
+
+// Writable array('d') columns of one projectile batch, held for the call.
+class ProjectileBuffers {
+public:
+    ~ProjectileBuffers() {
+        for (int i = 0; i < held_; ++i) {
+            PyBuffer_Release(&views_[i]);
+        }
+    }
+
+    bool Acquire(PyObject* const (&objects)[6], ProjectileColumns& columns) {
+        static const char* const kNames[6] = {"x", "y", "vx", "vy", "ttl", "radius"};
+        double* data[6] = {};
+        for (int i = 0; i < 6; ++i) {
+            if (PyObject_GetBuffer(objects[i], &views_[i], PyBUF_WRITABLE | PyBUF_FORMAT | PyBUF_C_CONTIGUOUS) != 0) {
+                return false;
+            }
+            ++held_;
+            if (!IsDoubleBuffer(views_[i])) {
+                PyErr_Format(PyExc_TypeError, "%s must be a writable array('d')", kNames[i]);
+                return false;
+            }
+            if (views_[i].len != views_[0].len) {
+                PyErr_Format(PyExc_ValueError, "%s has %zd entries, expected %zd", kNames[i],
+                             views_[i].len / views_[i].itemsize, views_[0].len / views_[0].itemsize);
+                return false;
+            }
+            data[i] = static_cast<double*>(views_[i].buf);
+        }
+        columns.x = data[0];
+        columns.y = data[1];
+        columns.vx = data[2];
+        columns.vy = data[3];
+        columns.ttl = data[4];
+        columns.radius = data[5];
+        columns.count = static_cast<size_t>(views_[0].len / views_[0].itemsize);
+        return true;
+    }
+
+private:
+    Py_buffer views_[6] = {};
+    int held_ = 0;
+};
+
+PyObject* CollisionWorldStepProjectiles(PyObject* object, PyObject* args) {
+    PyObject* buffers[6] = {};
+    double dt = 0.0;
+    if (!PyArg_ParseTuple(args, "OOOOOOd", &buffers[0], &buffers[1], &buffers[2], &buffers[3], &buffers[4],
+                          &buffers[5], &dt)) {
+        return nullptr;
+    }
+    CollisionState& state = *reinterpret_cast<CollisionWorldObject*>(object)->state;
+    ProjectileBuffers held;
+    ProjectileColumns columns;
+    if (!held.Acquire(buffers, columns)) {
+        return nullptr;
+    }
+    try {
+        StepProjectiles(columns, dt, state.tiles, state.projectile_status, state.removed, state.impacts);
+    } catch (const std::bad_alloc&) {
+        return PyErr_NoMemory();
+    }
+
+    PyObject* removed = PyList_New(static_cast<Py_ssize_t>(state.removed.size()));
+    PyObject* impacts = PyList_New(static_cast<Py_ssize_t>(state.impacts.size()));
+    if (removed == nullptr || impacts == nullptr) {
+        Py_XDECREF(removed);
+        Py_XDECREF(impacts);
+        return nullptr;
+    }
+    for (size_t i = 0; i < state.removed.size(); ++i) {
+        PyList_SET_ITEM(removed, static_cast<Py_ssize_t>(i), PyLong_FromUnsignedLong(state.removed[i]));
+    }
+    for (size_t i = 0; i < state.impacts.size(); ++i) {
+        const ProjectileImpact& impact = state.impacts[i];
+        PyList_SET_ITEM(impacts, static_cast<Py_ssize_t>(i),
+                        Py_BuildValue("(kdd)", static_cast<unsigned long>(impact.row), impact.x, impact.y));
+    }
+    if (PyErr_Occurred()) {
+        Py_DECREF(removed);
+        Py_DECREF(impacts);
+        return nullptr;
+    }
+    return Py_BuildValue("(NN)", removed, impacts);
+}
+
+PyMethodDef kCollisionWorldMethods[] = {
+    {"set_tiles", CollisionWorldSetTiles, METH_VARARGS,
+     "set_tiles(width, height, solid)\n\nReplaces the room; solid holds one byte per tile, row-major, non-zero = blocks."},
+    {"solid_at", CollisionWorldSolidAt, METH_VARARGS,
+     "solid_at(xs, ys) -> list[bool]\n\nWhether the tile under each point blocks movement."},
+    {"walkable", CollisionWorldWalkable, METH_VARARGS,
+     "walkable(xs, ys, radii) -> list[bool]\n\nWhether a box of half-size radius around each point touches no solid tile."},
+    {"build_circles", CollisionWorldBuildCircles, METH_VARARGS,
+     "build_circles(xs, ys, radii)\n\nReplaces the circles indexed by the spatial hash."},
+    {"first_overlaps", CollisionWorldFirstOverlaps, METH_VARARGS,
+     "first_overlaps(xs, ys, radii) -> list[int]\n\nLowest indexed circle each probe overlaps, or -1."},
+    {"build_flow_field", CollisionWorldBuildFlowField, METH_VARARGS,
+     "build_flow_field(goal_x, goal_y)\n\nRecomputes the path distances from every open tile to the goal tile."},
+    {"flow_directions", CollisionWorldFlowDirections, METH_VARARGS,
+     "flow_directions(xs, ys) -> list[(dx, dy)]\n\n"
+     "Unit vector from each point towards the next tile on its path to the goal; (0, 0) on the goal tile\n"
+     "and where no path exists."},
+    {"step_projectiles", CollisionWorldStepProjectiles, METH_VARARGS,
+     "step_projectiles(x, y, vx, vy, ttl, radius, dt) -> (removed, impacts)\n\n"
+     "Integrates a batch of array('d') columns in place and compacts survivors to the front.\n"
+     "removed lists dropped rows (expired or on a solid tile); impacts holds (row, x, y) for the latter.\n"
+     "The caller truncates every column to len(x) - len(removed)."},
+    {nullptr, nullptr, 0, nullptr},
+};
+
+// A heap type from a spec rather than a static PyTypeObject, whose dozens of
+// fields cannot all be spelled out without designated initializers.
+PyType_Slot kCollisionWorldSlots[] = {
+    {Py_tp_doc, const_cast<char*>("CollisionWorld(width, height, solid)\n\nTilemap plus a spatial hash of circles.")},
+    {Py_tp_new, reinterpret_cast<void*>(CollisionWorldNew)},
+    {Py_tp_init, reinterpret_cast<void*>(CollisionWorldInit)},
+    {Py_tp_dealloc, reinterpret_cast<void*>(CollisionWorldDealloc)},
+    {Py_tp_methods, kCollisionWorldMethods},
+    {0, nullptr},
+};
+
+PyType_Spec kCollisionWorldSpec = {
+    "rogue_native.CollisionWorld",
+    static_cast<int>(sizeof(CollisionWorldObject)),
+    0,
+    Py_TPFLAGS_DEFAULT,
+    kCollisionWorldSlots,
+};
+
+PyModuleDef kModule = {
+    PyModuleDef_HEAD_INIT,
+    "rogue_native",
+    "Native spatial hash, tilemap and flow-field queries for the simulation.",
+    -1,
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+};
+
+}  // namespace
+
+PyMODINIT_FUNC PyInit_rogue_native() {
+    PyObject* module = PyModule_Create(&kModule);
+    if (module == nullptr) {
+        return nullptr;
+    }
+    if (PyModule_AddStringConstant(module, "KERNEL_ISA", ProjectileKernelIsa()) < 0) {
+        Py_DECREF(module);
+        return nullptr;
+    }
+    PyObject* type = PyType_FromSpec(&kCollisionWorldSpec);
+    if (type == nullptr) {
+        Py_DECREF(module);
+        return nullptr;
+    }
+    if (PyModule_AddObject(module, "CollisionWorld", type) < 0) {
+        Py_DECREF(type);
+        Py_DECREF(module);
+        return nullptr;
+    }
+    return module;
+}
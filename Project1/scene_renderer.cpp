@@ -0,0 +1,672 @@
+#include "scene_renderer.h"
+
+#include "frame_profiler.h"
+#include "memory_budget.h"
+#include "rlgl.h"
+
+#include <algorithm>
+#include <array>
+
+namespace {
+
+constexpr int kChunkTiles = 16;
+// 48 chunks of 512x512 at 32 px tiles is 48 MiB; the 1280x720 view touches at
+// most 12 at zoom 1, the rest covers zoomed-out views and recently seen areas.
+constexpr int kMaxChunkTextures = 48;
+
+// Entity extents in tiles from their centre, used for both drawing and culling.
+constexpr float kPickupRadius = 0.22f;
+constexpr float kProjectileRadius = 0.18f;
+constexpr float kEffectRadius = 0.28f;
+constexpr float kActorExtent = 0.6f;  // body plus the health bar above it
+constexpr float kActorSpriteSize = 0.8f;
+// Projectiles are recorded in slices of this many, so a bullet storm
+// spreads over every worker instead of landing on one.
+constexpr size_t kProjectileSlice = 2048;
+
+using snapshot::CodeCount;
+using snapshot::CodeIndex;
+using snapshot::PickupKind;
+using snapshot::TileCode;
+
+// Default palettes, indexed by wire code so a draw pass looks colours up with
+// one load. renderer.palette overrides the tile fills and pickup colours.
+constexpr auto kTileFill = [] {
+    std::array<Color, CodeCount<TileCode>()> colors{};
+    for (Color& color : colors) {
+        color = Color{50, 48, 60, 255};
+    }
+    colors[CodeIndex(TileCode::Floor)] = Color{60, 52, 65, 255};
+    colors[CodeIndex(TileCode::Wall)] = Color{90, 92, 112, 255};
+    colors[CodeIndex(TileCode::Pit)] = Color{20, 20, 32, 255};
+    colors[CodeIndex(TileCode::Rock)] = Color{120, 120, 140, 255};
+    colors[CodeIndex(TileCode::Spikes)] = Color{110, 40, 40, 255};
+    colors[CodeIndex(TileCode::DoorUp)] = Color{150, 120, 60, 255};
+    colors[CodeIndex(TileCode::DoorDown)] = Color{150, 120, 60, 255};
+    colors[CodeIndex(TileCode::DoorLeft)] = Color{150, 120, 60, 255};
+    colors[CodeIndex(TileCode::DoorRight)] = Color{150, 120, 60, 255};
+    colors[CodeIndex(TileCode::Special)] = Color{100, 50, 130, 255};
+    return colors;
+}();
+
+// Alpha 0 means no outline.
+constexpr auto kTileOutline = [] {
+    std::array<Color, CodeCount<TileCode>()> colors{};
+    colors[CodeIndex(TileCode::Wall)] = Color{15, 15, 25, 180};
+    colors[CodeIndex(TileCode::Rock)] = Color{30, 30, 40, 200};
+    colors[CodeIndex(TileCode::Spikes)] = Color{200, 40, 60, 255};
+    colors[CodeIndex(TileCode::DoorUp)] = Color{240, 190, 90, 255};
+    colors[CodeIndex(TileCode::DoorDown)] = Color{240, 190, 90, 255};
+    colors[CodeIndex(TileCode::DoorLeft)] = Color{240, 190, 90, 255};
+    colors[CodeIndex(TileCode::DoorRight)] = Color{240, 190, 90, 255};
+    colors[CodeIndex(TileCode::Special)] = Color{200, 120, 255, 255};
+    return colors;
+}();
+
+constexpr auto kPickupColors = [] {
+    std::array<Color, CodeCount<PickupKind>()> colors{};
+    for (Color& color : colors) {
+        color = Color{220, 220, 220, 255};
+    }
+    colors[CodeIndex(PickupKind::Heart)] = Color{220, 60, 80, 255};
+    colors[CodeIndex(PickupKind::Coin)] = Color{230, 200, 80, 255};
+    colors[CodeIndex(PickupKind::Key)] = Color{180, 180, 200, 255};
+    colors[CodeIndex(PickupKind::Bomb)] = Color{90, 90, 90, 255};
+    return colors;
+}();
+
+// Mirrors RogueGame.SOLID_TILES.
+constexpr bool BlocksMovement(TileCode tile) {
+    return tile == TileCode::Wall || tile == TileCode::Rock || tile == TileCode::Pit;
+}
+
+// Codes come from the decoder, which maps anything unrecognised to Unknown,
+// but a stray byte must not index past the table.
+template <typename Code, size_t N>
+constexpr Color PaletteColor(const std::array<Color, N>& palette, Code code) {
+    return CodeIndex(code) < N ? palette[CodeIndex(code)] : palette[0];
+}
+
+}  // namespace
+
+void SceneRenderer::Load() {
+    shapes_.Load();
+    hud_.Load();
+    sprites_.Load();
+    particles_.Configure(particle_capacity_);
+    SetQualityLevel(quality_level_);
+}
+
+SceneRenderer::Palette SceneRenderer::DefaultPalette() {
+    Palette palette;
+    palette.tiles = kTileFill;
+    palette.pickups = kPickupColors;
+    return palette;
+}
+
+void SceneRenderer::SetPalette(const Palette& palette) {
+    const auto same = [](const Color& a, const Color& b) {
+        return a.r == b.r && a.g == b.g && a.b == b.b && a.a == b.a;
+    };
+    if (!std::equal(palette.tiles.begin(), palette.tiles.end(), palette_.tiles.begin(), same)) {
+        tile_cache_stale_ = true;
+    }
+    palette_ = palette;
+}
+
+void SceneRenderer::ReloadSprites() {
+    sprites_.Unload();
+    sprites_.Load();
+    tile_cache_stale_ = true;
+}
+
+void SceneRenderer::ReloadHud() {
+    hud_.Unload();
+    hud_.Load();
+}
+
+void SceneRenderer::SetQualityLevel(int level) {
+    constexpr std::array<int, kQualityLevels> kHudIntervals = {1, 6, 6, 15};
+    quality_level_ = std::clamp(level, 0, kQualityLevels - 1);
+    outlines_ = quality_level_ < 2;
+    effects_ = quality_level_ < 3;
+    particles_.SetLimit(effects_ ? particle_capacity_ >> quality_level_ : 0);
+    if (!effects_) {
+        particles_.Clear();
+    }
+    hud_.SetRebuildInterval(kHudIntervals[quality_level_]);
+}
+
+void SceneRenderer::Unload() {
+    shapes_.Unload();
+    hud_.Unload();
+    sprites_.Unload();
+    ResetChunks(0, 0, 0.0f);
+    tile_cache_revision_ = 0;
+    tile_cache_serial_ = 0;
+    tile_cache_sprites_ = 0;
+}
+
+void SceneRenderer::UpdateCamera(const WorldSnapshot& world, const WorldInterpolator::Positions& actors) {
+    Vector2 focus{world.room_width * 0.5f - 0.5f, world.room_height * 0.5f - 0.5f};
+    for (size_t i = 0; i < world.actors.Size() && i < actors.x.size(); ++i) {
+        if (world.actors.type[i] == snapshot::ActorType::Player) {
+            focus = Vector2{actors.x[i], actors.y[i]};
+            break;
+        }
+    }
+    camera_.Update(GetScreenWidth(), GetScreenHeight(), world.room_width, world.room_height, world.tile_size, focus);
+
+    stats_ = CullStats{};
+    stats_.visible_tiles = camera_.VisibleTiles().Area();
+    stats_.room_tiles = world.room_width * world.room_height;
+}
+
+// The room is static between layout changes, so it is baked into render
+// textures at room resolution, one per chunk, and only the chunks in view are
+// blitted each frame. Tiles changed by deltas (destroyed rocks, opened doors)
+// are redrawn into their chunk in place. Cost follows the visible area, not
+// the room size.
+void SceneRenderer::UpdateTileCache(const WorldSnapshot& world,
+                                    uint64_t layout_revision,
+                                    uint64_t serial,
+                                    const std::vector<TileChange>& dirty_tiles) {
+    tile_size_ = world.tile_size;
+    room_width_ = world.room_width;
+    room_height_ = world.room_height;
+    if (room_width_ <= 0 || room_height_ <= 0 || tile_size_ <= 0.0f) {
+        return;
+    }
+
+    const int chunks_x = (room_width_ + kChunkTiles - 1) / kChunkTiles;
+    const int chunks_y = (room_height_ + kChunkTiles - 1) / kChunkTiles;
+    if (chunks_x != chunks_x_ || chunks_y != chunks_y_ || tile_size_ != chunk_tile_size_) {
+        ResetChunks(chunks_x, chunks_y, tile_size_);
+        tile_cache_revision_ = 0;
+    }
+
+    // New tile sprites change every chunk; they arrive over the first frames.
+    if (tile_cache_revision_ != layout_revision || tile_cache_sprites_ != sprites_.TileRevision() ||
+        tile_cache_stale_) {
+        for (TileChunk& chunk : chunks_) {
+            chunk.dirty = true;
+        }
+        tile_cache_stale_ = false;
+        tile_cache_revision_ = layout_revision;
+        tile_cache_sprites_ = sprites_.TileRevision();
+        tile_cache_serial_ = serial;
+        flow_field_stale_ = true;
+    } else if (tile_cache_serial_ != serial) {
+        tile_cache_serial_ = serial;
+        flow_field_stale_ = flow_field_stale_ || !dirty_tiles.empty();
+        // Chunks without a clean texture are rebaked whole when they come
+        // into view, so only baked ones need the individual tiles.
+        unsigned int target = 0;
+        for (const TileChange& change : dirty_tiles) {
+            if (change.x >= room_width_ || change.y >= room_height_) {
+                continue;
+            }
+            const int chunk_x = change.x / kChunkTiles;
+            const int chunk_y = change.y / kChunkTiles;
+            TileChunk& chunk = chunks_[static_cast<size_t>(chunk_y) * chunks_x_ + chunk_x];
+            if (chunk.texture.id == 0 || chunk.dirty) {
+                continue;
+            }
+            if (target != chunk.texture.id) {
+                if (target != 0) {
+                    EndTextureMode();
+                }
+                BeginTextureMode(chunk.texture);
+                target = chunk.texture.id;
+            }
+            const Rectangle rect{
+                static_cast<float>(change.x - chunk_x * kChunkTiles) * tile_size_,
+                static_cast<float>(change.y - chunk_y * kChunkTiles) * tile_size_,
+                tile_size_,
+                tile_size_
+            };
+            // Replace the cell's old pixels rather than blending over them,
+            // or a translucent sprite shows the tile it replaced.
+            rlSetBlendFactors(RL_ONE, RL_ZERO, RL_FUNC_ADD);
+            BeginBlendMode(BLEND_CUSTOM);
+            DrawRectangleRec(rect, BLANK);
+            EndBlendMode();
+            DrawTile(world, change.x, change.y, rect);
+        }
+        if (target != 0) {
+            EndTextureMode();
+        }
+    }
+
+    ++frame_;
+    const TileRect visible = VisibleChunks();
+    for (int chunk_y = visible.y0; chunk_y < visible.y1; ++chunk_y) {
+        for (int chunk_x = visible.x0; chunk_x < visible.x1; ++chunk_x) {
+            TileChunk& chunk = chunks_[static_cast<size_t>(chunk_y) * chunks_x_ + chunk_x];
+            chunk.last_drawn = frame_;
+            if (chunk.texture.id == 0 && !AcquireChunkTexture(chunk)) {
+                continue;  // over budget: DrawTilemap draws its tiles directly
+            }
+            if (chunk.dirty) {
+                BakeChunk(world, chunk, chunk_x, chunk_y);
+            }
+        }
+    }
+    stats_.visible_chunks = visible.Area();
+    stats_.chunk_textures = chunk_textures_;
+}
+
+// Drops every chunk; textures are kept for reuse unless the tile size (and
+// with it the texture size) changed.
+void SceneRenderer::ResetChunks(int chunks_x, int chunks_y, float tile_size) {
+    for (TileChunk& chunk : chunks_) {
+        if (chunk.texture.id != 0) {
+            spare_textures_.push_back(chunk.texture);
+        }
+    }
+    if (tile_size != chunk_tile_size_) {
+        for (const RenderTexture2D& texture : spare_textures_) {
+            allocation_counter::AddExternalBytes(allocation_counter::MemoryTag::Render, -TextureBytes(texture));
+            UnloadRenderTexture(texture);
+        }
+        spare_textures_.clear();
+        chunk_textures_ = 0;
+        chunk_tile_size_ = tile_size;
+    }
+    chunks_.assign(static_cast<size_t>(chunks_x) * chunks_y, TileChunk{});
+    chunks_x_ = chunks_x;
+    chunks_y_ = chunks_y;
+}
+
+bool SceneRenderer::AcquireChunkTexture(TileChunk& chunk) {
+    if (!spare_textures_.empty()) {
+        chunk.texture = spare_textures_.back();
+        spare_textures_.pop_back();
+    } else if (chunk_textures_ < kMaxChunkTextures) {
+        const int size = static_cast<int>(kChunkTiles * chunk_tile_size_);
+        chunk.texture = LoadRenderTexture(size, size);
+        if (chunk.texture.id == 0) {
+            return false;
+        }
+        allocation_counter::AddExternalBytes(allocation_counter::MemoryTag::Render, TextureBytes(chunk.texture));
+        // Scaled views (zoom, overview) sample between texels; clamp keeps a
+        // chunk's edge from picking up its opposite side.
+        SetTextureFilter(chunk.texture.texture, TEXTURE_FILTER_BILINEAR);
+        SetTextureWrap(chunk.texture.texture, TEXTURE_WRAP_CLAMP);
+        ++chunk_textures_;
+    } else {
+        TileChunk* victim = nullptr;
+        for (TileChunk& candidate : chunks_) {
+            if (candidate.texture.id != 0 && candidate.last_drawn < frame_ &&
+                (victim == nullptr || candidate.last_drawn < victim->last_drawn)) {
+                victim = &candidate;
+            }
+        }
+        if (victim == nullptr) {
+            return false;
+        }
+        chunk.texture = victim->texture;
+        victim->texture = RenderTexture2D{};
+        victim->dirty = true;
+    }
+    chunk.dirty = true;
+    return true;
+}
+
+void SceneRenderer::BakeChunk(const WorldSnapshot& world, TileChunk& chunk, int chunk_x, int chunk_y) {
+    const int x0 = chunk_x * kChunkTiles;
+    const int y0 = chunk_y * kChunkTiles;
+    const int x1 = std::min(x0 + kChunkTiles, room_width_);
+    const int y1 = std::min(y0 + kChunkTiles, room_height_);
+    BeginTextureMode(chunk.texture);
+    ClearBackground(BLANK);
+    for (int y = y0; y < y1; ++y) {
+        for (int x = x0; x < x1; ++x) {
+            const Rectangle rect{
+                static_cast<float>(x - x0) * tile_size_,
+                static_cast<float>(y - y0) * tile_size_,
+                tile_size_,
+                tile_size_
+            };
+            DrawTile(world, x, y, rect);
+        }
+    }
+    EndTextureMode();
+    chunk.dirty = false;
+}
+
+TileRect SceneRenderer::VisibleChunks() const {
+    const TileRect tiles = camera_.VisibleTiles();
+    if (tiles.Empty() || chunks_.empty()) {
+        return TileRect{};
+    }
+    return TileRect{
+        tiles.x0 / kChunkTiles,
+        tiles.y0 / kChunkTiles,
+        std::min((tiles.x1 + kChunkTiles - 1) / kChunkTiles, chunks_x_),
+        std::min((tiles.y1 + kChunkTiles - 1) / kChunkTiles, chunks_y_)
+    };
+}
+
+void SceneRenderer::DrawTile(const WorldSnapshot& world, int x, int y, Rectangle rect) {
+    const TileCode tile = world.TileAt(x, y);
+    if (const Rectangle* sprite = sprites_.Find(SpriteAtlas::Set::Tile, CodeIndex(tile))) {
+        DrawTexturePro(sprites_.Texture(), *sprite, rect, Vector2{0.0f, 0.0f}, 0.0f, WHITE);
+        return;
+    }
+    DrawRectangleRec(rect, PaletteColor(palette_.tiles, tile));
+    const Color outline = PaletteColor(kTileOutline, tile);
+    if (outline.a > 0) {
+        DrawRectangleLinesEx(rect, 1.0f, outline);
+    }
+}
+
+void SceneRenderer::DrawTilemap(const WorldSnapshot& world) {
+    if (room_width_ != world.room_width || room_height_ != world.room_height) {
+        return;  // UpdateTileCache has not seen this room yet
+    }
+    const TileRect visible = VisibleChunks();
+    const TileRect tiles = camera_.VisibleTiles();
+    const float scale = camera_.Scale();
+    const Vector2 origin = camera_.Origin();
+    for (int chunk_y = visible.y0; chunk_y < visible.y1; ++chunk_y) {
+        for (int chunk_x = visible.x0; chunk_x < visible.x1; ++chunk_x) {
+            const TileChunk& chunk = chunks_[static_cast<size_t>(chunk_y) * chunks_x_ + chunk_x];
+            const int x0 = chunk_x * kChunkTiles;
+            const int y0 = chunk_y * kChunkTiles;
+            const int x1 = std::min(x0 + kChunkTiles, room_width_);
+            const int y1 = std::min(y0 + kChunkTiles, room_height_);
+
+            if (chunk.texture.id != 0 && !chunk.dirty) {
+                // Render textures are stored bottom-up: the baked tiles sit at
+                // the top of the texture and a negative source height flips
+                // them.
+                const Texture2D& texture = chunk.texture.texture;
+                const float used_w = (x1 - x0) * tile_size_;
+                const float used_h = (y1 - y0) * tile_size_;
+                const Rectangle source{0.0f, texture.height - used_h, used_w, -used_h};
+                const Rectangle dest{origin.x + x0 * scale, origin.y + y0 * scale, (x1 - x0) * scale, (y1 - y0) * scale};
+                DrawTexturePro(texture, source, dest, Vector2{0.0f, 0.0f}, 0.0f, WHITE);
+                continue;
+            }
+            for (int y = std::max(y0, tiles.y0); y < std::min(y1, tiles.y1); ++y) {
+                for (int x = std::max(x0, tiles.x0); x < std::min(x1, tiles.x1); ++x) {
+                    DrawTile(world, x, y, Rectangle{origin.x + x * scale, origin.y + y * scale, scale, scale});
+                }
+            }
+        }
+    }
+}
+
+void SceneRenderer::DrawFlowField(const WorldSnapshot& world) {
+    if (!show_flow_field_ || room_width_ != world.room_width || room_height_ != world.room_height ||
+        world.tiles.size() != static_cast<size_t>(room_width_) * room_height_) {
+        return;
+    }
+    const ActorArrays& actors = world.actors;
+    size_t player = actors.Size();
+    for (size_t i = 0; i < actors.Size(); ++i) {
+        if (actors.type[i] == snapshot::ActorType::Player) {
+            player = i;
+            break;
+        }
+    }
+    if (player == actors.Size()) {
+        return;
+    }
+    // The simulation's tile under a point: truncated and clamped.
+    const int goal_x = std::clamp(static_cast<int>(actors.x[player]), 0, room_width_ - 1);
+    const int goal_y = std::clamp(static_cast<int>(actors.y[player]), 0, room_height_ - 1);
+    UpdateFlowField(world, goal_x, goal_y);
+
+    const TileRect tiles = camera_.VisibleTiles();
+    const float scale = camera_.Scale();
+    const Vector2 origin = camera_.Origin();
+    const float max_distance = static_cast<float>(std::max<uint32_t>(1, flow_field_.MaxDistance()));
+    for (int y = tiles.y0; y < tiles.y1; ++y) {
+        for (int x = tiles.x0; x < tiles.x1; ++x) {
+            const uint8_t step = flow_field_.Step(x, y);
+            if (step == FlowField::kNoStep) {
+                continue;
+            }
+            // Near tiles are green, far ones red.
+            const float t = flow_field_.Distance(x, y) / max_distance;
+            const Color color{static_cast<unsigned char>(80 + 175 * t), static_cast<unsigned char>(230 - 170 * t), 90,
+                              200};
+            const Vector2 from{origin.x + (x + 0.5f) * scale, origin.y + (y + 0.5f) * scale};
+            const Vector2 to{from.x + FlowField::kStepX[step] * scale * 0.35f,
+                             from.y + FlowField::kStepY[step] * scale * 0.35f};
+            DrawLineEx(from, to, std::max(1.0f, scale * 0.06f), color);
+            DrawCircleV(to, std::max(1.5f, scale * 0.08f), color);
+        }
+    }
+    const Rectangle goal{origin.x + goal_x * scale, origin.y + goal_y * scale, scale, scale};
+    DrawRectangleLinesEx(goal, 2.0f, Color{90, 230, 90, 230});
+}
+
+void SceneRenderer::UpdateFlowField(const WorldSnapshot& world, int goal_x, int goal_y) {
+    if (!flow_field_stale_ && flow_field_.GoalX() == goal_x && flow_field_.GoalY() == goal_y &&
+        flow_field_.Width() == room_width_ && flow_field_.Height() == room_height_) {
+        return;
+    }
+    flow_solid_.resize(world.tiles.size());
+    for (size_t i = 0; i < world.tiles.size(); ++i) {
+        flow_solid_[i] = BlocksMovement(world.tiles[i]) ? 1 : 0;
+    }
+    flow_field_.Build(room_width_, room_height_, flow_solid_.data(), goal_x, goal_y);
+    flow_field_stale_ = false;
+}
+
+void SceneRenderer::UpdateParticles(const WorldSnapshot& world, const std::vector<ParticleSpawn>& spawns, float dt) {
+    if (world.meta.room_id != particle_room_) {
+        particle_room_ = world.meta.room_id;
+        particles_.Clear();
+    }
+    particles_.Update(dt);
+    for (const ParticleSpawn& spawn : spawns) {
+        if (spawn.sequence <= particle_sequence_) {
+            continue;
+        }
+        particle_sequence_ = spawn.sequence;
+        if (!effects_) {
+            continue;  // seen, so it does not start late if effects come back
+        }
+        const uint64_t ticks = world.meta.tick > spawn.tick ? world.meta.tick - spawn.tick : 0;
+        particles_.Spawn(spawn, static_cast<float>(ticks) * world.meta.delta_time);
+    }
+}
+
+void SceneRenderer::BuildEntityLayers(const WorldSnapshot& world,
+                                      const WorldInterpolator::Positions& actors,
+                                      const WorldInterpolator::Positions& projectiles,
+                                      JobSystem& jobs) {
+    // Pickups, actors, one build per projectile slice (at least one), effects.
+    const size_t slices = std::max<size_t>(1, (world.projectiles.Size() + kProjectileSlice - 1) / kProjectileSlice);
+    build_count_ = slices + 3;
+    if (builds_.size() < build_count_) {
+        builds_.resize(build_count_);
+    }
+
+    auto build = [&](size_t index) {
+        LayerBuild& layer = builds_[index];
+        layer.list.Clear();
+        layer.drawn = 0;
+        layer.culled = 0;
+        layer.start_us = FrameProfiler::NowMicros();
+        if (index == 0) {
+            RecordPickups(world, layer);
+        } else if (index == 1) {
+            RecordActors(world, actors, layer);
+        } else if (index == build_count_ - 1) {
+            RecordEffects(world, layer);
+        } else {
+            RecordProjectiles(world, projectiles, (index - 2) * kProjectileSlice, layer);
+        }
+        layer.duration_us = FrameProfiler::NowMicros() - layer.start_us;
+    };
+    jobs.ParallelFor(build_count_, build);
+
+    for (size_t i = 0; i < build_count_; ++i) {
+        stats_.drawn_entities += builds_[i].drawn;
+        stats_.culled_entities += builds_[i].culled;
+    }
+}
+
+void SceneRenderer::DrawEntityLayers() {
+    lists_.clear();
+    for (size_t i = 0; i < build_count_; ++i) {
+        lists_.push_back(&builds_[i].list);
+    }
+    shapes_.Submit(lists_.data(), lists_.size(), sprites_.Texture());
+}
+
+SceneRenderer::LayerTiming SceneRenderer::Timing(Layer layer) const {
+    if (build_count_ == 0) {
+        return LayerTiming{};
+    }
+    size_t first = 0;
+    size_t last = 0;
+    switch (layer) {
+    case Layer::Pickups: first = last = 0; break;
+    case Layer::Actors: first = last = 1; break;
+    case Layer::Projectiles: first = 2; last = build_count_ - 2; break;
+    default: first = last = build_count_ - 1; break;
+    }
+    int64_t start_us = builds_[first].start_us;
+    int64_t end_us = start_us;
+    for (size_t i = first; i <= last; ++i) {
+        start_us = std::min(start_us, builds_[i].start_us);
+        end_us = std::max(end_us, builds_[i].start_us + builds_[i].duration_us);
+    }
+    return LayerTiming{start_us, end_us - start_us};
+}
+
+// Sprites are recorded into the layer's list; Submit draws them through
+// raylib's batch, which keeps consecutive draws from the one atlas texture
+// in a single draw call, underneath every shape.
+bool SceneRenderer::RecordSprite(ShapeList& list, SpriteAtlas::Set set, size_t code, Vector2 center, float size,
+                                 Color tint) const {
+    const Rectangle* sprite = sprites_.Find(set, code);
+    if (!sprite) {
+        return false;
+    }
+    const Rectangle dest{center.x - size * 0.5f, center.y - size * 0.5f, size, size};
+    list.DrawSprite(*sprite, dest, tint);
+    return true;
+}
+
+// Counts the entity and tells the pass whether to skip it.
+bool SceneRenderer::Cull(LayerBuild& layer, float x, float y, float radius) const {
+    if (camera_.Visible(x, y, radius)) {
+        ++layer.drawn;
+        return false;
+    }
+    ++layer.culled;
+    return true;
+}
+
+void SceneRenderer::RecordPickups(const WorldSnapshot& world, LayerBuild& layer) const {
+    const PickupArrays& pickups = world.pickups;
+    const float scale = camera_.Scale();
+    for (size_t i = 0; i < pickups.Size(); ++i) {
+        if (Cull(layer, pickups.x[i], pickups.y[i], kPickupRadius)) {
+            continue;
+        }
+        Vector2 pos = camera_.WorldToScreen(pickups.x[i], pickups.y[i]);
+        if (RecordSprite(layer.list, SpriteAtlas::Set::Pickup, CodeIndex(pickups.kind[i]), pos,
+                         scale * kPickupRadius * 2.0f, WHITE)) {
+            continue;
+        }
+        layer.list.Circle(pos, scale * kPickupRadius, PaletteColor(palette_.pickups, pickups.kind[i]));
+    }
+}
+
+void SceneRenderer::RecordActors(const WorldSnapshot& world,
+                                 const WorldInterpolator::Positions& positions,
+                                 LayerBuild& layer) const {
+    const ActorArrays& actors = world.actors;
+    const float scale = camera_.Scale();
+    ShapeList& list = layer.list;
+    for (size_t i = 0; i < actors.Size(); ++i) {
+        if (Cull(layer, positions.x[i], positions.y[i], kActorExtent)) {
+            continue;
+        }
+        Vector2 pos = camera_.WorldToScreen(positions.x[i], positions.y[i]);
+
+        const bool invulnerable = actors.flags[i] & snapshot::kActorInvulnerable;
+        const bool sprite = RecordSprite(list, SpriteAtlas::Set::Actor, CodeIndex(actors.variant[i]), pos,
+                                         scale * kActorSpriteSize, invulnerable ? Color{255, 255, 180, 160} : WHITE);
+        if (actors.type[i] == snapshot::ActorType::Player) {
+            if (sprite) {
+                continue;
+            }
+            Color fill = Color{120, 200, 255, 255};
+            if (invulnerable) {
+                fill = Color{255, 255, 180, 255};
+            }
+            list.Circle(pos, scale * 0.35f, fill);
+            if (outlines_) {
+                list.CircleLines(pos, scale * 0.35f, Color{30, 30, 60, 255});
+            }
+        } else {
+            if (!sprite) {
+                const bool spitter = actors.variant[i] == snapshot::ActorVariant::Spitter;
+                Color fill = spitter ? Color{220, 90, 90, 255} : Color{200, 120, 120, 255};
+                list.Circle(pos, scale * 0.32f, fill);
+                if (outlines_) {
+                    list.CircleLines(pos, scale * 0.32f, Color{60, 20, 20, 255});
+                }
+            }
+
+            const int hp = actors.hp[i];
+            const int max_hp = std::max(1, static_cast<int>(actors.max_hp[i]));
+            float bar_width = scale * 0.6f;
+            Rectangle background{
+                pos.x - bar_width / 2.0f,
+                pos.y - scale * 0.5f,
+                bar_width,
+                4.0f
+            };
+            list.Rect(background, Color{30, 10, 10, 180});
+            Rectangle foreground = background;
+            foreground.width *= static_cast<float>(hp) / static_cast<float>(max_hp);
+            list.Rect(foreground, Color{220, 40, 40, 200});
+        }
+    }
+}
+
+void SceneRenderer::RecordProjectiles(const WorldSnapshot& world,
+                                      const WorldInterpolator::Positions& positions,
+                                      size_t first,
+                                      LayerBuild& layer) const {
+    const ProjectileArrays& projectiles = world.projectiles;
+    const float scale = camera_.Scale();
+    const size_t end = std::min(projectiles.Size(), first + kProjectileSlice);
+    for (size_t i = first; i < end; ++i) {
+        if (Cull(layer, positions.x[i], positions.y[i], kProjectileRadius)) {
+            continue;
+        }
+        const bool from_player = projectiles.owner[i] == snapshot::ProjectileOwner::Player;
+        Vector2 pos = camera_.WorldToScreen(positions.x[i], positions.y[i]);
+        Color color = from_player ? Color{150, 220, 255, 255} : Color{255, 150, 150, 255};
+        layer.list.Circle(pos, scale * kProjectileRadius, color);
+    }
+}
+
+void SceneRenderer::RecordEffects(const WorldSnapshot& world, LayerBuild& layer) const {
+    if (!effects_) {
+        return;
+    }
+    const EffectArrays& effects = world.effects;
+    const float scale = camera_.Scale();
+    for (size_t i = 0; i < effects.Size(); ++i) {
+        if (Cull(layer, effects.x[i], effects.y[i], kEffectRadius)) {
+            continue;
+        }
+        const bool blood = effects.kind[i] == snapshot::EffectKind::BloodSplatter;
+        Vector2 pos = camera_.WorldToScreen(effects.x[i], effects.y[i]);
+        Color color = blood ? Color{200, 40, 40, 180} : Color{220, 220, 255, 180};
+        layer.list.CircleLines(pos, scale * kEffectRadius, color);
+    }
+    particles_.Record(camera_, layer.list);
+}
@@ -0,0 +1,208 @@
+#pragma once
+#include "raylib.h"
+#include "flow_field.h"
+#include "hud_layer.h"
+#include "job_system.h"
+#include "particle_system.h"
+#include "shape_batch.h"
+#include "sprite_atlas.h"
+#include "world_camera.h"
+#include "world_interpolator.h"
+#include "world_snapshot.h"
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Draws a decoded world: the chunked tile cache, the entity layers through
+// one ShapeBatch and the sprite atlas, and the retained HUD layer. It knows
+// nothing about transports or timing, so the game and the benchmark run
+// exactly the same draw code. Only tiles and entities that intersect the
+// camera's view are drawn. Entity layers are recorded into ShapeLists on a
+// JobSystem before the frame starts and submitted on the GL thread; tiles
+// and the HUD are retained textures and stay on the GL thread throughout.
+// Particles are simulated here from the snapshot's spawn events and drawn
+// with the effects.
+class SceneRenderer {
+public:
+    // Entity layers, in draw order.
+    enum class Layer : uint8_t { Pickups = 0, Actors, Projectiles, Effects, Count };
+
+    // When a layer was recorded, on whichever thread recorded it. Projectiles
+    // are recorded in slices; their timing spans all of them.
+    struct LayerTiming {
+        int64_t start_us = 0;
+        int64_t duration_us = 0;
+    };
+
+    // Flat colours for tiles and pickups without a sprite, indexed by wire code.
+    struct Palette {
+        std::array<Color, snapshot::CodeCount<snapshot::TileCode>()> tiles{};
+        std::array<Color, snapshot::CodeCount<snapshot::PickupKind>()> pickups{};
+    };
+
+    // What the last frame drew; reset by UpdateCamera.
+    struct CullStats {
+        int visible_tiles = 0;
+        int room_tiles = 0;
+        int visible_chunks = 0;
+        int chunk_textures = 0;
+        uint32_t drawn_entities = 0;
+        uint32_t culled_entities = 0;
+    };
+
+    // Requires a GL context, so call after InitWindow.
+    void Load();
+    void Unload();
+
+    void ConfigureCamera(float zoom) { camera_.Configure(zoom); }
+    void ToggleOverview() { camera_.SetOverview(!camera_.Overview()); }
+    void ConfigureHud(const std::string& font_path) { hud_.Configure(font_path); }
+    void ConfigureSprites(const std::string& directory, int uploads_per_frame) {
+        sprites_.Configure(directory, uploads_per_frame);
+    }
+    // Before Load: how many particles can be alive at once.
+    void ConfigureParticles(size_t capacity) { particle_capacity_ = capacity; }
+    static Palette DefaultPalette();
+    // Between frames. New tile colours rebake the tile cache.
+    void SetPalette(const Palette& palette);
+    // Between frames, after ConfigureSprites or ConfigureHud: reloads the
+    // atlas (rebaking the tile cache as its sprites arrive) or the HUD font.
+    void ReloadSprites();
+    void ReloadHud();
+    // Adaptive quality, 0 = everything. Each level sheds what the one before
+    // it did and more: 1 halves the particle limit and redraws the HUD at most
+    // every 6 frames; 2 quarters the particles and drops actor outlines; 3
+    // drops effects and particles and redraws the HUD every 15 frames. Tiles
+    // are baked once, so they keep their look. Between frames only.
+    static constexpr int kQualityLevels = 4;
+    void SetQualityLevel(int level);
+    int QualityLevel() const { return quality_level_; }
+    void SetFlowFieldOverlay(bool enabled) { show_flow_field_ = enabled; }
+    void ToggleFlowFieldOverlay() { show_flow_field_ = !show_flow_field_; }
+
+    // Call once per frame before UpdateTileCache: moves sprites the loader
+    // thread finished into the atlas, a few per frame.
+    void UpdateSprites() { sprites_.Upload(); }
+
+    // Call once per frame before UpdateTileCache: points the camera at the
+    // player (or the room centre) for the current screen size.
+    void UpdateCamera(const WorldSnapshot& world, const WorldInterpolator::Positions& actors);
+
+    // Call once per frame before BeginDrawing, after UpdateCamera; it bakes
+    // the chunks that came into view. layout_revision, serial and dirty_tiles
+    // follow the IngestFrame contract.
+    void UpdateTileCache(const WorldSnapshot& world,
+                         uint64_t layout_revision,
+                         uint64_t serial,
+                         const std::vector<TileChange>& dirty_tiles);
+
+    // Call once per frame before BeginDrawing; redraws the HUD texture only
+    // if something on it changed.
+    void UpdateHud(const WorldSnapshot& world) { hud_.Update(world); }
+
+    void DrawTilemap(const WorldSnapshot& world);
+    // Debug overlay, drawn over the tilemap when enabled: the path each
+    // open tile takes towards the player, shaded by distance. It is the
+    // simulation's enemy flow field, rebuilt here from the snapshot's tiles
+    // whenever the player changes tile or the room changes.
+    void DrawFlowField(const WorldSnapshot& world);
+
+    // Call once per frame before BuildEntityLayers: advances live particles
+    // by dt seconds and starts the bursts in spawns not seen before (the
+    // ingest frame's list may repeat some). Clears them when the room changes.
+    void UpdateParticles(const WorldSnapshot& world, const std::vector<ParticleSpawn>& spawns, float dt);
+
+    // Call once per frame after UpdateCamera and UpdateSprites, before
+    // BeginDrawing: records every entity layer's draw list, spread over jobs.
+    // Touches no GL state. Adds the entity counts to Stats().
+    void BuildEntityLayers(const WorldSnapshot& world,
+                           const WorldInterpolator::Positions& actors,
+                           const WorldInterpolator::Positions& projectiles,
+                           JobSystem& jobs);
+    // Draws the lists BuildEntityLayers recorded, over the tilemap.
+    void DrawEntityLayers();
+    LayerTiming Timing(Layer layer) const;
+    void DrawHud() { hud_.Draw(); }
+
+    bool InstancedShapes() const { return shapes_.Instanced(); }
+    const CullStats& Stats() const { return stats_; }
+    uint64_t HudRebuilds() const { return hud_.Rebuilds(); }
+    const SpriteAtlas& Sprites() const { return sprites_; }
+    const ParticleSystem& Particles() const { return particles_; }
+
+private:
+    // kChunkTiles x kChunkTiles tiles baked into one render texture. Chunks
+    // get a texture when they first come into view; past the texture budget
+    // the least recently drawn chunk gives its texture up.
+    struct TileChunk {
+        RenderTexture2D texture{};
+        bool dirty = true;       // texture does not match the tiles
+        uint64_t last_drawn = 0;  // frame_ when last visible
+    };
+
+    void ResetChunks(int chunks_x, int chunks_y, float tile_size);
+    bool AcquireChunkTexture(TileChunk& chunk);
+    void BakeChunk(const WorldSnapshot& world, TileChunk& chunk, int chunk_x, int chunk_y);
+    TileRect VisibleChunks() const;
+    void DrawTile(const WorldSnapshot& world, int x, int y, Rectangle rect);
+    // One job of BuildEntityLayers: a layer, or a slice of the projectiles.
+    struct LayerBuild {
+        ShapeList list;
+        uint32_t drawn = 0;
+        uint32_t culled = 0;
+        int64_t start_us = 0;
+        int64_t duration_us = 0;
+    };
+
+    // The Record* passes run on worker threads: they only read the world,
+    // the camera, the atlas and the particles, and write their own LayerBuild.
+    void RecordPickups(const WorldSnapshot& world, LayerBuild& layer) const;
+    void RecordActors(const WorldSnapshot& world, const WorldInterpolator::Positions& positions,
+                      LayerBuild& layer) const;
+    void RecordProjectiles(const WorldSnapshot& world, const WorldInterpolator::Positions& positions,
+                           size_t first, LayerBuild& layer) const;
+    void RecordEffects(const WorldSnapshot& world, LayerBuild& layer) const;
+    bool Cull(LayerBuild& layer, float x, float y, float radius) const;
+    bool RecordSprite(ShapeList& list, SpriteAtlas::Set set, size_t code, Vector2 center, float size,
+                      Color tint) const;
+    void UpdateFlowField(const WorldSnapshot& world, int goal_x, int goal_y);
+
+    ShapeBatch shapes_;
+    HudLayer hud_;
+    SpriteAtlas sprites_;
+    WorldCamera camera_;
+    CullStats stats_;
+    // Pickups, actors, projectile slices, effects; grows to the frame with
+    // the most projectiles and is reused, so recording does not allocate.
+    std::vector<LayerBuild> builds_;
+    size_t build_count_ = 0;
+    std::vector<const ShapeList*> lists_;
+    std::vector<TileChunk> chunks_;
+    std::vector<RenderTexture2D> spare_textures_;
+    int chunks_x_ = 0;
+    int chunks_y_ = 0;
+    int chunk_textures_ = 0;      // loaded, in chunks_ or spare_textures_
+    float chunk_tile_size_ = 0.0f;  // tile size the loaded textures were sized for
+    uint64_t frame_ = 0;
+    uint64_t tile_cache_revision_ = 0;
+    uint64_t tile_cache_serial_ = 0;
+    uint64_t tile_cache_sprites_ = 0;  // sprites_.TileRevision() the chunks were baked with
+    bool tile_cache_stale_ = false;    // the palette or the atlas changed under the chunks
+    Palette palette_ = DefaultPalette();
+    float tile_size_ = 32.0f;
+    int room_width_ = 0;
+    int room_height_ = 0;
+    ParticleSystem particles_;
+    size_t particle_capacity_ = 4096;
+    uint64_t particle_sequence_ = 0;  // newest spawn started
+    uint32_t particle_room_ = 0;
+    FlowField flow_field_;
+    std::vector<uint8_t> flow_solid_;
+    bool show_flow_field_ = false;
+    bool flow_field_stale_ = true;  // tiles changed since flow_field_ was built
+    int quality_level_ = 0;
+    bool outlines_ = true;
+    bool effects_ = true;
+};
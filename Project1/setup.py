@@ -0,0 +1,33 @@
+"""Builds the optional rogue_native collision extension next to game_logic.py.
+
+    python setup.py build_ext --inplace
+
+The simulation falls back to pure-Python queries when it is absent.
+"""
+
+import os
+
+from setuptools import Extension, setup
+
+# No FMA contraction: the projectile kernel must round exactly like Python.
+# ROGUE_NATIVE_AVX=1 builds the AVX kernel instead of the SSE2 one.
+if os.name == "nt":
+    COMPILE_ARGS = ["/std:c++17", "/O2", "/fp:precise"]
+    AVX_ARGS = ["/arch:AVX"]
+else:
+    COMPILE_ARGS = ["-std=c++17", "-O2", "-ffp-contract=off"]
+    AVX_ARGS = ["-mavx"]
+if os.environ.get("ROGUE_NATIVE_AVX") == "1":
+    COMPILE_ARGS += AVX_ARGS
+
+setup(
+    name="rogue_native",
+    ext_modules=[
+        Extension(
+            "rogue_native",
+            sources=["rogue_native_module.cpp", "projectile_kernel.cpp", "spatial_hash.cpp", "flow_field.cpp"],
+            language="c++",
+            extra_compile_args=COMPILE_ARGS,
+        )
+    ],
+)
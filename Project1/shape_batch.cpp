@@ -0,0 +1,233 @@
+#include "shape_batch.h"
+
+#include "allocation_counter.h"
+#include "raymath.h"
+#include "rlgl.h"
+
+#include <algorithm>
+#include <cstddef>
+
+namespace {
+
+using Instance = ShapeList::Instance;
+
+// The instance buffer lives in GPU memory, outside the heap counters.
+void AccountInstanceBuffer(size_t capacity, int sign) {
+    allocation_counter::AddExternalBytes(allocation_counter::MemoryTag::Render,
+                                         sign * static_cast<int64_t>(capacity * sizeof(Instance)));
+}
+
+constexpr size_t kInitialCapacity = 1024;
+
+const char* kVertexShader = R"(#version 330
+layout(location = 0) in vec2 corner;
+layout(location = 1) in vec4 bounds;
+layout(location = 2) in vec4 color;
+layout(location = 3) in vec2 style;
+uniform mat4 mvp;
+out vec2 local;
+out vec4 tint;
+flat out vec2 shape_style;
+flat out float radius;
+void main() {
+    local = corner;
+    tint = color;
+    shape_style = style;
+    radius = bounds.z;
+    gl_Position = mvp * vec4(bounds.xy + corner * bounds.zw, 0.0, 1.0);
+}
+)";
+
+// style.x: 0 rectangle, 1 filled circle, 2 ring of style.y pixels.
+const char* kFragmentShader = R"(#version 330
+in vec2 local;
+in vec4 tint;
+flat in vec2 shape_style;
+flat in float radius;
+out vec4 final_color;
+void main() {
+    float alpha = 1.0;
+    if (shape_style.x > 0.5) {
+        float dist = length(local) * radius;
+        float edge = radius - dist;
+        if (shape_style.x > 1.5) {
+            edge = min(edge, dist - (radius - shape_style.y));
+        }
+        alpha = clamp(edge + 0.5, 0.0, 1.0);
+    }
+    if (alpha <= 0.0) {
+        discard;
+    }
+    final_color = vec4(tint.rgb, tint.a * alpha);
+}
+)";
+
+const float kQuad[] = {
+    -1.0f, -1.0f,  1.0f, -1.0f,  1.0f, 1.0f,
+    -1.0f, -1.0f,  1.0f, 1.0f,  -1.0f, 1.0f,
+};
+
+}  // namespace
+
+void ShapeBatch::Load() {
+    const int version = rlGetVersion();
+    if (version != RL_OPENGL_33 && version != RL_OPENGL_43) {
+        TraceLog(LOG_INFO, "Shape batch: instancing unavailable, using the default batch");
+        return;
+    }
+
+    shader_ = LoadShaderFromMemory(kVertexShader, kFragmentShader);
+    if (shader_.id == 0 || shader_.id == rlGetShaderIdDefault()) {
+        TraceLog(LOG_WARNING, "Shape batch: shader failed to compile, using the default batch");
+        shader_ = Shader{};
+        return;
+    }
+    mvp_location_ = GetShaderLocation(shader_, "mvp");
+
+    vao_ = rlLoadVertexArray();
+    rlEnableVertexArray(vao_);
+    quad_vbo_ = rlLoadVertexBuffer(kQuad, sizeof(kQuad), false);
+    rlSetVertexAttribute(0, 2, RL_FLOAT, false, 2 * sizeof(float), 0);
+    rlEnableVertexAttribute(0);
+
+    instance_capacity_ = kInitialCapacity;
+    instance_vbo_ = rlLoadVertexBuffer(nullptr, static_cast<int>(instance_capacity_ * sizeof(Instance)), true);
+    AccountInstanceBuffer(instance_capacity_, 1);
+    const int stride = sizeof(Instance);
+    rlSetVertexAttribute(1, 4, RL_FLOAT, false, stride, offsetof(Instance, x));
+    rlSetVertexAttribute(2, 4, RL_UNSIGNED_BYTE, true, stride, offsetof(Instance, color));
+    rlSetVertexAttribute(3, 2, RL_FLOAT, false, stride, offsetof(Instance, shape));
+    for (unsigned int attribute = 1; attribute <= 3; ++attribute) {
+        rlEnableVertexAttribute(attribute);
+        rlSetVertexAttributeDivisor(attribute, 1);
+    }
+    rlDisableVertexArray();
+}
+
+void ShapeBatch::Unload() {
+    if (instance_vbo_ != 0) {
+        rlUnloadVertexBuffer(instance_vbo_);
+        AccountInstanceBuffer(instance_capacity_, -1);
+    }
+    if (quad_vbo_ != 0) rlUnloadVertexBuffer(quad_vbo_);
+    if (vao_ != 0) rlUnloadVertexArray(vao_);
+    if (shader_.id != 0) UnloadShader(shader_);
+    instance_vbo_ = 0;
+    quad_vbo_ = 0;
+    vao_ = 0;
+    shader_ = Shader{};
+    instance_capacity_ = 0;
+}
+
+void ShapeList::Clear() {
+    instances_.clear();
+    sprites_.clear();
+}
+
+void ShapeList::Circle(Vector2 center, float radius, Color color) {
+    Push(center.x, center.y, radius, radius, color, Shape::Circle);
+}
+
+void ShapeList::CircleLines(Vector2 center, float radius, Color color) {
+    Push(center.x, center.y, radius, radius, color, Shape::Ring);
+}
+
+void ShapeList::Rect(Rectangle rect, Color color) {
+    const float half_width = rect.width * 0.5f;
+    const float half_height = rect.height * 0.5f;
+    Push(rect.x + half_width, rect.y + half_height, half_width, half_height, color, Shape::Rect);
+}
+
+void ShapeList::DrawSprite(Rectangle source, Rectangle dest, Color tint) {
+    sprites_.push_back(Sprite{source, dest, tint});
+}
+
+void ShapeList::Push(float x, float y, float half_width, float half_height, Color color, Shape shape) {
+    instances_.push_back(Instance{
+        x, y, half_width, half_height,
+        {color.r, color.g, color.b, color.a},
+        static_cast<float>(shape), 1.0f,
+    });
+}
+
+void ShapeBatch::Submit(const ShapeList* const* lists, size_t count, const Texture2D& sprites) {
+    size_t instances = 0;
+    for (size_t i = 0; i < count; ++i) {
+        for (const ShapeList::Sprite& sprite : lists[i]->Sprites()) {
+            DrawTexturePro(sprites, sprite.source, sprite.dest, Vector2{0.0f, 0.0f}, 0.0f, sprite.tint);
+        }
+        instances += lists[i]->Instances().size();
+    }
+    if (instances == 0) {
+        return;
+    }
+    if (Instanced()) {
+        SubmitInstanced(lists, count, instances);
+    } else {
+        SubmitFallback(lists, count);
+    }
+}
+
+void ShapeBatch::SubmitInstanced(const ShapeList* const* lists, size_t count, size_t instances) {
+    // Whatever raylib has queued (the tilemap blit, sprites) must land underneath.
+    rlDrawRenderBatchActive();
+
+    if (instances > instance_capacity_) {
+        AccountInstanceBuffer(instance_capacity_, -1);
+        instance_capacity_ = std::max(instances, instance_capacity_ * 2);
+        AccountInstanceBuffer(instance_capacity_, 1);
+        rlEnableVertexArray(vao_);
+        rlUnloadVertexBuffer(instance_vbo_);
+        instance_vbo_ = rlLoadVertexBuffer(nullptr, static_cast<int>(instance_capacity_ * sizeof(Instance)), true);
+        const int stride = sizeof(Instance);
+        rlSetVertexAttribute(1, 4, RL_FLOAT, false, stride, offsetof(Instance, x));
+        rlSetVertexAttribute(2, 4, RL_UNSIGNED_BYTE, true, stride, offsetof(Instance, color));
+        rlSetVertexAttribute(3, 2, RL_FLOAT, false, stride, offsetof(Instance, shape));
+        rlDisableVertexArray();
+    }
+    // Each list goes straight into its slice of the buffer, no staging copy.
+    size_t offset = 0;
+    for (size_t i = 0; i < count; ++i) {
+        const std::vector<Instance>& list = lists[i]->Instances();
+        if (list.empty()) {
+            continue;
+        }
+        rlUpdateVertexBuffer(instance_vbo_, list.data(), static_cast<int>(list.size() * sizeof(Instance)),
+                             static_cast<int>(offset * sizeof(Instance)));
+        offset += list.size();
+    }
+
+    rlEnableShader(shader_.id);
+    rlSetUniformMatrix(mvp_location_, MatrixMultiply(rlGetMatrixModelview(), rlGetMatrixProjection()));
+    rlEnableVertexArray(vao_);
+    rlDrawVertexArrayInstanced(0, 6, static_cast<int>(instances));
+    rlDisableVertexArray();
+    rlDisableShader();
+}
+
+void ShapeBatch::SubmitFallback(const ShapeList* const* lists, size_t count) {
+    using Shape = ShapeList::Shape;
+    for (size_t i = 0; i < count; ++i) {
+        for (const ShapeList::Instance& instance : lists[i]->Instances()) {
+            const Color color{instance.color[0], instance.color[1], instance.color[2], instance.color[3]};
+            const Vector2 center{instance.x, instance.y};
+            switch (static_cast<Shape>(instance.shape)) {
+                case Shape::Rect:
+                    DrawRectangleRec(Rectangle{
+                        instance.x - instance.half_width,
+                        instance.y - instance.half_height,
+                        instance.half_width * 2.0f,
+                        instance.half_height * 2.0f
+                    }, color);
+                    break;
+                case Shape::Circle:
+                    DrawCircleV(center, instance.half_width, color);
+                    break;
+                case Shape::Ring:
+                    DrawCircleLines(static_cast<int>(center.x), static_cast<int>(center.y), instance.half_width,
+                                    color);
+                    break;
+            }
+        }
+    }
+}
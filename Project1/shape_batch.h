@@ -0,0 +1,77 @@
+#pragma once
+
+#include "raylib.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// One layer's draws, recorded without touching GL: circles, rings and
+// rectangles for the ShapeBatch, plus sprite quads from one texture. Lists
+// are filled on any thread; ShapeBatch::Submit draws them on the GL thread.
+// Clear keeps the storage, so a warmed-up frame records without allocating.
+class ShapeList {
+public:
+    enum class Shape : uint8_t { Rect = 0, Circle, Ring };
+
+    // The instanced shader's vertex layout.
+    struct Instance {
+        float x;
+        float y;
+        float half_width;
+        float half_height;
+        uint8_t color[4];
+        float shape;
+        float thickness;
+    };
+
+    struct Sprite {
+        Rectangle source;
+        Rectangle dest;
+        Color tint;
+    };
+
+    void Clear();
+
+    void Circle(Vector2 center, float radius, Color color);
+    void CircleLines(Vector2 center, float radius, Color color);
+    void Rect(Rectangle rect, Color color);
+    void DrawSprite(Rectangle source, Rectangle dest, Color tint);
+
+    const std::vector<Instance>& Instances() const { return instances_; }
+    const std::vector<Sprite>& Sprites() const { return sprites_; }
+
+private:
+    void Push(float x, float y, float half_width, float half_height, Color color, Shape shape);
+
+    std::vector<Instance> instances_;
+    std::vector<Sprite> sprites_;
+};
+
+// Submits recorded ShapeLists. On OpenGL 3.3+ every shape is one instance of
+// a unit quad shaded as a signed distance field, so a frame costs a single
+// instanced draw call however many projectiles are alive. Elsewhere the
+// shapes are replayed through raylib's own batch. Sprites go first, through
+// raylib's batch (one draw call per texture), so shapes land on top of them;
+// list order, and order within a list, is preserved.
+class ShapeBatch {
+public:
+    // Requires a GL context, so call after InitWindow.
+    void Load();
+    void Unload();
+
+    void Submit(const ShapeList* const* lists, size_t count, const Texture2D& sprites);
+
+    bool Instanced() const { return vao_ != 0; }
+
+private:
+    void SubmitInstanced(const ShapeList* const* lists, size_t count, size_t instances);
+    void SubmitFallback(const ShapeList* const* lists, size_t count);
+
+    Shader shader_{};
+    int mvp_location_ = -1;
+    unsigned int vao_ = 0;
+    unsigned int quad_vbo_ = 0;
+    unsigned int instance_vbo_ = 0;
+    size_t instance_capacity_ = 0;
+};
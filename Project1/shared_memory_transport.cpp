@@ -0,0 +1,295 @@
+#include "shared_memory_transport.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr uint32_t kMappingMagic = 0x4D534752;  // "RGSM"
+constexpr uint32_t kMappingVersion = 2;
+constexpr int kReconnectInterval = 30;
+constexpr int kReadAttempts = 4;
+
+struct MappingHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t slot_count;
+    uint32_t slot_size;
+    std::atomic<uint64_t> write_sequence;
+    uint32_t writer_pid;
+    uint32_t reserved0;
+    // Written by the renderer: the newest tick it has presented, and its pid
+    // while it has the mapping open (0 once it lets go).
+    std::atomic<uint64_t> presented_tick;
+    std::atomic<uint32_t> reader_pid;
+    uint32_t reserved[5];
+};
+
+struct SlotHeader {
+    std::atomic<uint64_t> stamp;
+    std::atomic<uint32_t> size;
+    uint32_t reserved;
+};
+
+static_assert(sizeof(MappingHeader) == 64, "mapping header layout is shared with transport.py");
+static_assert(offsetof(MappingHeader, presented_tick) == 32, "mapping header layout is shared with transport.py");
+static_assert(offsetof(MappingHeader, reader_pid) == 40, "mapping header layout is shared with transport.py");
+static_assert(sizeof(SlotHeader) == 16, "slot header layout is shared with transport.py");
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "seqlock needs lock-free 64-bit atomics");
+
+MappingHeader* HeaderOf(unsigned char* view) {
+    return reinterpret_cast<MappingHeader*>(view);
+}
+
+uint32_t CurrentProcessId() {
+#ifdef _WIN32
+    return static_cast<uint32_t>(GetCurrentProcessId());
+#else
+    return static_cast<uint32_t>(getpid());
+#endif
+}
+
+const SlotHeader* SlotHeaderOf(const unsigned char* slot) {
+    return reinterpret_cast<const SlotHeader*>(slot);
+}
+
+}  // namespace
+
+SharedMemoryTransport::SharedMemoryTransport(fs::path mapping_path, fs::path shared_dir)
+    : mapping_path_(std::move(mapping_path)),
+      input_fallback_(std::move(shared_dir)) {}
+
+SharedMemoryTransport::~SharedMemoryTransport() {
+    Close();
+}
+
+bool SharedMemoryTransport::Open() {
+    input_fallback_.Open();
+    return Map();
+}
+
+void SharedMemoryTransport::Close() {
+    Unmap();
+    input_fallback_.Close();
+}
+
+bool SharedMemoryTransport::Map() {
+    Unmap();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileW(mapping_path_.c_str(), GENERIC_READ | GENERIC_WRITE,
+                              FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                              nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER file_size{};
+    if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart < static_cast<LONGLONG>(sizeof(MappingHeader))) {
+        CloseHandle(file);
+        return false;
+    }
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READWRITE, 0, 0, nullptr);
+    if (!mapping) {
+        CloseHandle(file);
+        return false;
+    }
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ | FILE_MAP_WRITE, 0, 0, 0);
+    if (!view) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+    file_handle_ = file;
+    mapping_handle_ = mapping;
+    view_ = static_cast<unsigned char*>(view);
+    view_size_ = static_cast<size_t>(file_size.QuadPart);
+#else
+    const int fd = open(mapping_path_.c_str(), O_RDWR);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info {};
+    if (fstat(fd, &info) != 0 || info.st_size < static_cast<off_t>(sizeof(MappingHeader))) {
+        close(fd);
+        return false;
+    }
+    void* view = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (view == MAP_FAILED) {
+        close(fd);
+        return false;
+    }
+    fd_ = fd;
+    view_ = static_cast<unsigned char*>(view);
+    view_size_ = static_cast<size_t>(info.st_size);
+#endif
+
+    MappingHeader* header = HeaderOf(view_);
+    const uint64_t required = sizeof(MappingHeader) +
+        static_cast<uint64_t>(header->slot_count) * (sizeof(SlotHeader) + header->slot_size);
+    if (header->magic != kMappingMagic || header->version != kMappingVersion ||
+        header->slot_count == 0 || required > view_size_) {
+        Unmap();
+        return false;
+    }
+    slot_count_ = header->slot_count;
+    slot_size_ = header->slot_size;
+    last_sequence_ = 0;
+    reader_pid_ = CurrentProcessId();
+    PublishPresented();
+    return true;
+}
+
+void SharedMemoryTransport::Unmap() {
+    if (view_ && slot_count_ != 0 && HeaderOf(view_)->magic == kMappingMagic) {
+        // Lets a lockstep simulation stop waiting for this renderer.
+        HeaderOf(view_)->reader_pid.store(0, std::memory_order_relaxed);
+    }
+#ifdef _WIN32
+    if (view_) UnmapViewOfFile(view_);
+    if (mapping_handle_) CloseHandle(static_cast<HANDLE>(mapping_handle_));
+    if (file_handle_) CloseHandle(static_cast<HANDLE>(file_handle_));
+    mapping_handle_ = nullptr;
+    file_handle_ = nullptr;
+#else
+    if (view_) munmap(view_, view_size_);
+    if (fd_ >= 0) close(fd_);
+    fd_ = -1;
+#endif
+    view_ = nullptr;
+    view_size_ = 0;
+    slot_count_ = 0;
+    slot_size_ = 0;
+}
+
+const unsigned char* SharedMemoryTransport::SlotAt(uint64_t sequence) const {
+    const uint64_t index = sequence % slot_count_;
+    return view_ + sizeof(MappingHeader) + index * (sizeof(SlotHeader) + slot_size_);
+}
+
+bool SharedMemoryTransport::EnsureMapped() {
+    if (!view_) {
+        // The simulation creates the mapping; until it exists, retry only
+        // occasionally so a missing writer does not cost a syscall per frame.
+        if (--reconnect_countdown_ > 0 || !Map()) {
+            if (reconnect_countdown_ <= 0) reconnect_countdown_ = kReconnectInterval;
+            return false;
+        }
+    }
+
+    const MappingHeader* header = HeaderOf(view_);
+    if (header->magic != kMappingMagic || header->slot_count != slot_count_ || header->slot_size != slot_size_) {
+        // Writer re-created the mapping with a different layout.
+        Unmap();
+        return false;
+    }
+    return true;
+}
+
+bool SharedMemoryTransport::ReadSlot(uint64_t sequence, SnapshotPayload& payload) {
+    const unsigned char* slot = SlotAt(sequence);
+    const SlotHeader* slot_header = SlotHeaderOf(slot);
+    const uint64_t stamp = slot_header->stamp.load(std::memory_order_acquire);
+    if (stamp != sequence * 2) {
+        return false;
+    }
+    const uint32_t size = slot_header->size.load(std::memory_order_relaxed);
+    if (size == 0 || size > slot_size_) {
+        return false;
+    }
+    payload.bytes.resize(size);
+    std::memcpy(payload.bytes.data(), slot + sizeof(SlotHeader), size);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slot_header->stamp.load(std::memory_order_relaxed) != stamp) {
+        return false;
+    }
+
+    payload.sequence = sequence;
+    last_sequence_ = sequence;
+    return true;
+}
+
+void SharedMemoryTransport::ReportPresented(uint64_t tick) {
+    presented_tick_.store(tick, std::memory_order_relaxed);
+}
+
+// Compares before writing: the header line also holds write_sequence, which
+// the simulation updates every tick. A restarted simulation zeroes the header
+// without changing its layout, so both fields are re-asserted, not cached.
+void SharedMemoryTransport::PublishPresented() {
+    MappingHeader* header = HeaderOf(view_);
+    if (header->reader_pid.load(std::memory_order_relaxed) != reader_pid_) {
+        header->reader_pid.store(reader_pid_, std::memory_order_relaxed);
+    }
+    const uint64_t tick = presented_tick_.load(std::memory_order_relaxed);
+    if (header->presented_tick.load(std::memory_order_relaxed) != tick) {
+        header->presented_tick.store(tick, std::memory_order_release);
+    }
+}
+
+bool SharedMemoryTransport::ReadLatest(SnapshotPayload& payload) {
+    if (!EnsureMapped()) {
+        return false;
+    }
+    PublishPresented();
+    const MappingHeader* header = HeaderOf(view_);
+    for (int attempt = 0; attempt < kReadAttempts; ++attempt) {
+        const uint64_t sequence = header->write_sequence.load(std::memory_order_acquire);
+        if (sequence < last_sequence_) {
+            // Writer restarted and reset its counter.
+            last_sequence_ = 0;
+        }
+        if (sequence == 0 || sequence == last_sequence_) {
+            return false;
+        }
+        if (ReadSlot(sequence, payload)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool SharedMemoryTransport::ReadNext(SnapshotPayload& payload) {
+    if (!EnsureMapped()) {
+        return false;
+    }
+    PublishPresented();
+    const MappingHeader* header = HeaderOf(view_);
+    for (int attempt = 0; attempt < kReadAttempts; ++attempt) {
+        const uint64_t latest = header->write_sequence.load(std::memory_order_acquire);
+        if (latest < last_sequence_) {
+            last_sequence_ = 0;
+        }
+        if (latest == 0 || latest == last_sequence_) {
+            return false;
+        }
+
+        // A fresh reader starts at the newest snapshot; an existing one
+        // resumes after its last read unless the ring has lapped it.
+        uint64_t sequence = last_sequence_ == 0 ? latest : last_sequence_ + 1;
+        if (latest - sequence >= slot_count_) {
+            sequence = latest - slot_count_ + 1;
+        }
+        if (ReadSlot(sequence, payload)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool SharedMemoryTransport::WriteInput(const std::string& payload) {
+    return input_fallback_.WriteInput(payload);
+}
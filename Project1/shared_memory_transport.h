@@ -0,0 +1,55 @@
+#pragma once
+
+#include "file_transport.h"
+#include "state_transport.h"
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+
+// Reads snapshots from a file-backed shared mapping written by the Python
+// simulation. The mapping is a small header followed by a ring of slots, each
+// guarded by a seqlock stamp, so a read is a memcpy with no syscalls and a
+// half-written slot is detected and retried instead of being parsed.
+// Layout is documented in docs/data_contract.md.
+class SharedMemoryTransport : public StateTransport {
+public:
+    SharedMemoryTransport(std::filesystem::path mapping_path, std::filesystem::path shared_dir);
+    ~SharedMemoryTransport() override;
+
+    bool Open() override;
+    void Close() override;
+    bool ReadLatest(SnapshotPayload& payload) override;
+    bool ReadNext(SnapshotPayload& payload) override;
+    bool WriteInput(const std::string& payload) override;
+    // Stored here and copied into the mapping header by the next read on the
+    // ingest thread, which owns the mapping.
+    void ReportPresented(uint64_t tick) override;
+    bool SupportsPresentedTicks() const override { return true; }
+    const char* Name() const override { return "shared_memory"; }
+
+private:
+    bool Map();
+    void Unmap();
+    bool EnsureMapped();
+    bool ReadSlot(uint64_t sequence, SnapshotPayload& payload);
+    const unsigned char* SlotAt(uint64_t sequence) const;
+    void PublishPresented();
+
+    std::filesystem::path mapping_path_;
+    FileTransport input_fallback_;
+    unsigned char* view_ = nullptr;
+    size_t view_size_ = 0;
+    uint32_t slot_count_ = 0;
+    uint32_t slot_size_ = 0;
+    uint64_t last_sequence_ = 0;
+    int reconnect_countdown_ = 0;
+    std::atomic<uint64_t> presented_tick_{0};
+    uint32_t reader_pid_ = 0;
+#ifdef _WIN32
+    void* file_handle_ = nullptr;
+    void* mapping_handle_ = nullptr;
+#else
+    int fd_ = -1;
+#endif
+};
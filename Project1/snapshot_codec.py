@@ -0,0 +1,301 @@
+"""Binary game_state encoding mirrored by snapshot_format.h on the C++ side."""
+
+from __future__ import annotations
+
+import struct
+from typing import Dict, List, Optional
+
+BINARY_MAGIC = 0x53534752  # "RGSS"
+BINARY_VERSION = 6
+NO_STRING = 0xFFFF
+
+FLAG_ROOM_CLEARED = 1 << 0
+FLAG_PLAYER_DEAD = 1 << 1
+FLAG_HAS_BOSS = 1 << 2
+FLAG_DELTA = 1 << 3
+ACTOR_INVULNERABLE = 1 << 0
+
+# Index in each list is the wire code; order must match the enums in snapshot_format.h.
+TILE_NAMES = [
+    "unknown", "floor", "wall", "pit", "rock", "spikes",
+    "door_up", "door_down", "door_left", "door_right", "special",
+]
+ACTOR_TYPE_NAMES = ["unknown", "player", "enemy", "npc", "boss"]
+PROJECTILE_OWNER_NAMES = ["player", "enemy"]
+PROJECTILE_KIND_NAMES = ["unknown", "player_projectile", "enemy_projectile", "bomb"]
+PICKUP_NAMES = [
+    "unknown", "heart", "soul_heart", "black_heart", "coin", "nickel",
+    "dime", "key", "bomb", "chest", "item_pedestal",
+]
+EFFECT_NAMES = ["unknown", "impact", "blood_splatter", "explosion"]
+
+TILE_CODES = {name: code for code, name in enumerate(TILE_NAMES)}
+ACTOR_TYPE_CODES = {name: code for code, name in enumerate(ACTOR_TYPE_NAMES)}
+PROJECTILE_OWNER_CODES = {name: code for code, name in enumerate(PROJECTILE_OWNER_NAMES)}
+PROJECTILE_KIND_CODES = {name: code for code, name in enumerate(PROJECTILE_KIND_NAMES)}
+PICKUP_CODES = {name: code for code, name in enumerate(PICKUP_NAMES)}
+EFFECT_CODES = {name: code for code, name in enumerate(EFFECT_NAMES)}
+
+WIRE_CODE_TABLES = (
+    TILE_NAMES, ACTOR_TYPE_NAMES, PROJECTILE_OWNER_NAMES, PROJECTILE_KIND_NAMES, PICKUP_NAMES, EFFECT_NAMES,
+)
+
+
+def code_table_hash(tables=WIRE_CODE_TABLES) -> int:
+    """FNV-1a over the code tables, as ``kCodeTableHash`` in snapshot_format.h:
+    each name followed by 0x00, each table followed by 0xFF."""
+    value = 2166136261
+    for names in tables:
+        for name in names:
+            for byte in name.encode("ascii") + b"\x00":
+                value = ((value ^ byte) * 16777619) & 0xFFFFFFFF
+        value = ((value ^ 0xFF) * 16777619) & 0xFFFFFFFF
+    return value
+
+
+CODE_TABLE_HASH = code_table_hash()
+
+HEADER = struct.Struct("<IHHIIQfIiiiiifHHIIIIHHiiHHIQIIIIIIQ")
+ACTOR = struct.Struct("<IBBHHHffffiif")
+PROJECTILE = struct.Struct("<IBBHffffffi")
+PICKUP = struct.Struct("<IB3xff")
+EFFECT = struct.Struct("<IB3xfff")
+TILE_CHANGE = struct.Struct("<HHB3x")
+PARTICLE_SPAWN = struct.Struct("<B3xffI")
+
+assert HEADER.size == 136 and ACTOR.size == 40 and PROJECTILE.size == 36
+assert PICKUP.size == 16 and EFFECT.size == 20 and TILE_CHANGE.size == 8
+assert PARTICLE_SPAWN.size == 16
+
+ENTITY_LISTS = ("actors", "projectiles", "pickups", "effects")
+
+
+class SnapshotDiffer:
+    """Turns full ``serialise_state`` output into keyframes and deltas.
+
+    A keyframe is the full state tagged ``"kind": "keyframe"``. Every other
+    message is a delta against the previous one (``base_tick``): entities whose
+    fields changed, ids that disappeared and tiles that changed, plus the small
+    ``meta``/``ui`` sections and this tick's particle spawn events in full.
+    Keyframes are sent on the first message, when the room changes, every
+    ``keyframe_interval`` ticks and whenever the renderer asks for one.
+    """
+
+    def __init__(self, keyframe_interval: int = 300) -> None:
+        self.keyframe_interval = max(1, int(keyframe_interval))
+        self._tick: Optional[int] = None
+        self._room_id = None
+        self._keyframe_tick = 0
+        self._tiles: List[List[str]] = []
+        self._entities: Dict[str, Dict[str, Dict]] = {name: {} for name in ENTITY_LISTS}
+        self._keyframe_requested = True
+
+    def request_keyframe(self) -> None:
+        self._keyframe_requested = True
+
+    def diff(self, state: Dict) -> Dict:
+        meta = state.get("meta", {})
+        tick = int(meta.get("tick", 0))
+        room_id = meta.get("room_id", 0)
+        tilemap = state.get("tilemap", {})
+        tiles = tilemap.get("tiles", [])
+        entities = {
+            name: {entity.get("id", ""): entity for entity in state.get(name, [])}
+            for name in ENTITY_LISTS
+        }
+
+        keyframe = (
+            self._keyframe_requested
+            or self._tick is None
+            or room_id != self._room_id
+            or tick - self._keyframe_tick >= self.keyframe_interval
+            or len(tiles) != len(self._tiles)
+        )
+        if keyframe:
+            message = dict(state)
+            message["kind"] = "keyframe"
+            self._keyframe_tick = tick
+            self._keyframe_requested = False
+        else:
+            message = {
+                "kind": "delta",
+                "base_tick": self._tick,
+                "meta": meta,
+                "tilemap": {key: value for key, value in tilemap.items() if key != "tiles"},
+                "tile_changes": self._tile_changes(tiles),
+                "upsert": {},
+                "remove": {},
+                "ui": state.get("ui", {}),
+                "particles": state.get("particles", []),
+            }
+            for name in ENTITY_LISTS:
+                previous = self._entities[name]
+                current = entities[name]
+                message["upsert"][name] = [
+                    entity for entity_id, entity in current.items() if previous.get(entity_id) != entity
+                ]
+                message["remove"][name] = [entity_id for entity_id in previous if entity_id not in current]
+
+        self._tick = tick
+        self._room_id = room_id
+        # Room tiles are mutated in place by the simulation, so keep a copy.
+        self._tiles = [list(row) for row in tiles]
+        self._entities = entities
+        return message
+
+    def _tile_changes(self, tiles: List[List[str]]) -> List[List]:
+        changes: List[List] = []
+        for y, (row, previous) in enumerate(zip(tiles, self._tiles)):
+            if row == previous:
+                continue
+            for x, tile in enumerate(row):
+                if x >= len(previous) or previous[x] != tile:
+                    changes.append([x, y, tile])
+        return changes
+
+
+class BinarySnapshotEncoder:
+    """Encodes keyframes and deltas from ``SnapshotDiffer`` (or plain
+    ``RogueGame.serialise_state`` output, which encodes as a keyframe).
+
+    String entity ids are mapped to stable ``u32`` handles for as long as the
+    entity stays alive, so handles in a delta match the renderer's rows.
+    """
+
+    def __init__(self) -> None:
+        self._ids: Dict[str, int] = {}
+        self._next_id = 1
+
+    def encode(self, state: Dict) -> bytes:
+        keyframe = state.get("kind", "keyframe") != "delta"
+        meta = state.get("meta", {})
+        tilemap = state.get("tilemap", {})
+        ui = state.get("ui", {}) or {}
+        # A keyframe rebuilds the handle table from the entities it lists; a
+        # delta extends it with new entities and drops the removed ones.
+        ids: Dict[str, int] = {} if keyframe else self._ids
+
+        strings: List[str] = list(ui.get("messages", []))
+        message_count = len(strings)
+        string_index: Dict[str, int] = {}
+
+        def intern(value: str) -> int:
+            index = string_index.get(value)
+            if index is None:
+                index = len(strings)
+                strings.append(value)
+                string_index[value] = index
+            return index
+
+        def handle(entity_id: str) -> int:
+            value = ids.get(entity_id) or self._ids.get(entity_id)
+            if value is None:
+                value = self._next_id
+                self._next_id += 1
+            ids[entity_id] = value
+            return value
+
+        rows = tilemap.get("tiles", [])
+        width = int(tilemap.get("width", len(rows[0]) if rows else 0))
+        height = int(tilemap.get("height", len(rows)))
+        tiles = bytearray(width * height if keyframe else 0)
+        for y, row in enumerate(rows[:height] if keyframe else []):
+            for x, tile in enumerate(row[:width]):
+                tiles[y * width + x] = TILE_CODES.get(tile, 0)
+        tiles.extend(bytes(-len(tiles) % 4))
+
+        entities = state if keyframe else state.get("upsert", {})
+        body = [bytes(tiles)]
+        actors = entities.get("actors", [])
+        for actor in actors:
+            body.append(ACTOR.pack(
+                handle(actor.get("id", "")),
+                ACTOR_TYPE_CODES.get(actor.get("type", "enemy"), 0),
+                ACTOR_INVULNERABLE if actor.get("invulnerable") else 0,
+                intern(actor.get("variant", "default")),
+                intern(actor.get("state", "idle")),
+                0,
+                actor.get("x", 0.0), actor.get("y", 0.0),
+                actor.get("dir_x", 0.0), actor.get("dir_y", 0.0),
+                int(actor.get("hp", 0)), int(actor.get("max_hp", 1)),
+                actor.get("speed", 0.0),
+            ))
+        projectiles = entities.get("projectiles", [])
+        for projectile in projectiles:
+            body.append(PROJECTILE.pack(
+                handle(projectile.get("id", "")),
+                PROJECTILE_OWNER_CODES.get(projectile.get("owner", "player"), 1),
+                PROJECTILE_KIND_CODES.get(projectile.get("kind", ""), 0),
+                0,
+                projectile.get("x", 0.0), projectile.get("y", 0.0),
+                projectile.get("vx", 0.0), projectile.get("vy", 0.0),
+                projectile.get("ttl", 0.0), projectile.get("radius", 0.2),
+                int(projectile.get("damage", 0)),
+            ))
+        pickups = entities.get("pickups", [])
+        for pickup in pickups:
+            body.append(PICKUP.pack(
+                handle(pickup.get("id", "")),
+                PICKUP_CODES.get(pickup.get("kind", "coin"), 0),
+                pickup.get("x", 0.0), pickup.get("y", 0.0),
+            ))
+        effects = entities.get("effects", [])
+        for effect in effects:
+            body.append(EFFECT.pack(
+                handle(effect.get("id", "")),
+                EFFECT_CODES.get(effect.get("kind", "impact"), 0),
+                effect.get("x", 0.0), effect.get("y", 0.0), effect.get("ttl", 0.0),
+            ))
+
+        removed_counts = []
+        removals = {} if keyframe else state.get("remove", {})
+        for name in ENTITY_LISTS:
+            handles = [ids.pop(entity_id) for entity_id in removals.get(name, []) if entity_id in ids]
+            body.append(struct.pack(f"<{len(handles)}I", *handles))
+            removed_counts.append(len(handles))
+
+        tile_changes = [] if keyframe else state.get("tile_changes", [])
+        for x, y, tile in tile_changes:
+            body.append(TILE_CHANGE.pack(int(x), int(y), TILE_CODES.get(tile, 0)))
+
+        particles = state.get("particles", [])[:0xFFFF]
+        for spawn in particles:
+            body.append(PARTICLE_SPAWN.pack(
+                EFFECT_CODES.get(spawn.get("kind", "impact"), 0),
+                spawn.get("x", 0.0), spawn.get("y", 0.0), int(spawn.get("seed", 0)) & 0xFFFFFFFF,
+            ))
+
+        flags = 0 if keyframe else FLAG_DELTA
+        if meta.get("room_cleared"):
+            flags |= FLAG_ROOM_CLEARED
+        if meta.get("player_dead"):
+            flags |= FLAG_PLAYER_DEAD
+        boss = ui.get("boss_health")
+        boss_hp = boss_max_hp = 0
+        boss_name = NO_STRING
+        if boss:
+            flags |= FLAG_HAS_BOSS
+            boss_hp = int(boss.get("hp", 0))
+            boss_max_hp = int(boss.get("max_hp", 1))
+            boss_name = intern(boss.get("name", "Boss"))
+
+        for value in strings:
+            encoded = value.encode("utf-8")[:0xFFFF]
+            body.append(struct.pack("<H", len(encoded)))
+            body.append(encoded)
+
+        self._ids = ids
+        payload = b"".join(body)
+        player_hp = int(meta.get("player_hp", 0))
+        header = HEADER.pack(
+            BINARY_MAGIC, BINARY_VERSION, HEADER.size, HEADER.size + len(payload), flags,
+            int(meta.get("tick", 0)), float(meta.get("delta_time", 0.0)), int(meta.get("room_id", 0)),
+            player_hp, int(meta.get("player_max_hp", max(player_hp, 1))),
+            int(meta.get("coins", 0)), int(meta.get("keys", 0)), int(meta.get("bombs", 0)),
+            float(tilemap.get("tile_size", 32)), width, height,
+            len(actors), len(projectiles), len(pickups), len(effects),
+            len(strings), message_count, boss_hp, boss_max_hp, boss_name, len(particles), CODE_TABLE_HASH,
+            int(state.get("base_tick", 0)), *removed_counts, len(tile_changes), int(meta.get("input_ack", 0)),
+            int(meta.get("timestamp_us", 0)),
+        )
+        return header + payload
@@ -0,0 +1,444 @@
+#include "snapshot_decoder.h"
+
+#include "allocation_counter.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string_view>
+
+namespace {
+
+class PayloadReader {
+public:
+    PayloadReader(const char* data, size_t size) : data_(data), size_(size) {}
+
+    template <typename T>
+    T Read() {
+        Require(sizeof(T));
+        T value;
+        std::memcpy(&value, data_ + offset_, sizeof(T));
+        offset_ += sizeof(T);
+        return value;
+    }
+
+    void ReadBytes(void* out, size_t length) {
+        Require(length);
+        if (length > 0) {
+            std::memcpy(out, data_ + offset_, length);
+        }
+        offset_ += length;
+    }
+
+    void ReadString(std::string& out, size_t length) {
+        Require(length);
+        out.assign(data_ + offset_, length);
+        offset_ += length;
+    }
+
+    void Align(size_t alignment) {
+        offset_ = std::min(size_, (offset_ + alignment - 1) / alignment * alignment);
+    }
+
+private:
+    void Require(size_t bytes) const {
+        if (bytes > size_ - offset_) {
+            throw std::runtime_error("binary snapshot truncated");
+        }
+    }
+
+    const char* data_;
+    size_t size_;
+    size_t offset_ = 0;
+};
+
+// Wire codes outside the known range decode as the enum's zero value.
+template <typename Code>
+Code ToCode(uint8_t value) {
+    return value < static_cast<uint8_t>(Code::Count) ? static_cast<Code>(value) : Code{};
+}
+
+// Created at start-up, outside any arena scope.
+const SnapshotJson kEmptyObject = SnapshotJson::object();
+const SnapshotJson kEmptyArray = SnapshotJson::array();
+
+// Views into the DOM's arena strings; the caller copies what it keeps. Like
+// nlohmann's value(), a present key of the wrong type throws.
+std::string_view AsString(const SnapshotJson& value) {
+    return value.get_ref<const ArenaString&>();
+}
+
+std::string_view StringOr(const SnapshotJson& object, const char* key, std::string_view fallback) {
+    const auto it = object.find(key);
+    return it == object.end() ? fallback : AsString(*it);
+}
+
+void ReadIds(PayloadReader& reader, size_t count, std::vector<uint32_t>& out) {
+    out.resize(count);
+    for (uint32_t& id : out) {
+        id = reader.Read<uint32_t>();
+    }
+}
+
+void ReadJsonIds(const SnapshotJson& lists, const char* key, std::vector<uint32_t>& out) {
+    out.clear();
+    if (!lists.contains(key)) {
+        return;
+    }
+    for (const SnapshotJson& id : lists[key]) {
+        out.push_back(snapshot::HashId(AsString(id)));
+    }
+}
+
+}  // namespace
+
+void DecodeBinarySnapshot(const char* data, size_t size, SnapshotUpdate& update) {
+    using namespace snapshot;
+
+    if (size < sizeof(Header)) {
+        throw std::runtime_error("binary snapshot truncated");
+    }
+    Header header;
+    std::memcpy(&header, data, sizeof(header));
+    if (header.magic != kBinaryMagic) {
+        throw std::runtime_error("not a binary snapshot");
+    }
+    if (header.version != kBinaryVersion) {
+        throw std::runtime_error("unsupported binary snapshot version " + std::to_string(header.version));
+    }
+    if (header.code_table_hash != kCodeTableHash) {
+        throw std::runtime_error("binary snapshot code tables differ from snapshot_format.h");
+    }
+    if (header.header_size < sizeof(Header) || header.payload_size > size || header.header_size > header.payload_size) {
+        throw std::runtime_error("binary snapshot header is inconsistent");
+    }
+
+    update.keyframe = (header.flags & kFlagDelta) == 0;
+    update.base_tick = update.keyframe ? 0 : header.base_tick;
+
+    WorldSnapshot& out = update.frame;
+    out.meta.tick = header.tick;
+    out.meta.delta_time = header.delta_time;
+    out.meta.room_id = header.room_id;
+    out.meta.player_hp = header.player_hp;
+    out.meta.player_max_hp = header.player_max_hp;
+    out.meta.coins = header.coins;
+    out.meta.keys = header.keys;
+    out.meta.bombs = header.bombs;
+    out.meta.room_cleared = (header.flags & kFlagRoomCleared) != 0;
+    out.meta.player_dead = (header.flags & kFlagPlayerDead) != 0;
+    out.meta.input_ack = header.input_ack;
+    out.meta.timestamp_us = header.timestamp_us;
+    out.tile_size = header.tile_size;
+    out.room_width = header.room_width;
+    out.room_height = header.room_height;
+
+    // Deltas carry no tile grid, only tile changes after the removed ids.
+    const char* body = data + header.header_size;
+    const size_t body_size = header.payload_size - header.header_size;
+    const size_t tile_count = update.keyframe ? static_cast<size_t>(header.room_width) * header.room_height : 0;
+    const size_t removed_count = static_cast<size_t>(header.removed_actor_count) + header.removed_projectile_count +
+        header.removed_pickup_count + header.removed_effect_count;
+    const size_t strings_offset = (tile_count + 3) / 4 * 4 +
+        header.actor_count * sizeof(ActorRecord) +
+        header.projectile_count * sizeof(ProjectileRecord) +
+        header.pickup_count * sizeof(PickupRecord) +
+        header.effect_count * sizeof(EffectRecord) +
+        removed_count * sizeof(uint32_t) +
+        header.tile_change_count * sizeof(TileChangeRecord) +
+        header.particle_count * sizeof(ParticleSpawnRecord);
+    if (strings_offset > body_size) {
+        throw std::runtime_error("binary snapshot truncated");
+    }
+
+    // The string table comes last but is read first, so variant names are
+    // resolved to enum codes once per snapshot rather than once per actor.
+    static thread_local std::vector<ActorVariant> string_variants;
+    string_variants.assign(header.string_count, ActorVariant::Default);
+    out.messages.resize(std::min(header.message_count, header.string_count));
+    // Without a boss, the same defaults as the JSON decoders.
+    out.boss.active = (header.flags & kFlagHasBoss) != 0;
+    out.boss.hp = out.boss.active ? header.boss_hp : 0;
+    out.boss.max_hp = out.boss.active ? std::max(1, static_cast<int>(header.boss_max_hp)) : 1;
+    if (out.boss.active) {
+        out.boss.name = "Boss";
+    } else {
+        out.boss.name.clear();
+    }
+
+    PayloadReader strings(body + strings_offset, body_size - strings_offset);
+    std::string value;
+    for (uint16_t index = 0; index < header.string_count; ++index) {
+        const uint16_t length = strings.Read<uint16_t>();
+        std::string& target = index < out.messages.size() ? out.messages[index] : value;
+        strings.ReadString(target, length);
+        if (out.boss.active && index == header.boss_name) {
+            out.boss.name = target;
+        }
+        string_variants[index] = ActorVariantFromName(target);
+    }
+
+    PayloadReader reader(body, strings_offset);
+    out.tiles.resize(tile_count);
+    reader.ReadBytes(out.tiles.data(), tile_count);
+    for (TileCode& tile : out.tiles) {
+        tile = ToCode<TileCode>(static_cast<uint8_t>(tile));
+    }
+    reader.Align(4);
+
+    ActorArrays& actors = out.actors;
+    actors.Resize(header.actor_count);
+    for (size_t i = 0; i < header.actor_count; ++i) {
+        const ActorRecord record = reader.Read<ActorRecord>();
+        actors.id[i] = record.id;
+        actors.type[i] = ToCode<ActorType>(record.type);
+        actors.variant[i] = record.variant < string_variants.size() ? string_variants[record.variant] : ActorVariant::Default;
+        actors.flags[i] = record.flags;
+        actors.x[i] = record.x;
+        actors.y[i] = record.y;
+        actors.dir_x[i] = record.dir_x;
+        actors.dir_y[i] = record.dir_y;
+        actors.speed[i] = record.speed;
+        actors.hp[i] = record.hp;
+        actors.max_hp[i] = record.max_hp;
+    }
+
+    ProjectileArrays& projectiles = out.projectiles;
+    projectiles.Resize(header.projectile_count);
+    for (size_t i = 0; i < header.projectile_count; ++i) {
+        const ProjectileRecord record = reader.Read<ProjectileRecord>();
+        projectiles.id[i] = record.id;
+        projectiles.owner[i] = ToCode<ProjectileOwner>(record.owner);
+        projectiles.kind[i] = ToCode<ProjectileKind>(record.kind);
+        projectiles.x[i] = record.x;
+        projectiles.y[i] = record.y;
+        projectiles.vx[i] = record.vx;
+        projectiles.vy[i] = record.vy;
+        projectiles.ttl[i] = record.ttl;
+        projectiles.radius[i] = record.radius;
+        projectiles.damage[i] = record.damage;
+    }
+
+    PickupArrays& pickups = out.pickups;
+    pickups.Resize(header.pickup_count);
+    for (size_t i = 0; i < header.pickup_count; ++i) {
+        const PickupRecord record = reader.Read<PickupRecord>();
+        pickups.id[i] = record.id;
+        pickups.kind[i] = ToCode<PickupKind>(record.kind);
+        pickups.x[i] = record.x;
+        pickups.y[i] = record.y;
+    }
+
+    EffectArrays& effects = out.effects;
+    effects.Resize(header.effect_count);
+    for (size_t i = 0; i < header.effect_count; ++i) {
+        const EffectRecord record = reader.Read<EffectRecord>();
+        effects.id[i] = record.id;
+        effects.kind[i] = ToCode<EffectKind>(record.kind);
+        effects.x[i] = record.x;
+        effects.y[i] = record.y;
+        effects.ttl[i] = record.ttl;
+    }
+
+    ReadIds(reader, header.removed_actor_count, update.removed_actors);
+    ReadIds(reader, header.removed_projectile_count, update.removed_projectiles);
+    ReadIds(reader, header.removed_pickup_count, update.removed_pickups);
+    ReadIds(reader, header.removed_effect_count, update.removed_effects);
+
+    update.tile_changes.resize(header.tile_change_count);
+    for (TileChange& change : update.tile_changes) {
+        const TileChangeRecord record = reader.Read<TileChangeRecord>();
+        change.x = record.x;
+        change.y = record.y;
+        change.code = ToCode<TileCode>(record.code);
+    }
+
+    update.particle_spawns.resize(header.particle_count);
+    for (ParticleSpawn& spawn : update.particle_spawns) {
+        const ParticleSpawnRecord record = reader.Read<ParticleSpawnRecord>();
+        spawn.tick = header.tick;
+        spawn.kind = ToCode<EffectKind>(record.kind);
+        spawn.x = record.x;
+        spawn.y = record.y;
+        spawn.seed = record.seed;
+    }
+}
+
+void DecodeJsonSnapshot(const SnapshotJson& state, SnapshotUpdate& update) {
+    using namespace snapshot;
+
+    update.keyframe = StringOr(state, "kind", "keyframe") != "delta";
+    update.base_tick = update.keyframe ? 0 : state.value("base_tick", uint64_t{0});
+
+    WorldSnapshot& out = update.frame;
+    const SnapshotJson& meta = state.contains("meta") ? state["meta"] : kEmptyObject;
+    out.meta.tick = meta.value("tick", uint64_t{0});
+    out.meta.delta_time = meta.value("delta_time", 0.0f);
+    out.meta.room_id = meta.value("room_id", 0u);
+    out.meta.player_hp = meta.value("player_hp", 0);
+    out.meta.player_max_hp = meta.value("player_max_hp", std::max(out.meta.player_hp, 1));
+    out.meta.coins = meta.value("coins", 0);
+    out.meta.keys = meta.value("keys", 0);
+    out.meta.bombs = meta.value("bombs", 0);
+    out.meta.room_cleared = meta.value("room_cleared", false);
+    out.meta.player_dead = meta.value("player_dead", false);
+    out.meta.input_ack = meta.value("input_ack", 0u);
+    out.meta.timestamp_us = meta.value("timestamp_us", uint64_t{0});
+
+    out.tiles.clear();
+    out.room_width = 0;
+    out.room_height = 0;
+    if (state.contains("tilemap")) {
+        const SnapshotJson& tilemap = state["tilemap"];
+        out.tile_size = tilemap.value("tile_size", 32.0f);
+        const SnapshotJson& rows = update.keyframe && tilemap.contains("tiles") ? tilemap["tiles"] : kEmptyArray;
+        int width = tilemap.value("width", 0);
+        for (const SnapshotJson& row : rows) {
+            width = std::max(width, static_cast<int>(row.size()));
+        }
+        const int height = std::max(tilemap.value("height", 0), static_cast<int>(rows.size()));
+        out.room_width = width;
+        out.room_height = height;
+        if (update.keyframe) {
+            out.tiles.assign(static_cast<size_t>(width) * height, TileCode::Unknown);
+        }
+        for (size_t y = 0; y < rows.size(); ++y) {
+            const SnapshotJson& row = rows[y];
+            for (size_t x = 0; x < row.size(); ++x) {
+                out.tiles[y * width + x] = TileCodeFromName(AsString(row[x]));
+            }
+        }
+    }
+
+    update.tile_changes.clear();
+    if (!update.keyframe && state.contains("tile_changes")) {
+        for (const SnapshotJson& change : state["tile_changes"]) {
+            TileChange tile;
+            tile.x = change.at(0).get<uint16_t>();
+            tile.y = change.at(1).get<uint16_t>();
+            tile.code = TileCodeFromName(AsString(change.at(2)));
+            update.tile_changes.push_back(tile);
+        }
+    }
+
+    update.particle_spawns.clear();
+    if (state.contains("particles")) {
+        for (const SnapshotJson& event : state["particles"]) {
+            ParticleSpawn spawn;
+            spawn.tick = out.meta.tick;
+            spawn.kind = EffectKindFromName(StringOr(event, "kind", "impact"));
+            spawn.x = event.value("x", 0.0f);
+            spawn.y = event.value("y", 0.0f);
+            spawn.seed = event.value("seed", 0u);
+            update.particle_spawns.push_back(spawn);
+        }
+    }
+
+    // Keyframes list entities at the top level; deltas nest the changed ones
+    // under "upsert" and the vanished ids under "remove".
+    const SnapshotJson& lists = update.keyframe ? state : (state.contains("upsert") ? state["upsert"] : kEmptyObject);
+    const SnapshotJson& removed = update.keyframe || !state.contains("remove") ? kEmptyObject : state["remove"];
+    ReadJsonIds(removed, "actors", update.removed_actors);
+    ReadJsonIds(removed, "projectiles", update.removed_projectiles);
+    ReadJsonIds(removed, "pickups", update.removed_pickups);
+    ReadJsonIds(removed, "effects", update.removed_effects);
+
+    const SnapshotJson& actor_list = lists.contains("actors") ? lists["actors"] : kEmptyArray;
+    ActorArrays& actors = out.actors;
+    actors.Resize(actor_list.size());
+    for (size_t i = 0; i < actor_list.size(); ++i) {
+        const SnapshotJson& actor = actor_list[i];
+        actors.id[i] = HashId(StringOr(actor, "id", ""));
+        actors.type[i] = ActorTypeFromName(StringOr(actor, "type", "enemy"));
+        actors.variant[i] = ActorVariantFromName(StringOr(actor, "variant", "default"));
+        actors.flags[i] = actor.value("invulnerable", false) ? kActorInvulnerable : 0;
+        actors.x[i] = actor.value("x", 0.0f);
+        actors.y[i] = actor.value("y", 0.0f);
+        actors.dir_x[i] = actor.value("dir_x", 0.0f);
+        actors.dir_y[i] = actor.value("dir_y", 0.0f);
+        actors.speed[i] = actor.value("speed", 0.0f);
+        actors.hp[i] = actor.value("hp", 0);
+        actors.max_hp[i] = actor.value("max_hp", 1);
+    }
+
+    const SnapshotJson& projectile_list = lists.contains("projectiles") ? lists["projectiles"] : kEmptyArray;
+    ProjectileArrays& projectiles = out.projectiles;
+    projectiles.Resize(projectile_list.size());
+    for (size_t i = 0; i < projectile_list.size(); ++i) {
+        const SnapshotJson& projectile = projectile_list[i];
+        projectiles.id[i] = HashId(StringOr(projectile, "id", ""));
+        projectiles.owner[i] = ProjectileOwnerFromName(StringOr(projectile, "owner", "player"));
+        projectiles.kind[i] = ProjectileKindFromName(StringOr(projectile, "kind", ""));
+        projectiles.x[i] = projectile.value("x", 0.0f);
+        projectiles.y[i] = projectile.value("y", 0.0f);
+        projectiles.vx[i] = projectile.value("vx", 0.0f);
+        projectiles.vy[i] = projectile.value("vy", 0.0f);
+        projectiles.ttl[i] = projectile.value("ttl", 0.0f);
+        projectiles.radius[i] = projectile.value("radius", 0.2f);
+        projectiles.damage[i] = projectile.value("damage", 0);
+    }
+
+    const SnapshotJson& pickup_list = lists.contains("pickups") ? lists["pickups"] : kEmptyArray;
+    PickupArrays& pickups = out.pickups;
+    pickups.Resize(pickup_list.size());
+    for (size_t i = 0; i < pickup_list.size(); ++i) {
+        const SnapshotJson& pickup = pickup_list[i];
+        pickups.id[i] = HashId(StringOr(pickup, "id", ""));
+        pickups.kind[i] = PickupKindFromName(StringOr(pickup, "kind", "coin"));
+        pickups.x[i] = pickup.value("x", 0.0f);
+        pickups.y[i] = pickup.value("y", 0.0f);
+    }
+
+    const SnapshotJson& effect_list = lists.contains("effects") ? lists["effects"] : kEmptyArray;
+    EffectArrays& effects = out.effects;
+    effects.Resize(effect_list.size());
+    for (size_t i = 0; i < effect_list.size(); ++i) {
+        const SnapshotJson& effect = effect_list[i];
+        effects.id[i] = HashId(StringOr(effect, "id", ""));
+        effects.kind[i] = EffectKindFromName(StringOr(effect, "kind", "impact"));
+        effects.x[i] = effect.value("x", 0.0f);
+        effects.y[i] = effect.value("y", 0.0f);
+        effects.ttl[i] = effect.value("ttl", 0.0f);
+    }
+
+    // Assigned in place so the strings keep their capacity between snapshots.
+    const SnapshotJson& ui = state.contains("ui") ? state["ui"] : kEmptyObject;
+    const SnapshotJson& messages = ui.contains("messages") ? ui["messages"] : kEmptyArray;
+    out.messages.resize(messages.size());
+    for (size_t i = 0; i < messages.size(); ++i) {
+        const std::string_view message = AsString(messages[i]);
+        out.messages[i].assign(message.data(), message.size());
+    }
+    out.boss.active = false;
+    out.boss.hp = 0;
+    out.boss.max_hp = 1;
+    out.boss.name.clear();
+    if (ui.contains("boss_health") && !ui["boss_health"].is_null()) {
+        const SnapshotJson& boss = ui["boss_health"];
+        const std::string_view name = StringOr(boss, "name", "Boss");
+        out.boss.active = true;
+        out.boss.hp = boss.value("hp", 0);
+        out.boss.max_hp = std::max(1, boss.value("max_hp", 1));
+        out.boss.name.assign(name.data(), name.size());
+    }
+}
+
+void ParseJsonSnapshot(const char* data, size_t size, SnapshotUpdate& out) {
+    allocation_counter::MemoryTagScope memory(allocation_counter::MemoryTag::Ingest);
+    // The DOM lives in this thread's arena and is destroyed before the scope
+    // rewinds it, so after warm-up a JSON snapshot parses without touching
+    // the heap for its nodes and strings.
+    thread_local FrameArena arena;
+    ArenaScope scope(arena);
+    const SnapshotJson state = SnapshotJson::parse(data, data + size);
+    DecodeJsonSnapshot(state, out);
+}
+
+void DecodeSnapshot(const char* data, size_t size, SnapshotUpdate& out) {
+    allocation_counter::MemoryTagScope memory(allocation_counter::MemoryTag::Ingest);
+    if (snapshot::IsBinarySnapshot(data, size)) {
+        DecodeBinarySnapshot(data, size, out);
+        return;
+    }
+    StreamJsonSnapshot(data, size, out);
+}
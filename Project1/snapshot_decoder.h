@@ -0,0 +1,40 @@
+#pragma once
+
+#include "frame_arena.h"
+#include "world_snapshot.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <vector>
+
+// DOM for JSON snapshots. Its nodes and strings come from the decoding
+// thread's FrameArena while ParseJsonSnapshot runs (see ArenaScope), so
+// parsed state is never individually freed. The stream decoder uses the same
+// type so nlohmann's token buffer comes from the arena too.
+using ArenaString = std::basic_string<char, std::char_traits<char>, ArenaAllocator<char>>;
+using SnapshotJson = nlohmann::basic_json<std::map, std::vector, ArenaString, bool, std::int64_t, std::uint64_t,
+                                          double, ArenaAllocator>;
+
+// Both decoders overwrite out completely and reuse its storage. They throw
+// std::runtime_error (or nlohmann::json::exception) on malformed input.
+// Messages without a delta marker decode as keyframes.
+void DecodeBinarySnapshot(const char* data, size_t size, SnapshotUpdate& out);
+void DecodeJsonSnapshot(const SnapshotJson& state, SnapshotUpdate& out);
+
+// Reads JSON with nlohmann's SAX interface and writes each value straight
+// into out as it is parsed: no DOM, no json nodes, and values under unknown
+// keys are scanned past without being stored. Keys may come in any order.
+// Gives the same result as ParseJsonSnapshot for every snapshot the
+// producer writes, and throws where it would; it also rejects a document
+// that is not an object, which the DOM path reads as an empty keyframe.
+void StreamJsonSnapshot(const char* data, size_t size, SnapshotUpdate& out);
+// Builds the DOM, then DecodeJsonSnapshot. The reference the stream decoder
+// is checked and benchmarked against.
+void ParseJsonSnapshot(const char* data, size_t size, SnapshotUpdate& out);
+
+// Picks the decoder from the payload: binary snapshots start with
+// snapshot::kBinaryMagic, anything else is streamed as JSON.
+void DecodeSnapshot(const char* data, size_t size, SnapshotUpdate& out);
@@ -0,0 +1,131 @@
+#include "snapshot_format.h"
+
+#include <cstring>
+
+namespace snapshot {
+
+namespace {
+
+// Name -> code map built at compile time: the names sorted once, looked up by
+// bisection. The decoder resolves every string field through one of these.
+template <typename Code, size_t N>
+class CodeMap {
+public:
+    constexpr explicit CodeMap(const std::array<std::string_view, N>& names) {
+        for (size_t i = 0; i < N; ++i) {
+            entries_[i] = Entry{names[i], static_cast<Code>(i)};
+        }
+        // Insertion sort: std::sort is not constexpr in C++17.
+        for (size_t i = 1; i < N; ++i) {
+            for (size_t j = i; j > 0 && entries_[j].name < entries_[j - 1].name; --j) {
+                const Entry swapped = entries_[j];
+                entries_[j] = entries_[j - 1];
+                entries_[j - 1] = swapped;
+            }
+        }
+    }
+
+    constexpr bool Unique() const {
+        for (size_t i = 1; i < N; ++i) {
+            if (!(entries_[i - 1].name < entries_[i].name)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    constexpr Code Find(std::string_view name, Code fallback) const {
+        size_t low = 0;
+        size_t high = N;
+        while (low < high) {
+            const size_t mid = low + (high - low) / 2;
+            if (entries_[mid].name < name) {
+                low = mid + 1;
+            } else {
+                high = mid;
+            }
+        }
+        return low < N && entries_[low].name == name ? entries_[low].code : fallback;
+    }
+
+private:
+    struct Entry {
+        std::string_view name;
+        Code code{};
+    };
+
+    std::array<Entry, N> entries_{};
+};
+
+template <typename Code, size_t N>
+constexpr CodeMap<Code, N> MakeCodeMap(const std::array<std::string_view, N>& names) {
+    return CodeMap<Code, N>(names);
+}
+
+constexpr auto kTileCodes = MakeCodeMap<TileCode>(kTileNames);
+constexpr auto kActorTypeCodes = MakeCodeMap<ActorType>(kActorTypeNames);
+constexpr auto kOwnerCodes = MakeCodeMap<ProjectileOwner>(kOwnerNames);
+constexpr auto kProjectileKindCodes = MakeCodeMap<ProjectileKind>(kProjectileKindNames);
+constexpr auto kPickupCodes = MakeCodeMap<PickupKind>(kPickupNames);
+constexpr auto kEffectCodes = MakeCodeMap<EffectKind>(kEffectNames);
+constexpr auto kVariantCodes = MakeCodeMap<ActorVariant>(kVariantNames);
+
+static_assert(kTileCodes.Unique() && kActorTypeCodes.Unique() && kOwnerCodes.Unique() &&
+                  kProjectileKindCodes.Unique() && kPickupCodes.Unique() && kEffectCodes.Unique() &&
+                  kVariantCodes.Unique(),
+              "wire names must be unique within a table");
+static_assert(kTileCodes.Find("door_left", TileCode::Unknown) == TileCode::DoorLeft, "tile names out of code order");
+static_assert(kPickupCodes.Find("item_pedestal", PickupKind::Unknown) == PickupKind::ItemPedestal,
+              "pickup names out of code order");
+static_assert(kEffectCodes.Find("blood_splatter", EffectKind::Unknown) == EffectKind::BloodSplatter,
+              "effect names out of code order");
+
+}  // namespace
+
+bool IsBinarySnapshot(const char* data, size_t size) {
+    if (size < sizeof(uint32_t)) {
+        return false;
+    }
+    uint32_t magic = 0;
+    std::memcpy(&magic, data, sizeof(magic));
+    return magic == kBinaryMagic;
+}
+
+TileCode TileCodeFromName(std::string_view name) {
+    return kTileCodes.Find(name, TileCode::Unknown);
+}
+
+ActorType ActorTypeFromName(std::string_view name) {
+    return kActorTypeCodes.Find(name, ActorType::Unknown);
+}
+
+ProjectileOwner ProjectileOwnerFromName(std::string_view name) {
+    return kOwnerCodes.Find(name, ProjectileOwner::Enemy);
+}
+
+ProjectileKind ProjectileKindFromName(std::string_view name) {
+    return kProjectileKindCodes.Find(name, ProjectileKind::Unknown);
+}
+
+PickupKind PickupKindFromName(std::string_view name) {
+    return kPickupCodes.Find(name, PickupKind::Unknown);
+}
+
+EffectKind EffectKindFromName(std::string_view name) {
+    return kEffectCodes.Find(name, EffectKind::Unknown);
+}
+
+ActorVariant ActorVariantFromName(std::string_view name) {
+    return kVariantCodes.Find(name, ActorVariant::Default);
+}
+
+uint32_t HashId(std::string_view id) {
+    uint32_t hash = 2166136261u;
+    for (const char c : id) {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+}  // namespace snapshot
@@ -0,0 +1,281 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// Binary game_state encoding. Layout and codes are mirrored by
+// snapshot_codec.py and documented in docs/data_contract.md; bump
+// kBinaryVersion whenever either changes.
+namespace snapshot {
+
+constexpr uint32_t kBinaryMagic = 0x53534752;  // "RGSS"
+constexpr uint16_t kBinaryVersion = 6;
+constexpr uint16_t kNoString = 0xFFFF;
+
+enum class TileCode : uint8_t {
+    Unknown = 0,
+    Floor,
+    Wall,
+    Pit,
+    Rock,
+    Spikes,
+    DoorUp,
+    DoorDown,
+    DoorLeft,
+    DoorRight,
+    Special,
+    Count
+};
+
+enum class ActorType : uint8_t { Unknown = 0, Player, Enemy, Npc, Boss, Count };
+enum class ProjectileOwner : uint8_t { Player = 0, Enemy, Count };
+enum class ProjectileKind : uint8_t { Unknown = 0, PlayerProjectile, EnemyProjectile, Bomb, Count };
+
+enum class PickupKind : uint8_t {
+    Unknown = 0,
+    Heart,
+    SoulHeart,
+    BlackHeart,
+    Coin,
+    Nickel,
+    Dime,
+    Key,
+    Bomb,
+    Chest,
+    ItemPedestal,
+    Count
+};
+
+enum class EffectKind : uint8_t { Unknown = 0, Impact, BloodSplatter, Explosion, Count };
+
+// Not a wire code: variants travel as strings and are resolved when decoding.
+enum class ActorVariant : uint8_t {
+    Default = 0,
+    Isaac,
+    Charger,
+    Hopper,
+    Spitter,
+    Bloat,
+    Turret,
+    Flyer,
+    Count
+};
+
+enum HeaderFlags : uint32_t {
+    kFlagRoomCleared = 1u << 0,
+    kFlagPlayerDead = 1u << 1,
+    kFlagHasBoss = 1u << 2,
+    kFlagDelta = 1u << 3,
+};
+
+enum ActorFlags : uint8_t {
+    kActorInvulnerable = 1u << 0,
+};
+
+template <typename Code>
+constexpr size_t CodeCount() {
+    return static_cast<size_t>(Code::Count);
+}
+
+template <typename Code>
+constexpr size_t CodeIndex(Code code) {
+    return static_cast<size_t>(code);
+}
+
+// Wire names, indexed by code. snapshot_codec.py keeps the same lists; the
+// binary header carries kCodeTableHash so a mismatch is caught on decode.
+constexpr std::array<std::string_view, CodeCount<TileCode>()> kTileNames = {
+    "unknown", "floor", "wall", "pit", "rock", "spikes",
+    "door_up", "door_down", "door_left", "door_right", "special",
+};
+
+constexpr std::array<std::string_view, CodeCount<ActorType>()> kActorTypeNames = {
+    "unknown", "player", "enemy", "npc", "boss",
+};
+
+constexpr std::array<std::string_view, CodeCount<ProjectileOwner>()> kOwnerNames = {
+    "player", "enemy",
+};
+
+constexpr std::array<std::string_view, CodeCount<ProjectileKind>()> kProjectileKindNames = {
+    "unknown", "player_projectile", "enemy_projectile", "bomb",
+};
+
+constexpr std::array<std::string_view, CodeCount<PickupKind>()> kPickupNames = {
+    "unknown", "heart", "soul_heart", "black_heart", "coin", "nickel",
+    "dime", "key", "bomb", "chest", "item_pedestal",
+};
+
+constexpr std::array<std::string_view, CodeCount<EffectKind>()> kEffectNames = {
+    "unknown", "impact", "blood_splatter", "explosion",
+};
+
+constexpr std::array<std::string_view, CodeCount<ActorVariant>()> kVariantNames = {
+    "default", "isaac", "charger", "hopper", "spitter", "bloat", "turret", "flyer",
+};
+
+namespace detail {
+
+constexpr uint32_t kFnvOffset = 2166136261u;
+constexpr uint32_t kFnvPrime = 16777619u;
+
+template <size_t N>
+constexpr uint32_t HashNames(uint32_t hash, const std::array<std::string_view, N>& names) {
+    for (const std::string_view name : names) {
+        for (const char c : name) {
+            hash = (hash ^ static_cast<uint8_t>(c)) * kFnvPrime;
+        }
+        hash = (hash ^ 0x00u) * kFnvPrime;
+    }
+    return (hash ^ 0xFFu) * kFnvPrime;
+}
+
+}  // namespace detail
+
+// FNV-1a over every wire-coded table in code order: each name followed by a
+// 0x00 byte, each table followed by 0xFF. Variants travel as strings and are
+// not part of it.
+constexpr uint32_t kCodeTableHash = detail::HashNames(
+    detail::HashNames(
+        detail::HashNames(
+            detail::HashNames(detail::HashNames(detail::HashNames(detail::kFnvOffset, kTileNames), kActorTypeNames),
+                              kOwnerNames),
+            kProjectileKindNames),
+        kPickupNames),
+    kEffectNames);
+
+#pragma pack(push, 1)
+struct Header {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t header_size;
+    uint32_t payload_size;
+    uint32_t flags;
+    uint64_t tick;
+    float delta_time;
+    uint32_t room_id;
+    int32_t player_hp;
+    int32_t player_max_hp;
+    int32_t coins;
+    int32_t keys;
+    int32_t bombs;
+    float tile_size;
+    uint16_t room_width;
+    uint16_t room_height;
+    uint32_t actor_count;
+    uint32_t projectile_count;
+    uint32_t pickup_count;
+    uint32_t effect_count;
+    uint16_t string_count;
+    uint16_t message_count;
+    int32_t boss_hp;
+    int32_t boss_max_hp;
+    uint16_t boss_name;
+    uint16_t particle_count;
+    uint32_t code_table_hash;  // kCodeTableHash of the writer
+    uint64_t base_tick;
+    uint32_t removed_actor_count;
+    uint32_t removed_projectile_count;
+    uint32_t removed_pickup_count;
+    uint32_t removed_effect_count;
+    uint32_t tile_change_count;
+    uint32_t input_ack;
+    uint64_t timestamp_us;
+};
+
+struct ActorRecord {
+    uint32_t id;
+    uint8_t type;
+    uint8_t flags;
+    uint16_t variant;
+    uint16_t state;
+    uint16_t reserved;
+    float x;
+    float y;
+    float dir_x;
+    float dir_y;
+    int32_t hp;
+    int32_t max_hp;
+    float speed;
+};
+
+struct ProjectileRecord {
+    uint32_t id;
+    uint8_t owner;
+    uint8_t kind;
+    uint16_t reserved;
+    float x;
+    float y;
+    float vx;
+    float vy;
+    float ttl;
+    float radius;
+    int32_t damage;
+};
+
+struct PickupRecord {
+    uint32_t id;
+    uint8_t kind;
+    uint8_t reserved[3];
+    float x;
+    float y;
+};
+
+struct EffectRecord {
+    uint32_t id;
+    uint8_t kind;
+    uint8_t reserved[3];
+    float x;
+    float y;
+    float ttl;
+};
+
+struct TileChangeRecord {
+    uint16_t x;
+    uint16_t y;
+    uint8_t code;
+    uint8_t reserved[3];
+};
+
+struct ParticleSpawnRecord {
+    uint8_t kind;  // EffectKind
+    uint8_t reserved[3];
+    float x;
+    float y;
+    uint32_t seed;
+};
+#pragma pack(pop)
+
+static_assert(sizeof(Header) == 136, "header layout is shared with snapshot_codec.py");
+static_assert(sizeof(ActorRecord) == 40, "actor layout is shared with snapshot_codec.py");
+static_assert(sizeof(ProjectileRecord) == 36, "projectile layout is shared with snapshot_codec.py");
+static_assert(sizeof(PickupRecord) == 16, "pickup layout is shared with snapshot_codec.py");
+static_assert(sizeof(EffectRecord) == 20, "effect layout is shared with snapshot_codec.py");
+static_assert(sizeof(TileChangeRecord) == 8, "tile change layout is shared with snapshot_codec.py");
+static_assert(sizeof(ParticleSpawnRecord) == 16, "particle spawn layout is shared with snapshot_codec.py");
+
+bool IsBinarySnapshot(const char* data, size_t size);
+
+TileCode TileCodeFromName(std::string_view name);
+ActorType ActorTypeFromName(std::string_view name);
+ProjectileOwner ProjectileOwnerFromName(std::string_view name);
+ProjectileKind ProjectileKindFromName(std::string_view name);
+PickupKind PickupKindFromName(std::string_view name);
+EffectKind EffectKindFromName(std::string_view name);
+ActorVariant ActorVariantFromName(std::string_view name);
+
+// JSON ids are strings; the decoders hash them (FNV-1a) so entities can be
+// matched across snapshots like binary ones.
+uint32_t HashId(std::string_view id);
+
+constexpr std::string_view TileCodeName(TileCode code) {
+    return CodeIndex(code) < kTileNames.size() ? kTileNames[CodeIndex(code)] : kTileNames[0];
+}
+
+constexpr std::string_view PickupKindName(PickupKind kind) {
+    return CodeIndex(kind) < kPickupNames.size() ? kPickupNames[CodeIndex(kind)] : kPickupNames[0];
+}
+
+}  // namespace snapshot
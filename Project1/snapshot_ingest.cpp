@@ -0,0 +1,170 @@
+#include "snapshot_ingest.h"
+
+#include "allocation_counter.h"
+#include "frame_profiler.h"
+#include "raylib.h"
+#include "snapshot_decoder.h"
+
+#include <chrono>
+#include <ctime>
+#include <exception>
+
+namespace {
+
+constexpr int kMaxSnapshotsPerPoll = 32;
+constexpr auto kIdleSleep = std::chrono::milliseconds(1);
+
+}  // namespace
+
+SnapshotIngest::~SnapshotIngest() {
+    Stop();
+}
+
+void SnapshotIngest::Start(StateTransport& transport) {
+    Stop();
+    transport_ = &transport;
+    running_.store(true, std::memory_order_relaxed);
+    thread_ = std::thread(&SnapshotIngest::Run, this);
+}
+
+void SnapshotIngest::Stop() {
+    running_.store(false, std::memory_order_relaxed);
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    transport_ = nullptr;
+    recorder_.Close();
+}
+
+void SnapshotIngest::Record(const std::filesystem::path& directory, bool compress) {
+    record_dir_ = directory;
+    record_compress_ = compress;
+    record_part_ = 0;
+    char stem[32];
+    const std::time_t now = std::time(nullptr);
+    std::strftime(stem, sizeof(stem), "replay_%Y%m%d_%H%M%S", std::localtime(&now));
+    record_stem_ = stem;
+    OpenRecording();
+}
+
+bool SnapshotIngest::OpenRecording() {
+    ++record_part_;
+    const std::string name = record_part_ == 1 ? record_stem_ + ".rgrp"
+                                               : record_stem_ + "_" + std::to_string(record_part_) + ".rgrp";
+    if (!recorder_.Open(record_dir_ / name, record_compress_)) {
+        return false;
+    }
+    TraceLog(LOG_INFO, "Recording snapshots to %s", recorder_.Path().string().c_str());
+    return true;
+}
+
+// Ingest thread, right after world_ accepted payload_.
+void SnapshotIngest::RecordPayload(bool keyframe) {
+    const uint64_t tick = world_.Snapshot().meta.tick;
+    if (keyframe && recorder_.Records() != 0 && tick < recorder_.LastTick()) {
+        recorder_.Close();
+        OpenRecording();
+    }
+    recorder_.Append(payload_.bytes.data(), payload_.bytes.size(), tick, keyframe);
+}
+
+bool SnapshotIngest::AcquireLatest() {
+    if ((middle_.load(std::memory_order_relaxed) & kFreshBit) == 0) {
+        return false;
+    }
+    front_ = middle_.exchange(front_, std::memory_order_acq_rel) & kIndexMask;
+    return true;
+}
+
+IngestStats SnapshotIngest::Stats() const {
+    IngestStats stats;
+    stats.idle_polls = idle_polls_.load(std::memory_order_relaxed);
+    stats.snapshots_parsed = snapshots_parsed_.load(std::memory_order_relaxed);
+    stats.snapshots_failed = snapshots_failed_.load(std::memory_order_relaxed);
+    stats.deltas_dropped = deltas_dropped_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void SnapshotIngest::Run() {
+    allocation_counter::MemoryTagScope memory(allocation_counter::MemoryTag::Ingest);
+    while (running_.load(std::memory_order_relaxed)) {
+        const int64_t started_us = FrameProfiler::NowMicros();
+        const uint64_t started_allocations = allocation_counter::ThreadAllocations();
+        if (Ingest()) {
+            Publish(FrameProfiler::NowMicros() - started_us, started_allocations);
+        } else {
+            idle_polls_.fetch_add(1, std::memory_order_relaxed);
+            std::this_thread::sleep_for(kIdleSleep);
+        }
+    }
+}
+
+// Deltas only apply in order, so drain everything the transport has buffered
+// before publishing once.
+bool SnapshotIngest::Ingest() {
+    bool changed = false;
+    for (int i = 0; i < kMaxSnapshotsPerPoll && transport_->ReadNext(payload_); ++i) {
+        try {
+            DecodeSnapshot(payload_.bytes.data(), payload_.bytes.size(), update_);
+        } catch (const std::exception& e) {
+            snapshots_failed_.fetch_add(1, std::memory_order_relaxed);
+            TraceLog(LOG_WARNING, "Failed to parse game_state snapshot: %s", e.what());
+            continue;
+        }
+        snapshots_parsed_.fetch_add(1, std::memory_order_relaxed);
+
+        const bool was_synced = world_.Synced();
+        const uint64_t tick = world_.Snapshot().meta.tick;
+        const bool keyframe = update_.keyframe;
+        if (world_.Apply(update_)) {
+            if (recorder_.IsOpen()) {
+                RecordPayload(keyframe);
+            }
+            changed = true;
+            continue;
+        }
+        deltas_dropped_.fetch_add(1, std::memory_order_relaxed);
+        if (was_synced) {
+            TraceLog(LOG_INFO, "Delta based on tick %llu does not follow tick %llu, requesting a keyframe",
+                     static_cast<unsigned long long>(update_.base_tick), static_cast<unsigned long long>(tick));
+            // Publish the loss of sync so the renderer asks for a keyframe.
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+void SnapshotIngest::Publish(int64_t ingest_us, uint64_t started_allocations) {
+    // The published copies belong to the world model, not the decoder.
+    allocation_counter::MemoryTagScope memory(allocation_counter::MemoryTag::World);
+
+    // If the render thread already took everything published so far, older
+    // dirty tiles are no longer needed. A frame taken between this check and
+    // the exchange below only means a few tiles get redrawn twice.
+    const bool taken = (middle_.load(std::memory_order_acquire) & kFreshBit) == 0;
+    if (taken || published_layout_revision_ != world_.TileLayoutRevision()) {
+        pending_dirty_.clear();
+    }
+    if (taken) {
+        pending_spawns_.clear();
+    }
+    const std::vector<TileChange>& dirty = world_.DirtyTiles();
+    pending_dirty_.insert(pending_dirty_.end(), dirty.begin(), dirty.end());
+    world_.ClearDirtyTiles();
+    const std::vector<ParticleSpawn>& spawns = world_.ParticleSpawns();
+    pending_spawns_.insert(pending_spawns_.end(), spawns.begin(), spawns.end());
+    world_.ClearParticleSpawns();
+
+    IngestFrame& frame = frames_[back_];
+    frame.serial = ++serial_;
+    frame.world = world_.Snapshot();
+    frame.tile_layout_revision = world_.TileLayoutRevision();
+    frame.dirty_tiles = pending_dirty_;
+    frame.particle_spawns = pending_spawns_;
+    frame.synced = world_.Synced();
+    frame.ingest_us = ingest_us;
+    frame.allocations = allocation_counter::ThreadAllocations() - started_allocations;
+    published_layout_revision_ = frame.tile_layout_revision;
+
+    back_ = middle_.exchange(back_ | kFreshBit, std::memory_order_acq_rel) & kIndexMask;
+}
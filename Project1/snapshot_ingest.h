@@ -0,0 +1,107 @@
+#pragma once
+
+#include "replay_file.h"
+#include "state_transport.h"
+#include "world_model.h"
+#include "world_snapshot.h"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Cumulative snapshot ingest counters.
+struct IngestStats {
+    uint64_t idle_polls = 0;  // polls that found no new snapshot
+    uint64_t snapshots_parsed = 0;
+    uint64_t snapshots_failed = 0;
+    uint64_t deltas_dropped = 0;  // deltas that did not follow the current tick
+};
+
+// One published view of the world. dirty_tiles lists tiles changed since the
+// last frame the render thread acquired (it may repeat a few), unless
+// tile_layout_revision moved, in which case the whole tilemap is stale.
+// particle_spawns works the same way; repeats are recognised by sequence.
+struct IngestFrame {
+    uint64_t serial = 0;
+    WorldSnapshot world;
+    uint64_t tile_layout_revision = 0;
+    std::vector<TileChange> dirty_tiles;
+    std::vector<ParticleSpawn> particle_spawns;
+    bool synced = false;
+    int64_t ingest_us = 0;  // reading, decoding and applying the snapshots behind this frame
+    uint64_t allocations = 0;  // heap allocations the ingest thread made for this frame, copy included
+};
+
+// Reads, decodes and applies snapshots on a background thread so transport
+// reads and large parses never stall a frame. Finished frames go through a
+// lock-free triple buffer: the ingest thread always has a back buffer to fill,
+// and the render thread swaps to the newest completed frame at frame start.
+class SnapshotIngest {
+public:
+    ~SnapshotIngest();
+
+    // The transport must outlive Stop(). Only ReadNext is called on it from
+    // the ingest thread.
+    void Start(StateTransport& transport);
+    void Stop();
+
+    // Call before Start. Every snapshot the world model accepts is appended,
+    // as received, to a new replay in directory (replay_<date>_<time>.rgrp);
+    // a keyframe whose tick goes backwards (the simulation restarted) starts
+    // the next part. Deltas that were dropped are not recorded, so the file
+    // always replays cleanly.
+    void Record(const std::filesystem::path& directory, bool compress);
+
+    // Render thread only. Swaps in the newest published frame; returns false
+    // if nothing was published since the previous call.
+    bool AcquireLatest();
+    const IngestFrame& Current() const { return frames_[front_]; }
+    const WorldSnapshot& World() const { return frames_[front_].world; }
+
+    IngestStats Stats() const;
+
+private:
+    void Run();
+    bool Ingest();
+    void Publish(int64_t ingest_us, uint64_t started_allocations);
+    void RecordPayload(bool keyframe);
+    bool OpenRecording();
+
+    static constexpr uint32_t kFreshBit = 4;
+    static constexpr uint32_t kIndexMask = 3;
+
+    StateTransport* transport_ = nullptr;
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+
+    // Ingest thread state.
+    WorldModel world_;
+    SnapshotUpdate update_;
+    SnapshotPayload payload_;
+    std::vector<TileChange> pending_dirty_;
+    std::vector<ParticleSpawn> pending_spawns_;
+    uint64_t published_layout_revision_ = 0;
+    uint64_t serial_ = 0;
+    uint32_t back_ = 0;
+    ReplayWriter recorder_;
+    std::filesystem::path record_dir_;
+    std::string record_stem_;
+    int record_part_ = 0;
+    bool record_compress_ = true;
+
+    // Triple buffer: back_ belongs to the ingest thread, front_ to the render
+    // thread, and middle_ holds the third index plus kFreshBit when it carries
+    // a frame the render thread has not taken yet.
+    std::array<IngestFrame, 3> frames_;
+    std::atomic<uint32_t> middle_{1};
+    uint32_t front_ = 2;
+
+    std::atomic<uint64_t> idle_polls_{0};
+    std::atomic<uint64_t> snapshots_parsed_{0};
+    std::atomic<uint64_t> snapshots_failed_{0};
+    std::atomic<uint64_t> deltas_dropped_{0};
+};
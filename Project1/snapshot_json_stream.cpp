@@ -0,0 +1,1023 @@
+#include "snapshot_decoder.h"
+
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+#include <string_view>
+
+// StreamJsonSnapshot: a SAX handler that decodes game_state JSON as it is
+// lexed. It keeps a stack of the containers it is inside, each tagged with
+// what it holds, and for every key looks up which field it names in that
+// container. Values of unknown keys are skipped whole. Where a DOM decode
+// would look at one key before another ("kind" decides whether entity lists
+// are top-level or under "upsert", and whether tiles count), the handler
+// reads both and settles it in Finish, so key order does not matter.
+
+namespace {
+
+using namespace snapshot;
+
+enum class Context : uint8_t {
+    Document,     // outside the top-level object
+    Top,
+    Meta,
+    Tilemap,
+    TileRows,     // tilemap.tiles
+    TileRow,
+    TileChanges,
+    TileChange,   // [x, y, tile]
+    Particles,
+    Particle,
+    Upsert,
+    Remove,
+    RemovedIds,   // remove.<table>
+    Entities,     // <table>, top-level or under upsert
+    Entity,
+    Ui,
+    Messages,
+    Boss,
+};
+
+enum class Table : uint8_t { Actors = 0, Projectiles, Pickups, Effects, Count };
+constexpr size_t kTableCount = static_cast<size_t>(Table::Count);
+
+// Where a table's rows came from; only one of them counts, by kind.
+enum class Source : uint8_t { None = 0, Top, Upsert };
+
+enum class TopField : uint8_t {
+    Kind, BaseTick, Meta, Tilemap, TileChanges, Particles, Actors, Projectiles, Pickups, Effects, Upsert, Remove, Ui
+};
+enum class MetaField : uint8_t {
+    Tick, DeltaTime, RoomId, PlayerHp, PlayerMaxHp, Coins, Keys, Bombs, RoomCleared, PlayerDead, InputAck, TimestampUs
+};
+enum class TilemapField : uint8_t { TileSize, Width, Height, Tiles };
+enum class ParticleField : uint8_t { Kind, X, Y, Seed };
+enum class UiField : uint8_t { Messages, BossHealth };
+enum class BossField : uint8_t { Name, Hp, MaxHp };
+enum class ActorField : uint8_t { Id, Type, Variant, Invulnerable, X, Y, DirX, DirY, Speed, Hp, MaxHp };
+enum class ProjectileField : uint8_t { Id, Owner, Kind, X, Y, Vx, Vy, Ttl, Radius, Damage };
+enum class PickupField : uint8_t { Id, Kind, X, Y };
+enum class EffectField : uint8_t { Id, Kind, X, Y, Ttl };
+
+constexpr std::array<std::string_view, 13> kTopFields = {
+    "kind", "base_tick", "meta", "tilemap", "tile_changes", "particles", "actors", "projectiles", "pickups",
+    "effects", "upsert", "remove", "ui",
+};
+constexpr std::array<std::string_view, 12> kMetaFields = {
+    "tick", "delta_time", "room_id", "player_hp", "player_max_hp", "coins", "keys", "bombs", "room_cleared",
+    "player_dead", "input_ack", "timestamp_us",
+};
+constexpr std::array<std::string_view, 4> kTilemapFields = {"tile_size", "width", "height", "tiles"};
+constexpr std::array<std::string_view, 4> kParticleFields = {"kind", "x", "y", "seed"};
+constexpr std::array<std::string_view, 2> kUiFields = {"messages", "boss_health"};
+constexpr std::array<std::string_view, 3> kBossFields = {"name", "hp", "max_hp"};
+constexpr std::array<std::string_view, kTableCount> kTableFields = {"actors", "projectiles", "pickups", "effects"};
+constexpr std::array<std::string_view, 11> kActorFields = {
+    "id", "type", "variant", "invulnerable", "x", "y", "dir_x", "dir_y", "speed", "hp", "max_hp",
+};
+constexpr std::array<std::string_view, 10> kProjectileFields = {
+    "id", "owner", "kind", "x", "y", "vx", "vy", "ttl", "radius", "damage",
+};
+constexpr std::array<std::string_view, 4> kPickupFields = {"id", "kind", "x", "y"};
+constexpr std::array<std::string_view, 5> kEffectFields = {"id", "kind", "x", "y", "ttl"};
+
+template <size_t N>
+int Lookup(const std::array<std::string_view, N>& names, std::string_view key) {
+    for (size_t i = 0; i < N; ++i) {
+        if (names[i] == key) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+// One scalar as SAX delivers it. The string view points into the lexer's
+// token buffer and is only valid during the callback.
+struct Scalar {
+    enum class Type : uint8_t { Null, Boolean, Integer, Unsigned, Float, String };
+
+    Type type = Type::Null;
+    bool boolean = false;
+    int64_t integer = 0;
+    uint64_t unsigned_integer = 0;
+    double real = 0.0;
+    std::string_view string;
+};
+
+[[noreturn]] void WrongType(std::string_view what) {
+    throw std::runtime_error("json snapshot: " + std::string(what) + " has the wrong type");
+}
+
+// Like nlohmann's get<T> for arithmetic T: any number or a boolean converts.
+template <typename T>
+T Number(const Scalar& value, std::string_view what) {
+    switch (value.type) {
+    case Scalar::Type::Integer:
+        return static_cast<T>(value.integer);
+    case Scalar::Type::Unsigned:
+        return static_cast<T>(value.unsigned_integer);
+    case Scalar::Type::Float:
+        return static_cast<T>(value.real);
+    case Scalar::Type::Boolean:
+        return static_cast<T>(value.boolean);
+    default:
+        WrongType(what);
+    }
+}
+
+bool Boolean(const Scalar& value, std::string_view what) {
+    if (value.type != Scalar::Type::Boolean) {
+        WrongType(what);
+    }
+    return value.boolean;
+}
+
+std::string_view String(const Scalar& value, std::string_view what) {
+    if (value.type != Scalar::Type::String) {
+        WrongType(what);
+    }
+    return value.string;
+}
+
+// Row defaults, as DecodeJsonSnapshot fills in missing keys.
+struct RowDefaults {
+    uint32_t id = HashId("");
+    ActorType actor_type = ActorTypeFromName("enemy");
+    ActorVariant actor_variant = ActorVariantFromName("default");
+    ProjectileOwner projectile_owner = ProjectileOwnerFromName("player");
+    ProjectileKind projectile_kind = ProjectileKindFromName("");
+    PickupKind pickup_kind = PickupKindFromName("coin");
+    EffectKind effect_kind = EffectKindFromName("impact");
+};
+
+const RowDefaults& Defaults() {
+    static const RowDefaults defaults;
+    return defaults;
+}
+
+// Tile rows as they arrive, laid out once the room's width is known.
+struct TileScratch {
+    std::vector<TileCode> codes;
+    std::vector<uint32_t> row_ends;
+};
+
+class SnapshotStream {
+public:
+    using Json = SnapshotJson;
+
+    SnapshotStream(SnapshotUpdate& update, TileScratch& scratch)
+        : update_(update), out_(update.frame), scratch_(scratch) {
+        Reset();
+    }
+
+    void Finish();
+
+    // nlohmann's SAX interface.
+    bool null() { return OnScalar(Scalar{}); }
+    bool boolean(bool value) {
+        Scalar scalar;
+        scalar.type = Scalar::Type::Boolean;
+        scalar.boolean = value;
+        return OnScalar(scalar);
+    }
+    bool number_integer(Json::number_integer_t value) {
+        Scalar scalar;
+        scalar.type = Scalar::Type::Integer;
+        scalar.integer = value;
+        return OnScalar(scalar);
+    }
+    bool number_unsigned(Json::number_unsigned_t value) {
+        Scalar scalar;
+        scalar.type = Scalar::Type::Unsigned;
+        scalar.unsigned_integer = value;
+        return OnScalar(scalar);
+    }
+    // A template because nlohmann's UBJSON reader, instantiated alongside the
+    // JSON one, passes the raw token as std::string.
+    template <typename Raw>
+    bool number_float(Json::number_float_t value, const Raw&) {
+        Scalar scalar;
+        scalar.type = Scalar::Type::Float;
+        scalar.real = value;
+        return OnScalar(scalar);
+    }
+    bool string(Json::string_t& value) {
+        Scalar scalar;
+        scalar.type = Scalar::Type::String;
+        scalar.string = std::string_view(value.data(), value.size());
+        return OnScalar(scalar);
+    }
+    bool binary(Json::binary_t&) { return OnScalar(Scalar{}); }
+    bool start_object(std::size_t) { return StartContainer(false); }
+    bool end_object() { return EndContainer(); }
+    bool start_array(std::size_t) { return StartContainer(true); }
+    bool end_array() { return EndContainer(); }
+    bool key(Json::string_t& value);
+    bool parse_error(std::size_t, const std::string&, const nlohmann::detail::exception& error) {
+        throw std::runtime_error(error.what());
+    }
+
+private:
+    static constexpr size_t kMaxDepth = 8;  // deepest known path: tilemap.tiles[y][x]
+
+    struct Level {
+        Context context = Context::Document;
+        Table table = Table::Actors;
+        uint32_t count = 0;  // elements so far, for arrays
+    };
+
+    void Reset();
+    Level& Current() { return stack_[depth_ - 1]; }
+    bool InArray() const;
+    void Push(Context context, Table table = Table::Actors);
+    bool StartContainer(bool array);
+    bool EndContainer();
+    bool OnScalar(const Scalar& value);
+    bool Ignored(Context context) const;
+    Context ObjectFor(const Level& level);
+    Context ArrayFor(const Level& level, Table& table);
+    bool WantTable(Table table, Source source);
+    void AppendRow(Table table);
+    void SetEntityField(Table table, const Scalar& value);
+    void SetMetaField(const Scalar& value);
+
+    SnapshotUpdate& update_;
+    WorldSnapshot& out_;
+    TileScratch& scratch_;
+    std::array<Level, kMaxDepth> stack_{};
+    size_t depth_ = 0;
+    int field_ = -1;     // what the current object's pending key names; -1 = unknown
+    uint32_t skip_ = 0;  // nesting inside a skipped container
+
+    bool kind_seen_ = false;
+    bool keyframe_ = true;
+    uint64_t base_tick_ = 0;
+    bool max_hp_seen_ = false;
+    bool tilemap_seen_ = false;
+    int width_field_ = 0;
+    int height_field_ = 0;
+    std::array<Source, kTableCount> sources_{};
+    size_t message_count_ = 0;
+};
+
+void SnapshotStream::Reset() {
+    out_.meta = SnapshotMeta{};
+    out_.tiles.clear();
+    out_.room_width = 0;
+    out_.room_height = 0;
+    out_.actors.Resize(0);
+    out_.projectiles.Resize(0);
+    out_.pickups.Resize(0);
+    out_.effects.Resize(0);
+    out_.boss.active = false;
+    out_.boss.hp = 0;
+    out_.boss.max_hp = 1;
+    out_.boss.name.clear();
+    update_.tile_changes.clear();
+    update_.particle_spawns.clear();
+    update_.removed_actors.clear();
+    update_.removed_projectiles.clear();
+    update_.removed_pickups.clear();
+    update_.removed_effects.clear();
+    scratch_.codes.clear();
+    scratch_.row_ends.clear();
+    stack_[0] = Level{};
+    depth_ = 1;
+}
+
+bool SnapshotStream::InArray() const {
+    switch (stack_[depth_ - 1].context) {
+    case Context::TileRows:
+    case Context::TileRow:
+    case Context::TileChanges:
+    case Context::TileChange:
+    case Context::Particles:
+    case Context::RemovedIds:
+    case Context::Entities:
+    case Context::Messages:
+        return true;
+    default:
+        return false;
+    }
+}
+
+void SnapshotStream::Push(Context context, Table table) {
+    if (depth_ == kMaxDepth) {
+        throw std::runtime_error("json snapshot nested too deeply");
+    }
+    stack_[depth_++] = Level{context, table, 0};
+    field_ = -1;
+}
+
+bool SnapshotStream::key(Json::string_t& value) {
+    if (skip_ > 0) {
+        return true;
+    }
+    const std::string_view name(value.data(), value.size());
+    switch (Current().context) {
+    case Context::Top:
+        field_ = Lookup(kTopFields, name);
+        break;
+    case Context::Meta:
+        field_ = Lookup(kMetaFields, name);
+        break;
+    case Context::Tilemap:
+        field_ = Lookup(kTilemapFields, name);
+        break;
+    case Context::Particle:
+        field_ = Lookup(kParticleFields, name);
+        break;
+    case Context::Upsert:
+    case Context::Remove:
+        field_ = Lookup(kTableFields, name);
+        break;
+    case Context::Ui:
+        field_ = Lookup(kUiFields, name);
+        break;
+    case Context::Boss:
+        field_ = Lookup(kBossFields, name);
+        break;
+    case Context::Entity:
+        switch (Current().table) {
+        case Table::Actors:
+            field_ = Lookup(kActorFields, name);
+            break;
+        case Table::Projectiles:
+            field_ = Lookup(kProjectileFields, name);
+            break;
+        case Table::Pickups:
+            field_ = Lookup(kPickupFields, name);
+            break;
+        default:
+            field_ = Lookup(kEffectFields, name);
+            break;
+        }
+        break;
+    default:
+        field_ = -1;
+        break;
+    }
+    return true;
+}
+
+// Which container an object value opens, or throws if the field it belongs
+// to is not an object.
+Context SnapshotStream::ObjectFor(const Level& level) {
+    switch (level.context) {
+    case Context::Document:
+        return Context::Top;
+    case Context::Top:
+        switch (static_cast<TopField>(field_)) {
+        case TopField::Meta:
+            return Context::Meta;
+        case TopField::Tilemap:
+            tilemap_seen_ = true;
+            out_.tile_size = 32.0f;
+            return Context::Tilemap;
+        case TopField::Upsert:
+            return Context::Upsert;
+        case TopField::Remove:
+            return Context::Remove;
+        case TopField::Ui:
+            return Context::Ui;
+        default:
+            WrongType(kTopFields[field_]);
+        }
+    case Context::Particles: {
+        ParticleSpawn spawn;
+        spawn.kind = Defaults().effect_kind;
+        update_.particle_spawns.push_back(spawn);
+        return Context::Particle;
+    }
+    case Context::Entities:
+        AppendRow(level.table);
+        return Context::Entity;
+    case Context::Ui:
+        if (static_cast<UiField>(field_) != UiField::BossHealth) {
+            WrongType("ui.messages");
+        }
+        out_.boss.active = true;
+        out_.boss.name.assign("Boss");
+        return Context::Boss;
+    default:
+        WrongType("an object");
+    }
+}
+
+// Which container an array value opens, or throws if its field is not an
+// array. Sets table for the per-table contexts.
+Context SnapshotStream::ArrayFor(const Level& level, Table& table) {
+    switch (level.context) {
+    case Context::Top:
+        switch (static_cast<TopField>(field_)) {
+        case TopField::TileChanges:
+            return Context::TileChanges;
+        case TopField::Particles:
+            return Context::Particles;
+        case TopField::Actors:
+        case TopField::Projectiles:
+        case TopField::Pickups:
+        case TopField::Effects:
+            table = static_cast<Table>(field_ - static_cast<int>(TopField::Actors));
+            return Context::Entities;
+        default:
+            WrongType(kTopFields[field_]);
+        }
+    case Context::Tilemap:
+        if (static_cast<TilemapField>(field_) != TilemapField::Tiles) {
+            WrongType(kTilemapFields[field_]);
+        }
+        return Context::TileRows;
+    case Context::TileRows:
+        return Context::TileRow;
+    case Context::TileChanges:
+        update_.tile_changes.emplace_back();
+        return Context::TileChange;
+    case Context::Upsert:
+        table = static_cast<Table>(field_);
+        return Context::Entities;
+    case Context::Remove:
+        table = static_cast<Table>(field_);
+        return Context::RemovedIds;
+    case Context::Ui:
+        if (static_cast<UiField>(field_) != UiField::Messages) {
+            WrongType("ui.boss_health");
+        }
+        return Context::Messages;
+    default:
+        WrongType("an array");
+    }
+}
+
+// Parts the DOM decoder never looks at for this kind, once the kind is known.
+bool SnapshotStream::Ignored(Context context) const {
+    if (!kind_seen_) {
+        return false;
+    }
+    switch (context) {
+    case Context::TileRows:
+        return !keyframe_;
+    case Context::TileChanges:
+    case Context::Remove:
+        return keyframe_;
+    default:
+        return false;
+    }
+}
+
+bool SnapshotStream::StartContainer(bool array) {
+    if (skip_ > 0 || (!InArray() && field_ < 0 && Current().context != Context::Document)) {
+        ++skip_;
+        return true;
+    }
+    Level& level = Current();
+    ++level.count;
+    if (!array) {
+        const Context context = ObjectFor(level);
+        if (Ignored(context)) {
+            ++skip_;
+            return true;
+        }
+        Push(context, level.table);
+        return true;
+    }
+    Table table = level.table;
+    const Context context = ArrayFor(level, table);
+    if (Ignored(context)) {
+        ++skip_;
+        return true;
+    }
+    if (context == Context::Entities) {
+        const Source source = level.context == Context::Top ? Source::Top : Source::Upsert;
+        if (!WantTable(table, source)) {
+            ++skip_;
+            return true;
+        }
+    }
+    Push(context, table);
+    return true;
+}
+
+bool SnapshotStream::EndContainer() {
+    if (skip_ > 0) {
+        --skip_;
+        return true;
+    }
+    const Level& level = Current();
+    if (level.context == Context::TileRow) {
+        scratch_.row_ends.push_back(static_cast<uint32_t>(scratch_.codes.size()));
+    } else if (level.context == Context::TileChange && level.count < 3) {
+        throw std::runtime_error("json snapshot: a tile change needs [x, y, tile]");
+    }
+    --depth_;
+    field_ = -1;
+    return true;
+}
+
+// Keyframes list entities at the top level, deltas under "upsert". Until
+// "kind" has been read either may be the one, so the newest list read wins
+// (a snapshot never has both) and Finish drops it if it was the wrong one.
+bool SnapshotStream::WantTable(Table table, Source source) {
+    const Source expected = keyframe_ ? Source::Top : Source::Upsert;
+    if (kind_seen_ && source != expected) {
+        return false;
+    }
+    const size_t index = static_cast<size_t>(table);
+    sources_[index] = source;
+    switch (table) {
+    case Table::Actors:
+        out_.actors.Resize(0);
+        break;
+    case Table::Projectiles:
+        out_.projectiles.Resize(0);
+        break;
+    case Table::Pickups:
+        out_.pickups.Resize(0);
+        break;
+    default:
+        out_.effects.Resize(0);
+        break;
+    }
+    return true;
+}
+
+void SnapshotStream::AppendRow(Table table) {
+    const RowDefaults& defaults = Defaults();
+    switch (table) {
+    case Table::Actors: {
+        ActorArrays& actors = out_.actors;
+        const size_t row = actors.Size();
+        actors.Resize(row + 1);
+        actors.id[row] = defaults.id;
+        actors.type[row] = defaults.actor_type;
+        actors.variant[row] = defaults.actor_variant;
+        actors.flags[row] = 0;
+        actors.x[row] = 0.0f;
+        actors.y[row] = 0.0f;
+        actors.dir_x[row] = 0.0f;
+        actors.dir_y[row] = 0.0f;
+        actors.speed[row] = 0.0f;
+        actors.hp[row] = 0;
+        actors.max_hp[row] = 1;
+        break;
+    }
+    case Table::Projectiles: {
+        ProjectileArrays& projectiles = out_.projectiles;
+        const size_t row = projectiles.Size();
+        projectiles.Resize(row + 1);
+        projectiles.id[row] = defaults.id;
+        projectiles.owner[row] = defaults.projectile_owner;
+        projectiles.kind[row] = defaults.projectile_kind;
+        projectiles.x[row] = 0.0f;
+        projectiles.y[row] = 0.0f;
+        projectiles.vx[row] = 0.0f;
+        projectiles.vy[row] = 0.0f;
+        projectiles.ttl[row] = 0.0f;
+        projectiles.radius[row] = 0.2f;
+        projectiles.damage[row] = 0;
+        break;
+    }
+    case Table::Pickups: {
+        PickupArrays& pickups = out_.pickups;
+        const size_t row = pickups.Size();
+        pickups.Resize(row + 1);
+        pickups.id[row] = defaults.id;
+        pickups.kind[row] = defaults.pickup_kind;
+        pickups.x[row] = 0.0f;
+        pickups.y[row] = 0.0f;
+        break;
+    }
+    default: {
+        EffectArrays& effects = out_.effects;
+        const size_t row = effects.Size();
+        effects.Resize(row + 1);
+        effects.id[row] = defaults.id;
+        effects.kind[row] = defaults.effect_kind;
+        effects.x[row] = 0.0f;
+        effects.y[row] = 0.0f;
+        effects.ttl[row] = 0.0f;
+        break;
+    }
+    }
+}
+
+void SnapshotStream::SetEntityField(Table table, const Scalar& value) {
+    switch (table) {
+    case Table::Actors: {
+        ActorArrays& actors = out_.actors;
+        const size_t row = actors.Size() - 1;
+        const std::string_view what = kActorFields[field_];
+        switch (static_cast<ActorField>(field_)) {
+        case ActorField::Id:
+            actors.id[row] = HashId(String(value, what));
+            break;
+        case ActorField::Type:
+            actors.type[row] = ActorTypeFromName(String(value, what));
+            break;
+        case ActorField::Variant:
+            actors.variant[row] = ActorVariantFromName(String(value, what));
+            break;
+        case ActorField::Invulnerable:
+            actors.flags[row] = Boolean(value, what) ? kActorInvulnerable : 0;
+            break;
+        case ActorField::X:
+            actors.x[row] = Number<float>(value, what);
+            break;
+        case ActorField::Y:
+            actors.y[row] = Number<float>(value, what);
+            break;
+        case ActorField::DirX:
+            actors.dir_x[row] = Number<float>(value, what);
+            break;
+        case ActorField::DirY:
+            actors.dir_y[row] = Number<float>(value, what);
+            break;
+        case ActorField::Speed:
+            actors.speed[row] = Number<float>(value, what);
+            break;
+        case ActorField::Hp:
+            actors.hp[row] = Number<int>(value, what);
+            break;
+        case ActorField::MaxHp:
+            actors.max_hp[row] = Number<int>(value, what);
+            break;
+        }
+        break;
+    }
+    case Table::Projectiles: {
+        ProjectileArrays& projectiles = out_.projectiles;
+        const size_t row = projectiles.Size() - 1;
+        const std::string_view what = kProjectileFields[field_];
+        switch (static_cast<ProjectileField>(field_)) {
+        case ProjectileField::Id:
+            projectiles.id[row] = HashId(String(value, what));
+            break;
+        case ProjectileField::Owner:
+            projectiles.owner[row] = ProjectileOwnerFromName(String(value, what));
+            break;
+        case ProjectileField::Kind:
+            projectiles.kind[row] = ProjectileKindFromName(String(value, what));
+            break;
+        case ProjectileField::X:
+            projectiles.x[row] = Number<float>(value, what);
+            break;
+        case ProjectileField::Y:
+            projectiles.y[row] = Number<float>(value, what);
+            break;
+        case ProjectileField::Vx:
+            projectiles.vx[row] = Number<float>(value, what);
+            break;
+        case ProjectileField::Vy:
+            projectiles.vy[row] = Number<float>(value, what);
+            break;
+        case ProjectileField::Ttl:
+            projectiles.ttl[row] = Number<float>(value, what);
+            break;
+        case ProjectileField::Radius:
+            projectiles.radius[row] = Number<float>(value, what);
+            break;
+        case ProjectileField::Damage:
+            projectiles.damage[row] = Number<int>(value, what);
+            break;
+        }
+        break;
+    }
+    case Table::Pickups: {
+        PickupArrays& pickups = out_.pickups;
+        const size_t row = pickups.Size() - 1;
+        const std::string_view what = kPickupFields[field_];
+        switch (static_cast<PickupField>(field_)) {
+        case PickupField::Id:
+            pickups.id[row] = HashId(String(value, what));
+            break;
+        case PickupField::Kind:
+            pickups.kind[row] = PickupKindFromName(String(value, what));
+            break;
+        case PickupField::X:
+            pickups.x[row] = Number<float>(value, what);
+            break;
+        case PickupField::Y:
+            pickups.y[row] = Number<float>(value, what);
+            break;
+        }
+        break;
+    }
+    default: {
+        EffectArrays& effects = out_.effects;
+        const size_t row = effects.Size() - 1;
+        const std::string_view what = kEffectFields[field_];
+        switch (static_cast<EffectField>(field_)) {
+        case EffectField::Id:
+            effects.id[row] = HashId(String(value, what));
+            break;
+        case EffectField::Kind:
+            effects.kind[row] = EffectKindFromName(String(value, what));
+            break;
+        case EffectField::X:
+            effects.x[row] = Number<float>(value, what);
+            break;
+        case EffectField::Y:
+            effects.y[row] = Number<float>(value, what);
+            break;
+        case EffectField::Ttl:
+            effects.ttl[row] = Number<float>(value, what);
+            break;
+        }
+        break;
+    }
+    }
+}
+
+void SnapshotStream::SetMetaField(const Scalar& value) {
+    SnapshotMeta& meta = out_.meta;
+    const std::string_view what = kMetaFields[field_];
+    switch (static_cast<MetaField>(field_)) {
+    case MetaField::Tick:
+        meta.tick = Number<uint64_t>(value, what);
+        break;
+    case MetaField::DeltaTime:
+        meta.delta_time = Number<float>(value, what);
+        break;
+    case MetaField::RoomId:
+        meta.room_id = Number<uint32_t>(value, what);
+        break;
+    case MetaField::PlayerHp:
+        meta.player_hp = Number<int>(value, what);
+        break;
+    case MetaField::PlayerMaxHp:
+        meta.player_max_hp = Number<int>(value, what);
+        max_hp_seen_ = true;
+        break;
+    case MetaField::Coins:
+        meta.coins = Number<int>(value, what);
+        break;
+    case MetaField::Keys:
+        meta.keys = Number<int>(value, what);
+        break;
+    case MetaField::Bombs:
+        meta.bombs = Number<int>(value, what);
+        break;
+    case MetaField::RoomCleared:
+        meta.room_cleared = Boolean(value, what);
+        break;
+    case MetaField::PlayerDead:
+        meta.player_dead = Boolean(value, what);
+        break;
+    case MetaField::InputAck:
+        meta.input_ack = Number<uint32_t>(value, what);
+        break;
+    case MetaField::TimestampUs:
+        meta.timestamp_us = Number<uint64_t>(value, what);
+        break;
+    }
+}
+
+bool SnapshotStream::OnScalar(const Scalar& value) {
+    if (skip_ > 0) {
+        return true;
+    }
+    Level& level = Current();
+    const bool in_array = InArray();
+    if (!in_array && field_ < 0 && level.context != Context::Document) {
+        return true;  // unknown key
+    }
+    ++level.count;
+    const bool null = value.type == Scalar::Type::Null;
+    switch (level.context) {
+    case Context::Document:
+        WrongType("the snapshot");
+    case Context::Top:
+        switch (static_cast<TopField>(field_)) {
+        case TopField::Kind:
+            keyframe_ = String(value, "kind") != "delta";
+            kind_seen_ = true;
+            break;
+        case TopField::BaseTick:
+            base_tick_ = Number<uint64_t>(value, "base_tick");
+            break;
+        case TopField::Actors:
+        case TopField::Projectiles:
+        case TopField::Pickups:
+        case TopField::Effects:
+            // null reads as an empty list, like the DOM's size() of null.
+            if (!null) {
+                WrongType(kTopFields[field_]);
+            }
+            WantTable(static_cast<Table>(field_ - static_cast<int>(TopField::Actors)), Source::Top);
+            break;
+        case TopField::TileChanges:
+        case TopField::Particles:
+        case TopField::Upsert:
+        case TopField::Remove:
+        case TopField::Ui:
+            if (!null) {
+                WrongType(kTopFields[field_]);
+            }
+            break;
+        default:
+            WrongType(kTopFields[field_]);
+        }
+        break;
+    case Context::Meta:
+        SetMetaField(value);
+        break;
+    case Context::Tilemap:
+        switch (static_cast<TilemapField>(field_)) {
+        case TilemapField::TileSize:
+            out_.tile_size = Number<float>(value, "tile_size");
+            break;
+        case TilemapField::Width:
+            width_field_ = Number<int>(value, "width");
+            break;
+        case TilemapField::Height:
+            height_field_ = Number<int>(value, "height");
+            break;
+        case TilemapField::Tiles:
+            if (!null) {
+                WrongType("tiles");
+            }
+            break;
+        }
+        break;
+    case Context::TileRows:
+        if (!null) {
+            WrongType("a tile row");
+        }
+        scratch_.row_ends.push_back(static_cast<uint32_t>(scratch_.codes.size()));  // an empty row
+        break;
+    case Context::TileRow:
+        scratch_.codes.push_back(TileCodeFromName(String(value, "a tile")));
+        break;
+    case Context::TileChange: {
+        TileChange& change = update_.tile_changes.back();
+        if (level.count == 1) {
+            change.x = Number<uint16_t>(value, "tile change x");
+        } else if (level.count == 2) {
+            change.y = Number<uint16_t>(value, "tile change y");
+        } else if (level.count == 3) {
+            change.code = TileCodeFromName(String(value, "tile change tile"));
+        }
+        break;
+    }
+    case Context::Particle: {
+        ParticleSpawn& spawn = update_.particle_spawns.back();
+        switch (static_cast<ParticleField>(field_)) {
+        case ParticleField::Kind:
+            spawn.kind = EffectKindFromName(String(value, "particle kind"));
+            break;
+        case ParticleField::X:
+            spawn.x = Number<float>(value, "particle x");
+            break;
+        case ParticleField::Y:
+            spawn.y = Number<float>(value, "particle y");
+            break;
+        case ParticleField::Seed:
+            spawn.seed = Number<uint32_t>(value, "particle seed");
+            break;
+        }
+        break;
+    }
+    case Context::Upsert:
+        if (!null) {
+            WrongType(kTableFields[field_]);
+        }
+        WantTable(static_cast<Table>(field_), Source::Upsert);
+        break;
+    case Context::Remove:
+        if (!null) {
+            WrongType(kTableFields[field_]);
+        }
+        break;
+    case Context::RemovedIds: {
+        const uint32_t id = HashId(String(value, "a removed id"));
+        switch (level.table) {
+        case Table::Actors:
+            update_.removed_actors.push_back(id);
+            break;
+        case Table::Projectiles:
+            update_.removed_projectiles.push_back(id);
+            break;
+        case Table::Pickups:
+            update_.removed_pickups.push_back(id);
+            break;
+        default:
+            update_.removed_effects.push_back(id);
+            break;
+        }
+        break;
+    }
+    case Context::Entity:
+        SetEntityField(level.table, value);
+        break;
+    case Context::Ui:
+        if (!null) {
+            WrongType(kUiFields[field_]);
+        }
+        break;
+    case Context::Messages: {
+        // Assigned in place so the strings keep their capacity between snapshots.
+        const std::string_view message = String(value, "a message");
+        if (message_count_ == out_.messages.size()) {
+            out_.messages.emplace_back();
+        }
+        out_.messages[message_count_++].assign(message.data(), message.size());
+        break;
+    }
+    case Context::Boss:
+        switch (static_cast<BossField>(field_)) {
+        case BossField::Name: {
+            const std::string_view name = String(value, "boss name");
+            out_.boss.name.assign(name.data(), name.size());
+            break;
+        }
+        case BossField::Hp:
+            out_.boss.hp = Number<int>(value, "boss hp");
+            break;
+        case BossField::MaxHp:
+            out_.boss.max_hp = Number<int>(value, "boss max_hp");
+            break;
+        }
+        break;
+    default:
+        WrongType("a value");
+    }
+    return true;
+}
+
+void SnapshotStream::Finish() {
+    if (depth_ != 1 || stack_[0].count == 0) {
+        WrongType("the snapshot");
+    }
+    update_.keyframe = keyframe_;
+    update_.base_tick = keyframe_ ? 0 : base_tick_;
+    if (!max_hp_seen_) {
+        out_.meta.player_max_hp = std::max(out_.meta.player_hp, 1);
+    }
+    out_.boss.max_hp = std::max(1, out_.boss.max_hp);
+    out_.messages.resize(message_count_);
+
+    // Tile rows only count in keyframes; a delta's tilemap carries the size.
+    if (tilemap_seen_) {
+        const std::vector<uint32_t>& ends = scratch_.row_ends;
+        const size_t rows = keyframe_ ? ends.size() : 0;
+        int width = width_field_;
+        for (size_t y = 0, start = 0; y < rows; start = ends[y++]) {
+            width = std::max(width, static_cast<int>(ends[y] - start));
+        }
+        const int height = std::max(height_field_, static_cast<int>(rows));
+        out_.room_width = width;
+        out_.room_height = height;
+        if (keyframe_) {
+            out_.tiles.assign(static_cast<size_t>(width) * height, TileCode::Unknown);
+            for (size_t y = 0, start = 0; y < rows; start = ends[y++]) {
+                std::copy(scratch_.codes.begin() + start, scratch_.codes.begin() + ends[y],
+                          out_.tiles.begin() + y * width);
+            }
+        }
+    }
+
+    if (keyframe_) {
+        update_.tile_changes.clear();
+        update_.removed_actors.clear();
+        update_.removed_projectiles.clear();
+        update_.removed_pickups.clear();
+        update_.removed_effects.clear();
+    }
+    const Source expected = keyframe_ ? Source::Top : Source::Upsert;
+    for (size_t table = 0; table < kTableCount; ++table) {
+        if (sources_[table] == expected) {
+            continue;
+        }
+        switch (static_cast<Table>(table)) {
+        case Table::Actors:
+            out_.actors.Resize(0);
+            break;
+        case Table::Projectiles:
+            out_.projectiles.Resize(0);
+            break;
+        case Table::Pickups:
+            out_.pickups.Resize(0);
+            break;
+        default:
+            out_.effects.Resize(0);
+            break;
+        }
+    }
+    for (ParticleSpawn& spawn : update_.particle_spawns) {
+        spawn.tick = out_.meta.tick;
+    }
+}
+
+}  // namespace
+
+void StreamJsonSnapshot(const char* data, size_t size, SnapshotUpdate& out) {
+    // The handler keeps nothing from the parse, but nlohmann's lexer buffers
+    // every key and string token in a string_t; with SnapshotJson that is an
+    // ArenaString, so after warm-up the parse does not touch the heap for it.
+    thread_local FrameArena arena;
+    thread_local TileScratch scratch;
+    ArenaScope scope(arena);
+    SnapshotStream stream(out, scratch);
+    SnapshotJson::sax_parse(data, data + size, &stream);
+    stream.Finish();
+}
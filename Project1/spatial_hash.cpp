@@ -0,0 +1,133 @@
+#include "spatial_hash.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+constexpr size_t kMinBuckets = 64;
+constexpr double kMaxCell = 1e15;
+
+}  // namespace
+
+SpatialHash::SpatialHash(double cell_size)
+    : cell_size_(cell_size > 0.0 ? cell_size : 1.0), inverse_cell_size_(1.0 / cell_size_) {}
+
+int64_t SpatialHash::CellOf(double value) const {
+    const double cell = std::floor(value * inverse_cell_size_);
+    // Keeps the cast defined for far-off or non-finite positions.
+    if (!(cell > -kMaxCell)) {
+        return static_cast<int64_t>(-kMaxCell);
+    }
+    return static_cast<int64_t>(std::min(cell, kMaxCell));
+}
+
+size_t SpatialHash::Bucket(int64_t cell_x, int64_t cell_y) const {
+    // Teschner et al. primes; the bucket count is a power of two.
+    const uint64_t hash = (static_cast<uint64_t>(cell_x) * 73856093u) ^ (static_cast<uint64_t>(cell_y) * 19349663u);
+    return static_cast<size_t>(hash) & bucket_mask_;
+}
+
+// Calls visit(bucket) for every bucket that can hold a circle reaching the
+// probe. A probe wider than the table just walks every bucket.
+template <typename Visit>
+void SpatialHash::ForEachBucket(double x, double y, double radius, Visit&& visit) const {
+    const double reach = radius + max_radius_;
+    const int64_t min_x = CellOf(x - reach);
+    const int64_t max_x = CellOf(x + reach);
+    const int64_t min_y = CellOf(y - reach);
+    const int64_t max_y = CellOf(y + reach);
+    const double cells = static_cast<double>(max_x - min_x + 1) * static_cast<double>(max_y - min_y + 1);
+    if (cells >= static_cast<double>(bucket_mask_ + 1)) {
+        for (size_t b = 0; b <= bucket_mask_; ++b) {
+            visit(b);
+        }
+        return;
+    }
+    for (int64_t cy = min_y; cy <= max_y; ++cy) {
+        for (int64_t cx = min_x; cx <= max_x; ++cx) {
+            visit(Bucket(cx, cy));
+        }
+    }
+}
+
+void SpatialHash::Build(const double* xs, const double* ys, const double* radii, size_t count) {
+    xs_.assign(xs, xs + count);
+    ys_.assign(ys, ys + count);
+    radii_.assign(radii, radii + count);
+    max_radius_ = 0.0;
+    for (size_t i = 0; i < count; ++i) {
+        max_radius_ = std::max(max_radius_, radii_[i]);
+    }
+
+    // One spare slot at the end so bucket b always has start[b + 1].
+    size_t buckets = kMinBuckets;
+    while (buckets < count * 2) {
+        buckets *= 2;
+    }
+    bucket_mask_ = buckets - 1;
+    bucket_start_.assign(buckets + 1, 0);
+    entries_.resize(count);
+
+    std::vector<uint32_t>& start = bucket_start_;
+    for (size_t i = 0; i < count; ++i) {
+        ++start[Bucket(CellOf(xs_[i]), CellOf(ys_[i])) + 1];
+    }
+    for (size_t b = 1; b <= buckets; ++b) {
+        start[b] += start[b - 1];
+    }
+    // Fill in index order so each bucket lists indices ascending; start[b]
+    // doubles as the cursor and ends up at the next bucket's start.
+    for (size_t i = 0; i < count; ++i) {
+        entries_[start[Bucket(CellOf(xs_[i]), CellOf(ys_[i]))]++] = static_cast<uint32_t>(i);
+    }
+    for (size_t b = buckets; b > 0; --b) {
+        start[b] = start[b - 1];
+    }
+    start[0] = 0;
+}
+
+bool SpatialHash::Overlaps(size_t index, double x, double y, double radius) const {
+    return std::hypot(xs_[index] - x, ys_[index] - y) < radius + radii_[index];
+}
+
+int32_t SpatialHash::FirstOverlap(double x, double y, double radius) const {
+    if (xs_.empty()) {
+        return kNone;
+    }
+    size_t best = xs_.size();
+    ForEachBucket(x, y, radius, [&](size_t bucket) {
+        for (uint32_t e = bucket_start_[bucket]; e < bucket_start_[bucket + 1]; ++e) {
+            const uint32_t index = entries_[e];
+            if (index >= best) {
+                break;  // entries are ascending; nothing later can win
+            }
+            if (Overlaps(index, x, y, radius)) {
+                best = index;
+                break;
+            }
+        }
+    });
+    return best < xs_.size() ? static_cast<int32_t>(best) : kNone;
+}
+
+void TileGrid::Assign(int width, int height, const uint8_t* solid) {
+    width_ = std::max(width, 0);
+    height_ = std::max(height, 0);
+    solid_.assign(solid, solid + static_cast<size_t>(width_) * height_);
+}
+
+bool TileGrid::SolidAt(double x, double y) const {
+    if (solid_.empty() || std::isnan(x) || std::isnan(y)) {
+        return false;
+    }
+    // Clamping first is equivalent to int() then clamp, and keeps the cast in range.
+    const int xi = static_cast<int>(std::clamp(x, 0.0, static_cast<double>(width_ - 1)));
+    const int yi = static_cast<int>(std::clamp(y, 0.0, static_cast<double>(height_ - 1)));
+    return solid_[static_cast<size_t>(yi) * width_ + xi] != 0;
+}
+
+bool TileGrid::Walkable(double x, double y, double radius) const {
+    return !SolidAt(x - radius, y - radius) && !SolidAt(x + radius, y - radius) &&
+           !SolidAt(x - radius, y + radius) && !SolidAt(x + radius, y + radius);
+}
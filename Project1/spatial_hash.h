@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Uniform-grid spatial hash over circles. Build buckets every circle by the
+// cell its centre falls in (a counting sort, so each bucket is a contiguous
+// run of indices); queries visit only the cells a probe circle can reach.
+// Positions are doubles so results match the Python simulation exactly.
+class SpatialHash {
+public:
+    static constexpr int32_t kNone = -1;
+
+    explicit SpatialHash(double cell_size = 1.0);
+
+    void Build(const double* xs, const double* ys, const double* radii, size_t count);
+
+    // Lowest index whose circle overlaps (x, y, radius), or kNone. Overlap is
+    // hypot(dx, dy) < radius + r, the test the simulation uses.
+    int32_t FirstOverlap(double x, double y, double radius) const;
+
+    size_t Size() const { return xs_.size(); }
+
+private:
+    size_t Bucket(int64_t cell_x, int64_t cell_y) const;
+    int64_t CellOf(double value) const;
+    bool Overlaps(size_t index, double x, double y, double radius) const;
+    template <typename Visit>
+    void ForEachBucket(double x, double y, double radius, Visit&& visit) const;
+
+    double cell_size_;
+    double inverse_cell_size_;
+    double max_radius_ = 0.0;
+    size_t bucket_mask_ = 0;
+    std::vector<double> xs_;
+    std::vector<double> ys_;
+    std::vector<double> radii_;
+    std::vector<uint32_t> bucket_start_;  // bucket b holds entries_[start[b], start[b + 1])
+    std::vector<uint32_t> entries_;
+};
+
+// Solid/open grid of the room, queried the way game_logic.py samples tiles:
+// coordinates truncate towards zero and clamp to the room edge.
+class TileGrid {
+public:
+    void Assign(int width, int height, const uint8_t* solid);
+
+    bool SolidAt(double x, double y) const;
+    // False if any corner of the box (x +- radius, y +- radius) is solid.
+    bool Walkable(double x, double y, double radius) const;
+
+    int Width() const { return width_; }
+    int Height() const { return height_; }
+    // Row-major, one byte per tile, non-zero = solid; empty when the room is.
+    const uint8_t* Solid() const { return solid_.data(); }
+
+private:
+    int width_ = 0;
+    int height_ = 0;
+    std::vector<uint8_t> solid_;
+};
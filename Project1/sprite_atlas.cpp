@@ -0,0 +1,213 @@
+#include "sprite_atlas.h"
+
+#include "frame_profiler.h"
+#include "memory_budget.h"
+#include "snapshot_format.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace {
+
+using snapshot::ActorVariant;
+using snapshot::CodeCount;
+using snapshot::PickupKind;
+using snapshot::TileCode;
+
+constexpr size_t kTileSlots = CodeCount<TileCode>();
+constexpr size_t kActorSlots = CodeCount<ActorVariant>();
+constexpr size_t kPickupSlots = CodeCount<PickupKind>();
+constexpr size_t kSlotCount = kTileSlots + kActorSlots + kPickupSlots;
+
+// Decoded images are converted to RGBA8.
+int64_t ImageBytes(const Image& image) {
+    return image.data != nullptr ? static_cast<int64_t>(image.width) * image.height * 4 : 0;
+}
+
+void ReleaseImage(const Image& image) {
+    allocation_counter::AddExternalBytes(allocation_counter::MemoryTag::Assets, -ImageBytes(image));
+    UnloadImage(image);
+}
+
+}  // namespace
+
+SpriteAtlas::~SpriteAtlas() {
+    stop_.store(true, std::memory_order_relaxed);
+    if (loader_.joinable()) {
+        loader_.join();
+    }
+}
+
+void SpriteAtlas::Configure(std::string directory, int uploads_per_frame) {
+    directory_ = std::move(directory);
+    uploads_per_frame_ = std::max(1, uploads_per_frame);
+}
+
+size_t SpriteAtlas::Slot(Set set, size_t code) {
+    switch (set) {
+        case Set::Tile:
+            return code < kTileSlots ? code : kSlotCount;
+        case Set::Actor:
+            return code < kActorSlots ? kTileSlots + code : kSlotCount;
+        case Set::Pickup:
+            return code < kPickupSlots ? kTileSlots + kActorSlots + code : kSlotCount;
+    }
+    return kSlotCount;
+}
+
+void SpriteAtlas::Load() {
+    if (directory_.empty() || texture_.id != 0) {
+        return;
+    }
+    allocation_counter::MemoryTagScope memory(allocation_counter::MemoryTag::Assets);
+    if (!DirectoryExists(directory_.c_str())) {
+        TraceLog(LOG_WARNING, "Sprite directory %s not found, using procedural sprites", directory_.c_str());
+        return;
+    }
+    load_started_us_ = FrameProfiler::NowMicros();
+    const int rows = static_cast<int>((kSlotCount + kColumns - 1) / kColumns);
+    Image blank = GenImageColor(kColumns * kCellSize, rows * kCellSize, BLANK);
+    texture_ = LoadTextureFromImage(blank);
+    UnloadImage(blank);
+    if (texture_.id == 0) {
+        TraceLog(LOG_WARNING, "Unable to create the sprite atlas, using procedural sprites");
+        return;
+    }
+    allocation_counter::AddExternalBytes(allocation_counter::MemoryTag::Assets, TextureBytes(texture_));
+
+    cells_.resize(kSlotCount);
+    ready_.assign(kSlotCount, 0);
+    for (size_t slot = 0; slot < kSlotCount; ++slot) {
+        cells_[slot] = Rectangle{static_cast<float>((slot % kColumns) * kCellSize),
+                                 static_cast<float>((slot / kColumns) * kCellSize), static_cast<float>(kCellSize),
+                                 static_cast<float>(kCellSize)};
+    }
+
+    // Added in slot order, so a job's index is its slot.
+    jobs_.clear();
+    auto add = [&](Set set, const char* folder, size_t code, std::string_view name) {
+        jobs_.push_back({set, code, directory_ + "/" + folder + "/" + std::string(name) + ".png"});
+    };
+    for (size_t code = 0; code < kTileSlots; ++code) {
+        add(Set::Tile, "tiles", code, snapshot::kTileNames[code]);
+    }
+    for (size_t code = 0; code < kActorSlots; ++code) {
+        add(Set::Actor, "actors", code, snapshot::kVariantNames[code]);
+    }
+    for (size_t code = 0; code < kPickupSlots; ++code) {
+        add(Set::Pickup, "pickups", code, snapshot::kPickupNames[code]);
+    }
+    pending_ = static_cast<int>(jobs_.size());
+    stop_.store(false, std::memory_order_relaxed);
+    loader_ = std::thread([this] { LoadImages(); });
+}
+
+void SpriteAtlas::Unload() {
+    stop_.store(true, std::memory_order_relaxed);
+    if (loader_.joinable()) {
+        loader_.join();
+    }
+    {
+        std::lock_guard<std::mutex> lock(decoded_mutex_);
+        uploading_.insert(uploading_.end(), decoded_.begin(), decoded_.end());
+        decoded_.clear();
+    }
+    for (Decoded& decoded : uploading_) {
+        ReleaseImage(decoded.image);
+    }
+    uploading_.clear();
+    if (texture_.id != 0) {
+        allocation_counter::AddExternalBytes(allocation_counter::MemoryTag::Assets, -TextureBytes(texture_));
+        UnloadTexture(texture_);
+        texture_ = Texture2D{};
+    }
+    std::fill(ready_.begin(), ready_.end(), 0);
+    loaded_ = 0;
+    missing_ = 0;
+    failed_ = 0;
+    pending_ = 0;
+    upload_us_ = 0;
+    upload_frames_ = 0;
+    decode_us_.store(0, std::memory_order_relaxed);
+}
+
+// Loader thread. Only CPU-side raylib calls: file IO, decode, convert, scale.
+void SpriteAtlas::LoadImages() {
+    allocation_counter::MemoryTagScope memory(allocation_counter::MemoryTag::Assets);
+    for (const Job& job : jobs_) {
+        if (stop_.load(std::memory_order_relaxed)) {
+            return;
+        }
+        const int64_t started_us = FrameProfiler::NowMicros();
+        Decoded decoded{Slot(job.set, job.code), FileExists(job.path.c_str()), Image{}};
+        if (decoded.found) {
+            decoded.image = LoadImage(job.path.c_str());
+            if (decoded.image.data != nullptr) {
+                ImageFormat(&decoded.image, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+                if (decoded.image.width != kCellSize || decoded.image.height != kCellSize) {
+                    ImageResize(&decoded.image, kCellSize, kCellSize);
+                }
+                // Held by raylib's malloc until Upload copies it into the atlas.
+                allocation_counter::AddExternalBytes(allocation_counter::MemoryTag::Assets,
+                                                     ImageBytes(decoded.image));
+            }
+        }
+        decode_us_.fetch_add(FrameProfiler::NowMicros() - started_us, std::memory_order_relaxed);
+        std::lock_guard<std::mutex> lock(decoded_mutex_);
+        decoded_.push_back(decoded);
+    }
+}
+
+void SpriteAtlas::Upload() {
+    if (pending_ <= 0) {
+        return;
+    }
+    if (uploading_.empty()) {
+        std::lock_guard<std::mutex> lock(decoded_mutex_);
+        uploading_.swap(decoded_);
+    }
+    if (uploading_.empty()) {
+        return;
+    }
+
+    const int64_t started_us = FrameProfiler::NowMicros();
+    int uploads = 0;
+    while (!uploading_.empty() && uploads < uploads_per_frame_) {
+        Decoded decoded = uploading_.back();
+        uploading_.pop_back();
+        --pending_;
+        if (decoded.image.data == nullptr) {
+            if (decoded.found) {
+                ++failed_;
+                TraceLog(LOG_WARNING, "Unable to decode sprite %s", jobs_[decoded.slot].path.c_str());
+            } else {
+                ++missing_;
+            }
+            continue;
+        }
+        UpdateTextureRec(texture_, cells_[decoded.slot], decoded.image.data);
+        ReleaseImage(decoded.image);
+        ready_[decoded.slot] = 1;
+        ++loaded_;
+        ++uploads;
+        if (decoded.slot < kTileSlots) {
+            ++tile_revision_;
+        }
+    }
+    if (uploads > 0) {
+        upload_us_ += FrameProfiler::NowMicros() - started_us;
+        ++upload_frames_;
+    }
+    if (pending_ == 0) {
+        Report();
+    }
+}
+
+void SpriteAtlas::Report() {
+    TraceLog(LOG_INFO,
+             "Sprites: %d loaded, %d missing, %d failed from %s into a %dx%d atlas; decode %.1f ms on the loader "
+             "thread, upload %.1f ms over %d frames, all in %.1f ms after load",
+             loaded_, missing_, failed_, directory_.c_str(), texture_.width, texture_.height,
+             decode_us_.load(std::memory_order_relaxed) / 1000.0, upload_us_ / 1000.0, upload_frames_,
+             (FrameProfiler::NowMicros() - load_started_us_) / 1000.0);
+}
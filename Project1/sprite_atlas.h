@@ -0,0 +1,95 @@
+#pragma once
+#include "raylib.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Tile, actor and pickup sprites packed into one texture, so a pass that
+// draws many of them binds a single texture and raylib keeps them in one
+// batch. Image files are found and decoded on a loader thread; Upload copies
+// a few finished ones into the atlas each frame, so startup never waits on
+// disk and sprites pop in over the first frames. Anything without a sprite
+// (no file, failed to decode, not uploaded yet) keeps its procedural look.
+//
+// Files are <directory>/tiles/<tile>.png, <directory>/actors/<variant>.png
+// and <directory>/pickups/<kind>.png, named by their wire names; any size,
+// scaled to kCellSize on the loader thread.
+class SpriteAtlas {
+public:
+    enum class Set : uint8_t { Tile = 0, Actor, Pickup };
+
+    static constexpr int kCellSize = 64;
+    static constexpr int kColumns = 8;
+
+    ~SpriteAtlas();
+
+    // Before Load. An empty directory disables sprites.
+    void Configure(std::string directory, int uploads_per_frame);
+
+    // Requires a GL context, so call after InitWindow. Creates the blank
+    // atlas and starts the loader thread.
+    void Load();
+    void Unload();
+
+    // Render thread, once per frame before drawing: uploads up to
+    // uploads_per_frame decoded sprites, and logs the startup report once
+    // the last one is in.
+    void Upload();
+
+    // Source rectangle in Texture() for a code of the set, or nullptr if it
+    // has no sprite (yet).
+    const Rectangle* Find(Set set, size_t code) const {
+        const size_t slot = Slot(set, code);
+        return slot < ready_.size() && ready_[slot] ? &cells_[slot] : nullptr;
+    }
+    const Texture2D& Texture() const { return texture_; }
+
+    // Bumped whenever a tile sprite arrives, so baked tiles can be redrawn.
+    uint64_t TileRevision() const { return tile_revision_; }
+    int Loaded() const { return loaded_; }
+    bool Loading() const { return pending_ > 0; }
+
+private:
+    struct Job {
+        Set set;
+        size_t code;
+        std::string path;
+    };
+
+    struct Decoded {
+        size_t slot;
+        bool found;   // the file exists
+        Image image;  // data is nullptr if missing or undecodable
+    };
+
+    static size_t Slot(Set set, size_t code);
+    void LoadImages();
+    void Report();
+
+    std::string directory_;
+    int uploads_per_frame_ = 4;
+    Texture2D texture_{};
+    std::vector<Rectangle> cells_;  // per slot
+    std::vector<uint8_t> ready_;    // per slot
+    std::vector<Job> jobs_;         // every candidate file; read-only while the loader runs
+    uint64_t tile_revision_ = 0;
+    int loaded_ = 0;
+    int missing_ = 0;
+    int failed_ = 0;
+    int pending_ = 0;  // jobs the render thread has not seen come back
+    int64_t load_started_us_ = 0;
+    int64_t upload_us_ = 0;
+    int upload_frames_ = 0;
+
+    std::thread loader_;
+    std::atomic<bool> stop_{false};
+    std::atomic<int64_t> decode_us_{0};
+    std::mutex decoded_mutex_;
+    std::vector<Decoded> decoded_;  // guarded by decoded_mutex_
+    std::vector<Decoded> uploading_;  // render thread, swapped with decoded_
+};
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct SnapshotPayload {
+    std::vector<char> bytes;
+    uint64_t sequence = 0;
+};
+
+// Channel between the Python simulation and the renderer. Implementations
+// deliver raw game_state payloads and carry input back to the simulation.
+// Reads happen on the ingest thread and WriteInput on the render thread, so
+// the two sides must not share mutable state.
+class StateTransport {
+public:
+    virtual ~StateTransport() = default;
+
+    virtual bool Open() = 0;
+    virtual void Close() = 0;
+    // Copies the newest complete snapshot into payload. Returns false when no
+    // snapshot newer than the previous call is available.
+    virtual bool ReadLatest(SnapshotPayload& payload) = 0;
+    // Copies the oldest snapshot not yet returned, so consecutive calls walk
+    // every buffered snapshot in order. If the writer has overwritten some of
+    // them the sequence skips ahead; callers applying deltas detect the gap.
+    virtual bool ReadNext(SnapshotPayload& payload) = 0;
+    virtual bool WriteInput(const std::string& payload) = 0;
+    // Render thread. Tells the simulation the newest tick now on screen, for
+    // ipc.sync: lockstep. Transports without a back channel ignore it.
+    virtual void ReportPresented(uint64_t tick) { (void)tick; }
+    // Whether ReportPresented reaches the simulation.
+    virtual bool SupportsPresentedTicks() const { return false; }
+    // Snapshots the transport knows it never delivered, e.g. gaps in a
+    // network stream's sequence numbers. Any thread.
+    virtual uint64_t PayloadsLost() const { return 0; }
+    virtual const char* Name() const = 0;
+};
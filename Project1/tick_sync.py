@@ -0,0 +1,115 @@
+"""Paces the simulation loop against its own clock and, optionally, the renderer."""
+
+from __future__ import annotations
+
+import logging
+import time
+from typing import Dict, List, Optional
+
+from transport import FileChannel
+
+logger = logging.getLogger(__name__)
+
+POLL_INTERVAL = 0.0005  # seconds between presented-tick checks while blocked
+SYNC_MODES = ("free", "lockstep")
+
+
+class TickPacer:
+    """Decides when ``RogueGame.run`` may simulate the next tick (``ipc.sync``).
+
+    ``free``: ticks follow fixed deadlines on the local clock, so step cost
+    does not make the rate drift; after a stall at most ``max_ticks_ahead``
+    late ticks run back to back before the schedule resets.
+
+    ``lockstep``: additionally, the simulation never publishes more than
+    ``max_ticks_ahead`` ticks the renderer has not presented yet; it sleeps
+    until the renderer's ``presented_tick`` catches up. With no renderer
+    attached, or one that has not presented anything for ``sync_timeout``
+    seconds, it stops waiting rather than hang.
+
+    Either way it logs the ticks in flight (published but not yet on screen)
+    every ``stats_log_interval`` seconds.
+    """
+
+    def __init__(self, channel: FileChannel, tick_rate: float, ipc_config: Dict) -> None:
+        self.channel = channel
+        self.interval = 1.0 / tick_rate
+        mode = ipc_config.get("sync", "free")
+        if mode not in SYNC_MODES:
+            logger.warning("unknown ipc sync mode %r; using free", mode)
+            mode = "free"
+        if mode == "lockstep" and ipc_config.get("transport", "shared_memory") != "shared_memory":
+            logger.warning("ipc sync lockstep needs the shared_memory transport; running free")
+            mode = "free"
+        self.mode = mode
+        self.max_ticks_ahead = max(1, int(ipc_config.get("max_ticks_ahead", 2)))
+        self.sync_timeout = float(ipc_config.get("sync_timeout", 1.0))
+        self.stats_interval = float(ipc_config.get("stats_log_interval", 10))
+
+        self._deadline: Optional[float] = None
+        self._last_presented: Optional[int] = None
+        self._last_progress = time.perf_counter()
+        self._stalled = False
+        self._in_flight: List[int] = []
+        self._blocked = 0.0
+        self._next_log = time.perf_counter() + self.stats_interval
+
+    def set_tick_rate(self, tick_rate: float) -> None:
+        """Paces ticks at a reloaded ``game.tick_rate`` from the next one on."""
+        self.interval = 1.0 / tick_rate
+        self._deadline = None
+
+    def wait(self, tick: int) -> None:
+        """Blocks until the tick after ``tick`` is due."""
+        now = time.perf_counter()
+        if self._deadline is None or now - self._deadline > self.max_ticks_ahead * self.interval:
+            self._deadline = now
+        if self._deadline > now:
+            time.sleep(self._deadline - now)
+
+        presented = self._observe()
+        if presented is not None:
+            self._in_flight.append(max(0, tick - presented))
+        if self.mode == "lockstep":
+            self._wait_for_renderer(tick, presented)
+        self._deadline += self.interval
+        self._log_stats()
+
+    def _observe(self) -> Optional[int]:
+        presented = self.channel.presented()
+        if presented != self._last_presented:
+            self._last_presented = presented
+            self._last_progress = time.perf_counter()
+            if self._stalled and presented is not None:
+                logger.info("renderer is presenting again; lockstep resumed")
+                self._stalled = False
+        return presented
+
+    def _wait_for_renderer(self, tick: int, presented: Optional[int]) -> None:
+        started = time.perf_counter()
+        while presented is not None and tick - presented >= self.max_ticks_ahead and not self._stalled:
+            if time.perf_counter() - self._last_progress > self.sync_timeout:
+                logger.warning(
+                    "renderer has not presented a tick for %.1f s; running ahead until it does", self.sync_timeout
+                )
+                self._stalled = True
+                break
+            time.sleep(POLL_INTERVAL)
+            presented = self._observe()
+        self._blocked += time.perf_counter() - started
+
+    def _log_stats(self) -> None:
+        if self.stats_interval <= 0:
+            return
+        now = time.perf_counter()
+        if now < self._next_log:
+            return
+        if self._in_flight:
+            ordered = sorted(self._in_flight)
+            logger.info(
+                "tick sync (%s): %d ticks in flight p50, %d max; blocked on the renderer %.0f ms",
+                self.mode, ordered[len(ordered) // 2], ordered[-1], self._blocked * 1000.0,
+            )
+        self._in_flight.clear()
+        self._blocked = 0.0
+        self._next_log = now + self.stats_interval
@@ -0,0 +1,564 @@
+"""Snapshot/input channels between the Python simulation and the C++ renderer."""
+
+from __future__ import annotations
+
+import json
+import logging
+import mmap
+import os
+import socket
+import struct
+import time
+import zlib
+from collections import deque
+from pathlib import Path
+from typing import Deque, Dict, List, Optional, Tuple
+
+from input_events import InputEventReader
+from snapshot_codec import BinarySnapshotEncoder, SnapshotDiffer
+
+logger = logging.getLogger(__name__)
+
+
+class FileChannel:
+    """Debug fallback: full JSON files in the shared directory.
+
+    Input always arrives as the renderer's event queue in ``input.json``, which
+    is only re-parsed when the file changed.
+    """
+
+    def __init__(self, shared_dir: Path) -> None:
+        self.shared_dir = shared_dir
+        self.state_path = shared_dir / "game_state.json"
+        self.input_path = shared_dir / "input.json"
+        self.input_events = InputEventReader()
+        self._input_signature: Optional[Tuple[int, int]] = None
+
+        # Whatever is already on disk was meant for a previous run (it may
+        # well end with a quit press).
+        stale = self._load_input()
+        if stale is not None:
+            self.input_events.skip(stale)
+
+    @property
+    def input_ack(self) -> int:
+        return self.input_events.last_sequence
+
+    def presented(self) -> Optional[int]:
+        """Newest tick the renderer reports on screen, or ``None`` when no
+        renderer is attached or the channel has no way back (files)."""
+        return None
+
+    def publish(self, state: Dict) -> None:
+        # Write-then-rename so the renderer never reads a half-written file.
+        temp_path = self.state_path.with_name(self.state_path.name + ".tmp")
+        with temp_path.open("w", encoding="utf-8") as fh:
+            json.dump(state, fh, indent=2)
+        try:
+            os.replace(temp_path, self.state_path)
+        except PermissionError:
+            # Windows refuses while the renderer has the file open; the next tick retries.
+            logger.debug("game_state.json is busy; skipping this tick")
+
+    def read_input(self) -> Dict:
+        payload = self._load_input()
+        if payload is not None:
+            self.input_events.apply(payload)
+        return self.input_events.state()
+
+    def _load_input(self) -> Optional[Dict]:
+        try:
+            stat = self.input_path.stat()
+        except FileNotFoundError:
+            return None
+        signature = (stat.st_mtime_ns, stat.st_size)
+        if signature == self._input_signature:
+            return None
+        try:
+            with self.input_path.open("r", encoding="utf-8") as fh:
+                data = json.load(fh)
+        except (OSError, json.JSONDecodeError):
+            # Caught mid-write; the signature is not recorded so it is retried.
+            return None
+        self._input_signature = signature
+        return data if isinstance(data, dict) else None
+
+    def close(self) -> None:
+        pass
+
+
+class SharedMemoryChannel(FileChannel):
+    """Publishes snapshots into a file-backed mapping read by the renderer.
+
+    The mapping is a 64-byte header followed by ``slot_count`` slots. Each slot
+    starts with a seqlock stamp that is odd while the slot is being written and
+    ``2 * sequence`` once it is complete; the header's ``write_sequence`` names
+    the newest complete slot. Payloads are compact JSON or the binary encoding
+    from ``snapshot_codec``. Input still travels through ``input.json``.
+
+    With ``deltas`` enabled most payloads are deltas from ``SnapshotDiffer``;
+    the renderer reads the ring in order and sets ``resync`` in its input when
+    it missed one, which forces the next payload to be a keyframe.
+
+    A payload larger than ``slot_size`` grows the slots (at least doubling) and
+    re-creates the mapping. The renderer sees the new layout in the header and
+    maps it again, and the next payload is a keyframe.
+
+    The renderer writes back into the header: ``presented_tick`` (the newest
+    tick it has drawn) and ``reader_pid`` (non-zero while it is attached),
+    which ``TickPacer`` uses for lockstep.
+    """
+
+    MAGIC = 0x4D534752  # "RGSM"
+    VERSION = 2
+    HEADER = struct.Struct("<IIIIQI4xQI20x")
+    SLOT_HEADER = struct.Struct("<QII")
+    SEQUENCE_OFFSET = 16
+    PRESENTED = struct.Struct("<QI")
+    PRESENTED_OFFSET = 32
+
+    def __init__(
+        self,
+        shared_dir: Path,
+        file_name: str,
+        slot_count: int,
+        slot_size: int,
+        snapshot_format: str = "json",
+        deltas: bool = False,
+        keyframe_interval: int = 300,
+    ) -> None:
+        super().__init__(shared_dir)
+        self.encoder = BinarySnapshotEncoder() if snapshot_format == "binary" else None
+        self.differ = SnapshotDiffer(keyframe_interval) if deltas else None
+        self.slot_count = max(1, int(slot_count))
+        self.sequence = 0
+        self.mapping_path = shared_dir / file_name
+        mode = "r+b" if self.mapping_path.exists() else "w+b"
+        self._file = self.mapping_path.open(mode)
+        self._map: Optional[mmap.mmap] = None
+        self._create_mapping(int(slot_size))
+
+    def _create_mapping(self, slot_size: int) -> None:
+        if self._map is not None:
+            # Invalidate first so a renderer never maps the old layout over the new size.
+            struct.pack_into("<I", self._map, 0, 0)
+            self._map.close()
+        self.slot_size = slot_size
+        self.slot_stride = self.SLOT_HEADER.size + self.slot_size
+        size = self.HEADER.size + self.slot_count * self.slot_stride
+        self._file.truncate(size)
+        self._map = mmap.mmap(self._file.fileno(), size)
+
+        # Invalidate first so a renderer never sees a valid header over stale slots.
+        self._map[0:size] = bytes(size)
+        self.HEADER.pack_into(
+            self._map, 0, self.MAGIC, self.VERSION, self.slot_count, self.slot_size, 0, os.getpid(), 0, 0
+        )
+
+    def publish(self, state: Dict) -> None:
+        payload = self._encode(state)
+        while len(payload) > self.slot_size:
+            slot_size = max(self.slot_size * 2, 1 << (len(payload) - 1).bit_length())
+            logger.warning(
+                "snapshot of %d bytes exceeds shm_slot_size %d; growing the slots to %d (raise shm_slot_size)",
+                len(payload), self.slot_size, slot_size,
+            )
+            self._create_mapping(slot_size)
+            if self.differ is not None:
+                # The renderer maps the ring afresh and needs a keyframe to start from.
+                self.differ.request_keyframe()
+                payload = self._encode(state)
+
+        sequence = self.sequence + 1
+        offset = self.HEADER.size + (sequence % self.slot_count) * self.slot_stride
+        data_offset = offset + self.SLOT_HEADER.size
+
+        struct.pack_into("<Q", self._map, offset, sequence * 2 - 1)
+        self._map[data_offset:data_offset + len(payload)] = payload
+        struct.pack_into("<I", self._map, offset + 8, len(payload))
+        struct.pack_into("<Q", self._map, offset, sequence * 2)
+        struct.pack_into("<Q", self._map, self.SEQUENCE_OFFSET, sequence)
+        self.sequence = sequence
+
+    def _encode(self, state: Dict) -> bytes:
+        message = self.differ.diff(state) if self.differ is not None else state
+        if self.encoder is not None:
+            return self.encoder.encode(message)
+        return json.dumps(message, separators=(",", ":")).encode("utf-8")
+
+    def presented(self) -> Optional[int]:
+        tick, reader_pid = self.PRESENTED.unpack_from(self._map, self.PRESENTED_OFFSET)
+        return tick if reader_pid else None
+
+    def read_input(self) -> Dict:
+        data = super().read_input()
+        if data.get("resync") and self.differ is not None:
+            self.differ.request_keyframe()
+        return data
+
+    def close(self) -> None:
+        self._map.close()
+        self._file.close()
+
+
+class _NetClient:
+    """One renderer attached to a ``NetworkChannel``."""
+
+    def __init__(self, key, address: Tuple, connection: Optional[socket.socket] = None) -> None:
+        self.key = key  # the socket itself for TCP, the peer address for UDP
+        self.address = address
+        self.connection = connection
+        self.role: Optional[str] = None  # set by its hello
+        self.events = InputEventReader()
+        self.received = bytearray()
+        self.outbox: Deque[memoryview] = deque()
+        self.outbox_bytes = 0
+        self.last_heard = time.monotonic()
+
+
+class NetworkChannel:
+    """Serves snapshots to renderers over TCP or UDP (``transport: tcp`` or
+    ``udp``), so the renderer can run on another machine and one simulation can
+    feed several renderers.
+
+    Each tick's message is diffed, encoded and (with ``net_compress: deflate``)
+    compressed once, framed once, and the same bytes go to every renderer.
+    Frames are numbered per run. A renderer that sees a gap, from a lost
+    datagram or from a TCP backlog dropped because it fell behind, asks for a
+    keyframe, and so does one that has just connected; the keyframe goes to
+    everyone. Over UDP a payload is split into ``net_mtu``-sized fragments.
+
+    Input travels back on the same socket. The first renderer to say hello
+    as a ``player`` steers; the rest are spectators, whose input is only read
+    to see whether they need a keyframe. The frame layout is documented in
+    docs/data_contract.md and mirrored by network_transport.cpp.
+    """
+
+    MAGIC = 0x544E4752  # "RGNT"
+    VERSION = 1
+    FRAME = struct.Struct("<IBBBxIIQIIII")
+    KIND_SNAPSHOT = 1
+    KIND_INPUT = 2
+    KIND_HELLO = 3
+    KIND_KEYFRAME = 4
+    FLAG_DEFLATE = 1
+    MIN_COMPRESS_SIZE = 128
+    MAX_FRAME_SIZE = 1 << 20  # from a renderer; input queues are a few KiB
+    MAX_BACKLOG_BYTES = 4 << 20  # per TCP client before its queued frames are dropped
+    UDP_TIMEOUT = 5.0  # renderers say hello every second
+
+    def __init__(
+        self,
+        protocol: str,
+        bind: str,
+        port: int,
+        snapshot_format: str = "binary",
+        deltas: bool = True,
+        keyframe_interval: int = 300,
+        compress: str = "deflate",
+        max_clients: int = 8,
+        mtu: int = 1200,
+    ) -> None:
+        self.protocol = protocol
+        self.encoder = BinarySnapshotEncoder() if snapshot_format == "binary" else None
+        self.differ = SnapshotDiffer(keyframe_interval) if deltas else None
+        if compress not in ("deflate", "none"):
+            logger.warning("unknown ipc net_compress %r; using none", compress)
+        self.compress = compress == "deflate"
+        self.max_clients = max(1, int(max_clients))
+        self.fragment_size = max(256, int(mtu)) - self.FRAME.size
+        self.stream = int.from_bytes(os.urandom(4), "little")
+        self.sequence = 0
+        self.input_events = InputEventReader()  # the steering renderer's
+        self.clients: Dict[object, _NetClient] = {}
+        self.controller: Optional[_NetClient] = None
+        self._dropped_frames = 0
+
+        kind = socket.SOCK_STREAM if protocol == "tcp" else socket.SOCK_DGRAM
+        family = socket.AF_INET6 if ":" in bind else socket.AF_INET
+        self.sock = socket.socket(family, kind)
+        self.sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+        if protocol == "udp":
+            self.sock.setsockopt(socket.SOL_SOCKET, socket.SO_SNDBUF, 4 << 20)
+        self.sock.bind((bind, int(port)))
+        if protocol == "tcp":
+            self.sock.listen(self.max_clients)
+        self.sock.setblocking(False)
+        logger.info("serving snapshots over %s on %s:%d", protocol, bind, int(port))
+
+    @property
+    def input_ack(self) -> int:
+        return self.input_events.last_sequence
+
+    def presented(self) -> Optional[int]:
+        return None
+
+    def publish(self, state: Dict) -> None:
+        self._poll()
+        if not self.clients:
+            # Nobody to send to; whoever connects next starts on a keyframe.
+            return
+        message = self.differ.diff(state) if self.differ is not None else state
+        if self.encoder is not None:
+            payload = self.encoder.encode(message)
+        else:
+            payload = json.dumps(message, separators=(",", ":")).encode("utf-8")
+        stored, flags = payload, 0
+        if self.compress and len(payload) >= self.MIN_COMPRESS_SIZE:
+            deflate = zlib.compressobj(1, zlib.DEFLATED, -15)
+            packed = deflate.compress(payload) + deflate.flush()
+            if len(packed) < len(payload):
+                stored, flags = packed, self.FLAG_DEFLATE
+        self.sequence += 1
+
+        if self.protocol == "tcp":
+            frame = memoryview(self._frame(self.KIND_SNAPSHOT, flags, self.sequence, stored, 0, len(stored), len(payload)))
+            for client in list(self.clients.values()):
+                self._queue(client, frame)
+            return
+        fragments = [
+            self._frame(self.KIND_SNAPSHOT, flags, self.sequence, stored[offset:offset + self.fragment_size],
+                        offset, len(stored), len(payload))
+            for offset in range(0, len(stored), self.fragment_size)
+        ]
+        for client in list(self.clients.values()):
+            for fragment in fragments:
+                try:
+                    self.sock.sendto(fragment, client.key)
+                except OSError:
+                    break  # a full send buffer is loss like any other
+
+    def read_input(self) -> Dict:
+        self._poll()
+        return self.input_events.state()
+
+    def close(self) -> None:
+        for client in list(self.clients.values()):
+            self._drop(client)
+        self.sock.close()
+
+    # ------------------------------------------------------------------
+    def _frame(self, kind: int, flags: int, sequence: int, body: bytes, offset: int, stored_size: int,
+               raw_size: int) -> bytes:
+        header = self.FRAME.pack(self.MAGIC, self.VERSION, kind, flags, self.stream, len(body), sequence,
+                                 offset, stored_size, raw_size, 0)
+        return header + body
+
+    def _queue(self, client: _NetClient, frame: memoryview) -> None:
+        if client.outbox_bytes + len(frame) > self.MAX_BACKLOG_BYTES and len(client.outbox) > 1:
+            # Too far behind to catch up. Keep the frame being sent, drop the
+            # rest; the gap in sequence numbers gets it a keyframe.
+            head = client.outbox.popleft()
+            self._dropped_frames += len(client.outbox)
+            client.outbox.clear()
+            client.outbox.append(head)
+            client.outbox_bytes = len(head)
+            logger.info("renderer %s fell behind; dropped its backlog (%d frames so far)",
+                        self._describe(client), self._dropped_frames)
+        client.outbox.append(frame)
+        client.outbox_bytes += len(frame)
+        self._flush(client)
+
+    def _flush(self, client: _NetClient) -> None:
+        while client.outbox:
+            head = client.outbox[0]
+            try:
+                sent = client.connection.send(head)
+            except BlockingIOError:
+                return
+            except OSError:
+                self._drop(client)
+                return
+            client.outbox_bytes -= sent
+            if sent < len(head):
+                client.outbox[0] = head[sent:]
+                return
+            client.outbox.popleft()
+
+    def _poll(self) -> None:
+        if self.protocol == "tcp":
+            self._accept()
+            for client in list(self.clients.values()):
+                self._receive_tcp(client)
+                if client.key in self.clients:
+                    self._flush(client)
+        else:
+            self._receive_udp()
+            now = time.monotonic()
+            for client in [c for c in self.clients.values() if now - c.last_heard > self.UDP_TIMEOUT]:
+                self._drop(client)
+
+    def _accept(self) -> None:
+        while True:
+            try:
+                connection, address = self.sock.accept()
+            except (BlockingIOError, InterruptedError):
+                return
+            if len(self.clients) >= self.max_clients:
+                logger.warning("refusing renderer %s:%d; net_max_clients reached", address[0], address[1])
+                connection.close()
+                continue
+            connection.setblocking(False)
+            connection.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+            self.clients[connection] = _NetClient(connection, address, connection)
+
+    def _receive_tcp(self, client: _NetClient) -> None:
+        while True:
+            try:
+                data = client.connection.recv(65536)
+            except BlockingIOError:
+                break
+            except OSError:
+                data = b""
+            if not data:
+                self._drop(client)
+                return
+            client.received += data
+        while len(client.received) >= self.FRAME.size:
+            fields = self.FRAME.unpack_from(client.received)
+            size = fields[5]
+            if fields[0] != self.MAGIC or size > self.MAX_FRAME_SIZE:
+                logger.warning("malformed frame from renderer %s; disconnecting", self._describe(client))
+                self._drop(client)
+                return
+            end = self.FRAME.size + size
+            if len(client.received) < end:
+                break
+            body = bytes(client.received[self.FRAME.size:end])
+            del client.received[:end]
+            self._handle(client, fields[2], body)
+            if client.key not in self.clients:
+                return
+
+    def _receive_udp(self) -> None:
+        while True:
+            try:
+                data, address = self.sock.recvfrom(65536)
+            except (BlockingIOError, InterruptedError):
+                return
+            except OSError:
+                # Windows reports an earlier datagram's ICMP unreachable here.
+                continue
+            if len(data) < self.FRAME.size:
+                continue
+            fields = self.FRAME.unpack_from(data)
+            if fields[0] != self.MAGIC or fields[5] != len(data) - self.FRAME.size:
+                continue
+            client = self.clients.get(address)
+            if client is None:
+                if fields[2] != self.KIND_HELLO or len(self.clients) >= self.max_clients:
+                    continue
+                client = self.clients[address] = _NetClient(address, address)
+            client.last_heard = time.monotonic()
+            self._handle(client, fields[2], data[self.FRAME.size:])
+
+    def _handle(self, client: _NetClient, kind: int, body: bytes) -> None:
+        if kind == self.KIND_HELLO:
+            if client.role is not None:
+                return  # a UDP keepalive
+            try:
+                hello = json.loads(body.decode("utf-8")) if body else {}
+            except (UnicodeDecodeError, json.JSONDecodeError):
+                hello = {}
+            client.role = "player" if isinstance(hello, dict) and hello.get("role") == "player" else "spectator"
+            if client.role == "player" and self.controller is None:
+                self.controller = client
+                self.input_events = client.events
+            logger.info("renderer %s attached as %s", self._describe(client),
+                        "the player" if client is self.controller else "a spectator")
+            self._request_keyframe()
+        elif kind == self.KIND_KEYFRAME:
+            self._request_keyframe()
+        elif kind == self.KIND_INPUT:
+            try:
+                data = json.loads(body.decode("utf-8"))
+            except (UnicodeDecodeError, json.JSONDecodeError):
+                return
+            if not isinstance(data, dict):
+                return
+            client.events.apply(data)
+            if client is not self.controller:
+                client.events.state()  # spectators' presses go nowhere
+            if client.events.resync:
+                self._request_keyframe()
+
+    def _request_keyframe(self) -> None:
+        if self.differ is not None:
+            self.differ.request_keyframe()
+
+    def _drop(self, client: _NetClient) -> None:
+        self.clients.pop(client.key, None)
+        if client.connection is not None:
+            client.connection.close()
+        logger.info("renderer %s detached", self._describe(client))
+        if client is self.controller:
+            # Held input must not outlive the renderer holding it.
+            self.input_events = InputEventReader()
+            self.controller = next((c for c in self.clients.values() if c.role == "player"), None)
+            if self.controller is not None:
+                self.input_events = self.controller.events
+                logger.info("renderer %s now steers", self._describe(self.controller))
+
+    @staticmethod
+    def _describe(client: _NetClient) -> str:
+        return "%s:%d" % client.address[:2]
+
+
+class MemoryChannel:
+    """Headless runs: nothing touches the shared directory. ``publish`` keeps
+    the newest state in ``latest`` and input is whatever the caller last
+    passed to ``send_input``; there is no renderer, so nothing paces it."""
+
+    def __init__(self) -> None:
+        self.latest: Optional[Dict] = None
+        self._input: Dict = {}
+
+    @property
+    def input_ack(self) -> int:
+        return 0
+
+    def presented(self) -> Optional[int]:
+        return None
+
+    def publish(self, state: Dict) -> None:
+        self.latest = state
+
+    def send_input(self, state: Dict) -> None:
+        self._input = state
+
+    def read_input(self) -> Dict:
+        return self._input
+
+    def close(self) -> None:
+        pass
+
+
+def open_channel(ipc_config: Dict, shared_dir: Path) -> FileChannel:
+    transport = ipc_config.get("transport", "shared_memory")
+    if transport == "file":
+        return FileChannel(shared_dir)
+    if transport == "memory":
+        return MemoryChannel()
+    if transport in ("tcp", "udp"):
+        return NetworkChannel(
+            transport,
+            ipc_config.get("net_bind", "127.0.0.1"),
+            int(ipc_config.get("net_port", 47800)),
+            ipc_config.get("format", "binary"),
+            bool(ipc_config.get("deltas", True)),
+            int(ipc_config.get("keyframe_interval", 300)),
+            ipc_config.get("net_compress", "deflate"),
+            int(ipc_config.get("net_max_clients", 8)),
+            int(ipc_config.get("net_mtu", 1200)),
+        )
+    if transport != "shared_memory":
+        logger.warning("unknown ipc transport %r; using shared_memory", transport)
+    return SharedMemoryChannel(
+        shared_dir,
+        ipc_config.get("shm_file", "game_state.shm"),
+        ipc_config.get("shm_slots", 16),
+        ipc_config.get("shm_slot_size", 262144),
+        ipc_config.get("format", "binary"),
+        bool(ipc_config.get("deltas", True)),
+        int(ipc_config.get("keyframe_interval", 300)),
+    )
@@ -0,0 +1,57 @@
+#include "world_camera.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+constexpr float kMinZoom = 0.1f;
+constexpr float kMaxZoom = 8.0f;
+// Screen fraction left around the room in overview.
+constexpr float kOverviewMargin = 0.95f;
+
+}  // namespace
+
+void WorldCamera::Configure(float zoom) {
+    zoom_ = std::clamp(std::isfinite(zoom) ? zoom : 1.0f, kMinZoom, kMaxZoom);
+}
+
+void WorldCamera::Update(int screen_width, int screen_height, int room_width, int room_height, float tile_size,
+                         Vector2 focus) {
+    const float screen_w = static_cast<float>(screen_width);
+    const float screen_h = static_cast<float>(screen_height);
+    if (overview_ && room_width > 0 && room_height > 0) {
+        scale_ = std::min(screen_w / room_width, screen_h / room_height) * kOverviewMargin;
+    } else {
+        scale_ = tile_size * zoom_;
+    }
+    scale_ = std::max(scale_, 1e-3f);
+
+    const float room_w = room_width * scale_;
+    const float room_h = room_height * scale_;
+    origin_.x = AxisOrigin(screen_w, room_w, (focus.x + 0.5f) * scale_);
+    origin_.y = AxisOrigin(screen_h, room_h, (focus.y + 0.5f) * scale_);
+
+    view_min_x_ = -origin_.x / scale_ - 0.5f;
+    view_min_y_ = -origin_.y / scale_ - 0.5f;
+    view_max_x_ = (screen_w - origin_.x) / scale_ - 0.5f;
+    view_max_y_ = (screen_h - origin_.y) / scale_ - 0.5f;
+
+    visible_tiles_.x0 = std::clamp(static_cast<int>(std::floor(-origin_.x / scale_)), 0, room_width);
+    visible_tiles_.y0 = std::clamp(static_cast<int>(std::floor(-origin_.y / scale_)), 0, room_height);
+    visible_tiles_.x1 = std::clamp(static_cast<int>(std::ceil((screen_w - origin_.x) / scale_)), 0, room_width);
+    visible_tiles_.y1 = std::clamp(static_cast<int>(std::ceil((screen_h - origin_.y) / scale_)), 0, room_height);
+}
+
+// Centres a room that fits; otherwise puts the focus mid-screen without
+// showing past the room edges. Rounded to whole pixels so scrolling does not
+// resample the cached tile textures.
+float WorldCamera::AxisOrigin(float screen, float room_pixels, float focus_pixels) {
+    float origin = 0.0f;
+    if (room_pixels <= screen) {
+        origin = (screen - room_pixels) * 0.5f;
+    } else {
+        origin = std::clamp(screen * 0.5f - focus_pixels, screen - room_pixels, 0.0f);
+    }
+    return std::round(origin);
+}
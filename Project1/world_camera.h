@@ -0,0 +1,61 @@
+#pragma once
+#include "raylib.h"
+
+// Half-open range of tiles [x0, x1) x [y0, y1).
+struct TileRect {
+    int x0 = 0;
+    int y0 = 0;
+    int x1 = 0;
+    int y1 = 0;
+
+    bool Empty() const { return x0 >= x1 || y0 >= y1; }
+    int Area() const { return Empty() ? 0 : (x1 - x0) * (y1 - y0); }
+};
+
+// Maps room coordinates (tiles; entities sit at x + 0.5, y + 0.5) to screen
+// pixels and answers what is on screen. A room that fits the screen is
+// centred as before; a larger one scrolls with the focus point (the player)
+// and is clamped so the view never leaves the room. Overview fits the whole
+// room on screen for a map preview.
+class WorldCamera {
+public:
+    void Configure(float zoom);
+    void SetOverview(bool overview) { overview_ = overview; }
+    bool Overview() const { return overview_; }
+
+    // Once per frame, before anything is culled or drawn.
+    void Update(int screen_width, int screen_height, int room_width, int room_height, float tile_size, Vector2 focus);
+
+    // Screen pixels per tile.
+    float Scale() const { return scale_; }
+    // Screen position of the top-left corner of tile (0, 0).
+    Vector2 Origin() const { return origin_; }
+
+    Vector2 WorldToScreen(float x, float y) const {
+        return {origin_.x + (x + 0.5f) * scale_, origin_.y + (y + 0.5f) * scale_};
+    }
+
+    // True if an entity at (x, y) reaching radius tiles from its centre
+    // touches the screen.
+    bool Visible(float x, float y, float radius) const {
+        return x + radius >= view_min_x_ && x - radius <= view_max_x_ && y + radius >= view_min_y_ &&
+               y - radius <= view_max_y_;
+    }
+
+    // Tiles that intersect the screen, clipped to the room.
+    TileRect VisibleTiles() const { return visible_tiles_; }
+
+private:
+    static float AxisOrigin(float screen, float room_pixels, float focus_pixels);
+
+    float zoom_ = 1.0f;
+    bool overview_ = false;
+    float scale_ = 32.0f;
+    Vector2 origin_{0.0f, 0.0f};
+    // Visible area in entity coordinates (already shifted by the 0.5 centre).
+    float view_min_x_ = 0.0f;
+    float view_min_y_ = 0.0f;
+    float view_max_x_ = 0.0f;
+    float view_max_y_ = 0.0f;
+    TileRect visible_tiles_;
+};
@@ -0,0 +1,86 @@
+#include "world_interpolator.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Moves further than this in one frame (respawns, room transitions) snap
+// instead of sliding across the room.
+constexpr float kSnapDistance = 3.0f;
+
+}  // namespace
+
+void WorldInterpolator::Configure(bool enabled, float max_extrapolation) {
+    enabled_ = enabled;
+    max_extrapolation_ = std::max(0.0f, max_extrapolation);
+}
+
+void WorldInterpolator::Update(const WorldSnapshot& world, bool new_frame, double now) {
+    if (new_frame) {
+        const bool continuous = world.meta.room_id == room_id_ && world.meta.tick > tick_;
+        frame_span_ = continuous ? static_cast<float>(world.meta.tick - tick_) * world.meta.delta_time : 0.0f;
+        frame_start_ = now;
+        tick_ = world.meta.tick;
+        room_id_ = world.meta.room_id;
+        Restart(actors_, world.actors);
+        Restart(projectiles_, world.projectiles);
+    }
+
+    const float elapsed = static_cast<float>(now - frame_start_);
+    const float alpha = enabled_ && frame_span_ > 0.0f ? std::min(1.0f, elapsed / frame_span_) : 1.0f;
+    Blend(actors_, world.actors, alpha);
+    Blend(projectiles_, world.projectiles, alpha);
+
+    if (!enabled_) {
+        return;
+    }
+    const float overrun = std::clamp(elapsed - frame_span_, 0.0f, max_extrapolation_);
+    if (overrun > 0.0f) {
+        const ProjectileArrays& projectiles = world.projectiles;
+        Positions& drawn = projectiles_.drawn;
+        for (size_t i = 0; i < projectiles.Size(); ++i) {
+            drawn.x[i] += projectiles.vx[i] * overrun;
+            drawn.y[i] += projectiles.vy[i] * overrun;
+        }
+    }
+}
+
+template <typename Arrays>
+void WorldInterpolator::Restart(Track& track, const Arrays& arrays) {
+    previous_rows_.Clear();
+    previous_rows_.Reserve(track.ids.size());
+    for (size_t row = 0; row < track.ids.size(); ++row) {
+        previous_rows_.Assign(track.ids[row], static_cast<uint32_t>(row));
+    }
+
+    const size_t count = arrays.Size();
+    track.from.x.resize(count);
+    track.from.y.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        float x = arrays.x[i];
+        float y = arrays.y[i];
+        const uint32_t previous = previous_rows_.Find(arrays.id[i]);
+        if (previous != IdIndex::kMissing) {
+            const float drawn_x = track.drawn.x[previous];
+            const float drawn_y = track.drawn.y[previous];
+            if (std::abs(drawn_x - x) < kSnapDistance && std::abs(drawn_y - y) < kSnapDistance) {
+                x = drawn_x;
+                y = drawn_y;
+            }
+        }
+        track.from.x[i] = x;
+        track.from.y[i] = y;
+    }
+    track.ids = arrays.id;
+    track.drawn.x.resize(count);
+    track.drawn.y.resize(count);
+}
+
+template <typename Arrays>
+void WorldInterpolator::Blend(Track& track, const Arrays& arrays, float alpha) {
+    for (size_t i = 0; i < arrays.Size(); ++i) {
+        track.drawn.x[i] = track.from.x[i] + (arrays.x[i] - track.from.x[i]) * alpha;
+        track.drawn.y[i] = track.from.y[i] + (arrays.y[i] - track.from.y[i]) * alpha;
+    }
+}
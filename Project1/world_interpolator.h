@@ -0,0 +1,53 @@
+#pragma once
+
+#include "id_index.h"
+#include "world_snapshot.h"
+
+#include <cstdint>
+#include <vector>
+
+// Smooths motion between simulation ticks so the renderer can run faster than
+// (and out of phase with) the simulation. When a new frame arrives, every
+// actor and projectile blends from where it was last drawn to its new snapshot
+// position over the ticks the frame advanced (meta.delta_time each), timed by
+// the local clock. If the next frame is late, projectiles keep moving along
+// vx/vy for up to max_extrapolation seconds; actors hold still.
+class WorldInterpolator {
+public:
+    struct Positions {
+        std::vector<float> x;
+        std::vector<float> y;
+    };
+
+    void Configure(bool enabled, float max_extrapolation);
+    bool Enabled() const { return enabled_; }
+
+    // Call once per rendered frame, with new_frame set when world changed.
+    void Update(const WorldSnapshot& world, bool new_frame, double now);
+
+    // Row-aligned with world.actors / world.projectiles from the last Update.
+    const Positions& Actors() const { return actors_.drawn; }
+    const Positions& Projectiles() const { return projectiles_.drawn; }
+
+private:
+    struct Track {
+        std::vector<uint32_t> ids;
+        Positions from;
+        Positions drawn;
+    };
+
+    template <typename Arrays>
+    void Restart(Track& track, const Arrays& arrays);
+    template <typename Arrays>
+    void Blend(Track& track, const Arrays& arrays, float alpha);
+
+    bool enabled_ = true;
+    float max_extrapolation_ = 0.1f;
+    uint64_t tick_ = 0;
+    uint32_t room_id_ = 0;
+    double frame_start_ = 0.0;
+    float frame_span_ = 0.0f;
+    Track actors_;
+    Track projectiles_;
+    IdIndex previous_rows_;
+};
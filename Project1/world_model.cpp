@@ -0,0 +1,115 @@
+#include "world_model.h"
+
+#include "allocation_counter.h"
+
+#include <utility>
+
+namespace {
+
+template <typename Arrays>
+void RebuildIndex(const Arrays& arrays, WorldModel::EntityIndex& index) {
+    index.Clear();
+    index.Reserve(arrays.Size());
+    for (size_t i = 0; i < arrays.Size(); ++i) {
+        index.Assign(arrays.id[i], static_cast<uint32_t>(i));
+    }
+}
+
+template <typename Arrays>
+void Upsert(Arrays& arrays, WorldModel::EntityIndex& index, const Arrays& changed) {
+    for (size_t i = 0; i < changed.Size(); ++i) {
+        bool inserted = false;
+        const uint32_t row = index.Insert(changed.id[i], static_cast<uint32_t>(arrays.Size()), inserted);
+        if (inserted) {
+            arrays.Resize(arrays.Size() + 1);
+        }
+        CopyRow(arrays, row, changed, i);
+    }
+}
+
+// Swap-remove: the last row fills the hole, so draw order is not preserved.
+template <typename Arrays>
+void Remove(Arrays& arrays, WorldModel::EntityIndex& index, const std::vector<uint32_t>& ids) {
+    for (const uint32_t id : ids) {
+        const uint32_t row = index.Find(id);
+        if (row == IdIndex::kMissing) {
+            continue;
+        }
+        const uint32_t last = static_cast<uint32_t>(arrays.Size() - 1);
+        index.Erase(id);
+        if (row != last) {
+            MoveRow(arrays, row, last);
+            index.Assign(arrays.id[row], row);
+        }
+        arrays.Resize(last);
+    }
+}
+
+}  // namespace
+
+bool WorldModel::Apply(SnapshotUpdate& update) {
+    allocation_counter::MemoryTagScope memory(allocation_counter::MemoryTag::World);
+    if (update.keyframe) {
+        ApplyKeyframe(update);
+    } else if (!synced_ || update.base_tick != world_.meta.tick) {
+        synced_ = false;
+        return false;
+    } else {
+        ApplyDelta(update);
+    }
+    for (ParticleSpawn& spawn : update.particle_spawns) {
+        spawn.sequence = ++particle_sequence_;
+        particle_spawns_.push_back(spawn);
+    }
+    return true;
+}
+
+void WorldModel::ApplyKeyframe(SnapshotUpdate& update) {
+    const WorldSnapshot& frame = update.frame;
+    if (frame.room_width != world_.room_width || frame.room_height != world_.room_height ||
+        frame.tile_size != world_.tile_size || frame.tiles != world_.tiles) {
+        ++tile_layout_revision_;
+        dirty_tiles_.clear();
+    }
+    update.frame.revision = world_.revision + 1;
+    std::swap(world_, update.frame);
+    RebuildIndex(world_.actors, actor_index_);
+    RebuildIndex(world_.projectiles, projectile_index_);
+    RebuildIndex(world_.pickups, pickup_index_);
+    RebuildIndex(world_.effects, effect_index_);
+    synced_ = true;
+}
+
+void WorldModel::ApplyDelta(SnapshotUpdate& update) {
+    WorldSnapshot& delta = update.frame;
+    ++world_.revision;
+    world_.meta = delta.meta;
+    if (delta.tile_size != world_.tile_size) {
+        world_.tile_size = delta.tile_size;
+        ++tile_layout_revision_;
+        dirty_tiles_.clear();
+    }
+    std::swap(world_.messages, delta.messages);
+    std::swap(world_.boss, delta.boss);
+
+    for (const TileChange& change : update.tile_changes) {
+        if (change.x >= world_.room_width || change.y >= world_.room_height) {
+            continue;
+        }
+        snapshot::TileCode& tile = world_.tiles[static_cast<size_t>(change.y) * world_.room_width + change.x];
+        if (tile != change.code) {
+            tile = change.code;
+            dirty_tiles_.push_back(change);
+        }
+    }
+
+    Remove(world_.actors, actor_index_, update.removed_actors);
+    Remove(world_.projectiles, projectile_index_, update.removed_projectiles);
+    Remove(world_.pickups, pickup_index_, update.removed_pickups);
+    Remove(world_.effects, effect_index_, update.removed_effects);
+
+    Upsert(world_.actors, actor_index_, delta.actors);
+    Upsert(world_.projectiles, projectile_index_, delta.projectiles);
+    Upsert(world_.pickups, pickup_index_, delta.pickups);
+    Upsert(world_.effects, effect_index_, delta.effects);
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "id_index.h"
+#include "world_snapshot.h"
+
+#include <cstdint>
+#include <vector>
+
+// Retained world the renderer draws from. Keyframes replace it wholesale and
+// deltas are applied in place, so a delta is only valid on top of the tick it
+// was diffed against. Each entity table keeps an id -> row index so upserts and
+// removals do not scan the arrays.
+class WorldModel {
+public:
+    using EntityIndex = IdIndex;
+
+    // Takes ownership of update.frame's contents (the storage is swapped back
+    // for reuse). Returns false and drops the update when it is a delta that
+    // does not follow the current state; the model then stays out of sync
+    // until the next keyframe.
+    bool Apply(SnapshotUpdate& update);
+
+    bool Synced() const { return synced_; }
+    const WorldSnapshot& Snapshot() const { return world_; }
+
+    // Bumped whenever the grid is replaced by different contents or its size
+    // changes; caches of the whole tilemap rebuild when it moves. Individual
+    // tiles changed by deltas in between are listed in DirtyTiles until the
+    // consumer clears them.
+    uint64_t TileLayoutRevision() const { return tile_layout_revision_; }
+    const std::vector<TileChange>& DirtyTiles() const { return dirty_tiles_; }
+    void ClearDirtyTiles() { dirty_tiles_.clear(); }
+
+    // Particle spawns of every update applied since the consumer last
+    // cleared them, oldest first and numbered in order.
+    const std::vector<ParticleSpawn>& ParticleSpawns() const { return particle_spawns_; }
+    void ClearParticleSpawns() { particle_spawns_.clear(); }
+
+private:
+    void ApplyKeyframe(SnapshotUpdate& update);
+    void ApplyDelta(SnapshotUpdate& update);
+
+    WorldSnapshot world_;
+    EntityIndex actor_index_;
+    EntityIndex projectile_index_;
+    EntityIndex pickup_index_;
+    EntityIndex effect_index_;
+    std::vector<TileChange> dirty_tiles_;
+    std::vector<ParticleSpawn> particle_spawns_;
+    uint64_t particle_sequence_ = 0;
+    uint64_t tile_layout_revision_ = 0;
+    bool synced_ = false;
+};
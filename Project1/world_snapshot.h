@@ -0,0 +1,209 @@
+#pragma once
+
+#include "snapshot_format.h"
+
+#include <cstdint>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+struct SnapshotMeta {
+    uint64_t tick = 0;
+    float delta_time = 0.0f;
+    uint32_t room_id = 0;
+    int player_hp = 0;
+    int player_max_hp = 0;
+    int coins = 0;
+    int keys = 0;
+    int bombs = 0;
+    bool room_cleared = false;
+    bool player_dead = false;
+    uint32_t input_ack = 0;
+    uint64_t timestamp_us = 0;  // Unix time the producer published this tick
+};
+
+struct BossHealth {
+    bool active = false;
+    int hp = 0;
+    int max_hp = 1;
+    std::string name;
+};
+
+// Entity tables are structs of parallel column vectors. Each one lists its
+// columns once in ColumnsOf so the row helpers below work on any table.
+template <typename Arrays>
+void ResizeColumns(Arrays& arrays, size_t count) {
+    std::apply([count](auto&... column) { (column.resize(count), ...); }, Arrays::ColumnsOf(arrays));
+}
+
+template <typename Arrays>
+void CopyRow(Arrays& dst, size_t to, const Arrays& src, size_t from) {
+    auto dst_columns = Arrays::ColumnsOf(dst);
+    auto src_columns = Arrays::ColumnsOf(src);
+    std::apply([&](auto&... target) {
+        std::apply([&](const auto&... source) { ((target[to] = source[from]), ...); }, src_columns);
+    }, dst_columns);
+}
+
+template <typename Arrays>
+void MoveRow(Arrays& arrays, size_t to, size_t from) {
+    std::apply([=](auto&... column) { ((column[to] = column[from]), ...); }, Arrays::ColumnsOf(arrays));
+}
+
+struct ActorArrays {
+    std::vector<uint32_t> id;
+    std::vector<snapshot::ActorType> type;
+    std::vector<snapshot::ActorVariant> variant;
+    std::vector<uint8_t> flags;
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> dir_x;
+    std::vector<float> dir_y;
+    std::vector<float> speed;
+    std::vector<int32_t> hp;
+    std::vector<int32_t> max_hp;
+
+    size_t Size() const { return id.size(); }
+    void Resize(size_t count) { ResizeColumns(*this, count); }
+
+    template <typename Self>
+    static auto ColumnsOf(Self& self) {
+        return std::tie(self.id,
+                        self.type,
+                        self.variant,
+                        self.flags,
+                        self.x,
+                        self.y,
+                        self.dir_x,
+                        self.dir_y,
+                        self.speed,
+                        self.hp,
+                        self.max_hp);
+    }
+};
+
+struct ProjectileArrays {
+    std::vector<uint32_t> id;
+    std::vector<snapshot::ProjectileOwner> owner;
+    std::vector<snapshot::ProjectileKind> kind;
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> vx;
+    std::vector<float> vy;
+    std::vector<float> ttl;
+    std::vector<float> radius;
+    std::vector<int32_t> damage;
+
+    size_t Size() const { return id.size(); }
+    void Resize(size_t count) { ResizeColumns(*this, count); }
+
+    template <typename Self>
+    static auto ColumnsOf(Self& self) {
+        return std::tie(self.id,
+                        self.owner,
+                        self.kind,
+                        self.x,
+                        self.y,
+                        self.vx,
+                        self.vy,
+                        self.ttl,
+                        self.radius,
+                        self.damage);
+    }
+};
+
+struct PickupArrays {
+    std::vector<uint32_t> id;
+    std::vector<snapshot::PickupKind> kind;
+    std::vector<float> x;
+    std::vector<float> y;
+
+    size_t Size() const { return id.size(); }
+    void Resize(size_t count) { ResizeColumns(*this, count); }
+
+    template <typename Self>
+    static auto ColumnsOf(Self& self) {
+        return std::tie(self.id,
+                        self.kind,
+                        self.x,
+                        self.y);
+    }
+};
+
+struct EffectArrays {
+    std::vector<uint32_t> id;
+    std::vector<snapshot::EffectKind> kind;
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> ttl;
+
+    size_t Size() const { return id.size(); }
+    void Resize(size_t count) { ResizeColumns(*this, count); }
+
+    template <typename Self>
+    static auto ColumnsOf(Self& self) {
+        return std::tie(self.id,
+                        self.kind,
+                        self.x,
+                        self.y,
+                        self.ttl);
+    }
+};
+
+// Decoded game_state, filled either from the binary encoding or from JSON.
+// Entities are stored as parallel arrays with string fields resolved to enum
+// codes, so draw passes never touch JSON or compare strings. The renderer
+// bumps revision every time it accepts a newly decoded snapshot.
+struct WorldSnapshot {
+    uint64_t revision = 0;
+    SnapshotMeta meta;
+    float tile_size = 32.0f;
+    int room_width = 0;
+    int room_height = 0;
+    std::vector<snapshot::TileCode> tiles;
+    ActorArrays actors;
+    ProjectileArrays projectiles;
+    PickupArrays pickups;
+    EffectArrays effects;
+    std::vector<std::string> messages;
+    BossHealth boss;
+
+    snapshot::TileCode TileAt(int x, int y) const {
+        return tiles[static_cast<size_t>(y) * room_width + x];
+    }
+};
+
+struct TileChange {
+    uint16_t x = 0;
+    uint16_t y = 0;
+    snapshot::TileCode code = snapshot::TileCode::Unknown;
+};
+
+// A burst of particles for the renderer to animate itself. The simulation
+// sends only this, in the message of the tick it happened on; the particles
+// never cross the channel.
+struct ParticleSpawn {
+    uint64_t sequence = 0;  // numbered by WorldModel, increasing
+    uint64_t tick = 0;
+    snapshot::EffectKind kind = snapshot::EffectKind::Unknown;
+    float x = 0.0f;
+    float y = 0.0f;
+    uint32_t seed = 0;
+};
+
+// One decoded message. A keyframe carries the whole world in frame; a delta
+// carries meta/ui plus only the entities that changed since base_tick, the ids
+// that disappeared and the tiles that changed. Either kind carries the
+// particle spawns of its tick.
+struct SnapshotUpdate {
+    bool keyframe = true;
+    uint64_t base_tick = 0;
+    WorldSnapshot frame;
+    std::vector<uint32_t> removed_actors;
+    std::vector<uint32_t> removed_projectiles;
+    std::vector<uint32_t> removed_pickups;
+    std::vector<uint32_t> removed_effects;
+    std::vector<TileChange> tile_changes;
+    std::vector<ParticleSpawn> particle_spawns;
+};